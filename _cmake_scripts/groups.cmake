@@ -45,6 +45,9 @@ elseif ( ${BUILD_GROUP} STREQUAL "everything" )
 	include( "${SRCDIR}/materialsystem/stdshaders/game_shader_dx9_${BUILD_GAME}.cmake" )
 
 	include( "${SRCDIR}/utils/captioncompiler/captioncompiler.cmake" )
+	include( "${SRCDIR}/utils/bitbuf_bench/bitbuf_bench.cmake" )
+	include( "${SRCDIR}/utils/strtools_bench/strtools_bench.cmake" )
+	include( "${SRCDIR}/utils/unicode_conformance/unicode_conformance.cmake" )
 
 	if ( ${IS_WINDOWS} )
 		# those are still windows-only for now...
@@ -23,6 +23,13 @@ extern "C" {
 	//-----------------------------------------------------------------------------
 	unsigned char* LZMA_Compress( unsigned char* pInput, unsigned int inputSize, unsigned int* pOutputSize );
 
+	//-----------------------------------------------------------------------------
+	// Encoding glue, compresses blockSize bytes at a time into a container which
+	// CLZMA decodes in parallel. Returns non-null Compressed buffer if successful.
+	// Caller must free.
+	//-----------------------------------------------------------------------------
+	unsigned char* LZMA_CompressBlocks( unsigned char* pInput, unsigned int inputSize, unsigned int blockSize, unsigned int* pOutputSize );
+
 	//-----------------------------------------------------------------------------
 	// Decoding glue. Returns true if succesful.
 	//-----------------------------------------------------------------------------
@@ -169,12 +169,13 @@ FileHandle_t CFileSystemStdio::Open( const char* pFileName, const char* pOptions
 
 	// if we got a pathID, only look into that SearchPath
 	if ( pathID != nullptr ) {
-		if ( m_SearchPaths.Find( pathID ) == CUtlDict<SearchPath>::InvalidIndex() ) {
+		const auto index{ m_SearchPaths.Find( pathID ) };
+		if ( index == m_SearchPaths.InvalidIndex() ) {
 			Warning( "[FileSystem] `Open()` Was given a pathID (%s) which wasn't loaded, may be a bug!\n", pathID );
 			return nullptr;
 		}
 
-		for ( const auto& driver : m_SearchPaths[pathID]->m_Drivers ) {
+		for ( const auto& driver : m_SearchPaths[index]->m_Drivers ) {
 			const auto desc{ driver->Open( pFileName, mode ) };
 			// only add to vector if we actually got an open file
 			if ( desc != nullptr ) {
@@ -383,25 +384,29 @@ void CFileSystemStdio::AddSearchPath( const char* pPath, const char* pathID, Sea
 	// TODO: Use string interning if possible
 	pathID = V_strlower( V_strdup( pathID ) );
 
-	if ( m_SearchPaths.Find( pathID ) == CUtlDict<SearchPath*>::InvalidIndex() ) {
-		// `Insert` does a `V_strdup`, so we can safely delete ours afterward.
-		m_SearchPaths.Insert( pathID, new SearchPath );
+	// `Insert` copies the key into a `CUtlString`, so we can safely delete ours afterward.
+	bool inserted;
+	const auto index{ m_SearchPaths.Insert( pathID, nullptr, &inserted ) };
+	if ( inserted ) {
+		m_SearchPaths[index] = new SearchPath;
 	}
 
+	auto* search{ m_SearchPaths[index] };
 	if ( addType == SearchPathAdd_t::PATH_ADD_TO_HEAD ) {
-		m_SearchPaths[pathID]->m_Drivers.AddToHead( driver );
+		search->m_Drivers.AddToHead( driver );
 	} else {
-		m_SearchPaths[pathID]->m_Drivers.AddToTail( driver );
+		search->m_Drivers.AddToTail( driver );
 	}
-	m_SearchPaths[pathID]->m_ClientIDs.AddToTail( m_LastId );
+	search->m_ClientIDs.AddToTail( m_LastId );
 	delete[] pathID;
 }
 bool CFileSystemStdio::RemoveSearchPath( const char* pPath, const char* pathID ) {
-	if ( m_SearchPaths.Find( pathID ) == CUtlDict<SearchPath>::InvalidIndex() ) {
+	const auto index{ m_SearchPaths.Find( pathID ) };
+	if ( index == m_SearchPaths.InvalidIndex() ) {
 		return false;
 	}
 
-	auto& drivers{ m_SearchPaths[pathID]->m_Drivers };
+	auto& drivers{ m_SearchPaths[index]->m_Drivers };
 	for ( int i{0}; i < drivers.Count(); i += 1 ) {
 		if ( V_strcmp( drivers[i]->GetNativePath(), pPath ) == 0 ) {
 			drivers[i]->Shutdown();
@@ -437,10 +442,11 @@ void CFileSystemStdio::RemoveAllSearchPaths() {
 
 void CFileSystemStdio::RemoveSearchPaths( const char* szPathID ) {
 	// is it a real search path?
-	if ( m_SearchPaths.Find( szPathID ) == CUtlDict<SearchPath>::InvalidIndex() ) {
+	const auto index{ m_SearchPaths.Find( szPathID ) };
+	if ( index == m_SearchPaths.InvalidIndex() ) {
 		return;
 	}
-	auto* search{ m_SearchPaths[szPathID] };
+	auto* search{ m_SearchPaths[index] };
 
 	// close all open descriptors the path's clients own
 	for ( auto i{m_Descriptors.Count()}; i > 0; i -= 1 ) {
@@ -465,8 +471,8 @@ void CFileSystemStdio::RemoveSearchPaths( const char* szPathID ) {
 	search->m_ClientIDs.Purge();
 
 	// delete search path
-	delete m_SearchPaths[szPathID];
-	m_SearchPaths.Remove( szPathID );
+	delete search;
+	m_SearchPaths.RemoveAt( index );
 }
 
 void CFileSystemStdio::MarkPathIDByRequestOnly( const char* pPathID, bool bRequestOnly ) {
@@ -474,11 +480,13 @@ void CFileSystemStdio::MarkPathIDByRequestOnly( const char* pPathID, bool bReque
 	// TODO: Use string interning if possible
 	const auto pathID{ V_strlower( V_strdup( pPathID ) ) };
 
-	if ( m_SearchPaths.Find( pathID ) == CUtlDict<SearchPath>::InvalidIndex() ) {
-		m_SearchPaths.Insert( pathID, new SearchPath );
+	bool inserted;
+	const auto index{ m_SearchPaths.Insert( pathID, nullptr, &inserted ) };
+	if ( inserted ) {
+		m_SearchPaths[index] = new SearchPath;
 	}
 
-	m_SearchPaths[pathID]->m_RequestOnly = bRequestOnly;
+	m_SearchPaths[index]->m_RequestOnly = bRequestOnly;
 	delete[] pathID;
 }
 
@@ -518,13 +526,14 @@ const char* CFileSystemStdio::RelativePathToFullPath( const char* pFileName, con
 	CFsDriver* drvr{ nullptr };
 	// if we got a pathID, only look into that SearchPath
 	if ( pPathID != nullptr ) {
-		if ( m_SearchPaths.Find( pPathID ) == CUtlDict<SearchPath>::InvalidIndex() ) {
+		const auto index{ m_SearchPaths.Find( pPathID ) };
+		if ( index == m_SearchPaths.InvalidIndex() ) {
 			Warning( "[FileSystem] `RelativePathToFullPath()` Was given a pathID (%s) which wasn't loaded, may be a bug!\n", pPathID );
 			return nullptr;
 		}
 
 		// find the right driver
-		drvr = helper( m_SearchPaths[pPathID] );
+		drvr = helper( m_SearchPaths[index] );
 	} else {
 		// else, look into all clients
 		for ( const auto& [_, searchPath] : m_SearchPaths ) {
@@ -548,12 +557,13 @@ const char* CFileSystemStdio::RelativePathToFullPath( const char* pFileName, con
 }
 
 int CFileSystemStdio::GetSearchPath( const char* pathID, bool bGetPackFiles, char* pDest, int maxLenInChars ) {
-	if ( m_SearchPaths.Find( pathID ) == CUtlDict<SearchPath>::InvalidIndex() ) {
+	const auto index{ m_SearchPaths.Find( pathID ) };
+	if ( index == m_SearchPaths.InvalidIndex() ) {
 		return 0;
 	}
 
 	int length{0};
-	for ( const auto& client : m_SearchPaths[pathID]->m_Drivers ) {
+	for ( const auto& client : m_SearchPaths[index]->m_Drivers ) {
 		if ( V_strcmp( client->GetType(), "pack" ) == 0 and !bGetPackFiles ) {
 			// pack files disabled...
 			continue;
@@ -705,8 +715,11 @@ const char* CFileSystemStdio::FindFirstEx( const char* pWildCard, const char* pP
 	if ( V_IsAbsolutePath( pWildCard ) ) {
 		s_RootFsDriver->ListDir( pWildCard, paths );
 	} else {
-		const auto& searchPath{ m_SearchPaths[pPathID] };
-		for ( const auto driver : searchPath->m_Drivers ) {
+		const auto pathIndex{ m_SearchPaths.Find( pPathID ) };
+		if ( pathIndex == m_SearchPaths.InvalidIndex() ) {
+			return nullptr;
+		}
+		for ( const auto driver : m_SearchPaths[pathIndex]->m_Drivers ) {
 			driver->ListDir( pWildCard, paths );
 		}
 	}
@@ -744,7 +757,64 @@ bool CFileSystemStdio::String( const FileNameHandle_t& pHandle, char* pBuf, int
 }
 
 // ---- Global Asynchronous file operations ----
-FSAsyncStatus_t CFileSystemStdio::AsyncReadMultiple( const FileAsyncRequest_t* pRequests, int nRequests, FSAsyncControl_t* phControls ) { AssertUnreachable(); return {}; }
+FSAsyncStatus_t CFileSystemStdio::AsyncReadMultiple( const FileAsyncRequest_t* pRequests, int nRequests, FSAsyncControl_t* phControls ) {
+	// Requests are always serviced right away, as if they had `FSASYNC_FLAGS_SYNC`, and the callbacks
+	// run before this returns: the descriptor list and search paths aren't safe to use off the main thread.
+	for ( auto i{ 0 }; i < nRequests; i += 1 ) {
+		FileAsyncRequest_t request{ pRequests[i] };
+		if ( phControls ) {
+			phControls[i] = nullptr;
+		}
+
+		const auto handle{ Open( request.pszFilename, "rb", request.pszPathID ) };
+		if ( handle == nullptr or request.nBytes == -1 ) {
+			// either a failed open or an exists test
+			if ( handle ) {
+				Close( handle );
+			}
+			if ( request.pfnCallback ) {
+				request.pfnCallback( request, 0, handle ? FSASYNC_OK : FSASYNC_ERR_FILEOPEN );
+			}
+			continue;
+		}
+
+		const auto nSize{ static_cast<int>( Size( handle ) ) };
+		const auto nOffset{ std::min( std::max( request.nOffset, 0 ), nSize ) };
+		const auto nBytes{ request.nBytes == 0 ? nSize - nOffset : std::min( request.nBytes, nSize - nOffset ) };
+		const bool bNullTerminate{ ( request.flags & FSASYNC_FLAGS_NULLTERMINATE ) != 0 };
+
+		bool bAllocated{ false };
+		if ( request.pData == nullptr ) {
+			const auto nAlloc{ static_cast<unsigned>( nBytes + ( bNullTerminate ? 1 : 0 ) ) };
+			request.pData = request.pfnAlloc ? request.pfnAlloc( request.pszFilename, nAlloc ) : AllocOptimalReadBuffer( handle, nAlloc, nOffset );
+			bAllocated = true;
+		}
+
+		auto status{ FSASYNC_OK };
+		auto nRead{ 0 };
+		if ( request.pData == nullptr ) {
+			status = FSASYNC_ERR_NOMEMORY;
+		} else {
+			Seek( handle, nOffset, FILESYSTEM_SEEK_HEAD );
+			nRead = Read( request.pData, nBytes, handle );
+			if ( nRead != nBytes ) {
+				status = FSASYNC_ERR_READING;
+			}
+			if ( bAllocated and bNullTerminate ) {
+				static_cast<char*>( request.pData )[ std::max( nRead, 0 ) ] = '\0';
+			}
+		}
+		Close( handle );
+
+		if ( request.pfnCallback ) {
+			request.pfnCallback( request, nRead, status );
+		}
+		if ( bAllocated and request.pData and ( request.flags & FSASYNC_FLAGS_FREEDATAPTR ) and not ( request.flags & FSASYNC_FLAGS_ALLOCNOFREE ) and request.pfnAlloc == nullptr ) {
+			FreeOptimalReadBuffer( request.pData );
+		}
+	}
+	return FSASYNC_OK;
+}
 FSAsyncStatus_t CFileSystemStdio::AsyncAppend( const char* pFileName, const void* pSrc, int nSrcBytes, bool bFreeMemory, FSAsyncControl_t* pControl ) { AssertUnreachable(); return {}; }
 FSAsyncStatus_t CFileSystemStdio::AsyncAppendFile( const char* pAppendToFileName, const char* pAppendFromFileName, FSAsyncControl_t* pControl ) { AssertUnreachable(); return {}; }
 void CFileSystemStdio::AsyncFinishAll( int iToPriority ) { AssertUnreachable(); }
@@ -790,7 +860,7 @@ void CFileSystemStdio::PrintOpenedFiles() {
 void CFileSystemStdio::PrintSearchPaths() {
 	Log( "---- Search Path table ----\n" );
 	for ( const auto& [searchPathId, searchPath] : m_SearchPaths ) {
-		Log( "%s(reqOnly=%d):\n", searchPathId, searchPath->m_RequestOnly );
+		Log( "%s(reqOnly=%d):\n", searchPathId.Get(), searchPath->m_RequestOnly );
 		for ( const auto& path : searchPath->m_Drivers ) {
 			if ( path->GetNativePath() and V_strcmp( path->GetNativePath(), "" ) != 0 ) {
 				Log( "  - %s\n", path->GetNativePath() );
@@ -879,7 +949,9 @@ bool CFileSystemStdio::ExtractRootKeyName( KeyValuesPreloadType_t type, char* ou
 
 FSAsyncStatus_t CFileSystemStdio::AsyncWrite( const char* pFileName, const void* pSrc, int nSrcBytes, bool bFreeMemory, bool bAppend, FSAsyncControl_t* pControl ) { AssertUnreachable(); return {}; }
 FSAsyncStatus_t CFileSystemStdio::AsyncWriteFile( const char* pFileName, const CUtlBuffer* pSrc, int nSrcBytes, bool bFreeMemory, bool bAppend, FSAsyncControl_t* pControl ) { AssertUnreachable(); return {}; }
-FSAsyncStatus_t CFileSystemStdio::AsyncReadMultipleCreditAlloc( const FileAsyncRequest_t* pRequests, int nRequests, const char* pszFile, int line, FSAsyncControl_t* phControls ) { AssertUnreachable(); return {}; }
+FSAsyncStatus_t CFileSystemStdio::AsyncReadMultipleCreditAlloc( const FileAsyncRequest_t* pRequests, int nRequests, const char* pszFile, int line, FSAsyncControl_t* phControls ) {
+	return AsyncReadMultiple( pRequests, nRequests, phControls );
+}
 
 bool CFileSystemStdio::GetFileTypeForFullPath( char const* pFullPath, wchar_t* buf, size_t bufSizeInBytes ) { AssertUnreachable(); return {}; }
 
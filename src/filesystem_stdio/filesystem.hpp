@@ -4,7 +4,8 @@
 #pragma once
 #include "basefilesystem.hpp"
 #include "driver/fsdriver.hpp"
-#include "tier1/utldict.h"
+#include "tier1/utlflathashmap.h"
+#include "tier1/utlstring.h"
 
 
 #undef AsyncRead
@@ -434,8 +435,8 @@ private:
 	bool m_Initialized{ false };
 	// The last-used driver ID, 0 is reserved for the root
 	int m_LastId{ 1 };
-	// The named search paths
-	CUtlDict<SearchPath*> m_SearchPaths{};
+	// The named search paths, case-insensitive and in the order they were first added
+	CUtlFlatHashMap<CUtlString, SearchPath*, CaselessStringHashFunctor, CaselessStringEqualFunctor> m_SearchPaths{};
 	// All open descriptors
 	CUtlVector<FileDescriptor*> m_Descriptors{ 10 };
 	// Open `FindFile*` states
@@ -8,6 +8,7 @@
 #include "cbase.h"
 
 #include "utlhashtable.h"
+#include "stringpool.h"
 #ifndef GC
 #include "igamesystem.h"
 #endif
@@ -31,29 +32,26 @@ class CGameStringPool : public CBaseGameSystem
 	void FreeAll()
 	{
 #if 0 && IsDebug()
-		m_Strings.DbgCheckIntegrity();
 		m_KeyLookupCache.DbgCheckIntegrity();
 #endif
-		m_Strings.Purge();
+		m_Strings.FreeAll();
 		m_KeyLookupCache.Purge();
 	}
 
-	CUtlHashtable<CUtlConstString> m_Strings;
+	// entity keyvalues are interned by the thousand during map spawn, a hashed pool keeps that cheap
+	CHashedStringPool m_Strings;
 	CUtlHashtable<const void*, const char*> m_KeyLookupCache;
 
 public:
 
-	CGameStringPool() : m_Strings(256) { }
+	CGameStringPool() : m_Strings( false ) { }
 
 	~CGameStringPool() { FreeAll(); }
 
 	void Dump( void )
 	{
-		CUtlVector<const char*> strings( 0, m_Strings.Count() );
-		for (UtlHashHandle_t i = m_Strings.FirstHandle(); i != m_Strings.InvalidHandle(); i = m_Strings.NextHandle(i))
-		{
-			strings.AddToTail( strings[i] );
-		}
+		CUtlVector<const char*> strings;
+		m_Strings.GetStrings( strings );
 		struct _Local {
 			static int __cdecl F(const char * const *a, const char * const *b) { return strcmp(*a, *b); }
 		};
@@ -65,17 +63,20 @@ public:
 		}
 		DevMsg( "\n" );
 		DevMsg( "Size:  %d items\n", strings.Count() );
+
+		StringPoolStats_t stats;
+		m_Strings.GetStats( stats );
+		DevMsg( "Storage:  %d bytes of strings in %d bytes, %d lookups, %d hits\n", stats.m_nStringBytes, stats.m_nPageBytes, stats.m_nLookups, stats.m_nHits );
 	}
 
 	const char *Find(const char *string)
 	{
-		UtlHashHandle_t i = m_Strings.Find( string );
-		return i == m_Strings.InvalidHandle() ? NULL : m_Strings[ i ].Get();
+		return m_Strings.Find( string );
 	}
 
 	const char *Allocate(const char *string)
 	{
-		return m_Strings[ m_Strings.Insert( string ) ].Get();
+		return m_Strings.Allocate( string );
 	}
 
 	const char *AllocateWithKey(const char *string, const void* key)
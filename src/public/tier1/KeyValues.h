@@ -289,6 +289,8 @@ private:
 
 	void Init();
 	const char* ReadToken( CUtlBuffer& buf, bool& wasQuoted, bool& wasConditional );
+	void FreeStringValue();
+	void AllocParsedValue( int nSize );
 	void WriteIndents( IBaseFileSystem* filesystem, FileHandle_t f, CUtlBuffer* pBuf, int indentLevel );
 
 	void FreeAllocatedValue();
@@ -311,7 +313,7 @@ private:
 	char m_iDataType;
 	char m_bHasEscapeSequences;  // true, if while parsing this KeyValue, Escape Sequences are used (default false)
 	char m_bEvaluateConditionals;// true, if while parsing this KeyValue, conditionals blocks are evaluated (default true)
-	char unused[ 1 ];
+	char m_bArenaValue;          // true, if m_sValue was allocated by the parser's string arena
 
 	KeyValues* m_pPeer; // pointer to next key in list
 	KeyValues* m_pSub;  // pointer to Start of a new sub key list
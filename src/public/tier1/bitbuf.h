@@ -171,6 +171,10 @@ public:
 	// Write a list of bits in.
 	bool WriteBits( const void* pIn, int nBits );
 
+	// Write nCount values of numbits each, the same bits as a WriteUBitLong for each of them.
+	// Values are masked to numbits, and are gathered a 64-bit word at a time.
+	bool WriteBitsArray( const uint32* pValues, int nCount, int numbits );
+
 	// writes an unsigned integer with variable bit length
 	void WriteUBitVar( unsigned int data );
 
@@ -197,6 +201,10 @@ public:
 	void WriteBitVec3Normal( const Vector& fa );
 	void WriteBitAngles( const QAngle& fa );
 
+	// Same as writing each vector in turn, but buffered
+	void WriteBitVec3CoordArray( const Vector* pVecs, int nCount );
+	void WriteBitVec3NormalArray( const Vector* pVecs, int nCount );
+
 
 	// Byte functions.
 public:
@@ -496,6 +504,8 @@ public:
 
 	// Read a list of bits in.
 	void ReadBits( void* pOut, int nBits );
+	// Read nCount values of numbits each, same as a ReadUBitLong for each of them.
+	void ReadBitsArray( uint32* pValues, int nCount, int numbits );
 	// Read a list of bits in, but don't overrun the destination buffer.
 	// Returns the number of bits read into the buffer. The remaining
 	// bits are skipped over.
@@ -538,6 +548,10 @@ public:
 	void ReadBitVec3Normal( Vector& fa );
 	void ReadBitAngles( QAngle& fa );
 
+	// Same as reading each vector in turn, but buffered
+	void ReadBitVec3CoordArray( Vector* pVecs, int nCount );
+	void ReadBitVec3NormalArray( Vector* pVecs, int nCount );
+
 	// Faster for comparisons but do not fully decode float values
 	unsigned int ReadBitCoordBits();
 	unsigned int ReadBitCoordMPBits( bool bIntegral, bool bLowPrecision );
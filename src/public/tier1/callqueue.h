@@ -9,6 +9,11 @@
 
 #include "tier0/tslist.h"
 #include "functors.h"
+#include "functorarena.h"
+#include "lockfreequeue.h"
+#if IsDebug()
+#include <atomic>
+#endif
 
 #if IsWindows()
 #pragma once
@@ -26,7 +31,7 @@
 	template <typename FUNCTION_RETTYPE FUNC_TEMPLATE_FUNC_PARAMS_##N FUNC_TEMPLATE_ARG_PARAMS_##N> \
 	void QueueCall(FUNCTION_RETTYPE (*pfnProxied)( FUNC_BASE_TEMPLATE_FUNC_PARAMS_##N ) FUNC_ARG_FORMAL_PARAMS_##N ) \
 		{ \
-		QueueFunctorInternal( CreateFunctor( pfnProxied FUNC_FUNCTOR_CALL_ARGS_##N ) ); \
+		QueueFunctorInternal( GetFunctorFactory().CreateFunctor( pfnProxied FUNC_FUNCTOR_CALL_ARGS_##N ) ); \
 		}
 
 //-------------------------------------
@@ -35,7 +40,7 @@
 	template <typename OBJECT_TYPE_PTR, typename FUNCTION_CLASS, typename FUNCTION_RETTYPE FUNC_TEMPLATE_FUNC_PARAMS_##N FUNC_TEMPLATE_ARG_PARAMS_##N> \
 	void QueueCall(OBJECT_TYPE_PTR pObject, FUNCTION_RETTYPE ( FUNCTION_CLASS::*pfnProxied )( FUNC_BASE_TEMPLATE_FUNC_PARAMS_##N ) FUNC_ARG_FORMAL_PARAMS_##N ) \
 		{ \
-		QueueFunctorInternal( CreateFunctor( pObject, pfnProxied FUNC_FUNCTOR_CALL_ARGS_##N ) ); \
+		QueueFunctorInternal( GetFunctorFactory().CreateFunctor( pObject, pfnProxied FUNC_FUNCTOR_CALL_ARGS_##N ) ); \
 		}
 
 //-------------------------------------
@@ -44,7 +49,7 @@
 	template <typename OBJECT_TYPE_PTR, typename FUNCTION_CLASS, typename FUNCTION_RETTYPE FUNC_TEMPLATE_FUNC_PARAMS_##N FUNC_TEMPLATE_ARG_PARAMS_##N> \
 	void QueueCall(OBJECT_TYPE_PTR pObject, FUNCTION_RETTYPE ( FUNCTION_CLASS::*pfnProxied )( FUNC_BASE_TEMPLATE_FUNC_PARAMS_##N ) const FUNC_ARG_FORMAL_PARAMS_##N ) \
 		{ \
-		QueueFunctorInternal( CreateFunctor( pObject, pfnProxied FUNC_FUNCTOR_CALL_ARGS_##N ) ); \
+		QueueFunctorInternal( GetFunctorFactory().CreateFunctor( pObject, pfnProxied FUNC_FUNCTOR_CALL_ARGS_##N ) ); \
 		}
 
 //-------------------------------------
@@ -53,7 +58,7 @@
 	template <typename OBJECT_TYPE_PTR, typename FUNCTION_CLASS, typename FUNCTION_RETTYPE FUNC_TEMPLATE_FUNC_PARAMS_##N FUNC_TEMPLATE_ARG_PARAMS_##N> \
 	void QueueRefCall(OBJECT_TYPE_PTR pObject, FUNCTION_RETTYPE ( FUNCTION_CLASS::*pfnProxied )( FUNC_BASE_TEMPLATE_FUNC_PARAMS_##N ) FUNC_ARG_FORMAL_PARAMS_##N ) \
 		{ \
-		QueueFunctorInternal( CreateRefCountingFunctor( pObject, pfnProxied FUNC_FUNCTOR_CALL_ARGS_##N ) ); \
+		QueueFunctorInternal( GetFunctorFactory().CreateRefCountingFunctor( pObject, pfnProxied FUNC_FUNCTOR_CALL_ARGS_##N ) ); \
 		}
 
 //-------------------------------------
@@ -62,7 +67,7 @@
 	template <typename OBJECT_TYPE_PTR, typename FUNCTION_CLASS, typename FUNCTION_RETTYPE FUNC_TEMPLATE_FUNC_PARAMS_##N FUNC_TEMPLATE_ARG_PARAMS_##N> \
 	void QueueRefCall(OBJECT_TYPE_PTR pObject, FUNCTION_RETTYPE ( FUNCTION_CLASS::*pfnProxied )( FUNC_BASE_TEMPLATE_FUNC_PARAMS_##N ) const FUNC_ARG_FORMAL_PARAMS_##N ) \
 		{ \
-		QueueFunctorInternal( CreateRefCountingFunctor( pObject, pfnProxied FUNC_FUNCTOR_CALL_ARGS_##N ) ); \
+		QueueFunctorInternal( GetFunctorFactory().CreateRefCountingFunctor( pObject, pfnProxied FUNC_FUNCTOR_CALL_ARGS_##N ) ); \
 		\
 		}
 
@@ -75,7 +80,10 @@
 
 //-----------------------------------------------------
 
-template <typename QUEUE_TYPE = CTSQueue<CFunctor *> >
+// Any number of threads may queue calls, but only one thread at a time may
+// call CallQueued(), WaitAndCallQueued() or Flush(). Functors are allocated
+// from a CFunctorArena rather than individually new'd.
+template <typename QUEUE_TYPE = CUnboundedMPSCQueue<CFunctor *> >
 class CCallQueueT
 {
 public:
@@ -117,22 +125,32 @@ public:
 			return;
 		}
 
+		// Calls queued after this point are left for the next time
 		m_queue.PushItem( NULL );
 
+		// Everything before the sentinel is on its way, but PopItem() may miss an item
+		// whose producer hasn't finished pushing it, so wait for each one
 		CFunctor *pFunctor;
-
-		while ( m_queue.PopItem( &pFunctor ) && pFunctor != NULL )
+		for ( ;; )
 		{
-#if IsDebug()
-			if ( pFunctor->m_nUserID == m_nBreakSerialNumber)
-			{
-				m_nBreakSerialNumber = (unsigned)-1;
-			}
-#endif
-			(*pFunctor)();
-			pFunctor->Release();
+			m_queue.WaitPopItem( &pFunctor );
+			if ( pFunctor == NULL )
+				break;
+			Call( pFunctor );
 		}
+	}
 
+	// Sleeps until at least one call is queued, then calls everything queued
+	void WaitAndCallQueued()
+	{
+		CFunctor *pFunctor;
+		do
+		{
+			m_queue.WaitPopItem( &pFunctor );
+		} while ( pFunctor == NULL );
+		Call( pFunctor );
+
+		CallQueued();
 	}
 
 	void QueueFunctor( CFunctor *pFunctor )
@@ -146,9 +164,11 @@ public:
 		m_queue.PushItem( NULL );
 
 		CFunctor *pFunctor;
-
-		while ( m_queue.PopItem( &pFunctor ) && pFunctor != NULL )
+		for ( ;; )
 		{
+			m_queue.WaitPopItem( &pFunctor );
+			if ( pFunctor == NULL )
+				break;
 			pFunctor->Release();
 		}
 	}
@@ -156,6 +176,23 @@ public:
 	FUNC_GENERATE_QUEUE_METHODS();
 
 private:
+	CFunctorArenaFactory &GetFunctorFactory()
+	{
+		return m_FunctorFactory;
+	}
+
+	void Call( CFunctor *pFunctor )
+	{
+#if IsDebug()
+		if ( pFunctor->m_nUserID == m_nBreakSerialNumber)
+		{
+			m_nBreakSerialNumber = (unsigned)-1;
+		}
+#endif
+		(*pFunctor)();
+		pFunctor->Release();
+	}
+
 	void QueueFunctorInternal( CFunctor *pFunctor )
 	{
 		if ( !m_bNoQueue )
@@ -173,9 +210,12 @@ private:
 	}
 
 	QUEUE_TYPE m_queue;
+	CFunctorArenaFactory m_FunctorFactory;
 	bool m_bNoQueue;
-	unsigned m_nCurSerialNumber;
+#if IsDebug()
+	std::atomic<unsigned> m_nCurSerialNumber;
 	unsigned m_nBreakSerialNumber;
+#endif
 };
 
 class CCallQueue : public CCallQueueT<>
@@ -197,6 +237,12 @@ public:
 	FUNC_GENERATE_QUEUE_METHODS();
 
 private:
+	// Implementations own their queue and its memory, so calls queued through here use the heap
+	static CDefaultFunctorFactory GetFunctorFactory()
+	{
+		return CDefaultFunctorFactory();
+	}
+
 	virtual void QueueFunctorInternal( CFunctor *pFunctor ) = 0;
 };
 
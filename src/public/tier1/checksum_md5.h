@@ -36,6 +36,10 @@ char* MD5_Print( unsigned char* digest, int hashlen );
 /// bothering with the context object.
 void MD5_ProcessSingleBuffer( const void* p, int len, MD5Value_t& md5Result );
 
+/// Calculates the MD5s of many buffers, hashing up to four of them at the same time.
+/// Gives the same results as calling `MD5_ProcessSingleBuffer()` on each.
+void MD5_ProcessBuffers( const void* const* ppBuffers, const int* pLengths, int nBuffers, MD5Value_t* pResults );
+
 unsigned int MD5_PseudoRandom( unsigned int nSeed );
 
 /// Returns true if the values match.
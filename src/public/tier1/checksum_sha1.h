@@ -85,10 +85,6 @@ public:
 private:
 	// Private SHA-1 transformation
 	void Transform( unsigned long state[ 5 ], unsigned char buffer[ 64 ] );
-
-	// Member variables
-	unsigned char m_workspace[ 64 ];
-	SHA1_WORKSPACE_BLOCK* m_block;// SHA1 pointer to the byte array above
 };
 
 #define GenerateHash( hash, pubData, cubData )   \
@@ -100,6 +96,9 @@ private:
 	}
 
 #if !defined( _MINIMUM_BUILD_ )
+	// Hashes many buffers, up to four of them at the same time; the digests are the same as CSHA1's
+	void SHA1_ProcessBuffers( const void* const* ppBuffers, const int* pLengths, int nBuffers, SHADigest_t* pDigests );
+
 	// hash comparison function, for use with CUtlMap/CUtlRBTree
 	bool HashLessFunc( SHADigest_t const& lhs, SHADigest_t const& rhs );
 
@@ -78,6 +78,7 @@ public:
 //-----------------------------------------------------------------------------
 class ConCommandBase {
 	friend class CCvar;
+	friend class CCVarSystem;
 	friend class ConVar;
 	friend class ConCommand;
 	friend void ConVar_Register( int nCVarFlag, IConCommandBaseAccessor* pAccessor );
@@ -288,6 +289,7 @@ private:
 //-----------------------------------------------------------------------------
 class ConVar : public ConCommandBase, public IConVar {
 	friend class CCvar;
+	friend class CCVarSystem;
 	friend class ConVarRef;
 
 public:
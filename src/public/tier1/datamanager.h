@@ -7,6 +7,7 @@
 #include "tier0/threadtools.h"
 #include "utlmultilist.h"
 #include "utlvector.h"
+#include <atomic>
 
 FORWARD_DECLARE_HANDLE( memhandle_t );
 
@@ -242,3 +243,216 @@ inline int CDataManagerBase::LockCount( memhandle_t handle ) {
 	Unlock();
 	return result;
 }
+
+
+//-----------------------------------------------------------------------------
+// Concurrent version of CDataManagerBase, for caches hit by many threads at once.
+// Resources are spread over shards, each with its own mutex and LRU list, so threads
+// working on different resources rarely meet; across shards the LRU is approximate.
+// Handles are 32 bits: shard, index in the shard and a serial to catch stale handles.
+// Locking an already locked resource, getting it and unlocking it (but for the last
+// unlock) don't take any mutex.
+//-----------------------------------------------------------------------------
+struct DataManagerShardStats_t {
+	uint32 m_nHits;
+	uint32 m_nMisses;  // lookups with a stale or bad handle
+	uint32 m_nEvictions;
+	uint32 m_nBytes;
+	int m_nResources;
+};
+
+class CDataManagerConcurrentBase {
+public:
+	static constexpr int NUM_SHARDS{ 16 };
+
+	void DestroyResource( memhandle_t handle );
+
+	int UnlockResource( memhandle_t handle );
+	void TouchResource( memhandle_t handle );
+	void MarkAsStale( memhandle_t handle );  // move to head of LRU
+
+	int LockCount( memhandle_t handle );
+	int BreakLock( memhandle_t handle );
+	int BreakAllLocks();
+
+	unsigned int TargetSize() const { return m_nTargetSize; }
+	unsigned int AvailableSize() const { return m_nTargetSize - m_nMemUsed; }
+	unsigned int UsedSize() const { return m_nMemUsed; }
+
+	void NotifySizeChanged( memhandle_t handle, unsigned int oldSize, unsigned int newSize );
+
+	void SetTargetSize( unsigned int targetSize ) { m_nTargetSize = targetSize; }
+
+	// NOTE: flush is equivalent to Destroy
+	unsigned int FlushAllUnlocked();
+	unsigned int FlushToTargetSize() { return EnsureCapacity( 0 ); }
+	unsigned int FlushAll();
+	unsigned int Purge( unsigned int nBytesToPurge );
+	// Evicts in batches, a shard at a time, the resources are destroyed outside its mutex
+	unsigned int EnsureCapacity( unsigned int size );
+
+	/**
+	 * When deferred, creating a resource never evicts: the owner calls `FlushToTargetSize()`
+	 * periodically instead (once a frame, from a job...), which keeps eviction off the lookup threads.
+	 */
+	void SetDeferredEviction( bool bDeferred ) { m_bDeferEviction = bDeferred; }
+
+	void GetShardStats( int nShard, DataManagerShardStats_t& stats ) const;
+	void ResetStats();
+
+	// Debugging only!!!!
+	void GetLRUHandleList( CUtlVector<memhandle_t>& list );
+	void GetLockHandleList( CUtlVector<memhandle_t>& list );
+protected:
+	explicit CDataManagerConcurrentBase( unsigned int maxSize );
+	virtual ~CDataManagerConcurrentBase();
+
+	// derived class must call these to implement public API
+	// the handle is reserved, but the resource isn't in the LRU until it gets stored
+	memhandle_t CreateHandle( bool bCreateLocked );
+	memhandle_t StoreResourceInHandle( memhandle_t handle, void* pStore, unsigned int realSize );
+	void* GetResource_NoLock( memhandle_t handle );
+	void* GetResource_NoLockNoLRUTouch( memhandle_t handle );
+	void* LockResource( memhandle_t handle );
+
+	// NOTE: you must call this from the destructor of the derived class! (will assert otherwise)
+	void FreeAllLists() {
+		FlushAll();
+		m_bListsAreFreed = true;
+	}
+
+	[[nodiscard]]
+	bool IsEvictionDeferred() const { return m_bDeferEviction; }
+
+	// Implemented by derived class:
+	virtual void DestroyResourceStorage( void* ) = 0;
+private:
+	static constexpr int SHARD_BITS{ 4 };
+	static constexpr int INDEX_BITS{ 16 };
+	static constexpr int SERIAL_BITS{ 32 - SHARD_BITS - INDEX_BITS };
+	static constexpr uint32 SERIAL_MASK{ ( 1u << SERIAL_BITS ) - 1 };
+	static constexpr int LOCK_BITS{ 32 - SERIAL_BITS };
+	static constexpr uint32 LOCK_MASK{ ( 1u << LOCK_BITS ) - 1 };
+	static constexpr uint16 INVALID_INDEX{ 0xFFFF };
+	static constexpr int BLOCK_BITS{ 8 };
+	static constexpr int BLOCK_SIZE{ 1 << BLOCK_BITS };
+	static constexpr int EVICTION_BATCH{ 32 };
+	static_assert( NUM_SHARDS == 1 << SHARD_BITS );
+
+	enum EList : uint8 { LIST_NONE, LIST_LRU, LIST_LOCKED, LIST_FREE, LIST_COUNT };
+
+	/**
+	 * Elements live in fixed blocks which never move, so they can be read without the shard's mutex.
+	 * The state is changed with atomics; the serial and lock count going to or from 0 only under the mutex.
+	 */
+	struct Element_t {
+		std::atomic<uint32> m_nState{ 1u << LOCK_BITS };  // serial << LOCK_BITS | lock count
+		std::atomic<void*> m_pStore{ nullptr };
+		unsigned int m_nSize{ 0 };  // as stored, plus the notified changes
+		uint16 m_nPrev{ INVALID_INDEX };
+		uint16 m_nNext{ INVALID_INDEX };
+		EList m_nList{ LIST_NONE };
+	};
+	struct List_t {
+		uint16 m_nHead{ INVALID_INDEX };  // least recently used
+		uint16 m_nTail{ INVALID_INDEX };
+		int m_nCount{ 0 };
+	};
+	struct alignas( 64 ) Shard_t {
+		CThreadFastMutex m_Mutex{};
+		std::atomic<Element_t*> m_pBlocks[ ( 1 << INDEX_BITS ) / BLOCK_SIZE ]{};
+		int m_nElements{ 0 };
+		List_t m_Lists[ LIST_COUNT ]{};
+
+		std::atomic<uint32> m_nHits{ 0 };
+		std::atomic<uint32> m_nMisses{ 0 };
+		std::atomic<uint32> m_nEvictions{ 0 };
+		std::atomic<uint32> m_nBytes{ 0 };
+	};
+
+	static uint32 ToBits( memhandle_t handle ) { return static_cast<uint32>( reinterpret_cast<uintp>( handle ) ); }
+	static memhandle_t ToHandle( int nShard, uint16 index, uint32 nSerial );
+	static uint16 IndexOf( uint32 nBits ) { return ( nBits >> SHARD_BITS ) & INVALID_INDEX; }
+	static uint32 SerialOf( uint32 nBits ) { return nBits >> ( SHARD_BITS + INDEX_BITS ); }
+	static Element_t& At( Shard_t& shard, uint16 index ) { return shard.m_pBlocks[ index >> BLOCK_BITS ].load( std::memory_order_relaxed )[ index & ( BLOCK_SIZE - 1 ) ]; }
+
+	Shard_t& ShardOf( uint32 nBits ) { return m_Shards[ nBits & ( NUM_SHARDS - 1 ) ]; }
+	// The element a handle points to, without taking the mutex; the serial still has to be checked
+	Element_t* Resolve( Shard_t& shard, uint32 nBits );
+
+	// Must hold the shard's mutex
+	static void Link( Shard_t& shard, EList list, uint16 index, bool bToHead = false );
+	static void Unlink( Shard_t& shard, uint16 index );
+	void* FreeElement( Shard_t& shard, uint16 index );
+	int FlushList( Shard_t& shard, EList list, CUtlVector<void*>& destroyList );
+	void DestroyAll( const CUtlVector<void*>& destroyList );
+private:
+	Shard_t m_Shards[ NUM_SHARDS ];
+	std::atomic<uint32> m_nNextShard{ 0 };
+	std::atomic<uint32> m_nEvictionCursor{ 0 };
+	std::atomic<uint32> m_nMemUsed{ 0 };
+	std::atomic<uint32> m_nTargetSize;
+	bool m_bDeferEviction{ false };
+	bool m_bListsAreFreed{ false };
+};
+
+template<class STORAGE_TYPE, class CREATE_PARAMS, class LOCK_TYPE = STORAGE_TYPE*>
+class CDataManagerConcurrent : public CDataManagerConcurrentBase {
+	typedef CDataManagerConcurrentBase BaseClass;
+public:
+	explicit CDataManagerConcurrent( unsigned int size = (unsigned) -1 ) : BaseClass( size ) {}
+
+	~CDataManagerConcurrent() {
+		// NOTE: This must be called in all implementations of CDataManagerConcurrent
+		FreeAllLists();
+	}
+
+	// Use GetData() to translate pointer to LOCK_TYPE
+	LOCK_TYPE LockResource( memhandle_t hMem ) {
+		void* pLock = BaseClass::LockResource( hMem );
+		if ( pLock ) {
+			return StoragePointer( pLock )->GetData();
+		}
+		return nullptr;
+	}
+
+	// Use GetData() to translate pointer to LOCK_TYPE
+	LOCK_TYPE GetResource_NoLock( memhandle_t hMem ) {
+		void* pLock = BaseClass::GetResource_NoLock( hMem );
+		if ( pLock ) {
+			return StoragePointer( pLock )->GetData();
+		}
+		return nullptr;
+	}
+
+	// Use GetData() to translate pointer to LOCK_TYPE
+	// Doesn't touch the memory LRU
+	LOCK_TYPE GetResource_NoLockNoLRUTouch( memhandle_t hMem ) {
+		void* pLock = BaseClass::GetResource_NoLockNoLRUTouch( hMem );
+		if ( pLock ) {
+			return StoragePointer( pLock )->GetData();
+		}
+		return nullptr;
+	}
+
+	// Wrapper to match implementation of allocation with typed storage & alloc params.
+	memhandle_t CreateResource( const CREATE_PARAMS& createParams, bool bCreateLocked = false ) {
+		if (! BaseClass::IsEvictionDeferred() ) {
+			BaseClass::EnsureCapacity( STORAGE_TYPE::EstimatedSize( createParams ) );
+		}
+		memhandle_t handle = BaseClass::CreateHandle( bCreateLocked );
+		if ( handle == INVALID_MEMHANDLE ) {
+			return INVALID_MEMHANDLE;
+		}
+		STORAGE_TYPE* pStore = STORAGE_TYPE::CreateResource( createParams );
+		return BaseClass::StoreResourceInHandle( handle, pStore, pStore->Size() );
+	}
+private:
+	STORAGE_TYPE* StoragePointer( void* pMem ) {
+		return static_cast<STORAGE_TYPE*>( pMem );
+	}
+
+	void DestroyResourceStorage( void* pStore ) override {
+		StoragePointer( pStore )->DestroyResource();
+	}
+};
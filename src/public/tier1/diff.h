@@ -7,8 +7,12 @@
 // Serialization/unserialization buffer
 //=============================================================================//
 #pragma once
+#include "tier1/utlvector.h"
 #include <cinttypes>
 
+
+class CUtlBuffer;
+
 int FindDiffs( uint8_t const* NewBlock, uint8_t const* OldBlock,
 			   int NewSize, int OldSize, int& DiffListSize, uint8_t* Output, uint32_t OutSize );
 
@@ -22,3 +26,60 @@ void ApplyDiffs( uint8_t const* OldBlock, uint8_t const* DiffList,
 
 int FindDiffsLowMemory( uint8_t const* NewBlock, uint8_t const* OldBlock,
 						int NewSize, int OldSize, int& DiffListSize, uint8_t* Output, uint32_t OutSize );
+
+// Applies a diff made by CDeltaEncoder::FORMAT_COMPACT, returns false if it's malformed or doesn't fit
+bool ApplyDiffsCompact( uint8_t const* OldBlock, uint8_t const* DiffList,
+						int OldSize, int DiffListSize, int& ResultListSize, uint8_t* Output, uint32_t OutSize );
+
+
+//-----------------------------------------------------------------------------
+// Delta encoder which indexes the old data with a rolling hash over blocks,
+// and can be fed the new data a piece at a time. The FindDiffs functions use it.
+//-----------------------------------------------------------------------------
+class CDeltaEncoder {
+public:
+	enum Format_t {
+		FORMAT_LEGACY,   // read by ApplyDiffs
+		FORMAT_COMPACT,  // varint lengths and offsets, read by ApplyDiffsCompact
+	};
+
+	/**
+	 * Matches at least twice the block size long are always found, shorter ones only when they're where an edit in place would put them.
+	 * The index of the old data is kept under nMaxIndexBytes, by sampling it more sparsely.
+	 */
+	explicit CDeltaEncoder( Format_t format = FORMAT_LEGACY, int nBlockSize = 16, int nMaxIndexBytes = 4 * 1024 * 1024 );
+
+	// Indexes the old data, which must stay valid until `Finish()`; starts a new diff
+	void SetSource( uint8_t const* pOld, int nOldSize );
+	// Diffs the next piece of the new data, appending what's done to the output
+	void Encode( uint8_t const* pNew, int nNewSize, CUtlBuffer& out );
+	// Flushes what's pending, returns whether the new data differs from the old one
+	bool Finish( CUtlBuffer& out );
+private:
+	// Longest match for the window at pNew, by looking it up in the index
+	int FindMatch( uint8_t const* pNew, int nAvailable, uint32_t hash, int& nOldStart, int& nBackward ) const;
+	// Whether a copy is worth it, compared to leaving the bytes as literals
+	bool IsWorthCopying( int nOldStart, int nLength ) const;
+
+	void FlushLiterals( CUtlBuffer& out );
+	void FlushCopy( CUtlBuffer& out );
+	void EmitCopy( CUtlBuffer& out, int nOffset, int nLength );
+
+	Format_t m_Format;
+	int m_nBlockSize;
+	int m_nMaxIndexEntries;
+	uint32_t m_nHashOutFactor;  // multiplier of the byte leaving the window
+
+	uint8_t const* m_pOld{ nullptr };
+	int m_nOldSize{ 0 };
+	CUtlVector<uint32_t> m_Index;  // old offset + 1 of the sampled blocks, by hash
+	int m_nIndexShift{ 32 };
+
+	CUtlVector<uint8_t> m_Literals;
+	int m_nLiteralsSinceCopy{ 0 };
+	int m_nCopyStart{ 0 };  // of the pending copy, in the old data
+	int m_nCopyLength{ 0 };
+	int m_nCopySource{ 0 };  // where the applier's copy position is
+	int m_nNewSize{ 0 };
+	bool m_bDifferent{ false };
+};
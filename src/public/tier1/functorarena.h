@@ -0,0 +1,56 @@
+//
+// Created by ENDERZOMBI102 on 18/10/2026.
+//
+// Purpose: Memory for functors created and released at a high rate, like queued calls.
+//          Functors come from a few size classes of magazine pools, so creating one is
+//          a pop from the calling thread's magazine instead of a trip to the heap.
+//          Functors too big for the biggest class still go to the heap.
+//
+#pragma once
+#include "tier1/functors.h"
+#include "tier1/mempool.h"
+#include <atomic>
+
+
+class CFunctorArena {
+public:
+	CFunctorArena();
+	~CFunctorArena();
+	CFunctorArena( const CFunctorArena& ) = delete;
+	CFunctorArena& operator=( const CFunctorArena& ) = delete;
+
+	// Shared by the call queues of this module
+	static CFunctorArena& GetDefault();
+
+	void* Alloc( size_t nBytes );
+	// Frees memory of any arena
+	static void Free( void* pMem );
+private:
+	// In front of every allocation, so `Free()` knows where it came from
+	struct alignas( 16 ) Header_t {
+		CMemoryPoolMagazineMT* m_pPool;  // nullptr for the heap
+	};
+
+	static constexpr int NUM_SIZE_CLASSES{ 4 };
+	static constexpr int SIZE_CLASSES[ NUM_SIZE_CLASSES ]{ 64, 128, 256, 512 };  // with the header
+
+	CMemoryPoolMagazineMT* m_pPools[ NUM_SIZE_CLASSES ];
+};
+
+
+// Base of the functors made by a `CFunctorArenaFactory`, which give their memory back to the arena
+class CArenaFunctorBase : public CFunctor {
+public:
+	int AddRef() override { return m_nRefs.fetch_add( 1, std::memory_order_relaxed ) + 1; }
+	int Release() override;
+private:
+	std::atomic<int> m_nRefs{ 1 };
+};
+
+// Has the same `CreateFunctor()`/`CreateRefCountingFunctor()` as `CDefaultFunctorFactory`
+class CFunctorArenaFactory : public CCustomizedFunctorFactory<CFunctorArena, CArenaFunctorBase> {
+public:
+	explicit CFunctorArenaFactory( CFunctorArena& arena = CFunctorArena::GetDefault() ) {
+		SetAllocator( &arena );
+	}
+};
@@ -102,3 +102,39 @@ uint32 MurmurHash2( const void* key, int32 len, uint32 seed );
 uint32 MurmurHash2LowerCase( char const* pString, uint32 nSeed );
 
 uint64 MurmurHash64( const void* key, int32 len, uint32 seed );
+
+//-----------------------------------------------------------------------------
+// xxHash3, 64 bit. Matches the reference XXH3_64bits_withSeed() output.
+//-----------------------------------------------------------------------------
+uint64 XXHash3_64( const void* key, int32 len, uint64 seed = 0 );
+
+// Streaming version, for data which comes in pieces; the digest is the same as hashing it all at once
+class CXXHash3Stream {
+public:
+	explicit CXXHash3Stream( uint64 seed = 0 ) { Reset( seed ); }
+
+	void Reset( uint64 seed = 0 );
+	void Update( const void* pData, int32 len );
+	[[nodiscard]]
+	uint64 Digest() const;
+private:
+	void ConsumeStripes( const uint8* pData, int32 nStripes );
+
+	alignas( 16 ) uint64 m_Acc[ 8 ];
+	uint8 m_Secret[ 192 ];
+	uint8 m_Buffer[ 256 ];
+	uint8 m_LastStripe[ 64 ];  // the end of the data consumed so far, the final stripe may need it
+	int32 m_nBuffered;
+	int32 m_nStripesInBlock;
+	uint64 m_nTotalLen;
+	uint64 m_nSeed;
+};
+
+// Hashes the bytes of the item, for the hash containers
+template<typename T>
+struct XXHash3HashFunctor {
+	unsigned int operator()( const T& item ) const { return static_cast<uint32>( XXHash3_64( &item, sizeof( item ) ) ); }
+};
+struct XXHash3StringHashFunctor {
+	unsigned int operator()( const char* pszKey ) const;
+};
@@ -19,6 +19,10 @@ public:
 	bool WriteAsBinary( KeyValues* pNode, CUtlBuffer& buffer );
 	bool ReadAsBinary( KeyValues* pNode, CUtlBuffer& buffer );
 
+	// Flat format, see `CKeyValuesView`. `pNode` and its peers are the top level keys.
+	bool WriteAsFlat( KeyValues* pNode, CUtlBuffer& buffer );
+	bool ReadAsFlat( KeyValues* pNode, const void* pData, int nSize );
+
 private:
 	// These types are used for serialization of KeyValues nodes.
 	// Do not renumber them or you will break serialization across
@@ -35,3 +39,96 @@ private:
 		PACKTYPE_NULLMARKER,// used to mark the end of a block in the binary format
 	};
 };
+
+
+//-----------------------------------------------------------------------------
+// Purpose: Flat binary KeyValues, which can be queried in place (e.g. straight
+//			from a memory mapped file) without building a tree of KeyValues.
+//
+//			Layout: header, nodes, sorted child indices, string blob.
+//			Node 0 is an unnamed root holding the top level keys. The children
+//			of a key are contiguous and in file order, while a second list of
+//			their indices, sorted by name, is used by `FindKey()`.
+//			Names and values are offsets in the blob, which is shared: equal
+//			strings are stored once. Numbers also get their text form stored,
+//			so `GetString()` never needs to convert.
+//-----------------------------------------------------------------------------
+struct KVFlatHeader_t {
+	uint32 m_nMagic;
+	uint32 m_nVersion;
+	uint32 m_nSize;  // of the whole thing, header included
+	uint32 m_nNodeCount;
+	uint32 m_nNodesOffset;
+	uint32 m_nIndexOffset;
+	uint32 m_nIndexCount;
+	uint32 m_nBlobOffset;
+	uint32 m_nBlobSize;
+};
+
+struct KVFlatNode_t {
+	uint32 m_nName;  // blob offset
+	uint8 m_nType;   // KeyValues::types_t
+	uint8 m_nFlags;
+	uint16 m_nUnused;
+	uint32 m_nValue;   // first child, int, float or color bits, blob offset of an uint64
+	uint32 m_nString;  // index offset of the sorted children (count first), or blob offset of the value's text
+};
+
+#define KVFLAT_MAGIC			0x3146564B	// "KVF1"
+#define KVFLAT_VERSION			1
+#define KVFLAT_NODE_LAST_CHILD	0x01
+
+
+class CKeyValuesView {
+public:
+	CKeyValuesView() = default;
+
+	/**
+	 * Checks the buffer is a well-formed flat KeyValues, and returns a view of its first top level key.
+	 * The buffer must be 4-byte aligned and outlive the views, nothing is copied.
+	 * Returns an invalid view if the buffer is not well-formed, or has no keys.
+	 */
+	static CKeyValuesView FromBuffer( const void* pData, int nSize );
+
+	[[nodiscard]]
+	bool IsValid() const { return m_pHeader != nullptr; }
+
+	[[nodiscard]]
+	const char* GetName() const;
+	[[nodiscard]]
+	KeyValues::types_t GetDataType() const;
+
+	// Finds a key by (case-insensitive) name, "a/b/c" paths are supported as with `KeyValues::FindKey()`
+	[[nodiscard]]
+	CKeyValuesView FindKey( const char* keyName ) const;
+	[[nodiscard]]
+	CKeyValuesView GetFirstSubKey() const;
+	[[nodiscard]]
+	CKeyValuesView GetNextKey() const;
+	[[nodiscard]]
+	int GetSubKeyCount() const;
+
+	// Same conversions as KeyValues, but these never modify anything
+	int GetInt( const char* keyName = nullptr, int defaultValue = 0 ) const;
+	uint64 GetUint64( const char* keyName = nullptr, uint64 defaultValue = 0 ) const;
+	float GetFloat( const char* keyName = nullptr, float defaultValue = 0.0f ) const;
+	const char* GetString( const char* keyName = nullptr, const char* defaultValue = "" ) const;
+	bool GetBool( const char* keyName = nullptr, bool defaultValue = false ) const { return GetInt( keyName, defaultValue ? 1 : 0 ) != 0; }
+	Color GetColor( const char* keyName = nullptr ) const;
+	bool IsEmpty( const char* keyName = nullptr ) const;
+private:
+	CKeyValuesView( const KVFlatHeader_t* pHeader, uint32 nNode ) : m_pHeader( pHeader ), m_nNode( nNode ) { }
+
+	[[nodiscard]]
+	const KVFlatNode_t& Node( uint32 nNode ) const;
+	[[nodiscard]]
+	const char* String( uint32 nOffset ) const;
+	[[nodiscard]]
+	const uint32* Index( uint32 nOffset ) const;
+	// Child named `pName[0..nLength)`, or an invalid view
+	[[nodiscard]]
+	CKeyValuesView FindSubKey( const char* pName, int nLength ) const;
+private:
+	const KVFlatHeader_t* m_pHeader{ nullptr };
+	uint32 m_nNode{ 0 };
+};
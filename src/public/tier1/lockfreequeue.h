@@ -0,0 +1,295 @@
+//
+// Created by ENDERZOMBI102 on 18/10/2026.
+//
+// Purpose: Lock-free queues for handing work between threads.
+//          - `CBoundedMPMCQueue`/`CBoundedMPSCQueue`: a fixed ring of cells, each with a sequence
+//            number telling producers and consumers whose turn it is (Vyukov's bounded queue).
+//            Single consumer pops are a load and a store, no compare-exchange.
+//          - `CUnboundedMPSCQueue`: a linked list where producers only swap the tail, so a push
+//            is one atomic exchange no matter how many threads are pushing (Vyukov's MPSC queue).
+//            Nodes come from a per-thread magazine pool, not from the heap.
+//          Consumers can block with `WaitPopItem()`, which sleeps on an address (futex on Linux,
+//          WaitOnAddress on Windows) and costs producers nothing while nobody waits.
+//          For an unbounded queue with many consumers, use tier0's `CTSQueue`.
+//
+#pragma once
+#include "tier0/dbg.h"
+#include "tier0/threadtools.h"
+#include "tier1/mempool.h"
+#include <atomic>
+#include <new>
+#include <utility>
+
+
+// Wakes consumers sleeping on an empty queue
+class CQueueWaiter {
+public:
+	// Call after making an item available
+	void Notify() {
+		// pairs with the fence in `Wait()`: either the waiter sees the item, or we see the waiter
+		std::atomic_thread_fence( std::memory_order_seq_cst );
+		if ( m_nWaiters.load( std::memory_order_relaxed ) ) {
+			m_nEpoch.fetch_add( 1, std::memory_order_release );
+			m_nEpoch.notify_one();
+		}
+	}
+	void NotifyAll() {
+		std::atomic_thread_fence( std::memory_order_seq_cst );
+		if ( m_nWaiters.load( std::memory_order_relaxed ) ) {
+			m_nEpoch.fetch_add( 1, std::memory_order_release );
+			m_nEpoch.notify_all();
+		}
+	}
+
+	// Calls `tryPop()` until it succeeds, spinning for a bit before going to sleep
+	template<typename F>
+	void Wait( F&& tryPop ) {
+		for ( auto i{ 0 }; i < SPIN_COUNT; i += 1 ) {
+			if ( tryPop() ) {
+				return;
+			}
+			ThreadPause();
+		}
+
+		while ( true ) {
+			const auto nEpoch{ m_nEpoch.load( std::memory_order_acquire ) };
+			m_nWaiters.fetch_add( 1, std::memory_order_relaxed );
+			std::atomic_thread_fence( std::memory_order_seq_cst );
+			if ( tryPop() ) {
+				m_nWaiters.fetch_sub( 1, std::memory_order_relaxed );
+				return;
+			}
+			m_nEpoch.wait( nEpoch, std::memory_order_acquire );
+			m_nWaiters.fetch_sub( 1, std::memory_order_relaxed );
+			if ( tryPop() ) {
+				return;
+			}
+		}
+	}
+private:
+	static constexpr int SPIN_COUNT{ 64 };
+
+	std::atomic<uint32> m_nEpoch{ 0 };
+	std::atomic<uint32> m_nWaiters{ 0 };
+};
+
+
+template<typename T, bool MULTI_CONSUMER>
+class CBoundedQueueT {
+public:
+	// Rounded up to a power of two
+	explicit CBoundedQueueT( int nCapacity ) {
+		Assert( nCapacity > 0 and nCapacity <= ( 1 << 30 ) );
+		auto nCells{ 2u };
+		while ( nCells < static_cast<uint32>( nCapacity ) ) {
+			nCells *= 2;
+		}
+		m_nMask = nCells - 1;
+		m_pCells = new Cell_t[ nCells ];
+		for ( auto i{ 0u }; i < nCells; i += 1 ) {
+			m_pCells[ i ].m_nSequence.store( i, std::memory_order_relaxed );
+		}
+	}
+	~CBoundedQueueT() { delete[] m_pCells; }
+	CBoundedQueueT( const CBoundedQueueT& ) = delete;
+	CBoundedQueueT& operator=( const CBoundedQueueT& ) = delete;
+
+	// Returns false if the queue is full
+	bool TryPushItem( const T& item ) {
+		auto nPos{ m_nEnqueuePos.load( std::memory_order_relaxed ) };
+		Cell_t* pCell;
+		while ( true ) {
+			pCell = &m_pCells[ nPos & m_nMask ];
+			const auto nDiff{ static_cast<int32>( pCell->m_nSequence.load( std::memory_order_acquire ) - nPos ) };
+			if ( nDiff == 0 ) {
+				if ( m_nEnqueuePos.compare_exchange_weak( nPos, nPos + 1, std::memory_order_relaxed ) ) {
+					break;
+				}
+			} else if ( nDiff < 0 ) {
+				return false;
+			} else {
+				nPos = m_nEnqueuePos.load( std::memory_order_relaxed );
+			}
+		}
+
+		pCell->m_Value = item;
+		pCell->m_nSequence.store( nPos + 1, std::memory_order_release );
+		m_Waiter.Notify();
+		return true;
+	}
+	// Waits for room if the queue is full
+	void PushItem( const T& item ) {
+		for ( auto nTries{ 0 }; not TryPushItem( item ); nTries += 1 ) {
+			if ( nTries < 64 ) {
+				ThreadPause();
+			} else {
+				ThreadSleep( 0 );
+			}
+		}
+	}
+
+	bool PopItem( T* pResult ) {
+		auto nPos{ m_nDequeuePos.load( std::memory_order_relaxed ) };
+		Cell_t* pCell;
+		while ( true ) {
+			pCell = &m_pCells[ nPos & m_nMask ];
+			const auto nDiff{ static_cast<int32>( pCell->m_nSequence.load( std::memory_order_acquire ) - ( nPos + 1 ) ) };
+			if ( nDiff < 0 ) {
+				return false;
+			}
+			if constexpr ( MULTI_CONSUMER ) {
+				if ( nDiff == 0 and m_nDequeuePos.compare_exchange_weak( nPos, nPos + 1, std::memory_order_relaxed ) ) {
+					break;
+				}
+				if ( nDiff > 0 ) {
+					nPos = m_nDequeuePos.load( std::memory_order_relaxed );
+				}
+			} else {
+				Assert( nDiff == 0 );
+				m_nDequeuePos.store( nPos + 1, std::memory_order_relaxed );
+				break;
+			}
+		}
+
+		*pResult = std::move( pCell->m_Value );
+		pCell->m_nSequence.store( nPos + m_nMask + 1, std::memory_order_release );
+		return true;
+	}
+	// Pops up to nMax items, returns how many
+	int PopItems( T* pResults, int nMax ) {
+		auto nCount{ 0 };
+		while ( nCount < nMax and PopItem( &pResults[ nCount ] ) ) {
+			nCount += 1;
+		}
+		return nCount;
+	}
+	// Blocks until there's an item
+	void WaitPopItem( T* pResult ) {
+		m_Waiter.Wait( [ & ] { return PopItem( pResult ); } );
+	}
+
+	// Only exact when no other thread is using the queue
+	[[nodiscard]]
+	int Count() const {
+		return static_cast<int32>( m_nEnqueuePos.load( std::memory_order_acquire ) - m_nDequeuePos.load( std::memory_order_acquire ) );
+	}
+	[[nodiscard]]
+	int Capacity() const { return static_cast<int>( m_nMask + 1 ); }
+private:
+	struct Cell_t {
+		std::atomic<uint32> m_nSequence;
+		T m_Value;
+	};
+
+	Cell_t* m_pCells;
+	uint32 m_nMask;
+	// each end on its own cache line, so producers and consumers don't fight over it
+	alignas( 64 ) std::atomic<uint32> m_nEnqueuePos{ 0 };
+	alignas( 64 ) std::atomic<uint32> m_nDequeuePos{ 0 };
+	alignas( 64 ) CQueueWaiter m_Waiter;
+};
+
+template<typename T>
+using CBoundedMPMCQueue = CBoundedQueueT<T, true>;
+template<typename T>
+using CBoundedMPSCQueue = CBoundedQueueT<T, false>;
+
+
+/**
+ * Any number of threads can push, only one may pop at a time.
+ * Items pushed by the same thread come out in the order they were pushed.
+ */
+template<typename T>
+class CUnboundedMPSCQueue {
+public:
+	CUnboundedMPSCQueue() : m_Nodes( NodePool() ) {
+		const auto pStub{ AllocNode() };
+		m_pHead = pStub;
+		m_pTail.store( pStub, std::memory_order_relaxed );
+	}
+	~CUnboundedMPSCQueue() {
+		T item;
+		while ( PopItem( &item ) ) { }
+		FreeNode( m_pHead );
+	}
+	CUnboundedMPSCQueue( const CUnboundedMPSCQueue& ) = delete;
+	CUnboundedMPSCQueue& operator=( const CUnboundedMPSCQueue& ) = delete;
+
+	void PushItem( const T& item ) {
+		const auto pNode{ AllocNode() };
+		pNode->m_Value = item;
+		m_nCount.fetch_add( 1, std::memory_order_relaxed );
+		const auto pPrev{ m_pTail.exchange( pNode, std::memory_order_acq_rel ) };
+		// until this store the node is invisible to the consumer, which waits for it in `PopItem()`
+		pPrev->m_pNext.store( pNode, std::memory_order_release );
+		m_Waiter.Notify();
+	}
+
+	// Consumer only: false when empty, or when the next item's producer is still linking it in
+	bool PopItem( T* pResult ) {
+		const auto pHead{ m_pHead };
+		auto pNext{ pHead->m_pNext.load( std::memory_order_acquire ) };
+		if ( pNext == nullptr ) {
+			if ( m_pTail.load( std::memory_order_acquire ) == pHead ) {
+				return false;
+			}
+			// a producer swapped the tail but didn't link its node yet, it's usually a few instructions away;
+			// if it got preempted there, the queue counts as empty until it runs again and notifies
+			for ( auto i{ 0 }; ( pNext = pHead->m_pNext.load( std::memory_order_acquire ) ) == nullptr; i += 1 ) {
+				if ( i == LINK_SPINS ) {
+					return false;
+				}
+				ThreadPause();
+			}
+		}
+
+		// the next node becomes the stub, its value is moved out now
+		*pResult = std::move( pNext->m_Value );
+		m_pHead = pNext;
+		m_nCount.fetch_sub( 1, std::memory_order_relaxed );
+		FreeNode( pHead );
+		return true;
+	}
+	// Consumer only: pops up to nMax items, returns how many
+	int PopItems( T* pResults, int nMax ) {
+		auto nCount{ 0 };
+		while ( nCount < nMax and PopItem( &pResults[ nCount ] ) ) {
+			nCount += 1;
+		}
+		return nCount;
+	}
+	// Consumer only: blocks until there's an item
+	void WaitPopItem( T* pResult ) {
+		m_Waiter.Wait( [ & ] { return PopItem( pResult ); } );
+	}
+
+	[[nodiscard]]
+	int Count() const { return m_nCount.load( std::memory_order_relaxed ); }
+	// Consumer only
+	[[nodiscard]]
+	bool IsEmpty() const { return m_pHead->m_pNext.load( std::memory_order_acquire ) == nullptr and m_pTail.load( std::memory_order_acquire ) == m_pHead; }
+private:
+	static constexpr int LINK_SPINS{ 64 };
+
+	struct Node_t {
+		std::atomic<Node_t*> m_pNext{ nullptr };
+		T m_Value{};
+	};
+
+	// Shared by all the queues of this type, a magazine pool per queue would run out of pool slots
+	static CMemoryPoolMagazineMT& NodePool() {
+		static CMemoryPoolMagazineMT s_Pool{ sizeof( Node_t ), 256, UTLMEMORYPOOL_GROW_FAST, "CUnboundedMPSCQueue", alignof( Node_t ) };
+		return s_Pool;
+	}
+	Node_t* AllocNode() { return ::new( m_Nodes.Alloc() ) Node_t; }
+	void FreeNode( Node_t* pNode ) {
+		pNode->~Node_t();
+		m_Nodes.Free( pNode );
+	}
+
+	CMemoryPoolMagazineMT& m_Nodes;  // also keeps the pool alive for as long as static queues are
+	alignas( 64 ) std::atomic<Node_t*> m_pTail;
+	std::atomic<int> m_nCount{ 0 };
+	alignas( 64 ) Node_t* m_pHead;
+	alignas( 64 ) CQueueWaiter m_Waiter;
+};
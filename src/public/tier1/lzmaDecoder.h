@@ -11,6 +11,7 @@
 #ifndef _LZMADECODER_H
 #define _LZMADECODER_H
 #pragma once
+#include <stddef.h>
 
 // Thanks for the useful define namespacing, LZMA
 #include "../../utils/lzma/C/7zVersion.h"
@@ -18,6 +19,7 @@
 #define LZMA_SDK_VERSION_MINOR MY_VER_MINOR
 
 #define LZMA_ID				(('A'<<24)|('M'<<16)|('Z'<<8)|('L'))
+#define LZMA_BLOCKS_ID		(('B'<<24)|('M'<<16)|('Z'<<8)|('L'))
 
 // bind the buffer for correct identification
 #pragma pack(1)
@@ -27,6 +29,16 @@ struct LzmaHeader {
 	unsigned int	lzmaSize;		// always little endian
 	unsigned char	properties[5];
 };
+
+// Container of independently compressed blocks, so they can be decoded in parallel.
+// It's followed by blockCount + 1 offsets of the blocks from the start of the header, the last one is the end
+// of the data. Each block is either a regular LzmaHeader stream, or stored as is when its size is blockSize.
+struct LzmaBlocksHeader {
+	unsigned int	id;
+	unsigned int	actualSize;		// always little endian
+	unsigned int	blockSize;		// uncompressed size of every block but the last, always little endian
+	unsigned int	blockCount;		// always little endian
+};
 #pragma pack()
 
 class CLZMAStream;
@@ -34,11 +46,44 @@ class CLZMAStream;
 class CLZMA
 {
 public:
+	// Block containers are decoded on the thread pool
 	static unsigned int	Uncompress( unsigned char *pInput, unsigned char *pOutput );
 	static bool			IsCompressed( unsigned char *pInput );
+	static bool			IsBlockCompressed( unsigned char *pInput );
 	static unsigned int	GetActualSize( unsigned char *pInput );
 };
 
+//-----------------------------------------------------------------------------
+// Decoder state kept between calls, so decoding a buffer doesn't allocate.
+// Not thread safe, CLZMA::Uncompress uses one per thread.
+//-----------------------------------------------------------------------------
+class CLZMADecoder
+{
+public:
+	CLZMADecoder();
+	~CLZMADecoder();
+
+	// Decodes a single stream with a source-engine style header, returns the uncompressed size or 0 on failure
+	unsigned int Uncompress( unsigned char *pInput, unsigned char *pOutput );
+	// Decodes raw lzma data, nOutputSize must be the exact uncompressed size
+	bool Decode( const unsigned char *pProperties, const unsigned char *pInput, unsigned int nInputSize,
+	             unsigned char *pOutput, unsigned int nOutputSize );
+
+	// The calling thread's decoder
+	static CLZMADecoder &ThreadDecoder();
+
+private:
+	CLZMADecoder( const CLZMADecoder & );
+	CLZMADecoder &operator=( const CLZMADecoder & );
+
+	// Allocator callbacks, the probabilities go in the state's arena when they fit
+	static void *ArenaAlloc( void *p, size_t size );
+	static void ArenaFree( void *p, void *address );
+
+	struct DecoderState_t;
+	DecoderState_t *m_pState;
+};
+
 // For files besides the implementation, we forward declare a dummy struct. We can't unconditionally forward declare
 // this because LzmaEnc.h typedefs this directly to an unnamed struct :-/
 #ifndef CLzmaDec_t
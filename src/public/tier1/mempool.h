@@ -16,6 +16,7 @@
 #include "tier0/tslist.h"
 #include "tier1/utlrbtree.h"
 #include "tier1/utlvector.h"
+#include <atomic>
 
 //-----------------------------------------------------------------------------
 // Purpose: Optimized pool memory allocator
@@ -134,6 +135,112 @@ private:
 };
 
 
+//-----------------------------------------------------------------------------
+// Multithreaded pool where every thread allocates from and frees to its own
+// magazines (small stacks of free blocks), and only trades full and empty ones
+// with a depot shared by the threads of its NUMA node. Most allocations and frees
+// touch nothing but the calling thread's data; blobs are still made by CUtlMemoryPool,
+// by the thread which ran out of blocks, so their pages land on its node.
+//-----------------------------------------------------------------------------
+struct MemoryPoolStats_t {
+	int m_nBlockSize;
+	int m_nBlobs;
+	int m_nBlocksInUse;   // allocated and not freed yet
+	int m_nBlocksCached;  // free, sitting in magazines
+	int m_nThreads;       // threads with magazines
+	uint32 m_nAllocs;
+	uint32 m_nFrees;
+	uint32 m_nDepotExchanges;  // magazines traded with a depot
+	uint32 m_nRefills;         // magazines filled from the blobs
+};
+
+class CMemoryPoolMagazineMT : public CUtlMemoryPool {
+public:
+	CMemoryPoolMagazineMT( int blockSize, int numElements, int growMode = UTLMEMORYPOOL_GROW_FAST, const char* pszAllocOwner = NULL, int nAlignment = 0 );
+	~CMemoryPoolMagazineMT();
+
+	void* Alloc() { return Alloc( m_BlockSize ); }
+	void* Alloc( size_t amount );
+	void* AllocZero() { return AllocZero( m_BlockSize ); }
+	void* AllocZero( size_t amount );
+	void Free( void* pMem );
+
+	// Frees everything, no other thread may be using the pool meanwhile
+	void Clear();
+
+	// Gives the calling thread's magazines back, for threads about to idle for a long time
+	void FlushThreadCache();
+
+	// returns number of allocated blocks
+	int Count();
+	void GetStats( MemoryPoolStats_t& stats );
+
+private:
+	enum {
+		MAGAZINE_SIZE = 32,
+		MAX_POOLS = 256,  // live pools with magazines per process, the others fall back to a mutex
+		MAX_NUMA_NODES = 4,
+		MAX_DEPOT_MAGAZINES = 16  // full magazines a depot keeps, the surplus goes back to the blobs
+	};
+
+	struct Magazine_t {
+		Magazine_t* m_pNext;
+		int m_nCount;
+		void* m_pBlocks[ MAGAZINE_SIZE ];
+	};
+
+	// The calling thread's magazines: blocks come from `m_pLoaded`, `m_pPrevious` is kept as a spare
+	struct alignas( 64 ) ThreadCache_t {
+		CMemoryPoolMagazineMT* m_pPool;  // NULL once the pool is gone
+		ThreadCache_t* m_pNext;          // in the pool's list
+		Magazine_t* m_pLoaded;
+		Magazine_t* m_pPrevious;
+		int m_nNode;
+		int m_nEpoch;
+		// only written by the owner, summed by `GetStats()`
+		std::atomic<uint32> m_nAllocs;
+		std::atomic<uint32> m_nFrees;
+	};
+
+	struct alignas( 64 ) Depot_t {
+		CThreadFastMutex m_Mutex;
+		Magazine_t* m_pFull;
+		Magazine_t* m_pEmpty;
+		int m_nFull;
+	};
+
+	ThreadCache_t* GetThreadCache();
+	ThreadCache_t* CreateThreadCache();
+	static void ReleaseThreadCache( ThreadCache_t* pCache );
+	// Must hold the registry mutex
+	void DrainThreadCache( ThreadCache_t* pCache );
+	void DrainDepots();
+
+	bool Reload( ThreadCache_t* pCache );
+	void Unload( ThreadCache_t* pCache );
+	void FreeToBlobs( Magazine_t* pMagazine );
+	static Magazine_t* NewMagazine();
+
+	// slots handed back by destroyed pools, guarded by the registry mutex
+	static int s_FreeSlots[ MAX_POOLS ];
+	static int s_nFreeSlots;
+	static int s_nNextSlot;
+
+	int m_nSlot;
+	std::atomic<int> m_nEpoch;  // bumped by `Clear()`, stale magazines get dropped
+	CThreadFastMutex m_BlobMutex;
+	Depot_t m_Depots[ MAX_NUMA_NODES ];
+	ThreadCache_t* m_pThreadCaches;
+
+	// counts of the threads gone, and of the blocks which went around the magazines
+	std::atomic<uint32> m_nRetiredAllocs;
+	std::atomic<uint32> m_nRetiredFrees;
+	std::atomic<uint32> m_nDepotExchanges;
+	std::atomic<uint32> m_nRefills;
+	int m_nRetiredThreads;
+};
+
+
 //-----------------------------------------------------------------------------
 // Wrapper macro to make an allocator that returns particular typed allocations
 // and construction and destruction of objects.
@@ -358,6 +465,25 @@ private:
 #define DEFINE_FIXEDSIZE_ALLOCATOR_MT( _class, _initsize, _grow ) \
 	CMemoryPoolMT _class::s_Allocator( sizeof( _class ), _initsize, _grow, #_class " pool" )
 
+#define DECLARE_FIXEDSIZE_ALLOCATOR_MAGAZINE( _class )                                                                 \
+public:                                                                                                                \
+	inline void* operator new( size_t size ) {                                                                         \
+		MEM_ALLOC_CREDIT_( #_class " pool" );                                                                          \
+		return s_Allocator.Alloc( size );                                                                              \
+	}                                                                                                                  \
+	inline void* operator new( size_t size, int nBlockUse, const char* pFileName, int nLine ) {                        \
+		MEM_ALLOC_CREDIT_( #_class " pool" );                                                                          \
+		return s_Allocator.Alloc( size );                                                                              \
+	}                                                                                                                  \
+	inline void operator delete( void* p ) { s_Allocator.Free( p ); }                                                  \
+	inline void operator delete( void* p, int nBlockUse, const char* pFileName, int nLine ) { s_Allocator.Free( p ); } \
+                                                                                                                       \
+private:                                                                                                               \
+	static CMemoryPoolMagazineMT s_Allocator
+
+#define DEFINE_FIXEDSIZE_ALLOCATOR_MAGAZINE( _class, _initsize, _grow ) \
+	CMemoryPoolMagazineMT _class::s_Allocator( sizeof( _class ), _initsize, _grow, #_class " pool" )
+
 //-----------------------------------------------------------------------------
 // Macros that make it simple to make a class use a fixed-size allocator
 // This version allows us to use a memory pool which is externally defined...
@@ -18,8 +18,8 @@ public:
 	void Term();
 
 	int GetSize();
-	int GetMaxSize();
-	int GetUsed();
+	int GetMaxSize() const;
+	int GetUsed() const;
 
 	void* Alloc( unsigned bytes, bool bClear = false ) RESTRICT;
 
@@ -29,6 +29,10 @@ public:
 
 	void Access( void** ppRegion, unsigned* pBytes );
 
+	// Most memory ever used at once, since Init() or the last reset
+	unsigned GetHighWater() const;
+	void ResetHighWater() { m_highWater = 0; }
+
 	void PrintContents();
 
 	void* GetBase();
@@ -45,6 +49,7 @@ private:
 
 	unsigned m_maxSize;
 	unsigned m_alignment;
+	unsigned m_highWater;  // updated when freeing, the current use counts too
 	#if IsWindows()
 		unsigned m_commitSize;
 		unsigned m_minCommit;
@@ -84,13 +89,13 @@ ALWAYS_INLINE void* CMemoryStack::Alloc( unsigned bytes, bool bClear ) RESTRICT
 
 //-------------------------------------
 
-inline int CMemoryStack::GetMaxSize() {
+inline int CMemoryStack::GetMaxSize() const {
 	return m_maxSize;
 }
 
 //-------------------------------------
 
-inline int CMemoryStack::GetUsed() {
+inline int CMemoryStack::GetUsed() const {
 	return ( m_pNextAlloc - m_pBase );
 }
 
@@ -106,6 +111,12 @@ inline MemoryStackMark_t CMemoryStack::GetCurrentAllocPoint() {
 	return ( m_pNextAlloc - m_pBase );
 }
 
+//-------------------------------------
+
+inline unsigned CMemoryStack::GetHighWater() const {
+	return MAX( m_highWater, (unsigned) GetUsed() );
+}
+
 //-----------------------------------------------------------------------------
 // The CUtlMemoryStack class:
 // A fixed memory class
@@ -10,3 +10,9 @@ bool CheckMMXTechnology();
 bool CheckSSETechnology();
 bool CheckSSE2Technology();
 bool Check3DNowTechnology();
+bool CheckAVX2Technology();
+// Makes `CheckAVX2Technology()` report false from now on, so the SSE2 paths can be tested on any CPU.
+// Code which already picked its implementations keeps them, so call it before anything else
+void DisableAVX2Technology();
+bool CheckPCLMULQDQTechnology();
+bool CheckSHATechnology();
@@ -0,0 +1,272 @@
+//
+// Created by ENDERZOMBI102 on 18/10/2026.
+//
+// Purpose: Per-thread scratch memory, for temporaries which don't outlive a frame.
+//          Every thread gets its own `CMemoryStack`, and what's allocated in a scope
+//          is given back all at once when its `CScratchMark` goes away, so trace results,
+//          sort buffers and entity lists don't go through the heap every frame.
+//
+#pragma once
+#include "tier0/memalloc.h"
+#include "tier1/memstack.h"
+#include "tier1/utlvector.h"
+#include <cstring>
+
+
+struct ScratchArenaStats_t {
+	unsigned m_nUsed;
+	unsigned m_nReserved;
+	unsigned m_nHighWater;       // since the thread started, or the last reset
+	unsigned m_nFrameHighWater;  // since the last `EndFrame()`
+	unsigned m_nOverflows;       // allocations which didn't fit, and went to the heap
+};
+
+class CScratchArena {
+public:
+	static constexpr unsigned ALIGNMENT{ 16 };
+
+	// The calling thread's arena, reserved on first use
+	static CScratchArena& ThreadArena();
+	// Size reserved by the arenas created from now on
+	static void SetDefaultSize( unsigned nMaxSize );
+	// Highest high-water mark of all threads' arenas, to size them
+	static unsigned GetPeakHighWater();
+
+	/**
+	 * Returns `nullptr` when the arena is full instead of growing it,
+	 * the allocators below go to the heap for those.
+	 */
+	void* Alloc( unsigned nBytes, bool bClear = false );
+	template<typename T>
+	T* AllocArray( int nCount ) { return static_cast<T*>( Alloc( nCount * sizeof( T ) ) ); }
+	// Only gives the memory back right away if it's the last allocation, otherwise it waits for the mark
+	void Free( void* pMem, unsigned nBytes );
+	// Grows the last allocation in place, if there's room
+	bool Extend( void* pMem, unsigned nOldBytes, unsigned nNewBytes );
+	[[nodiscard]]
+	bool Owns( const void* pMem ) const;
+
+	[[nodiscard]]
+	MemoryStackMark_t GetMark() { return m_Stack.GetCurrentAllocPoint(); }
+	void FreeToMark( MemoryStackMark_t mark );
+
+	// Call once a frame, with no mark open: starts a new frame high-water mark
+	void EndFrame();
+	void GetStats( ScratchArenaStats_t& stats ) const;
+	void ResetHighWater();
+private:
+	CScratchArena() = default;
+	[[nodiscard]]
+	bool IsTop( const void* pMem, unsigned nBytes ) const;
+
+	CMemoryStack m_Stack;
+	unsigned m_nHighWater{ 0 };
+	unsigned m_nOverflows{ 0 };
+};
+
+
+// Rewinds the arena to where it was when constructed
+class CScratchMark {
+public:
+	CScratchMark() : CScratchMark( CScratchArena::ThreadArena() ) { }
+	explicit CScratchMark( CScratchArena& arena ) : m_Arena( arena ), m_Mark( arena.GetMark() ) { }
+	~CScratchMark() { m_Arena.FreeToMark( m_Mark ); }
+	CScratchMark( const CScratchMark& ) = delete;
+	CScratchMark& operator=( const CScratchMark& ) = delete;
+
+	[[nodiscard]]
+	CScratchArena& Arena() const { return m_Arena; }
+	void* Alloc( unsigned nBytes, bool bClear = false ) { return m_Arena.Alloc( nBytes, bClear ); }
+	template<typename T>
+	T* AllocArray( int nCount ) { return m_Arena.AllocArray<T>( nCount ); }
+private:
+	CScratchArena& m_Arena;
+	MemoryStackMark_t m_Mark;
+};
+
+
+/**
+ * STL allocator on a scratch arena, e.g. `std::vector<int, CScratchAllocator<int>>`.
+ * Containers must be gone before their mark is; whatever doesn't fit in the arena comes from the heap.
+ */
+template<typename T>
+class CScratchAllocator {
+	template<typename U>
+	friend class CScratchAllocator;
+public:
+	using value_type = T;
+
+	CScratchAllocator() : m_pArena( &CScratchArena::ThreadArena() ) { }
+	explicit CScratchAllocator( CScratchArena& arena ) : m_pArena( &arena ) { }
+	template<typename U>
+	CScratchAllocator( const CScratchAllocator<U>& other ) : m_pArena( other.m_pArena ) { }
+
+	T* allocate( size_t nCount ) {
+		static_assert( alignof( T ) <= CScratchArena::ALIGNMENT );
+		auto pMem{ m_pArena->Alloc( nCount * sizeof( T ) ) };
+		if ( pMem == nullptr ) {
+			pMem = MemAlloc_AllocAligned( nCount * sizeof( T ), CScratchArena::ALIGNMENT );
+		}
+		return static_cast<T*>( pMem );
+	}
+	void deallocate( T* pMem, size_t nCount ) {
+		if ( m_pArena->Owns( pMem ) ) {
+			m_pArena->Free( pMem, nCount * sizeof( T ) );
+		} else {
+			MemAlloc_FreeAligned( pMem );
+		}
+	}
+
+	template<typename U>
+	bool operator==( const CScratchAllocator<U>& other ) const { return m_pArena == other.m_pArena; }
+	template<typename U>
+	bool operator!=( const CScratchAllocator<U>& other ) const { return m_pArena != other.m_pArena; }
+private:
+	CScratchArena* m_pArena;
+};
+
+
+//-----------------------------------------------------------------------------
+// CUtlVector memory on the calling thread's scratch arena, see `CUtlVectorScratch`.
+// Elements are moved with memcpy when growing, like CUtlMemory does.
+//-----------------------------------------------------------------------------
+template<typename T>
+class CUtlMemoryScratch {
+public:
+	CUtlMemoryScratch( int nGrowSize = 0, int nInitSize = 0 ) : m_pArena( &CScratchArena::ThreadArena() ) {
+		if ( nInitSize > 0 ) {
+			Resize( nInitSize );
+		}
+	}
+	CUtlMemoryScratch( T* pMemory, int numElements ) { Assert( 0 ); }
+	~CUtlMemoryScratch() { Purge(); }
+
+	// Can we use this index?
+	bool IsIdxValid( int i ) const { return i >= 0 && i < m_nAllocated; }
+	static int InvalidIndex() { return -1; }
+
+	// Gets the base address
+	T* Base() { return m_pMemory; }
+	const T* Base() const { return m_pMemory; }
+
+	// element access
+	T& operator[]( int i ) {
+		Assert( IsIdxValid( i ) );
+		return m_pMemory[ i ];
+	}
+	const T& operator[]( int i ) const {
+		Assert( IsIdxValid( i ) );
+		return m_pMemory[ i ];
+	}
+	T& Element( int i ) {
+		Assert( IsIdxValid( i ) );
+		return m_pMemory[ i ];
+	}
+	const T& Element( int i ) const {
+		Assert( IsIdxValid( i ) );
+		return m_pMemory[ i ];
+	}
+
+	// Attaches the buffer to external memory....
+	void SetExternalBuffer( T* pMemory, int numElements ) { Assert( 0 ); }
+
+	// Size
+	int NumAllocated() const { return m_nAllocated; }
+	int Count() const { return m_nAllocated; }
+
+	// Grows the memory, so that at least allocated + num elements are allocated
+	void Grow( int num = 1 ) {
+		Resize( MAX( m_nAllocated + num, m_nAllocated * 2 ) );
+	}
+
+	// Makes sure we've got at least this much memory
+	void EnsureCapacity( int num ) {
+		if ( num > m_nAllocated ) {
+			Resize( num );
+		}
+	}
+
+	// Memory deallocation
+	void Purge() {
+		Release();
+		m_pMemory = nullptr;
+		m_nAllocated = 0;
+	}
+	// Scratch memory isn't worth shrinking
+	void Purge( int numElements ) {
+		if ( numElements == 0 ) {
+			Purge();
+		}
+	}
+
+	void Swap( CUtlMemoryScratch& other ) {
+		V_swap( m_pArena, other.m_pArena );
+		V_swap( m_pMemory, other.m_pMemory );
+		V_swap( m_nAllocated, other.m_nAllocated );
+	}
+
+	// is the memory externally allocated?
+	bool IsExternallyAllocated() const { return false; }
+
+	// Set the size by which the memory grows
+	void SetGrowSize( int size ) { }
+
+	class Iterator_t {
+	public:
+		Iterator_t( int i ) : index( i ) { }
+		int index;
+		bool operator==( const Iterator_t it ) const { return index == it.index; }
+		bool operator!=( const Iterator_t it ) const { return index != it.index; }
+	};
+	Iterator_t First() const { return Iterator_t( m_nAllocated ? 0 : InvalidIndex() ); }
+	Iterator_t Next( const Iterator_t& it ) const { return Iterator_t( it.index + 1 < m_nAllocated ? it.index + 1 : InvalidIndex() ); }
+	int GetIndex( const Iterator_t& it ) const { return it.index; }
+	bool IsIdxAfter( int i, const Iterator_t& it ) const { return i > it.index; }
+	bool IsValidIterator( const Iterator_t& it ) const { return IsIdxValid( it.index ); }
+	Iterator_t InvalidIterator() const { return Iterator_t( InvalidIndex() ); }
+private:
+	void Resize( int nCount ) {
+		static_assert( alignof( T ) <= CScratchArena::ALIGNMENT );
+		const auto nOldBytes{ static_cast<unsigned>( m_nAllocated * sizeof( T ) ) };
+		const auto nNewBytes{ static_cast<unsigned>( nCount * sizeof( T ) ) };
+
+		// usually the vector grown last is on top, and has room right after it
+		if ( m_pMemory and m_pArena->Extend( m_pMemory, nOldBytes, nNewBytes ) ) {
+			m_nAllocated = nCount;
+			return;
+		}
+
+		auto pNew{ static_cast<T*>( m_pArena->Alloc( nNewBytes ) ) };
+		if ( pNew == nullptr ) {
+			pNew = static_cast<T*>( MemAlloc_AllocAligned( nNewBytes, CScratchArena::ALIGNMENT ) );
+		}
+		if ( m_pMemory ) {
+			memcpy( pNew, m_pMemory, nOldBytes );
+			Release();
+		}
+		m_pMemory = pNew;
+		m_nAllocated = nCount;
+	}
+	void Release() {
+		if ( m_pMemory == nullptr ) {
+			return;
+		}
+		if ( m_pArena->Owns( m_pMemory ) ) {
+			m_pArena->Free( m_pMemory, m_nAllocated * sizeof( T ) );
+		} else {
+			MemAlloc_FreeAligned( m_pMemory );
+		}
+	}
+
+	CScratchArena* m_pArena;
+	T* m_pMemory{ nullptr };
+	int m_nAllocated{ 0 };
+};
+
+// A CUtlVector living in the calling thread's scratch arena, must be gone before the enclosing mark is
+template<typename T>
+class CUtlVectorScratch : public CUtlVector<T, CUtlMemoryScratch<T>> {
+	typedef CUtlVector<T, CUtlMemoryScratch<T>> BaseClass;
+public:
+	explicit CUtlVectorScratch( int initSize = 0 ) : BaseClass( 0, initSize ) { }
+};
@@ -5,6 +5,7 @@
 // $NoKeywords: $
 //=============================================================================//
 #pragma once
+#include "tier0/threadtools.h"
 #include "utlrbtree.h"
 #include "utlvector.h"
 
@@ -75,3 +76,100 @@ public:
 	char* HandleToString( unsigned short handle );
 	void SpewStrings();
 };
+
+
+//-----------------------------------------------------------------------------
+// Purpose: A high capacity, thread safe, reference counted string pool.
+//
+// Strings are found through an open addressing hash table which keeps the
+// hash of every string next to its handle, so probes rarely touch the
+// strings themselves. Strings are stored in large pages, and handles are 32-bit.
+//
+// Lookups and references share a read lock, counts are atomic; only adding
+// a new string or freeing one whose count dropped to zero takes the write lock.
+//-----------------------------------------------------------------------------
+typedef uint32 StringPoolHandle_t;
+#define STRING_POOL_INVALID_HANDLE static_cast<StringPoolHandle_t>( 0 )
+
+struct StringPoolStats_t {
+	int m_nStrings;        // live strings
+	int m_nStringBytes;    // bytes of the live strings, terminators included
+	int m_nPageBytes;      // bytes of string storage, free blocks included
+	int m_nFreeBytes;      // freed blocks, waiting to be reused
+	int m_nTableCapacity;  // slots in the hash table
+	int m_nTombstones;     // slots of freed strings
+	int m_nLongestProbe;   // worst number of slots looked at by a lookup
+	int m_nLookups;
+	int m_nHits;
+};
+
+class CHashedStringPool {
+public:
+	explicit CHashedStringPool( bool bCaseInsensitive = true );
+	~CHashedStringPool();
+
+	unsigned int Count() const;
+	void FreeAll();
+
+	// Non counted use, like CStringPool: the strings live until FreeAll()
+	const char* Allocate( const char* pszValue );
+	const char* Find( const char* pszValue ) const;
+
+	// Counted use, like CCountedStringPool: a string is freed when its last reference goes
+	StringPoolHandle_t ReferenceStringHandle( const char* pIntrinsic );
+	StringPoolHandle_t FindStringHandle( const char* pIntrinsic ) const;
+	const char* ReferenceString( const char* pIntrinsic );
+	void DereferenceString( const char* pIntrinsic );
+	void DereferenceStringHandle( StringPoolHandle_t handle );
+	const char* HandleToString( StringPoolHandle_t handle ) const;
+
+	void GetStats( StringPoolStats_t& stats ) const;
+	void GetStrings( CUtlVector<const char*>& strings ) const;
+	void SpewStrings() const;
+
+private:
+	struct Entry_t {
+		char* m_pString;  // nullptr if free
+		uint32 m_nHash;
+		uint32 m_nLength;
+		CInterlockedInt m_nRefs;
+	};
+	struct Slot_t {
+		uint32 m_nHash;
+		StringPoolHandle_t m_Handle;  // entry index + 1
+	};
+	static constexpr StringPoolHandle_t TOMBSTONE{ ~0u };
+	static constexpr int PAGE_SIZE{ 64 * 1024 };
+	static constexpr int BLOCK_GRANULARITY{ 8 };
+	static constexpr int MAX_BLOCK_SIZE{ 256 };  // longer strings are allocated on their own
+
+	uint32 HashOf( const char* pszValue, uint32 nLength ) const;
+	bool Matches( const Entry_t& entry, const char* pszValue, uint32 nLength, uint32 nHash ) const;
+	// Returns the slot with the string, or -1
+	int LookupSlot( const char* pszValue, uint32 nLength, uint32 nHash ) const;
+	// Needs the write lock
+	StringPoolHandle_t Insert( const char* pszValue, uint32 nLength, uint32 nHash );
+	void Remove( StringPoolHandle_t handle );
+	void Rehash( int nCapacity );
+	char* AllocBlock( int nSize );
+	void FreeBlock( char* pBlock, int nSize );
+private:
+	bool m_bCaseInsensitive;
+
+	mutable CThreadRWLock m_Lock;
+	CUtlVector<Slot_t> m_Table;
+	int m_nUsedSlots;  // live strings and tombstones
+	CUtlVector<Entry_t> m_Entries;
+	CUtlVector<int> m_FreeEntries;
+
+	CUtlVector<char*> m_Pages;
+	int m_nPageUsed;
+	char* m_pFreeBlocks[ MAX_BLOCK_SIZE / BLOCK_GRANULARITY ];  // freed blocks by size, linked through their first bytes
+
+	int m_nStringBytes;
+	int m_nFreeBytes;
+	int m_nLongBytes;
+	mutable CInterlockedInt m_nLookups;
+	mutable CInterlockedInt m_nHits;
+	mutable CInterlockedInt m_nLongestProbe;
+};
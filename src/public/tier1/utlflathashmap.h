@@ -0,0 +1,481 @@
+//
+// Created by ENDERZOMBI102 on 18/10/2026.
+//
+// Purpose: An open addressing hash map, probed 16 slots at a time.
+//          Every slot of the table has a control byte holding 7 bits of its key's hash,
+//          a lookup compares a whole group of them with a single SSE2 compare, and only
+//          looks at the entries whose bits matched, so a miss rarely touches an entry at all.
+//          Entries live in their own array, in insertion order: their indices stay valid
+//          when the table grows, and iterating doesn't depend on the hashes.
+//          `CUtlHashMap` at the bottom is the same map with Valve's interface.
+//
+#pragma once
+#include "tier0/dbg.h"
+#include "tier0/memalloc.h"
+#include "tier1/strtools.h"
+#include "tier1/utlcommon.h"
+#include "tier1/utlmemory.h"
+#include <bit>
+#include <cstring>
+#include <emmintrin.h>
+#include <new>
+
+
+struct UtlFlatHashMapStats_t {
+	int m_nCount;
+	int m_nSlots;
+	int m_nDeleted;           // slots of removed entries, which still make lookups probe further
+	int m_nMaxProbeGroups;    // groups looked at to find the worst placed entry
+	float m_flAvgProbeGroups;
+};
+
+// Control bytes of the table a map starts with, so lookups in an empty map don't need a check
+alignas( 16 ) inline constexpr uint8 g_UtlFlatHashMapEmptyGroup[ 16 ]{
+	0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+	0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80
+};
+
+
+/**
+ * Keys with an alternate argument type (e.g. `const char*` for `CUtlString`) can be
+ * looked up, inserted and removed with it, a key is only built when it gets inserted.
+ * Indices are stable until the entry is removed, `Rehash()` and growth don't move them.
+ */
+template<typename K, typename V, typename H = DefaultHashFunctor<K>, typename E = DefaultEqualFunctor<K>, typename AlternateKeyT = typename ArgumentTypeInfo<K>::Alt_t>
+class CUtlFlatHashMap {
+public:
+	using IndexType_t = int;
+	using KeyArg_t = typename ArgumentTypeInfo<K>::Arg_t;
+	using KeyAlt_t = typename ArgumentTypeInfo<AlternateKeyT>::Arg_t;
+	using ElemArg_t = typename ArgumentTypeInfo<V>::Arg_t;
+
+	struct Node_t {
+		K key;
+		V elem;
+	};
+
+	explicit CUtlFlatHashMap( int nExpected = 0, const H& hash = H(), const E& equal = E() ) : m_Hash( hash ), m_Equal( equal ) {
+		if ( nExpected > 0 ) {
+			EnsureCapacity( nExpected );
+		}
+	}
+	CUtlFlatHashMap( const CUtlFlatHashMap& other ) : m_Hash( other.m_Hash ), m_Equal( other.m_Equal ) {
+		*this = other;
+	}
+	~CUtlFlatHashMap() { Purge(); }
+
+	CUtlFlatHashMap& operator=( const CUtlFlatHashMap& other ) {
+		if ( &other == this ) {
+			return *this;
+		}
+		// copies the free list too, so the indices are the same in both maps
+		RemoveAll();
+		m_Entries.EnsureCapacity( other.m_nEntryEnd );
+		for ( auto i{ 0 }; i < other.m_nEntryEnd; i += 1 ) {
+			const auto& entry{ other.m_Entries[ i ] };
+			m_Entries[ i ].m_nHash = entry.m_nHash;
+			m_Entries[ i ].m_nLink = entry.m_nLink;
+			if ( entry.m_nLink >= 0 ) {
+				::new( &m_Entries[ i ].m_Node ) Node_t( entry.m_Node );
+			}
+		}
+		m_nEntryEnd = other.m_nEntryEnd;
+		m_nFirstFree = other.m_nFirstFree;
+		m_nCount = other.m_nCount;
+		Rehash();
+		return *this;
+	}
+
+	void Swap( CUtlFlatHashMap& other ) {
+		m_Entries.Swap( other.m_Entries );
+		V_swap( m_nEntryEnd, other.m_nEntryEnd );
+		V_swap( m_nFirstFree, other.m_nFirstFree );
+		V_swap( m_nCount, other.m_nCount );
+		V_swap( m_pCtrl, other.m_pCtrl );
+		V_swap( m_pSlots, other.m_pSlots );
+		V_swap( m_nGroupMask, other.m_nGroupMask );
+		V_swap( m_nGrowthLeft, other.m_nGrowthLeft );
+		V_swap( m_Hash, other.m_Hash );
+		V_swap( m_Equal, other.m_Equal );
+	}
+
+	// element access
+	V& operator[]( IndexType_t i ) { return Element( i ); }
+	const V& operator[]( IndexType_t i ) const { return Element( i ); }
+	V& Element( IndexType_t i ) {
+		Assert( IsValidIndex( i ) );
+		return m_Entries[ i ].m_Node.elem;
+	}
+	const V& Element( IndexType_t i ) const {
+		Assert( IsValidIndex( i ) );
+		return m_Entries[ i ].m_Node.elem;
+	}
+	const K& Key( IndexType_t i ) const {
+		Assert( IsValidIndex( i ) );
+		return m_Entries[ i ].m_Node.key;
+	}
+
+	[[nodiscard]]
+	bool IsValidIndex( IndexType_t i ) const { return i >= 0 and i < m_nEntryEnd and m_Entries[ i ].m_nLink >= 0; }
+	static IndexType_t InvalidIndex() { return -1; }
+
+	[[nodiscard]]
+	int Count() const { return m_nCount; }
+	// Upper bound of the indices in use, for iterating with `IsValidIndex()`
+	[[nodiscard]]
+	IndexType_t MaxElement() const { return m_nEntryEnd; }
+
+	// Iterates in insertion order, except that removed indices are reused
+	IndexType_t FirstInorder() const { return NextValid( 0 ); }
+	IndexType_t NextInorder( IndexType_t i ) const { return NextValid( i + 1 ); }
+
+	IndexType_t Find( KeyArg_t key ) const { return FindIndex<KeyArg_t>( key ); }
+	IndexType_t Find( KeyAlt_t key ) const { return FindIndex<KeyAlt_t>( key ); }
+	[[nodiscard]]
+	bool HasElement( KeyArg_t key ) const { return Find( key ) != InvalidIndex(); }
+	[[nodiscard]]
+	bool HasElement( KeyAlt_t key ) const { return Find( key ) != InvalidIndex(); }
+
+	// Inserts a default constructed element if the key isn't there
+	IndexType_t Insert( KeyArg_t key ) { return DoInsert<KeyArg_t>( key ); }
+	IndexType_t Insert( KeyAlt_t key ) { return DoInsert<KeyAlt_t>( key ); }
+	// Doesn't replace the element if the key is already there
+	IndexType_t Insert( KeyArg_t key, ElemArg_t elem, bool* pDidInsert = nullptr ) { return DoInsert<KeyArg_t>( key, elem, pDidInsert ); }
+	IndexType_t Insert( KeyAlt_t key, ElemArg_t elem, bool* pDidInsert = nullptr ) { return DoInsert<KeyAlt_t>( key, elem, pDidInsert ); }
+	IndexType_t InsertOrReplace( KeyArg_t key, ElemArg_t elem ) {
+		bool bInserted;
+		const auto i{ DoInsert<KeyArg_t>( key, elem, &bInserted ) };
+		if (! bInserted ) {
+			m_Entries[ i ].m_Node.elem = elem;
+		}
+		return i;
+	}
+
+	void RemoveAt( IndexType_t i ) {
+		Assert( IsValidIndex( i ) );
+		auto& entry{ m_Entries[ i ] };
+		const auto nSlot{ entry.m_nLink };
+		// no probe ever went past a group which still has an empty slot, so this one can be empty too
+		if ( EmptyMask( LoadGroup( static_cast<uint32>( nSlot ) / GROUP_WIDTH ) ) ) {
+			m_pCtrl[ nSlot ] = CTRL_EMPTY;
+			m_nGrowthLeft += 1;
+		} else {
+			m_pCtrl[ nSlot ] = CTRL_DELETED;
+		}
+
+		Destruct( &entry.m_Node );
+		entry.m_nLink = -2 - m_nFirstFree;
+		m_nFirstFree = i;
+		m_nCount -= 1;
+	}
+	bool Remove( KeyArg_t key ) { return DoRemove<KeyArg_t>( key ); }
+	bool Remove( KeyAlt_t key ) { return DoRemove<KeyAlt_t>( key ); }
+
+	// Removes everything, keeping the memory
+	void RemoveAll() {
+		for ( auto i{ FirstInorder() }; i != InvalidIndex(); i = NextInorder( i ) ) {
+			Destruct( &m_Entries[ i ].m_Node );
+		}
+		m_nEntryEnd = 0;
+		m_nFirstFree = -1;
+		m_nCount = 0;
+		if ( m_pSlots ) {
+			memset( m_pCtrl, CTRL_EMPTY, SlotCount() );
+			m_nGrowthLeft = MaxLoad( SlotCount() );
+		}
+	}
+	// Removes everything, and frees the memory
+	void Purge() {
+		RemoveAll();
+		FreeTable();
+		m_Entries.Purge();
+	}
+	void PurgeAndDeleteElements() {
+		for ( auto i{ FirstInorder() }; i != InvalidIndex(); i = NextInorder( i ) ) {
+			delete m_Entries[ i ].m_Node.elem;
+		}
+		Purge();
+	}
+
+	// Makes room for this many entries, without growing again
+	void EnsureCapacity( int nCount ) {
+		m_Entries.EnsureCapacity( nCount );
+		if ( MaxLoad( SlotCount() ) < nCount ) {
+			Resize( SlotsFor( nCount ) );
+		}
+	}
+	void Reserve( int nCount ) { EnsureCapacity( nCount ); }
+	// Rebuilds the table for the current count, or nMinCount if bigger: clears removed slots, and may shrink it
+	void Rehash( int nMinCount = 0 ) {
+		const auto nCount{ MAX( m_nCount, nMinCount ) };
+		if ( nCount == 0 ) {
+			FreeTable();
+			return;
+		}
+		Resize( SlotsFor( nCount ) );
+	}
+
+	void GetStats( UtlFlatHashMapStats_t& stats ) const {
+		stats.m_nCount = m_nCount;
+		stats.m_nSlots = m_pSlots ? SlotCount() : 0;
+		stats.m_nDeleted = 0;
+		for ( auto nSlot{ 0 }; nSlot < stats.m_nSlots; nSlot += 1 ) {
+			stats.m_nDeleted += m_pCtrl[ nSlot ] == CTRL_DELETED;
+		}
+
+		stats.m_nMaxProbeGroups = 0;
+		auto nTotalGroups{ 0 };
+		for ( auto i{ FirstInorder() }; i != InvalidIndex(); i = NextInorder( i ) ) {
+			const auto& entry{ m_Entries[ i ] };
+			const auto nTarget{ static_cast<uint32>( entry.m_nLink ) / GROUP_WIDTH };
+			auto nGroups{ 1 };
+			auto nGroup{ ( entry.m_nHash >> 7 ) & m_nGroupMask };
+			while ( nGroup != nTarget ) {
+				nGroup = ( nGroup + nGroups ) & m_nGroupMask;
+				nGroups += 1;
+			}
+			stats.m_nMaxProbeGroups = MAX( stats.m_nMaxProbeGroups, nGroups );
+			nTotalGroups += nGroups;
+		}
+		stats.m_flAvgProbeGroups = m_nCount ? static_cast<float>( nTotalGroups ) / m_nCount : 0.0f;
+	}
+
+	class const_iterator {
+	public:
+		const_iterator( const CUtlFlatHashMap* pMap, IndexType_t i ) : m_pMap( pMap ), m_nIndex( i ) { }
+		const Node_t& operator*() const { return m_pMap->m_Entries[ m_nIndex ].m_Node; }
+		const Node_t* operator->() const { return &**this; }
+		const_iterator& operator++() {
+			m_nIndex = m_pMap->NextInorder( m_nIndex );
+			return *this;
+		}
+		bool operator==( const const_iterator& other ) const { return m_nIndex == other.m_nIndex; }
+		bool operator!=( const const_iterator& other ) const { return m_nIndex != other.m_nIndex; }
+	protected:
+		const CUtlFlatHashMap* m_pMap;
+		IndexType_t m_nIndex;
+	};
+	class iterator : public const_iterator {
+	public:
+		using const_iterator::const_iterator;
+		Node_t& operator*() const { return const_cast<CUtlFlatHashMap*>( this->m_pMap )->m_Entries[ this->m_nIndex ].m_Node; }
+		Node_t* operator->() const { return &**this; }
+		iterator& operator++() {
+			const_iterator::operator++();
+			return *this;
+		}
+	};
+
+	iterator begin() { return { this, FirstInorder() }; }
+	iterator end() { return { this, InvalidIndex() }; }
+	const_iterator begin() const { return { this, FirstInorder() }; }
+	const_iterator end() const { return { this, InvalidIndex() }; }
+private:
+	static constexpr uint32 GROUP_WIDTH{ 16 };
+	static constexpr uint8 CTRL_EMPTY{ 0x80 };
+	static constexpr uint8 CTRL_DELETED{ 0xFE };
+
+	struct Entry_t {
+		uint32 m_nHash;
+		int m_nLink;  // slot in the table, or `-2 - next free entry` once removed
+		Node_t m_Node;
+	};
+
+	[[nodiscard]]
+	int SlotCount() const { return static_cast<int>( ( m_nGroupMask + 1 ) * GROUP_WIDTH ); }
+	// Keeps at least an eighth of the slots empty, so probes have somewhere to stop
+	static int MaxLoad( int nSlots ) { return nSlots - nSlots / 8; }
+	static int SlotsFor( int nCount ) {
+		auto nSlots{ static_cast<int>( GROUP_WIDTH ) };
+		while ( MaxLoad( nSlots ) < nCount ) {
+			nSlots *= 2;
+		}
+		return nSlots;
+	}
+
+	[[nodiscard]]
+	__m128i LoadGroup( uint32 nGroup ) const { return _mm_load_si128( reinterpret_cast<const __m128i*>( m_pCtrl + nGroup * GROUP_WIDTH ) ); }
+	static unsigned EmptyMask( __m128i ctrl ) { return _mm_movemask_epi8( _mm_cmpeq_epi8( ctrl, _mm_set1_epi8( static_cast<char>( CTRL_EMPTY ) ) ) ); }
+
+	// Slot of the entry with this key, or -1; groups are probed in a triangular sequence, which visits all of them
+	template<typename KeyT>
+	int FindSlot( KeyT key, uint32 nHash ) const {
+		const auto tag{ _mm_set1_epi8( static_cast<char>( nHash & 0x7F ) ) };
+		auto nGroup{ ( nHash >> 7 ) & m_nGroupMask };
+		for ( uint32 nStep{ 1 };; nStep += 1 ) {
+			const auto ctrl{ LoadGroup( nGroup ) };
+			for ( auto nMatch{ static_cast<unsigned>( _mm_movemask_epi8( _mm_cmpeq_epi8( ctrl, tag ) ) ) }; nMatch; nMatch &= nMatch - 1 ) {
+				const auto nSlot{ static_cast<int>( nGroup * GROUP_WIDTH + std::countr_zero( nMatch ) ) };
+				const auto& entry{ m_Entries[ m_pSlots[ nSlot ] ] };
+				if ( entry.m_nHash == nHash and m_Equal( entry.m_Node.key, key ) ) {
+					return nSlot;
+				}
+			}
+			if ( EmptyMask( ctrl ) ) {
+				return -1;
+			}
+			nGroup = ( nGroup + nStep ) & m_nGroupMask;
+		}
+	}
+	// First empty or removed slot along the key's probe sequence
+	int FindFreeSlot( uint32 nHash ) const {
+		auto nGroup{ ( nHash >> 7 ) & m_nGroupMask };
+		for ( uint32 nStep{ 1 };; nStep += 1 ) {
+			const auto nFree{ static_cast<unsigned>( _mm_movemask_epi8( LoadGroup( nGroup ) ) ) };
+			if ( nFree ) {
+				return static_cast<int>( nGroup * GROUP_WIDTH + std::countr_zero( nFree ) );
+			}
+			nGroup = ( nGroup + nStep ) & m_nGroupMask;
+		}
+	}
+
+	template<typename KeyT>
+	IndexType_t FindIndex( KeyT key ) const {
+		const auto nSlot{ FindSlot<KeyT>( key, static_cast<uint32>( m_Hash( key ) ) ) };
+		return nSlot == -1 ? InvalidIndex() : m_pSlots[ nSlot ];
+	}
+
+	// Index of the key's entry, the element of a new one is left for the caller to construct
+	template<typename KeyT>
+	IndexType_t FindOrAddKey( KeyT key, bool& bInserted ) {
+		const auto nHash{ static_cast<uint32>( m_Hash( key ) ) };
+		const auto nSlot{ FindSlot<KeyT>( key, nHash ) };
+		bInserted = nSlot == -1;
+		if (! bInserted ) {
+			return m_pSlots[ nSlot ];
+		}
+
+		const auto i{ AddEntry( nHash ) };
+		::new( &m_Entries[ i ].m_Node.key ) K( key );
+		return i;
+	}
+	template<typename KeyT>
+	IndexType_t DoInsert( KeyT key ) {
+		bool bInserted;
+		const auto i{ FindOrAddKey<KeyT>( key, bInserted ) };
+		if ( bInserted ) {
+			::new( &m_Entries[ i ].m_Node.elem ) V();
+		}
+		return i;
+	}
+	template<typename KeyT>
+	IndexType_t DoInsert( KeyT key, ElemArg_t elem, bool* pDidInsert ) {
+		bool bInserted;
+		const auto i{ FindOrAddKey<KeyT>( key, bInserted ) };
+		if ( bInserted ) {
+			::new( &m_Entries[ i ].m_Node.elem ) V( elem );
+		}
+		if ( pDidInsert ) {
+			*pDidInsert = bInserted;
+		}
+		return i;
+	}
+
+	template<typename KeyT>
+	bool DoRemove( KeyT key ) {
+		const auto i{ FindIndex<KeyT>( key ) };
+		if ( i == InvalidIndex() ) {
+			return false;
+		}
+		RemoveAt( i );
+		return true;
+	}
+
+	// Takes a slot and an entry for the hash, the node is left for the caller to construct
+	IndexType_t AddEntry( uint32 nHash ) {
+		if ( m_nGrowthLeft == 0 ) {
+			// lots of removed slots: clearing them makes enough room, otherwise grow
+			const auto nSlots{ m_pSlots ? SlotCount() : 0 };
+			Resize( nSlots and m_nCount < MaxLoad( nSlots ) / 2 ? nSlots : SlotsFor( m_nCount + 1 + m_nCount / 2 ) );
+		}
+
+		const auto nSlot{ FindFreeSlot( nHash ) };
+		if ( m_pCtrl[ nSlot ] == CTRL_EMPTY ) {
+			m_nGrowthLeft -= 1;
+		}
+
+		IndexType_t i;
+		if ( m_nFirstFree != -1 ) {
+			i = m_nFirstFree;
+			m_nFirstFree = -2 - m_Entries[ i ].m_nLink;
+		} else {
+			if ( m_nEntryEnd == m_Entries.NumAllocated() ) {
+				m_Entries.Grow();
+			}
+			i = m_nEntryEnd;
+			m_nEntryEnd += 1;
+		}
+
+		auto& entry{ m_Entries[ i ] };
+		entry.m_nHash = nHash;
+		entry.m_nLink = nSlot;
+		m_pCtrl[ nSlot ] = static_cast<uint8>( nHash & 0x7F );
+		m_pSlots[ nSlot ] = i;
+		m_nCount += 1;
+		return i;
+	}
+
+	// Moves every entry to a new table, the cached hashes save calling the hash functor again
+	void Resize( int nSlots ) {
+		Assert( nSlots >= static_cast<int>( GROUP_WIDTH ) and std::has_single_bit( static_cast<uint32>( nSlots ) ) and MaxLoad( nSlots ) >= m_nCount );
+		FreeTable();
+		m_pCtrl = static_cast<uint8*>( MemAlloc_AllocAligned( nSlots * ( 1 + sizeof( int ) ), GROUP_WIDTH ) );
+		m_pSlots = reinterpret_cast<int*>( m_pCtrl + nSlots );
+		m_nGroupMask = nSlots / GROUP_WIDTH - 1;
+		m_nGrowthLeft = MaxLoad( nSlots ) - m_nCount;
+		memset( m_pCtrl, CTRL_EMPTY, nSlots );
+
+		for ( auto i{ FirstInorder() }; i != InvalidIndex(); i = NextInorder( i ) ) {
+			auto& entry{ m_Entries[ i ] };
+			const auto nSlot{ FindFreeSlot( entry.m_nHash ) };
+			entry.m_nLink = nSlot;
+			m_pCtrl[ nSlot ] = static_cast<uint8>( entry.m_nHash & 0x7F );
+			m_pSlots[ nSlot ] = i;
+		}
+	}
+	void FreeTable() {
+		if ( m_pSlots ) {
+			MemAlloc_FreeAligned( m_pCtrl );
+		}
+		m_pCtrl = const_cast<uint8*>( g_UtlFlatHashMapEmptyGroup );
+		m_pSlots = nullptr;
+		m_nGroupMask = 0;
+		m_nGrowthLeft = 0;
+	}
+
+	IndexType_t NextValid( IndexType_t i ) const {
+		for ( ; i < m_nEntryEnd; i += 1 ) {
+			if ( m_Entries[ i ].m_nLink >= 0 ) {
+				return i;
+			}
+		}
+		return InvalidIndex();
+	}
+
+	CUtlMemory<Entry_t> m_Entries;
+	IndexType_t m_nEntryEnd{ 0 };  // entries from here on were never used
+	IndexType_t m_nFirstFree{ -1 };
+	int m_nCount{ 0 };
+
+	uint8* m_pCtrl{ const_cast<uint8*>( g_UtlFlatHashMapEmptyGroup ) };  // control bytes, followed by `m_pSlots` in the same block
+	int* m_pSlots{ nullptr };  // entry of every slot, `nullptr` while there's no table
+	uint32 m_nGroupMask{ 0 };
+	int m_nGrowthLeft{ 0 };  // empty slots which can still be filled before the table is full
+
+	H m_Hash;
+	E m_Equal;
+};
+
+
+// Valve's `CUtlHashMap` interface, where the equality functor comes before the hash one
+template<typename K, typename T, typename L = DefaultEqualFunctor<K>, typename H = DefaultHashFunctor<K>>
+class CUtlHashMap : public CUtlFlatHashMap<K, T, H, L> {
+	using BaseClass = CUtlFlatHashMap<K, T, H, L>;
+public:
+	// there are no buckets, only the number of elements matters
+	explicit CUtlHashMap( int cBucketsExpected = 16, int cElementsExpected = 0, int cMaxElementsExpected = 0 )
+		: BaseClass( MAX( cElementsExpected, cMaxElementsExpected ) ) { }
+};
+
+#define FOR_EACH_HASHMAP( mapName, iteratorName ) \
+	for ( int iteratorName = ( mapName ).FirstInorder(); iteratorName != ( mapName ).InvalidIndex(); iteratorName = ( mapName ).NextInorder( iteratorName ) )
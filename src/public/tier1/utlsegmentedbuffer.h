@@ -0,0 +1,226 @@
+//
+// Created by ENDERZOMBI102 on 18/10/2026.
+//
+// Purpose: A binary serialization buffer made of a chain of segments, instead of one growable block.
+//          Appending never moves what was already written, foreign memory can be appended without
+//          copying it, and the whole thing is written out one segment at a time, so building
+//          big files (save games, demos, BSP lumps) doesn't pay for reallocations.
+//          The Put*/Get* methods behave like the binary mode ones of `CUtlBuffer`.
+//
+#pragma once
+#include "tier1/byteswap.h"
+#include "tier1/utlbuffer.h"
+#include "tier1/utlvector.h"
+#include <cstring>
+
+
+class IBaseFileSystem;
+typedef void* FileHandle_t;
+
+
+class CUtlSegmentedBuffer {
+public:
+	enum SeekType_t {
+		SEEK_HEAD = 0,
+		SEEK_CURRENT,
+		SEEK_TAIL
+	};
+
+	static constexpr int DEFAULT_SEGMENT_SIZE{ 64 * 1024 };
+
+	// Called when the buffer is done with an external segment
+	using FreeFunc_t = void(*)( void* pMemory, void* pContext );
+
+	// A contiguous run of the buffer's data, see `GetIOVecs()`
+	struct IOVec_t {
+		const void* m_pBase;
+		int m_nLength;
+	};
+
+	explicit CUtlSegmentedBuffer( int nSegmentSize = DEFAULT_SEGMENT_SIZE );
+	~CUtlSegmentedBuffer();
+	CUtlSegmentedBuffer( const CUtlSegmentedBuffer& ) = delete;
+	CUtlSegmentedBuffer& operator=( const CUtlSegmentedBuffer& ) = delete;
+
+	void Swap( CUtlSegmentedBuffer& other );
+
+	// Controls endian-ness of the data - default matches the current platform
+	void ActivateByteSwapping( bool bActivate ) { m_Byteswap.ActivateByteSwapping( bActivate ); }
+	void SetBigEndian( bool bigEndian ) { m_Byteswap.SetTargetBigEndian( bigEndian ); }
+	bool IsBigEndian() { return m_Byteswap.IsTargetBigEndian(); }
+
+	// Resets the buffer, owned segments are kept around for reuse
+	void Clear();
+	// Clears out the buffer, and frees all memory
+	void Purge();
+
+	// Read stuff out, strings are read until a null character is reached
+	char GetChar() { return GetTypeBin<char>(); }
+	unsigned char GetUnsignedChar() { return GetTypeBin<unsigned char>(); }
+	short GetShort() { return GetTypeBin<short>(); }
+	unsigned short GetUnsignedShort() { return GetTypeBin<unsigned short>(); }
+	int GetInt() { return GetTypeBin<int>(); }
+	int64 GetInt64() { return GetTypeBin<int64>(); }
+	unsigned int GetUnsignedInt() { return GetTypeBin<unsigned int>(); }
+	float GetFloat() { return GetTypeBin<float>(); }
+	double GetDouble() { return GetTypeBin<double>(); }
+	template<size_t maxLenInChars>
+	void GetString( char ( &pString )[ maxLenInChars ] ) { GetStringInternal( pString, maxLenInChars ); }
+	void GetStringManualCharCount( char* pString, size_t maxLenInChars ) { GetStringInternal( pString, maxLenInChars ); }
+	void Get( void* pMem, int nSize );
+	// Gets at most nSize bytes, returns how many were read
+	int GetUpTo( void* pMem, int nSize );
+	// Used for getting objects that have a byteswap datadesc defined
+	template<typename T>
+	void GetObjects( T* dest, int count = 1 );
+
+	// Write stuff in, strings are written with their null terminating character
+	void PutChar( char c ) { PutTypeBin( c ); }
+	void PutUnsignedChar( unsigned char uc ) { PutTypeBin( uc ); }
+	void PutUint64( uint64 ub ) { PutTypeBin( ub ); }
+	void PutInt16( int16 s16 ) { PutTypeBin( s16 ); }
+	void PutShort( short s ) { PutTypeBin( s ); }
+	void PutUnsignedShort( unsigned short us ) { PutTypeBin( us ); }
+	void PutInt( int i ) { PutTypeBin( i ); }
+	void PutInt64( int64 i ) { PutTypeBin( i ); }
+	void PutUnsignedInt( unsigned int u ) { PutTypeBin( u ); }
+	void PutFloat( float f ) { PutTypeBin( f ); }
+	void PutDouble( double d ) { PutTypeBin( d ); }
+	void PutString( const char* pString );
+	void Put( const void* pMem, int nSize );
+	// Used for putting objects that have a byteswap datadesc defined
+	template<typename T>
+	void PutObjects( T* src, int count = 1 );
+
+	/**
+	 * Appends memory owned by someone else as its own segment, without copying it.
+	 * The memory must stay valid until `pfnFree` is called, or until the buffer is cleared if it's `nullptr`.
+	 * Since the memory isn't ours, it's never written to, and the next put starts a new segment.
+	 */
+	void PutExternal( const void* pMemory, int nSize, FreeFunc_t pfnFree = nullptr, void* pContext = nullptr );
+	// Moves the segments of another buffer to the end of this one, leaving it empty
+	void PutSegments( CUtlSegmentedBuffer& other );
+
+	// Where am I writing (put)/reading (get)?
+	int TellPut() const { return m_nPut; }
+	int TellGet() const { return m_nGet; }
+	int GetBytesRemaining() const { return m_nPut - m_nGet; }
+	void SeekGet( SeekType_t type, int offset );
+
+	// Am I valid? (underflow error), Once invalid it stays invalid
+	bool IsValid() const { return not m_bGetOverflow; }
+
+	// Scatter-gather access to the data from the get position onwards
+	int GetSegmentCount() const { return m_Segments.Count(); }
+	int GetIOVecs( CUtlVector<IOVec_t>& vecs ) const;
+
+	// Writes the data from the get position onwards, a segment at a time; doesn't move the get position
+	bool WriteToFile( IBaseFileSystem* pFileSystem, FileHandle_t hFile ) const;
+	// Appends up to nSize bytes read from the file straight into segments, returns how many were read
+	int ReadFromFile( IBaseFileSystem* pFileSystem, FileHandle_t hFile, int nSize );
+	// Flattens the data from the get position onwards, for the APIs which need it contiguous
+	void CopyTo( CUtlBuffer& buf ) const;
+private:
+	struct Segment_t {
+		byte* m_pData;
+		int m_nStart;     // offset of the segment in the buffer
+		int m_nSize;
+		int m_nCapacity;  // same as the size for external segments, which are read-only
+		FreeFunc_t m_pfnFree;
+		void* m_pFreeContext;
+		bool m_bExternal;
+	};
+
+	template<typename T>
+	T GetTypeBin();
+	template<typename T>
+	void PutTypeBin( T src );
+
+	void GetStringInternal( char* pString, size_t maxLenInChars );
+	// Spreads the data over the tail segment and as many new ones as needed
+	void PutSlow( const void* pMem, int nSize );
+	void AllocSegment();
+	void ReleaseSegment( Segment_t& segment, bool bKeepSpare );
+	// Moves the get position to the next segment when the current one is exhausted
+	void SkipExhaustedSegments();
+
+	CUtlVector<Segment_t> m_Segments;
+	CUtlVector<byte*> m_SpareSegments;  // owned segments of the default size, from a previous clear
+	int m_nSegmentSize;
+
+	int m_nPut{ 0 };
+	int m_nGet{ 0 };
+	int m_nGetSegment{ 0 };
+	int m_nGetOffset{ 0 };  // in the get segment
+	bool m_bGetOverflow{ false };
+
+	CByteswap m_Byteswap;
+};
+
+
+inline void CUtlSegmentedBuffer::Put( const void* pMem, int nSize ) {
+	if ( nSize <= 0 ) {
+		return;
+	}
+	// most puts fit in the tail segment
+	if ( m_Segments.Count() ) {
+		auto& tail{ m_Segments.Tail() };
+		if ( tail.m_nCapacity - tail.m_nSize >= nSize ) {
+			memcpy( tail.m_pData + tail.m_nSize, pMem, nSize );
+			tail.m_nSize += nSize;
+			m_nPut += nSize;
+			return;
+		}
+	}
+
+	PutSlow( pMem, nSize );
+}
+
+template<typename T>
+inline T CUtlSegmentedBuffer::GetTypeBin() {
+	T dest;
+	if ( m_nGetSegment < m_Segments.Count() and m_Segments[ m_nGetSegment ].m_nSize - m_nGetOffset >= static_cast<int>( sizeof( T ) ) ) {
+		memcpy( &dest, m_Segments[ m_nGetSegment ].m_pData + m_nGetOffset, sizeof( T ) );
+		m_nGetOffset += sizeof( T );
+		m_nGet += sizeof( T );
+	} else {
+		// straddles two segments, or there's nothing left
+		Get( &dest, sizeof( T ) );
+	}
+
+	if ( m_Byteswap.IsSwappingBytes() and sizeof( T ) > 1 ) {
+		m_Byteswap.SwapBufferToTargetEndian<T>( &dest, &dest );
+	}
+	return dest;
+}
+
+template<typename T>
+inline void CUtlSegmentedBuffer::PutTypeBin( T src ) {
+	if ( m_Byteswap.IsSwappingBytes() and sizeof( T ) > 1 ) {
+		m_Byteswap.SwapBufferToTargetEndian<T>( &src, &src );
+	}
+	Put( &src, sizeof( T ) );
+}
+
+template<typename T>
+inline void CUtlSegmentedBuffer::GetObjects( T* dest, int count ) {
+	Get( dest, sizeof( T ) * count );
+	if ( m_Byteswap.IsSwappingBytes() ) {
+		for ( auto i{ 0 }; i < count; i += 1 ) {
+			m_Byteswap.SwapFieldsToTargetEndian<T>( &dest[ i ] );
+		}
+	}
+}
+
+template<typename T>
+inline void CUtlSegmentedBuffer::PutObjects( T* src, int count ) {
+	if (! m_Byteswap.IsSwappingBytes() ) {
+		Put( src, sizeof( T ) * count );
+		return;
+	}
+	for ( auto i{ 0 }; i < count; i += 1 ) {
+		T swapped;
+		m_Byteswap.SwapFieldsToTargetEndian<T>( &swapped, &src[ i ] );
+		Put( &swapped, sizeof( T ) );
+	}
+}
@@ -9,6 +9,7 @@
 #include "tier0/threadtools.h"
 #include "tier1/utlrbtree.h"
 #include "tier1/utlvector.h"
+#include <atomic>
 
 
 //-----------------------------------------------------------------------------
@@ -193,6 +194,94 @@ private:
 };
 
 
+//-----------------------------------------------------------------------------
+// CUtlSymbolTableHashed:
+// description:
+//    A thread safe symbol table with 32-bit ids, for tables which are big or
+//    hot enough for `CUtlSymbolTableMT`'s 16-bit ids and lock to get in the way.
+//    Lookups are lock-free: strings are found through an open addressing
+//    hash index, with the hash of every string computed once and kept beside it.
+//    Adds only lock one of several stripes, picked by the string's hash.
+//-----------------------------------------------------------------------------
+typedef uint32 UtlSymId32_t;
+#define UTL_INVAL_SYMBOL32 static_cast<UtlSymId32_t>( ~0u )
+
+class CUtlSymbolTableHashed {
+public:
+	explicit CUtlSymbolTableHashed( bool caseInsensitive = false );
+	~CUtlSymbolTableHashed();
+
+	// Finds and/or creates a symbol based on the string
+	UtlSymId32_t AddString( const char* pString );
+
+	// Finds the symbol for pString
+	[[nodiscard]]
+	UtlSymId32_t Find( const char* pString ) const;
+
+	// Look up the string associated with a particular symbol
+	[[nodiscard]]
+	const char* String( UtlSymId32_t id ) const;
+
+	// The hash of the string associated with a particular symbol
+	[[nodiscard]]
+	uint32 Hash( UtlSymId32_t id ) const;
+
+	[[nodiscard]]
+	int GetNumStrings() const { return static_cast<int>( m_nCount.load( std::memory_order_acquire ) ); }
+
+	// Remove all symbols in the table, must not race with any other call.
+	void RemoveAll();
+private:
+	struct Entry_t {
+		const char* m_pString;
+		uint32 m_nHash;
+		uint32 m_nLength;
+	};
+	// Entries are in segments which never move, each twice as big as the previous one
+	static constexpr int FIRST_SEGMENT_BITS{ 8 };
+	static constexpr int SEGMENT_COUNT{ 32 - FIRST_SEGMENT_BITS };
+
+	// `m_nId` is the id + 1, so that 0 is an empty slot
+	struct Slot_t {
+		std::atomic<uint32> m_nHash;
+		std::atomic<uint32> m_nId;
+	};
+	struct Table_t {
+		uint32 m_nMask;
+		Slot_t* m_pSlots;
+	};
+	static constexpr uint32 RESERVED_SLOT{ ~0u };  // being filled in by an add
+	static constexpr int STRIPE_COUNT{ 16 };
+	static constexpr int STRING_PAGE_SIZE{ 64 * 1024 };
+
+	[[nodiscard]]
+	uint32 HashOf( const char* pString, uint32 nLength ) const;
+	[[nodiscard]]
+	const Entry_t& EntryOf( UtlSymId32_t id ) const;
+	[[nodiscard]]
+	UtlSymId32_t Lookup( const Table_t* pTable, const char* pString, uint32 nLength, uint32 nHash ) const;
+	// Copies the string in the pool, and gives it an id
+	UtlSymId32_t AllocEntry( const char* pString, uint32 nLength, uint32 nHash );
+	static void Insert( Table_t* pTable, uint32 nHash, UtlSymId32_t id );
+	static Table_t* AllocTable( uint32 nCapacity );
+	void Grow();
+private:
+	bool m_bInsensitive;
+
+	std::atomic<Table_t*> m_pTable{ nullptr };
+	CUtlVector<Table_t*> m_RetiredTables{};  // readers may still be probing these
+	// writers hold it for read, growing the index holds it for write
+	mutable CThreadRWLock m_IndexLock{};
+	CThreadFastMutex m_Stripes[ STRIPE_COUNT ]{};
+
+	// entries and strings
+	CThreadFastMutex m_PoolMutex{};
+	Entry_t* m_pSegments[ SEGMENT_COUNT ]{};
+	std::atomic<uint32> m_nCount{ 0 };
+	CUtlVector<char*> m_StringPages{};
+	int m_nPageUsed{ STRING_PAGE_SIZE };
+};
+
 //-----------------------------------------------------------------------------
 // CUtlFilenameSymbolTable:
 // description:
@@ -0,0 +1,249 @@
+//
+// Created by ENDERZOMBI102 on 18/10/2026.
+//
+// Purpose: C++20 coroutines which run on an `IThreadPool`.
+//          A coroutine returning `CJobCoroutine` can `co_await` other coroutines, `CJob`s
+//          and `IFileSystem::AsyncRead` completions; when what it waited on is done,
+//          the rest of it is queued back onto the pool as a job.
+//
+#pragma once
+#include "filesystem.h"
+#include "vstdlib/jobthread.h"
+#include <atomic>
+#include <coroutine>
+#include <utility>
+
+
+// Coroutine frames are recycled through size-classed free lists
+JOB_INTERFACE void* JobCoroutine_AllocFrame( size_t size );
+JOB_INTERFACE void JobCoroutine_FreeFrame( void* pFrame, size_t size );
+
+// Queues the resumption of a coroutine on a pool
+inline void JobCoroutine_Schedule( IThreadPool* pPool, std::coroutine_handle<> handle, JobPriority_t priority = JP_NORMAL ) {
+	const auto job{ CreateLambdaJob( [handle] { handle.resume(); }, priority ) };
+	job->SetDescription( "JobCoroutine" );
+	pPool->AddJob( job );
+	job->Release();
+}
+
+
+class CJobCoroutine {
+public:
+	struct promise_type {
+		static void* operator new( size_t size ) { return JobCoroutine_AllocFrame( size ); }
+		static void operator delete( void* pFrame, size_t size ) { JobCoroutine_FreeFrame( pFrame, size ); }
+
+		CJobCoroutine get_return_object() { return CJobCoroutine{ std::coroutine_handle<promise_type>::from_promise( *this ) }; }
+		std::suspend_always initial_suspend() noexcept { return {}; }
+		auto final_suspend() noexcept {
+			struct FinalAwaiter_t {
+				bool await_ready() noexcept { return false; }
+				void await_suspend( std::coroutine_handle<promise_type> handle ) noexcept {
+					auto& promise{ handle.promise() };
+					// whoever awaits us gets queued, plain waiters get signaled
+					const auto continuation{ promise.m_Continuation.exchange( FINISHED ) };
+					promise.m_Finished.Set();
+					if ( continuation != nullptr ) {
+						JobCoroutine_Schedule( promise.m_pPool, std::coroutine_handle<>::from_address( continuation ) );
+					}
+					promise.Release( handle );
+				}
+				void await_resume() noexcept { }
+			};
+			return FinalAwaiter_t{};
+		}
+		void return_void() { }
+		void unhandled_exception() {
+			AssertMsg( false, "Unhandled exception in job coroutine" );
+			std::terminate();
+		}
+
+		void Release( std::coroutine_handle<promise_type> handle ) {
+			if ( --m_nRefs == 0 ) {
+				handle.destroy();
+			}
+		}
+
+		// marks "finished" in `m_Continuation`
+		static inline void* const FINISHED{ reinterpret_cast<void*>( 1 ) };
+
+		IThreadPool* m_pPool{ nullptr };
+		CThreadEvent m_Finished{ true };
+		std::atomic<void*> m_Continuation{ nullptr };
+		CInterlockedInt m_nRefs{ 2 };  // the `CJobCoroutine` and the running coroutine
+		bool m_bStarted{ false };
+	};
+	using Handle_t = std::coroutine_handle<promise_type>;
+
+	CJobCoroutine() = default;
+	CJobCoroutine( CJobCoroutine&& other ) noexcept : m_Handle( std::exchange( other.m_Handle, nullptr ) ) { }
+	CJobCoroutine& operator=( CJobCoroutine&& other ) noexcept {
+		if ( this != &other ) {
+			Detach();
+			m_Handle = std::exchange( other.m_Handle, nullptr );
+		}
+		return *this;
+	}
+	CJobCoroutine( const CJobCoroutine& ) = delete;
+	CJobCoroutine& operator=( const CJobCoroutine& ) = delete;
+	~CJobCoroutine() { Detach(); }
+
+	/**
+	 * Queues the coroutine on the pool, it will resume there after every await too.
+	 * Awaiting a coroutine which wasn't started starts it on the awaiter's pool.
+	 */
+	void Start( IThreadPool* pPool = nullptr, JobPriority_t priority = JP_NORMAL ) {
+		auto& promise{ m_Handle.promise() };
+		if ( promise.m_bStarted ) {
+			return;
+		}
+		promise.m_bStarted = true;
+		promise.m_pPool = pPool ? pPool : g_pThreadPool;
+		JobCoroutine_Schedule( promise.m_pPool, m_Handle, priority );
+	}
+
+	[[nodiscard]]
+	bool IsValid() const { return static_cast<bool>( m_Handle ); }
+	[[nodiscard]]
+	bool IsFinished() const { return m_Handle.promise().m_Continuation.load() == promise_type::FINISHED; }
+
+	/**
+	 * Blocks until the coroutine completes, running pool jobs in the meantime.
+	 * Not for use inside a coroutine, `co_await` it instead.
+	 */
+	bool WaitForFinish( unsigned timeout = TT_INFINITE ) {
+		auto& promise{ m_Handle.promise() };
+		Start();
+		return IsFinished() or promise.m_pPool->YieldWait( promise.m_Finished, timeout );
+	}
+
+	// co_await support
+	bool await_ready() const { return IsFinished(); }
+	bool await_suspend( Handle_t awaiter ) {
+		auto& promise{ m_Handle.promise() };
+		if (! promise.m_bStarted ) {
+			promise.m_bStarted = true;
+			promise.m_pPool = awaiter.promise().m_pPool;
+			// register before running it, so it can't finish unnoticed
+			promise.m_Continuation = awaiter.address();
+			JobCoroutine_Schedule( promise.m_pPool, m_Handle );
+			return true;
+		}
+
+		void* expected{ nullptr };
+		// false if it finished in the meantime: don't suspend at all
+		return promise.m_Continuation.compare_exchange_strong( expected, awaiter.address() );
+	}
+	void await_resume() const { }
+private:
+	explicit CJobCoroutine( Handle_t handle ) : m_Handle( handle ) { }
+
+	void Detach() {
+		if (! m_Handle ) {
+			return;
+		}
+		if ( m_Handle.promise().m_bStarted ) {
+			m_Handle.promise().Release( m_Handle );
+		} else {
+			// never ran, so nobody else holds it
+			m_Handle.destroy();
+		}
+		m_Handle = nullptr;
+	}
+private:
+	Handle_t m_Handle{ nullptr };
+};
+
+
+//-----------------------------------------------------------------------------
+// Awaitables
+//
+// Each resumes the coroutine from the completion of what it waits on, by queueing it back
+// onto its pool; no thread sits blocked in the meantime.
+// There is no `CThreadEvent` awaiter: events have no completion hook to resume from,
+// wait on the job or coroutine which sets the event instead.
+//-----------------------------------------------------------------------------
+
+class CJobAwaiter {
+public:
+	explicit CJobAwaiter( CJob* pJob ) : m_pJob( pJob ) { }
+
+	bool await_ready() const { return m_pJob == nullptr or m_pJob->IsFinished(); }
+	bool await_suspend( CJobCoroutine::Handle_t awaiter ) {
+		m_Awaiter = awaiter;
+		// false if it finished in the meantime: don't suspend at all
+		return m_pJob->AddCompletionCallback( &CJobAwaiter::OnComplete, this );
+	}
+	JobStatus_t await_resume() const { return m_pJob ? m_pJob->GetStatus() : JOB_OK; }
+private:
+	static void OnComplete( CJob* pJob, void* pContext ) {
+		const auto awaiter{ static_cast<CJobAwaiter*>( pContext )->m_Awaiter };
+		JobCoroutine_Schedule( awaiter.promise().m_pPool, awaiter );
+	}
+
+	CJob* m_pJob;
+	CJobCoroutine::Handle_t m_Awaiter{ nullptr };
+};
+inline CJobAwaiter operator co_await( CJob& job ) { return CJobAwaiter{ &job }; }
+
+
+/**
+ * Awaits an `IFileSystem::AsyncRead`, the coroutine is queued back on its pool from the completion callback.
+ * Filesystems which service the read before `AsyncRead` returns (filesystem_stdio always does) resume it inline instead.
+ * If the request has no buffer, the filesystem allocates one and the awaiter takes ownership of it
+ * (free with `IFileSystem::FreeOptimalReadBuffer()`).
+ */
+class CAsyncReadAwaiter {
+public:
+	struct Result_t {
+		FSAsyncStatus_t m_Status;
+		void* m_pData;
+		int m_nBytesRead;
+	};
+
+	CAsyncReadAwaiter( IFileSystem* pFileSystem, const FileAsyncRequest_t& request )
+		: m_pFileSystem( pFileSystem ), m_Request( request ) { }
+
+	bool await_ready() const { return false; }
+	bool await_suspend( CJobCoroutine::Handle_t awaiter ) {
+		m_Awaiter = awaiter;
+		m_Request.pfnCallback = &CAsyncReadAwaiter::OnComplete;
+		m_Request.pContext = this;
+		if ( m_Request.pData == nullptr ) {
+			m_Request.flags = ( m_Request.flags | FSASYNC_FLAGS_ALLOCNOFREE ) & ~FSASYNC_FLAGS_FREEDATAPTR;
+		}
+
+		const auto status{ m_pFileSystem->AsyncRead( m_Request, nullptr ) };
+		if ( status < FSASYNC_OK ) {
+			// the callback won't come, carry on with the error
+			m_Result = { status, nullptr, 0 };
+			return false;
+		}
+		// if the callback already ran, nobody is going to queue us: carry on here
+		auto state{ STATE_STARTING };
+		return m_State.compare_exchange_strong( state, STATE_SUSPENDED, std::memory_order_acq_rel );
+	}
+	Result_t await_resume() const { return m_Result; }
+private:
+	static void OnComplete( const FileAsyncRequest_t& request, int nBytesRead, FSAsyncStatus_t err ) {
+		const auto self{ static_cast<CAsyncReadAwaiter*>( request.pContext ) };
+		self->m_Result = { err, request.pData, nBytesRead };
+		const auto awaiter{ self->m_Awaiter };
+		if ( self->m_State.exchange( STATE_COMPLETED, std::memory_order_acq_rel ) == STATE_SUSPENDED ) {
+			// don't run the rest of the coroutine on the filesystem's thread
+			JobCoroutine_Schedule( awaiter.promise().m_pPool, awaiter );
+		}
+	}
+
+	enum State_t { STATE_STARTING, STATE_SUSPENDED, STATE_COMPLETED };
+
+	IFileSystem* m_pFileSystem;
+	FileAsyncRequest_t m_Request;
+	CJobCoroutine::Handle_t m_Awaiter{ nullptr };
+	Result_t m_Result{ FSASYNC_STATUS_PENDING, nullptr, 0 };
+	std::atomic<State_t> m_State{ STATE_STARTING };
+};
+
+inline CAsyncReadAwaiter AsyncReadAwait( IFileSystem* pFileSystem, const FileAsyncRequest_t& request ) {
+	return CAsyncReadAwaiter{ pFileSystem, request };
+}
@@ -0,0 +1,111 @@
+//
+// Created by ENDERZOMBI102 on 18/10/2026.
+//
+#pragma once
+#include "tier1/functors.h"
+#include "tier1/utlvector.h"
+#include "vstdlib/jobthread.h"
+#include <initializer_list>
+
+
+using JobGraphTask_t = int;
+static constexpr JobGraphTask_t JOB_GRAPH_INVALID_TASK{ -1 };
+
+/**
+ * A set of tasks with dependencies between them, executed on an `IThreadPool`.
+ *
+ * A task is started as soon as all of its predecessors finished; the first successor
+ * made ready by a task is run right after it on the same thread, the others are queued.
+ * The graph's structure is kept between runs, so it can be built once and run every frame.
+ */
+class JOB_CLASS CJobGraph {
+public:
+	explicit CJobGraph( const char* pszName = "JobGraph", IThreadPool* pPool = nullptr );
+	~CJobGraph();
+
+	/**
+	 * Adds a task to the graph, can't be called while the graph is running.
+	 * @param pszName Name of the task, used in telemetry and timing dumps.
+	 * @param pFunctor The work to do, the graph takes over the reference.
+	 * @param predecessors Tasks which have to finish before this one can start.
+	 * @return The handle of the new task.
+	 */
+	JobGraphTask_t AddTask( const char* pszName, CFunctor* pFunctor, std::initializer_list<JobGraphTask_t> predecessors = {}, JobPriority_t priority = JP_NORMAL );
+	/**
+	 * Makes `task` wait on `predecessor`, can't be called while the graph is running.
+	 */
+	void AddDependency( JobGraphTask_t task, JobGraphTask_t predecessor );
+	// Removes every task
+	void RemoveAll();
+
+	[[nodiscard]]
+	int TaskCount() const { return m_Tasks.Count(); }
+	[[nodiscard]]
+	const char* GetName() const { return m_szName; }
+
+	/**
+	 * Queues the tasks without predecessors and returns immediately.
+	 */
+	void Start();
+	/**
+	 * Waits for the current run to finish, helping the pool execute jobs in the meantime.
+	 * @return true if every task got executed, false on timeout or cancellation.
+	 */
+	bool WaitForFinish( unsigned timeout = TT_INFINITE );
+	// Start() + WaitForFinish()
+	bool Run( unsigned timeout = TT_INFINITE ) {
+		Start();
+		return WaitForFinish( timeout );
+	}
+	[[nodiscard]]
+	bool IsRunning() const { return m_nRemaining != 0; }
+
+	/**
+	 * Skips every task of the current run which didn't start yet, tasks already running are let finish.
+	 */
+	void Cancel();
+	[[nodiscard]]
+	bool IsCancelled() const { return m_bCancelled; }
+
+	/**
+	 * Prints when, where and for how long each task of the last run executed.
+	 */
+	void DumpTimings() const;
+	// Duration of the last run of a task, in seconds
+	[[nodiscard]]
+	double GetTaskDuration( JobGraphTask_t task ) const;
+private:
+	struct Task_t {
+		const char* m_pszName;
+		CFunctor* m_pFunctor;
+		JobPriority_t m_Priority;
+		CUtlVector<JobGraphTask_t> m_Successors;
+		int m_nPredecessors;
+		CInterlockedInt m_nPending;  // predecessors left to finish in the current run
+		// timings of the last run
+		double m_flStart;
+		double m_flEnd;
+		ThreadId_t m_Thread;
+		bool m_bSkipped;
+	};
+
+	void Submit( JobGraphTask_t task );
+	// Executes a task and the chain of successors it made ready
+	void Execute( JobGraphTask_t task );
+	[[nodiscard]]
+	bool IsAcyclic() const;
+
+	friend class CJobGraphTaskJob;
+private:
+	const char* m_szName;
+	IThreadPool* m_pPool;
+	CUtlVector<Task_t*> m_Tasks{};
+	CUtlVector<JobGraphTask_t> m_Roots{};
+	bool m_bValidated{ false };
+
+	CInterlockedInt m_nRemaining;
+	CInterlockedInt m_bCancelled;
+	CThreadEvent m_Finished{ true };
+	double m_flStart{ 0 };
+	double m_flEnd{ 0 };
+};
@@ -33,6 +33,7 @@
 #include "tier1/refcount.h"
 #include "tier1/utllinkedlist.h"
 #include "tier1/utlvector.h"
+#include <algorithm>
 #include <climits>
 #include "vstdlib/vstdlib.h"
 
@@ -502,6 +503,20 @@ public:
 	}
 	CThreadEvent* AccessEvent() { return &m_CompleteEvent; }
 
+	//-----------------------------------------------------
+	// Completion callbacks, each runs once on the thread which finishes or aborts the job.
+	// Returns false without registering the callback if the job is already finished.
+	//-----------------------------------------------------
+	using CompletionFn_t = void (*)( CJob* pJob, void* pContext );
+	bool AddCompletionCallback( CompletionFn_t pfnCallback, void* pContext ) {
+		AUTO_LOCK_FM( m_CallbackMutex );
+		if ( IsFinished() ) {
+			return false;
+		}
+		m_CompletionCallbacks.AddToTail( { pfnCallback, pContext } );
+		return true;
+	}
+
 	//-----------------------------------------------------
 	// Perform the job
 	//-----------------------------------------------------
@@ -549,9 +564,17 @@ private:
 	CThreadEvent m_CompleteEvent;
 	char m_szDescription[32];
 
+	struct CompletionCallback_t {
+		CompletionFn_t m_pfnCallback;
+		void* m_pContext;
+	};
+	CThreadFastMutex m_CallbackMutex;
+	CUtlVector<CompletionCallback_t> m_CompletionCallbacks;
+
 private:
 	//-----------------------------------------------------
 	CJob( const CJob& fromRequest );
+	void RunCompletionCallbacks();
 	void operator=( const CJob& fromRequest );
 
 	virtual JobStatus_t DoExecute() = 0;
@@ -1082,6 +1105,181 @@ private:
 };
 
 
+//-----------------------------------------------------------------------------
+// Work splitting: adaptive, ranges are halved and given away for as long as
+// the pool has idle threads, the caller always works on a piece itself.
+// Waiting is done through `YieldWait`, so these are safe to nest inside jobs.
+//-----------------------------------------------------------------------------
+
+template<typename FUNCTION>
+class CLambdaJob : public CJob {
+public:
+	explicit CLambdaJob( FUNCTION function, JobPriority_t priority = JP_NORMAL )
+		: CJob( priority ), m_Function( std::move( function ) ) { }
+
+private:
+	JobStatus_t DoExecute() override {
+		m_Function();
+		return JOB_OK;
+	}
+
+	FUNCTION m_Function;
+};
+
+template<typename FUNCTION>
+inline CJob* CreateLambdaJob( FUNCTION&& function, JobPriority_t priority = JP_NORMAL ) {
+	return new CLambdaJob<std::decay_t<FUNCTION>>( std::forward<FUNCTION>( function ), priority );
+}
+
+// Calls `function( from, to )` on sub-ranges of [from, to) no smaller than `grain` (unless the whole range is).
+template<typename INDEX_TYPE, typename FUNCTION>
+void ParallelForRange( INDEX_TYPE from, INDEX_TYPE to, const FUNCTION& function, INDEX_TYPE grain = 1, IThreadPool* pPool = nullptr ) {
+	if ( pPool == nullptr ) {
+		pPool = g_pThreadPool;
+	}
+	grain = std::max( grain, static_cast<INDEX_TYPE>( 1 ) );
+
+	// every split halves the range, so this can't overflow
+	CUtlVectorFixedGrowable<CJob*, 16> jobs;
+	while ( pPool and to - from > grain and pPool->NumIdleThreads() > 0 ) {
+		const INDEX_TYPE mid{ static_cast<INDEX_TYPE>( from + ( to - from ) / 2 ) };
+		const auto job{ CreateLambdaJob( [mid, to, &function, grain, pPool] { ParallelForRange( mid, to, function, grain, pPool ); } ) };
+		pPool->AddJob( job );
+		jobs.AddToTail( job );
+		to = mid;
+	}
+
+	function( from, to );
+
+	if ( jobs.Count() ) {
+		pPool->YieldWait( jobs.Base(), jobs.Count() );
+		for ( const auto job : jobs ) {
+			job->Release();
+		}
+	}
+}
+
+// Calls `function( i )` for every i in [from, to).
+template<typename INDEX_TYPE, typename FUNCTION>
+void ParallelFor( INDEX_TYPE from, INDEX_TYPE to, const FUNCTION& function, INDEX_TYPE grain = 1, IThreadPool* pPool = nullptr ) {
+	ParallelForRange(
+		from, to,
+		[&function]( INDEX_TYPE first, INDEX_TYPE last ) {
+			for ( INDEX_TYPE i{ first }; i < last; ++i ) {
+				function( i );
+			}
+		},
+		grain, pPool
+	);
+}
+
+template<typename ITEM_TYPE, typename FUNCTION>
+void ParallelFor( CUtlVector<ITEM_TYPE>& items, const FUNCTION& function, int grain = 1, IThreadPool* pPool = nullptr ) {
+	ITEM_TYPE* pBase{ items.Base() };
+	ParallelFor( 0, items.Count(), [pBase, &function]( int i ) { function( pBase[i] ); }, grain, pPool );
+}
+
+/**
+ * Folds [from, to) into a single value.
+ * @param identity The neutral element of `reduce`, each piece starts from it.
+ * @param map `T( INDEX_TYPE first, INDEX_TYPE last, T init )`, accumulates a sub-range on top of `init`.
+ * @param reduce `T( const T& left, const T& right )`, must be associative; pieces are combined in index order.
+ */
+template<typename T, typename INDEX_TYPE, typename MAP, typename REDUCE>
+T ParallelReduce( INDEX_TYPE from, INDEX_TYPE to, const T& identity, const MAP& map, const REDUCE& reduce, INDEX_TYPE grain = 1, IThreadPool* pPool = nullptr ) {
+	if ( pPool == nullptr ) {
+		pPool = g_pThreadPool;
+	}
+	grain = std::max( grain, static_cast<INDEX_TYPE>( 1 ) );
+
+	// each split off piece keeps its partial result in its job
+	struct Piece_t {
+		explicit Piece_t( const T& init ) : m_Result( init ) {}
+		T m_Result;
+		CJob* m_pJob{ nullptr };
+	};
+	CUtlVectorFixedGrowable<Piece_t*, 16> pieces;
+
+	while ( pPool and to - from > grain and pPool->NumIdleThreads() > 0 ) {
+		const INDEX_TYPE mid{ static_cast<INDEX_TYPE>( from + ( to - from ) / 2 ) };
+		const auto piece{ new Piece_t( identity ) };
+		piece->m_pJob = CreateLambdaJob( [piece, mid, to, &identity, &map, &reduce, grain, pPool] {
+			piece->m_Result = ParallelReduce( mid, to, identity, map, reduce, grain, pPool );
+		} );
+		pPool->AddJob( piece->m_pJob );
+		pieces.AddToTail( piece );
+		to = mid;
+	}
+
+	T result{ map( from, to, identity ) };
+
+	// the last piece split off is the closest to ours
+	for ( auto i{ pieces.Count() - 1 }; i >= 0; i -= 1 ) {
+		pPool->YieldWait( pieces[i]->m_pJob );
+		result = reduce( result, pieces[i]->m_Result );
+		pieces[i]->m_pJob->Release();
+		delete pieces[i];
+	}
+
+	return result;
+}
+
+/**
+ * Sorts [pBase, pBase + nCount) with a parallel quicksort, pieces smaller than `grain` are sorted with `std::sort`.
+ * Not stable.
+ */
+template<typename T, typename LESS>
+void ParallelSort( T* pBase, int nCount, const LESS& less, int grain = 2048, IThreadPool* pPool = nullptr ) {
+	if ( pPool == nullptr ) {
+		pPool = g_pThreadPool;
+	}
+
+	CUtlVectorFixedGrowable<CJob*, 16> jobs;
+	while ( pPool and nCount > std::max( grain, 2 ) and pPool->NumIdleThreads() > 0 ) {
+		// median of three, copied out since partitioning moves things around
+		T* pMid{ pBase + nCount / 2 };
+		T* pLast{ pBase + nCount - 1 };
+		if ( less( *pMid, *pBase ) ) {
+			std::swap( *pMid, *pBase );
+		}
+		if ( less( *pLast, *pMid ) ) {
+			std::swap( *pLast, *pMid );
+			if ( less( *pMid, *pBase ) ) {
+				std::swap( *pMid, *pBase );
+			}
+		}
+		const T pivot{ *pMid };
+
+		// [ < pivot | == pivot | > pivot ]
+		T* pEqual{ std::partition( pBase, pBase + nCount, [&]( const T& item ) { return less( item, pivot ); } ) };
+		T* pGreater{ std::partition( pEqual, pBase + nCount, [&]( const T& item ) { return not less( pivot, item ); } ) };
+
+		// give away the upper part, keep working on the lower one
+		const int nGreater{ static_cast<int>( pBase + nCount - pGreater ) };
+		if ( nGreater > 1 ) {
+			const auto job{ CreateLambdaJob( [pGreater, nGreater, &less, grain, pPool] { ParallelSort( pGreater, nGreater, less, grain, pPool ); } ) };
+			pPool->AddJob( job );
+			jobs.AddToTail( job );
+		}
+		nCount = static_cast<int>( pEqual - pBase );
+	}
+
+	std::sort( pBase, pBase + nCount, less );
+
+	if ( jobs.Count() ) {
+		pPool->YieldWait( jobs.Base(), jobs.Count() );
+		for ( const auto job : jobs ) {
+			job->Release();
+		}
+	}
+}
+
+template<typename T>
+void ParallelSort( T* pBase, int nCount, int grain = 2048, IThreadPool* pPool = nullptr ) {
+	ParallelSort( pBase, nCount, []( const T& left, const T& right ) { return left < right; }, grain, pPool );
+}
+
+
 //-----------------------------------------------------------------------------
 // Raw thread launching
 //-----------------------------------------------------------------------------
@@ -1183,6 +1381,7 @@ inline JobStatus_t CJob::Execute() {
 			result = m_status = DoExecute();
 			DoCleanup();
 			m_CompleteEvent.Set();
+			RunCompletionCallbacks();
 			break;
 		}
 
@@ -1206,6 +1405,20 @@ inline JobStatus_t CJob::Execute() {
 }
 
 
+//---------------------------------------------------------
+
+inline void CJob::RunCompletionCallbacks() {
+	// take them out first, so they don't run under the callback lock
+	CUtlVector<CompletionCallback_t> callbacks;
+	{
+		AUTO_LOCK_FM( m_CallbackMutex );
+		callbacks.Swap( m_CompletionCallbacks );
+	}
+	for ( const auto& callback : callbacks ) {
+		callback.m_pfnCallback( this, callback.m_pContext );
+	}
+}
+
 //---------------------------------------------------------
 
 inline JobStatus_t CJob::TryExecute() {
@@ -1245,6 +1458,7 @@ inline JobStatus_t CJob::Abort( bool bDiscard ) {
 				DoCleanup();
 			}
 			m_CompleteEvent.Set();
+			RunCompletionCallbacks();
 		} break;
 
 		case JOB_STATUS_ABORTED:
@@ -40,9 +40,17 @@ public:
 
 		return rotr32( static_cast<uint32_t>( x >> 27 ), count );
 	}
-	// e.discard(z)
+	// e.discard(z), in O(log z)
 	void discard( unsigned long long n );
 
+	/**
+	 * Fills `pOut` with the next `count` values, the same as calling `operator()` that many times.
+	 * Several steps of the generator are computed at once in SIMD lanes (SSE2, AVX2 when available).
+	 */
+	void Generate( uint32_t* pOut, size_t count );
+	// Same as `Generate`, mapped to floats in [flMin, flMax)
+	void GenerateFloats( float* pOut, size_t count, float flMin = 0.0f, float flMax = 1.0f );
+
 	// x == y
 	bool operator==( const PcgEngine& rhs ) const;
 	// x != y
@@ -56,6 +64,9 @@ public:
 	static constexpr result_type min() { return 0; }
 	static constexpr result_type max() { return std::numeric_limits<uint32_t>::max(); }
 private:
+	// Coefficients which advance the state by `delta` steps: `state * mult + plus`
+	static void JumpCoefficients( unsigned long long delta, uint64_t& mult, uint64_t& plus );
+
 	uint64_t m_luState;
 
 	static constexpr uint64_t multiplier{ 6364136223846793005u };
@@ -11,6 +11,7 @@
 #include "tier0/basetypes.h"
 #include "tier0/threadtools.h"
 #include "vstdlib/vstdlib.h"
+#include <xmmintrin.h>
 
 #if defined( _MSC_VER )
 	#pragma warning( push )
@@ -49,6 +50,10 @@ public:
 	int RandomInt( int iMinVal, int iMaxVal ) override;
 	float RandomFloatExp( float flMinVal = 0.0f, float flMaxVal = 1.0f, float flExponent = 1.0f ) override;
 
+	// Bulk versions, a single lock and SIMD generation for the whole span
+	void RandomFloats( float* pOut, int nCount, float flMinVal = 0.0f, float flMaxVal = 1.0f );
+	void RandomInts( int* pOut, int nCount, int iMinVal, int iMaxVal );
+
 private:
 	friend class CGaussianRandomStream;
 	PcgEngine m_Engine;
@@ -87,6 +92,14 @@ VSTDLIB_INTERFACE float RandomFloatExp( float flMinVal = 0.0f, float flMaxVal =
 VSTDLIB_INTERFACE int RandomInt( int iMinVal, int iMaxVal );
 VSTDLIB_INTERFACE float RandomGaussianFloat( float flMean = 0.0f, float flStdDev = 1.0f );
 
+// Fill a span with random numbers in one call, from the installed stream
+VSTDLIB_INTERFACE void RandomFloats( float* pOut, int nCount, float flMinVal = 0.0f, float flMaxVal = 1.0f );
+VSTDLIB_INTERFACE void RandomInts( int* pOut, int nCount, int iMinVal, int iMaxVal );
+// for `fltx4` spans
+inline void RandomFloats( __m128* pOut, int nCount, float flMinVal = 0.0f, float flMaxVal = 1.0f ) {
+	RandomFloats( reinterpret_cast<float*>( pOut ), nCount * 4, flMinVal, flMaxVal );
+}
+
 //-----------------------------------------------------------------------------
 // IUniformRandomStream interface for free functions
 //-----------------------------------------------------------------------------
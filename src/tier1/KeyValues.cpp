@@ -31,16 +31,19 @@
 #include "convar.h"
 #include "tier0/dbg.h"
 #include "tier0/mem.h"
+#include "tier0/threadtools.h"
 #include "utlbuffer.h"
 #include "utlhash.h"
 #include "utlqueue.h"
 #include "utlvector.h"
 #include <cstdlib>
+#include <emmintrin.h>
 
 // memdbgon must be the last include file in a .cpp file!!!
 #include "tier0/memdbgon.h"
 
-static const char* s_LastFileLoadingFrom = "unknown"; // just needed for error messages
+// parsing state is per thread, so that files can be parsed in parallel
+static thread_local const char* s_LastFileLoadingFrom = "unknown"; // just needed for error messages
 
 // Statics for the growable string table
 int (*KeyValues::s_pfGetSymbolForString)( const char *name, bool bCreate ) = &KeyValues::GetSymbolForStringClassic;
@@ -48,7 +51,14 @@ const char *(*KeyValues::s_pfGetStringForSymbol)( int symbol ) = &KeyValues::Get
 CKeyValuesGrowableStringTable *KeyValues::s_pGrowableStringTable = nullptr;
 
 #define KEYVALUES_TOKEN_SIZE	4096
-static char s_pTokenBuf[KEYVALUES_TOKEN_SIZE];
+static thread_local char s_pTokenBuf[KEYVALUES_TOKEN_SIZE];
+
+// how much of the buffer the tokenizer looks at in one go, longer tokens take the slow path
+#define KEYVALUES_SCAN_WINDOW	KEYVALUES_TOKEN_SIZE
+
+// parsed string values are bump allocated from blocks of this size
+#define KEYVALUES_ARENA_BLOCK_SIZE	( 4 * 1024 )
+#define KEYVALUES_ARENA_MAX_STRING	( KEYVALUES_ARENA_BLOCK_SIZE / 16 )
 
 
 #define INTERNALWRITE( pData, len ) InternalWrite( filesystem, f, pBuf, pData, len )
@@ -128,7 +138,8 @@ private:
 	const char *m_pFilename;
 	int		m_errorIndex;
 	int		m_maxErrorIndex;
-} g_KeyValuesErrorStack;
+};
+static thread_local CKeyValuesErrorStack g_KeyValuesErrorStack;
 
 
 // a simple helper that creates stack entries as it goes in & out of scope
@@ -165,6 +176,201 @@ private:
 	int m_stackLevel;
 };
 
+//-----------------------------------------------------------------------------
+// Purpose: Allocator for the string values of parsed keys.
+// Every LoadFromBuffer() bump allocates from its own blocks, so parsers don't contend
+// and a block only holds strings of one tree: the blocks go back to the heap as the
+// tree is freed, and a key outliving its tree keeps at most one small block alive.
+//-----------------------------------------------------------------------------
+class CKeyValuesStringArena
+{
+public:
+	~CKeyValuesStringArena()
+	{
+		if ( m_pBlock )
+			Release( m_pBlock );
+	}
+
+	// Returns nullptr if the string is too big for a block
+	char *Alloc( int nSize )
+	{
+		if ( nSize > KEYVALUES_ARENA_MAX_STRING )
+			return nullptr;
+
+		// uint64 values are stored here too
+		nSize = ALIGN_VALUE( nSize, 8 );
+		if ( !m_pBlock || m_pBlock->m_nUsed + nSize > KEYVALUES_ARENA_BLOCK_SIZE )
+		{
+			if ( m_pBlock )
+				Release( m_pBlock );
+
+			m_pBlock = (Block_t *)MemAlloc_AllocAligned( KEYVALUES_ARENA_BLOCK_SIZE, KEYVALUES_ARENA_BLOCK_SIZE );
+			m_pBlock->m_nRefs = 1;	// the arena's reference, dropped when it moves to the next block
+			m_pBlock->m_nUsed = HEADER_SIZE;
+		}
+
+		char *pString = (char *)m_pBlock + m_pBlock->m_nUsed;
+		m_pBlock->m_nUsed += nSize;
+		++m_pBlock->m_nRefs;
+		return pString;
+	}
+
+	// Can be called from any thread
+	static void Free( char *pString )
+	{
+		// blocks are aligned to their size, so the header is found from any string in it
+		Release( (Block_t *)( (uintp)pString & ~( (uintp)KEYVALUES_ARENA_BLOCK_SIZE - 1 ) ) );
+	}
+
+private:
+	struct Block_t
+	{
+		CInterlockedInt m_nRefs;
+		int m_nUsed;
+	};
+	static constexpr int HEADER_SIZE = ALIGN_VALUE( sizeof( Block_t ), 16 );
+
+	static void Release( Block_t *pBlock )
+	{
+		if ( --pBlock->m_nRefs == 0 )
+			MemAlloc_FreeAligned( pBlock );
+	}
+
+	Block_t *m_pBlock = nullptr;
+};
+// the arena of the innermost LoadFromBuffer() running on this thread
+static thread_local CKeyValuesStringArena *s_pStringArena = nullptr;
+
+
+//-----------------------------------------------------------------------------
+// Purpose: SSE2 scanners for the tokenizer. They look at a contiguous span of
+// the buffer 16 bytes at a time, and return the offset of the first byte
+// matching, or -1 if there's none in the span.
+//-----------------------------------------------------------------------------
+static inline bool KeyValues_IsSpace( char c )
+{
+	return c == ' ' || ( c >= '\t' && c <= '\r' );
+}
+
+static inline bool KeyValues_IsTokenEnd( char c )
+{
+	// control characters other than whitespace are part of unquoted tokens
+	return c == 0 || KeyValues_IsSpace( c ) || c == '"' || c == '{' || c == '}';
+}
+
+static inline int KeyValues_FirstBit( int nMask )
+{
+#if defined( COMPILER_MSVC )
+	unsigned long nIndex;
+	_BitScanForward( &nIndex, nMask );
+	return (int)nIndex;
+#else
+	return __builtin_ctz( nMask );
+#endif
+}
+
+// First byte which isn't whitespace
+static int KeyValues_ScanNonSpace( const char *p, int n )
+{
+	int i = 0;
+	const __m128i space = _mm_set1_epi8( ' ' );
+	const __m128i tab = _mm_set1_epi8( '\t' );
+	const __m128i range = _mm_set1_epi8( '\r' - '\t' );
+	for ( ; i + 16 <= n; i += 16 )
+	{
+		__m128i chunk = _mm_loadu_si128( (const __m128i *)( p + i ) );
+		// '\t' through '\r' end up in [0, 4], unsigned
+		__m128i offset = _mm_sub_epi8( chunk, tab );
+		__m128i isSpace = _mm_or_si128( _mm_cmpeq_epi8( chunk, space ), _mm_cmpeq_epi8( _mm_min_epu8( offset, range ), offset ) );
+		int nMask = ~_mm_movemask_epi8( isSpace ) & 0xFFFF;
+		if ( nMask )
+			return i + KeyValues_FirstBit( nMask );
+	}
+	for ( ; i < n; i++ )
+	{
+		if ( !KeyValues_IsSpace( p[i] ) )
+			return i;
+	}
+	return -1;
+}
+
+// End of an unquoted token
+static int KeyValues_ScanTokenEnd( const char *p, int n )
+{
+	int i = 0;
+	const __m128i space = _mm_set1_epi8( ' ' );
+	const __m128i quote = _mm_set1_epi8( '"' );
+	const __m128i open = _mm_set1_epi8( '{' );
+	const __m128i close = _mm_set1_epi8( '}' );
+	while ( i + 16 <= n )
+	{
+		__m128i chunk = _mm_loadu_si128( (const __m128i *)( p + i ) );
+		// anything up to ' ' is a candidate, control characters get sorted out below
+		__m128i hits = _mm_cmpeq_epi8( _mm_min_epu8( chunk, space ), chunk );
+		hits = _mm_or_si128( hits, _mm_cmpeq_epi8( chunk, quote ) );
+		hits = _mm_or_si128( hits, _mm_or_si128( _mm_cmpeq_epi8( chunk, open ), _mm_cmpeq_epi8( chunk, close ) ) );
+		int nMask = _mm_movemask_epi8( hits );
+		while ( nMask )
+		{
+			int nIndex = i + KeyValues_FirstBit( nMask );
+			if ( KeyValues_IsTokenEnd( p[nIndex] ) )
+				return nIndex;
+			nMask &= nMask - 1;
+		}
+		i += 16;
+	}
+	for ( ; i < n; i++ )
+	{
+		if ( KeyValues_IsTokenEnd( p[i] ) )
+			return i;
+	}
+	return -1;
+}
+
+// Closing quote or escape character of a quoted token
+static int KeyValues_ScanQuoteEnd( const char *p, int n, char escapeChar )
+{
+	int i = 0;
+	const __m128i quote = _mm_set1_epi8( '"' );
+	const __m128i escape = _mm_set1_epi8( escapeChar );
+	for ( ; i + 16 <= n; i += 16 )
+	{
+		__m128i chunk = _mm_loadu_si128( (const __m128i *)( p + i ) );
+		int nMask = _mm_movemask_epi8( _mm_or_si128( _mm_cmpeq_epi8( chunk, quote ), _mm_cmpeq_epi8( chunk, escape ) ) );
+		if ( nMask )
+			return i + KeyValues_FirstBit( nMask );
+	}
+	for ( ; i < n; i++ )
+	{
+		if ( p[i] == '"' || p[i] == escapeChar )
+			return i;
+	}
+	return -1;
+}
+
+// The next bytes of the buffer, if they're in memory
+static const char *KeyValues_PeekSpan( CUtlBuffer &buf, int &nSpan )
+{
+	nSpan = MIN( buf.GetBytesRemaining(), KEYVALUES_SCAN_WINDOW );
+	if ( nSpan <= 0 || !buf.IsText() )
+		return nullptr;
+	return (const char *)buf.PeekGet( nSpan, 0 );
+}
+
+static void KeyValues_EatWhiteSpace( CUtlBuffer &buf )
+{
+	int nSpan;
+	while ( const char *pSpan = KeyValues_PeekSpan( buf, nSpan ) )
+	{
+		int nSkip = KeyValues_ScanNonSpace( pSpan, nSpan );
+		buf.SeekGet( CUtlBuffer::SEEK_CURRENT, nSkip >= 0 ? nSkip : nSpan );
+		if ( nSkip >= 0 )
+			return;
+	}
+	buf.EatWhiteSpace();
+}
+
+
 // Uncomment this line to hit the ~CLeakTrack assert to see what's looking like it's leaking
 // #define LEAKTRACK
 
@@ -464,8 +670,7 @@ void KeyValues::Init()
 	m_bHasEscapeSequences = false;
 	m_bEvaluateConditionals = true;
 
-	// for future proof
-	memset( unused, 0, sizeof(unused) );
+	m_bArenaValue = false;
 }
 
 //-----------------------------------------------------------------------------
@@ -499,12 +704,37 @@ void KeyValues::RemoveEverything()
 		delete dat;
 	}
 
-	delete [] m_sValue;
-	m_sValue = nullptr;
+	FreeStringValue();
 	delete [] m_wsValue;
 	m_wsValue = nullptr;
 }
 
+//-----------------------------------------------------------------------------
+// Purpose: Frees the string value, wherever it was allocated from
+//-----------------------------------------------------------------------------
+void KeyValues::FreeStringValue()
+{
+	if ( m_bArenaValue )
+		CKeyValuesStringArena::Free( m_sValue );
+	else
+		delete [] m_sValue;
+
+	m_sValue = nullptr;
+	m_bArenaValue = false;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: Allocates the string value of a key being parsed, from the parse's string arena
+//-----------------------------------------------------------------------------
+void KeyValues::AllocParsedValue( int nSize )
+{
+	Assert( !m_sValue );
+	m_sValue = s_pStringArena ? s_pStringArena->Alloc( nSize ) : nullptr;
+	m_bArenaValue = m_sValue != nullptr;
+	if ( !m_bArenaValue )
+		m_sValue = new char[nSize];
+}
+
 //-----------------------------------------------------------------------------
 // Purpose: 
 // Input  : *f - 
@@ -548,7 +778,7 @@ const char *KeyValues::ReadToken( CUtlBuffer &buf, bool &wasQuoted, bool &wasCon
 	// eating white spaces and remarks loop
 	while ( true )
 	{
-		buf.EatWhiteSpace();
+		KeyValues_EatWhiteSpace( buf );
 		if ( !buf.IsValid() )
 			return nullptr;	// file ends after reading whitespaces
 
@@ -561,12 +791,30 @@ const char *KeyValues::ReadToken( CUtlBuffer &buf, bool &wasQuoted, bool &wasCon
 	if ( !c )
 		return nullptr;
 
+	int nSpan;
+	const char *pSpan;
+
 	// read quoted strings specially
 	if ( *c == '\"' )
 	{
 		wasQuoted = true;
-		buf.GetDelimitedString( m_bHasEscapeSequences ? GetCStringCharConversion() : GetNoEscCharConversion(), 
-			s_pTokenBuf, KEYVALUES_TOKEN_SIZE );
+		CUtlCharConversion *pConv = m_bHasEscapeSequences ? GetCStringCharConversion() : GetNoEscCharConversion();
+
+		// if there's nothing to convert, copy it straight out of the buffer
+		if ( ( pSpan = KeyValues_PeekSpan( buf, nSpan ) ) )
+		{
+			int nEnd = KeyValues_ScanQuoteEnd( pSpan + 1, nSpan - 1, pConv->GetEscapeChar() );
+			if ( nEnd >= 0 && pSpan[ 1 + nEnd ] == '\"' )
+			{
+				int nLen = MIN( nEnd, KEYVALUES_TOKEN_SIZE - 1 );
+				Q_memcpy( s_pTokenBuf, pSpan + 1, nLen );
+				s_pTokenBuf[ nLen ] = 0;
+				buf.SeekGet( CUtlBuffer::SEEK_CURRENT, nEnd + 2 );
+				return s_pTokenBuf;
+			}
+		}
+
+		buf.GetDelimitedString( pConv, s_pTokenBuf, KEYVALUES_TOKEN_SIZE );
 		return s_pTokenBuf;
 	}
 
@@ -579,6 +827,23 @@ const char *KeyValues::ReadToken( CUtlBuffer &buf, bool &wasQuoted, bool &wasCon
 		return s_pTokenBuf;
 	}
 
+	// find the end of the token in one go, if it's in memory
+	if ( ( pSpan = KeyValues_PeekSpan( buf, nSpan ) ) )
+	{
+		int nEnd = KeyValues_ScanTokenEnd( pSpan, nSpan );
+		if ( nEnd >= 0 && nEnd < KEYVALUES_TOKEN_SIZE )
+		{
+			Q_memcpy( s_pTokenBuf, pSpan, nEnd );
+			s_pTokenBuf[ nEnd ] = 0;
+
+			const char *pConditionalStart = (const char *)memchr( s_pTokenBuf, '[', nEnd );
+			wasConditional = pConditionalStart && strchr( pConditionalStart, ']' );
+
+			buf.SeekGet( CUtlBuffer::SEEK_CURRENT, nEnd );
+			return s_pTokenBuf;
+		}
+	}
+
 	// read in the token until we hit a whitespace or a control character
 	bool bReportedError = false;
 	bool bConditionalStart = false;
@@ -653,6 +918,7 @@ bool KeyValues::LoadFromFile( IBaseFileSystem *filesystem, const char *resourceN
 	#endif
 
 	#if defined( STAGING_ONLY )
+		// Cached files are checked against the file's time and size on every hit.
 		static bool s_bCacheEnabled = !!CommandLine()->FindParm( "-enable_keyvalues_cache" );
 		const bool bUseCache = s_bCacheEnabled && ( s_pfGetSymbolForString == KeyValues::GetSymbolForStringClassic );
 	#else
@@ -1595,7 +1861,7 @@ void KeyValues::SetColor( const char *keyName, Color value)
 void KeyValues::SetStringValue( char const *strValue )
 {
 	// delete the old value
-	delete [] m_sValue;
+	FreeStringValue();
 	// make sure we're not storing the WSTRING  - as we're converting over to STRING
 	delete [] m_wsValue;
 	m_wsValue = nullptr;
@@ -1629,7 +1895,7 @@ void KeyValues::SetString( const char *keyName, const char *value )
 		}
 
 		// delete the old value
-		delete [] dat->m_sValue;
+		dat->FreeStringValue();
 		// make sure we're not storing the WSTRING  - as we're converting over to STRING
 		delete [] dat->m_wsValue;
 		dat->m_wsValue = nullptr;
@@ -1660,8 +1926,7 @@ void KeyValues::SetWString( const char *keyName, const wchar_t *value )
 		// delete the old value
 		delete [] dat->m_wsValue;
 		// make sure we're not storing the STRING  - as we're converting over to WSTRING
-		delete [] dat->m_sValue;
-		dat->m_sValue = nullptr;
+		dat->FreeStringValue();
 
 		if (!value)
 		{
@@ -1702,7 +1967,7 @@ void KeyValues::SetUint64( const char *keyName, uint64 value )
 	if ( dat )
 	{
 		// delete the old value
-		delete [] dat->m_sValue;
+		dat->FreeStringValue();
 		// make sure we're not storing the WSTRING  - as we're converting over to STRING
 		delete [] dat->m_wsValue;
 		dat->m_wsValue = nullptr;
@@ -2222,6 +2487,11 @@ bool KeyValues::LoadFromBuffer( char const *resourceName, CUtlBuffer &buf, IBase
 	bool wasQuoted;
 	bool wasConditional;
 	g_KeyValuesErrorStack.SetFilename( resourceName );	
+
+	// included files are parsed into arenas of their own
+	CKeyValuesStringArena stringArena;
+	CKeyValuesStringArena *pPreviousArena = s_pStringArena;
+	s_pStringArena = &stringArena;
 	do 
 	{
 		bool bAccepted = true;
@@ -2317,6 +2587,7 @@ bool KeyValues::LoadFromBuffer( char const *resourceName, CUtlBuffer &buf, IBase
 			pCurrentKey = nullptr;
 		}
 	} while ( buf.IsValid() );
+	s_pStringArena = pPreviousArena;
 
 	AppendIncludedKeys( includedKeys );
 	{
@@ -2464,11 +2735,7 @@ void KeyValues::RecursiveLoadFromBuffer( char const *resourceName, CUtlBuffer &b
 				break;
 			}
 			
-			if (dat->m_sValue)
-			{
-				delete[] dat->m_sValue;
-				dat->m_sValue = nullptr;
-			}
+			dat->FreeStringValue();
 
 			int len = Q_strlen( value );
 
@@ -2508,7 +2775,7 @@ void KeyValues::RecursiveLoadFromBuffer( char const *resourceName, CUtlBuffer &b
 							digit -= 'A' - ( '9' + 1 );
 					retVal = ( retVal * 16 ) + ( digit - '0' );
 				}
-				dat->m_sValue = new char[sizeof(uint64)];
+				dat->AllocParsedValue( sizeof(uint64) );
 				*((uint64 *)dat->m_sValue) = retVal;
 				dat->m_iDataType = TYPE_UINT64;
 			}
@@ -2530,7 +2797,7 @@ void KeyValues::RecursiveLoadFromBuffer( char const *resourceName, CUtlBuffer &b
 			if (dat->m_iDataType == TYPE_STRING)
 			{
 				// copy in the string information
-				dat->m_sValue = new char[len+1];
+				dat->AllocParsedValue( len + 1 );
 				Q_memcpy( dat->m_sValue, value, len+1 );
 			}
 
@@ -2777,19 +3044,32 @@ bool KeyValues::ReadAsBinary( CUtlBuffer &buffer, int nStackDepth )
 
 #include "tier0/memdbgoff.h"
 
+//-----------------------------------------------------------------------------
+// Purpose: returns the keyvalues system, letting it size its pool for us first
+//-----------------------------------------------------------------------------
+static IKeyValuesSystem *KeyValuesAllocator()
+{
+	static IKeyValuesSystem *s_pSystem = []
+	{
+		KeyValuesSystem()->RegisterSizeofKeyValues( sizeof( KeyValues ) );
+		return KeyValuesSystem();
+	}();
+	return s_pSystem;
+}
+
 //-----------------------------------------------------------------------------
 // Purpose: memory allocator
 //-----------------------------------------------------------------------------
 void *KeyValues::operator new( size_t iAllocSize )
 {
 	MEM_ALLOC_CREDIT();
-	return KeyValuesSystem()->AllocKeyValuesMemory( (int)iAllocSize );
+	return KeyValuesAllocator()->AllocKeyValuesMemory( (int)iAllocSize );
 }
 
 void *KeyValues::operator new( size_t iAllocSize, int nBlockUse, const char *pFileName, int nLine )
 {
 	MemAlloc_PushAllocDbgInfo( pFileName, nLine );
-	void *p = KeyValuesSystem()->AllocKeyValuesMemory( (int)iAllocSize );
+	void *p = KeyValuesAllocator()->AllocKeyValuesMemory( (int)iAllocSize );
 	MemAlloc_PopAllocDbgInfo();
 	return p;
 }
@@ -101,6 +101,167 @@ public:
 static CBitWriteMasksInit g_BitWriteMasksInit;
 
 
+// ---------------------------------------------------------------------------------------- //
+// Bulk operations keep the bits in a 64-bit word and move them 32 at a time, instead of
+// a masked read-modify-write of the buffer for every field. Callers make sure all the
+// bits fit in the buffer before using these.
+// ---------------------------------------------------------------------------------------- //
+
+class CBitWriteAccumulator
+{
+public:
+	explicit CBitWriteAccumulator( bf_write *pBuf ) : m_pBuf( pBuf )
+	{
+		// start from the dword we're in, so only whole dwords get stored
+		m_pOut = &pBuf->m_pData[ pBuf->m_iCurBit >> 5 ];
+		m_nBits = pBuf->m_iCurBit & 31;
+		m_nWord = m_nBits ? ( LoadLittleDWord( m_pOut, 0 ) & g_ExtraMasks[ m_nBits ] ) : 0;
+	}
+
+	ALWAYS_INLINE void Put( unsigned int data, int numbits )
+	{
+		Assert( numbits > 0 && numbits <= 32 );
+		m_nWord |= (uint64)( data & g_ExtraMasks[ numbits ] ) << m_nBits;
+		m_nBits += numbits;
+		m_pBuf->m_iCurBit += numbits;
+		if ( m_nBits >= 32 )
+		{
+			StoreLittleDWord( m_pOut++, 0, (unsigned long)m_nWord );
+			m_nWord >>= 32;
+			m_nBits -= 32;
+		}
+	}
+
+	// Stores the partial dword, the bits past the cursor are kept
+	void Flush()
+	{
+		if ( m_nBits )
+		{
+			unsigned long mask = g_ExtraMasks[ m_nBits ];
+			StoreLittleDWord( m_pOut, 0, ( LoadLittleDWord( m_pOut, 0 ) & ~mask ) | ( (unsigned long)m_nWord & mask ) );
+		}
+	}
+
+private:
+	bf_write *m_pBuf;
+	unsigned long *m_pOut;
+	uint64 m_nWord;
+	int m_nBits;
+};
+
+class CBitReadAccumulator
+{
+public:
+	explicit CBitReadAccumulator( bf_read *pBuf ) : m_pBuf( pBuf )
+	{
+		m_pIn = (const unsigned long *)pBuf->m_pData + ( pBuf->m_iCurBit >> 5 );
+		int nSkip = pBuf->m_iCurBit & 31;
+		m_nWord = 0;
+		m_nBits = 0;
+		// a dword is only loaded when it has bits we need, so we never read past the one the data ends in
+		if ( nSkip )
+		{
+			m_nWord = LoadLittleDWord( m_pIn++, 0 ) >> nSkip;
+			m_nBits = 32 - nSkip;
+		}
+	}
+
+	ALWAYS_INLINE unsigned int Get( int numbits )
+	{
+		Assert( numbits > 0 && numbits <= 32 );
+		if ( m_nBits < numbits )
+		{
+			m_nWord |= (uint64)LoadLittleDWord( m_pIn++, 0 ) << m_nBits;
+			m_nBits += 32;
+		}
+		unsigned int value = (unsigned int)m_nWord & g_ExtraMasks[ numbits ];
+		m_nWord >>= numbits;
+		m_nBits -= numbits;
+		m_pBuf->m_iCurBit += numbits;
+		return value;
+	}
+
+private:
+	bf_read *m_pBuf;
+	const unsigned long *m_pIn;
+	uint64 m_nWord;
+	int m_nBits;
+};
+
+// The most a vector takes, three flags and three full coords / two flags, two normals and a sign
+#define BITVEC3COORD_MAX_BITS ( 3 + 3 * ( 3 + COORD_INTEGER_BITS + COORD_FRACTIONAL_BITS ) )
+#define BITVEC3NORMAL_MAX_BITS ( 2 + 2 * ( 1 + NORMAL_FRACTIONAL_BITS ) + 1 )
+
+// The bits WriteBitCoord() writes for f, returns how many they are
+static inline int EncodeBitCoord( float f, unsigned int &bits )
+{
+	int		signbit = (f <= -COORD_RESOLUTION);
+	int		intval = (int)abs(f);
+	int		fractval = abs((int)(f*COORD_DENOMINATOR)) & (COORD_DENOMINATOR-1);
+
+	bits = ( intval != 0 ) | ( ( fractval != 0 ) << 1 );
+	if ( !intval && !fractval )
+		return 2;
+
+	bits |= signbit << 2;
+	int numbits = 3;
+	if ( intval )
+	{
+		bits |= ( (unsigned int)( intval - 1 ) & g_ExtraMasks[ COORD_INTEGER_BITS ] ) << numbits;
+		numbits += COORD_INTEGER_BITS;
+	}
+	if ( fractval )
+	{
+		bits |= (unsigned int)fractval << numbits;
+		numbits += COORD_FRACTIONAL_BITS;
+	}
+	return numbits;
+}
+
+// The bits WriteBitNormal() writes for f, always 1 + NORMAL_FRACTIONAL_BITS of them
+static inline unsigned int EncodeBitNormal( float f )
+{
+	int	signbit = (f <= -NORMAL_RESOLUTION);
+	unsigned int fractval = abs( (int)(f*NORMAL_DENOMINATOR) );
+	if (fractval > NORMAL_DENOMINATOR)
+		fractval = NORMAL_DENOMINATOR;
+	return signbit | ( fractval << 1 );
+}
+
+// Same as bf_read::ReadBitCoord()
+static inline float DecodeBitCoord( CBitReadAccumulator &in )
+{
+	int		intval = in.Get( 1 );
+	int		fractval = in.Get( 1 );
+	float	value = 0.0;
+
+	if ( intval || fractval )
+	{
+		int signbit = in.Get( 1 );
+		if ( intval )
+			intval = in.Get( COORD_INTEGER_BITS ) + 1;
+		if ( fractval )
+			fractval = in.Get( COORD_FRACTIONAL_BITS );
+
+		value = intval + ((float)fractval * COORD_RESOLUTION);
+		if ( signbit )
+			value = -value;
+	}
+	return value;
+}
+
+// Same as bf_read::ReadBitNormal()
+static inline float DecodeBitNormal( CBitReadAccumulator &in )
+{
+	int	signbit = in.Get( 1 );
+	unsigned int fractval = in.Get( NORMAL_FRACTIONAL_BITS );
+	float value = (float)fractval * NORMAL_RESOLUTION;
+	if ( signbit )
+		value = -value;
+	return value;
+}
+
+
 // ---------------------------------------------------------------------------------------- //
 // bf_write
 // ---------------------------------------------------------------------------------------- //
@@ -529,6 +690,27 @@ bool bf_write::WriteBitsFromBuffer( bf_read *pIn, int nBits )
 }
 
 
+bool bf_write::WriteBitsArray( const uint32 *pValues, int nCount, int numbits )
+{
+	Assert( numbits > 0 && numbits <= 32 );
+
+	if ( (int64)nCount * numbits > GetNumBitsLeft() )
+	{
+		// write what fits and overflow on the first one that doesn't, like one at a time would
+		for ( int i = 0; i < nCount && !IsOverflowed(); i++ )
+			WriteUBitLong( pValues[i], numbits, false );
+		return !IsOverflowed();
+	}
+
+	CBitWriteAccumulator out( this );
+	for ( int i = 0; i < nCount; i++ )
+		out.Put( pValues[i], numbits );
+	out.Flush();
+
+	return !IsOverflowed();
+}
+
+
 void bf_write::WriteBitAngle( float fAngle, int numbits )
 {
 	int d;
@@ -690,6 +872,78 @@ void bf_write::WriteBitVec3Normal( const Vector& fa )
 	WriteOneBit( signbit );
 }
 
+void bf_write::WriteBitVec3CoordArray( const Vector *pVecs, int nCount )
+{
+	int i = 0;
+	{
+		CBitWriteAccumulator out( this );
+		for ( ; i < nCount && GetNumBitsLeft() >= BITVEC3COORD_MAX_BITS; i++ )
+		{
+			const Vector &fa = pVecs[i];
+			int xflag = (fa[0] >= COORD_RESOLUTION) || (fa[0] <= -COORD_RESOLUTION);
+			int yflag = (fa[1] >= COORD_RESOLUTION) || (fa[1] <= -COORD_RESOLUTION);
+			int zflag = (fa[2] >= COORD_RESOLUTION) || (fa[2] <= -COORD_RESOLUTION);
+			out.Put( xflag | ( yflag << 1 ) | ( zflag << 2 ), 3 );
+
+			unsigned int bits;
+			if ( xflag )
+			{
+				int numbits = EncodeBitCoord( fa[0], bits );
+				out.Put( bits, numbits );
+			}
+			if ( yflag )
+			{
+				int numbits = EncodeBitCoord( fa[1], bits );
+				out.Put( bits, numbits );
+			}
+			if ( zflag )
+			{
+				int numbits = EncodeBitCoord( fa[2], bits );
+				out.Put( bits, numbits );
+			}
+		}
+		out.Flush();
+	}
+
+	// close to the end of the buffer, leave the overflow handling to the checked path
+	for ( ; i < nCount; i++ )
+		WriteBitVec3Coord( pVecs[i] );
+}
+
+void bf_write::WriteBitVec3NormalArray( const Vector *pVecs, int nCount )
+{
+	int i = 0;
+	{
+		CBitWriteAccumulator out( this );
+		for ( ; i < nCount && GetNumBitsLeft() >= BITVEC3NORMAL_MAX_BITS; i++ )
+		{
+			const Vector &fa = pVecs[i];
+			int xflag = (fa[0] >= NORMAL_RESOLUTION) || (fa[0] <= -NORMAL_RESOLUTION);
+			int yflag = (fa[1] >= NORMAL_RESOLUTION) || (fa[1] <= -NORMAL_RESOLUTION);
+
+			// it all fits a single put
+			unsigned int bits = xflag | ( yflag << 1 );
+			int numbits = 2;
+			if ( xflag )
+			{
+				bits |= EncodeBitNormal( fa[0] ) << numbits;
+				numbits += 1 + NORMAL_FRACTIONAL_BITS;
+			}
+			if ( yflag )
+			{
+				bits |= EncodeBitNormal( fa[1] ) << numbits;
+				numbits += 1 + NORMAL_FRACTIONAL_BITS;
+			}
+			bits |= (unsigned int)(fa[2] <= -NORMAL_RESOLUTION) << numbits;
+			out.Put( bits, numbits + 1 );
+		}
+		out.Flush();
+	}
+
+	for ( ; i < nCount; i++ )
+		WriteBitVec3Normal( pVecs[i] );
+}
+
 void bf_write::WriteBitAngles( const QAngle& fa )
 {
 	// FIXME:
@@ -864,6 +1118,15 @@ void bf_read::ReadBits(void *pOutData, int nBits)
 	unsigned char *pOut = (unsigned char*)pOutData;
 	int nBitsLeft = nBits;
 
+	// byte aligned: block copy
+	if ( (m_iCurBit & 7) == 0 && nBitsLeft >= 8 && nBitsLeft <= GetNumBitsLeft() )
+	{
+		int numbytes = nBitsLeft >> 3;
+		Q_memcpy( pOut, m_pData + (m_iCurBit >> 3), numbytes );
+		pOut += numbytes;
+		nBitsLeft -= numbytes << 3;
+		m_iCurBit += numbytes << 3;
+	}
 	
 	// align output to dword boundary
 	while( ((size_t)pOut & 3) != 0 && nBitsLeft >= 8 )
@@ -873,13 +1136,23 @@ void bf_read::ReadBits(void *pOutData, int nBits)
 		nBitsLeft -= 8;
 	}
 
-        // read dwords
-        while ( nBitsLeft >= 32 )
-        {
-                *((unsigned long*)pOut) = ReadUBitLong(32);
-                pOut += sizeof(unsigned long);
-                nBitsLeft -= 32;
-        }
+	// read dwords
+	if ( nBitsLeft >= 32 && nBitsLeft <= GetNumBitsLeft() )
+	{
+		CBitReadAccumulator in( this );
+		while ( nBitsLeft >= 32 )
+		{
+			*((unsigned long*)pOut) = in.Get(32);
+			pOut += sizeof(unsigned long);
+			nBitsLeft -= 32;
+		}
+	}
+	while ( nBitsLeft >= 32 )
+	{
+		*((unsigned long*)pOut) = ReadUBitLong(32);
+		pOut += sizeof(unsigned long);
+		nBitsLeft -= 32;
+	}
 
 	// read remaining bytes
 	while ( nBitsLeft >= 8 )
@@ -897,6 +1170,23 @@ void bf_read::ReadBits(void *pOutData, int nBits)
 
 }
 
+void bf_read::ReadBitsArray( uint32 *pValues, int nCount, int numbits )
+{
+	Assert( numbits > 0 && numbits <= 32 );
+
+	if ( (int64)nCount * numbits > GetNumBitsLeft() )
+	{
+		// the ones past the end come out as zeros
+		for ( int i = 0; i < nCount; i++ )
+			pValues[i] = ReadUBitLong( numbits );
+		return;
+	}
+
+	CBitReadAccumulator in( this );
+	for ( int i = 0; i < nCount; i++ )
+		pValues[i] = in.Get( numbits );
+}
+
 int bf_read::ReadBitsClamped_ptr(void *pOutData, size_t outSizeBytes, size_t nBits)
 {
 	size_t outSizeBits = outSizeBytes * 8;
@@ -1311,6 +1601,66 @@ void bf_read::ReadBitVec3Normal( Vector& fa )
 		fa[2] = -fa[2];
 }
 
+void bf_read::ReadBitVec3CoordArray( Vector *pVecs, int nCount )
+{
+	int i = 0;
+	{
+		CBitReadAccumulator in( this );
+		for ( ; i < nCount && GetNumBitsLeft() >= BITVEC3COORD_MAX_BITS; i++ )
+		{
+			Vector &fa = pVecs[i];
+			fa.Init( 0, 0, 0 );
+
+			int xflag = in.Get( 1 );
+			int yflag = in.Get( 1 );
+			int zflag = in.Get( 1 );
+
+			if ( xflag )
+				fa[0] = DecodeBitCoord( in );
+			if ( yflag )
+				fa[1] = DecodeBitCoord( in );
+			if ( zflag )
+				fa[2] = DecodeBitCoord( in );
+		}
+	}
+
+	// close to the end of the buffer, leave the overflow handling to the checked path
+	for ( ; i < nCount; i++ )
+		ReadBitVec3Coord( pVecs[i] );
+}
+
+void bf_read::ReadBitVec3NormalArray( Vector *pVecs, int nCount )
+{
+	int i = 0;
+	{
+		CBitReadAccumulator in( this );
+		for ( ; i < nCount && GetNumBitsLeft() >= BITVEC3NORMAL_MAX_BITS; i++ )
+		{
+			Vector &fa = pVecs[i];
+			int xflag = in.Get( 1 );
+			int yflag = in.Get( 1 );
+
+			fa[0] = xflag ? DecodeBitNormal( in ) : 0.0f;
+			fa[1] = yflag ? DecodeBitNormal( in ) : 0.0f;
+
+			// The first two imply the third (but not its sign)
+			int znegative = in.Get( 1 );
+
+			float fafafbfb = fa[0] * fa[0] + fa[1] * fa[1];
+			if (fafafbfb < 1.0f)
+				fa[2] = sqrt( 1.0f - fafafbfb );
+			else
+				fa[2] = 0.0f;
+
+			if (znegative)
+				fa[2] = -fa[2];
+		}
+	}
+
+	for ( ; i < nCount; i++ )
+		ReadBitVec3Normal( pVecs[i] );
+}
+
 void bf_read::ReadBitAngles( QAngle& fa )
 {
 	Vector tmp;
@@ -7,6 +7,10 @@
 #include "basetypes.h"
 #include "commonmacros.h"
 #include "checksum_crc.h"
+#include "tier1/processor_detect.h"
+#include <cstring>
+#include <emmintrin.h>
+#include <wmmintrin.h>
 
 // memdbgon must be the last include file in a .cpp file!!!
 #include "tier0/memdbgon.h"
@@ -98,83 +102,154 @@ CRC32_t	CRC32_GetTableEntry( unsigned int slot )
 	return pulCRCTable[(unsigned char)slot];
 }
 
+//-----------------------------------------------------------------------------
+// Slicing-by-8: table k holds the CRC of a byte followed by k zero bytes, so
+// 8 bytes are folded in at once with independent lookups.
+//-----------------------------------------------------------------------------
+struct CRC32SliceTables_t
+{
+	CRC32_t m_Table[8][NUM_BYTES];
+};
+
+static constexpr CRC32SliceTables_t CRC32_MakeSliceTables()
+{
+	CRC32SliceTables_t tables{};
+	for ( unsigned int i = 0; i < NUM_BYTES; i++ )
+	{
+		CRC32_t crc = i;
+		for ( int bit = 0; bit < 8; bit++ )
+			crc = ( crc >> 1 ) ^ ( ( crc & 1 ) ? 0xEDB88320 : 0 );
+		tables.m_Table[0][i] = crc;
+	}
+	for ( int k = 1; k < 8; k++ )
+	{
+		for ( unsigned int i = 0; i < NUM_BYTES; i++ )
+			tables.m_Table[k][i] = ( tables.m_Table[k - 1][i] >> 8 ) ^ tables.m_Table[0][tables.m_Table[k - 1][i] & 0xFF];
+	}
+	return tables;
+}
+
+static constexpr CRC32SliceTables_t s_CRCSliceTables = CRC32_MakeSliceTables();
+
+static CRC32_t CRC32_ProcessSliceBy8( CRC32_t ulCrc, const unsigned char *pb, int nBuffer )
+{
+	const CRC32_t ( *t )[NUM_BYTES] = s_CRCSliceTables.m_Table;
+	while ( nBuffer >= 8 )
+	{
+		CRC32_t one, two;
+		memcpy( &one, pb, sizeof( one ) );
+		memcpy( &two, pb + 4, sizeof( two ) );
+		one = LittleLong( one ) ^ ulCrc;
+		two = LittleLong( two );
+		ulCrc = t[7][one & 0xFF] ^ t[6][( one >> 8 ) & 0xFF] ^ t[5][( one >> 16 ) & 0xFF] ^ t[4][one >> 24]
+			  ^ t[3][two & 0xFF] ^ t[2][( two >> 8 ) & 0xFF] ^ t[1][( two >> 16 ) & 0xFF] ^ t[0][two >> 24];
+		pb += 8;
+		nBuffer -= 8;
+	}
+
+	while ( nBuffer-- > 0 )
+		ulCrc = pulCRCTable[*pb++ ^ (unsigned char)ulCrc] ^ (ulCrc >> 8);
+
+	return ulCrc;
+}
+
+//-----------------------------------------------------------------------------
+// Carry-less multiplication folding, see Intel's "Fast CRC Computation for
+// Generic Polynomials Using PCLMULQDQ Instruction". Four 128-bit lanes are
+// folded 64 bytes at a time, then into one, then Barrett-reduced to 32 bits.
+// The constants are x^n mod P for the reflected CRC-32 polynomial.
+//-----------------------------------------------------------------------------
+#if defined( COMPILER_MSVC )
+	#define CRC32_TARGET_PCLMUL
+#else
+	#define CRC32_TARGET_PCLMUL __attribute__(( target( "pclmul" ) ))
+#endif
+
+alignas( 16 ) static const uint64 s_CRCFold4[2] = { 0x0154442bd4ull, 0x01c6e41596ull };    // x^(512+32), x^(512-32)
+alignas( 16 ) static const uint64 s_CRCFold1[2] = { 0x01751997d0ull, 0x00ccaa009eull };    // x^(128+32), x^(128-32)
+alignas( 16 ) static const uint64 s_CRCFold64[2] = { 0x0163cd6124ull, 0 };                  // x^64
+alignas( 16 ) static const uint64 s_CRCBarrett[2] = { 0x01db710641ull, 0x01f7011641ull };  // P, floor( x^64 / P )
+
+CRC32_TARGET_PCLMUL static CRC32_t CRC32_ProcessPCLMUL( CRC32_t ulCrc, const unsigned char *pb, int nBuffer )
+{
+	// not worth setting up for short buffers
+	if ( nBuffer < 64 )
+		return CRC32_ProcessSliceBy8( ulCrc, pb, nBuffer );
+
+	int nFold = nBuffer & ~15;
+	const unsigned char *pEnd = pb + nFold;
+
+	__m128i x1 = _mm_loadu_si128( (const __m128i *)( pb + 0x00 ) );
+	__m128i x2 = _mm_loadu_si128( (const __m128i *)( pb + 0x10 ) );
+	__m128i x3 = _mm_loadu_si128( (const __m128i *)( pb + 0x20 ) );
+	__m128i x4 = _mm_loadu_si128( (const __m128i *)( pb + 0x30 ) );
+	x1 = _mm_xor_si128( x1, _mm_cvtsi32_si128( (int)ulCrc ) );
+	pb += 64;
+
+	__m128i k = _mm_load_si128( (const __m128i *)s_CRCFold4 );
+	while ( pEnd - pb >= 64 )
+	{
+		__m128i x5 = _mm_clmulepi64_si128( x1, k, 0x00 );
+		__m128i x6 = _mm_clmulepi64_si128( x2, k, 0x00 );
+		__m128i x7 = _mm_clmulepi64_si128( x3, k, 0x00 );
+		__m128i x8 = _mm_clmulepi64_si128( x4, k, 0x00 );
+		x1 = _mm_clmulepi64_si128( x1, k, 0x11 );
+		x2 = _mm_clmulepi64_si128( x2, k, 0x11 );
+		x3 = _mm_clmulepi64_si128( x3, k, 0x11 );
+		x4 = _mm_clmulepi64_si128( x4, k, 0x11 );
+		x1 = _mm_xor_si128( _mm_xor_si128( x1, x5 ), _mm_loadu_si128( (const __m128i *)( pb + 0x00 ) ) );
+		x2 = _mm_xor_si128( _mm_xor_si128( x2, x6 ), _mm_loadu_si128( (const __m128i *)( pb + 0x10 ) ) );
+		x3 = _mm_xor_si128( _mm_xor_si128( x3, x7 ), _mm_loadu_si128( (const __m128i *)( pb + 0x20 ) ) );
+		x4 = _mm_xor_si128( _mm_xor_si128( x4, x8 ), _mm_loadu_si128( (const __m128i *)( pb + 0x30 ) ) );
+		pb += 64;
+	}
+
+	// four lanes into one
+	k = _mm_load_si128( (const __m128i *)s_CRCFold1 );
+	__m128i x5 = _mm_clmulepi64_si128( x1, k, 0x00 );
+	x1 = _mm_xor_si128( _mm_xor_si128( _mm_clmulepi64_si128( x1, k, 0x11 ), x2 ), x5 );
+	x5 = _mm_clmulepi64_si128( x1, k, 0x00 );
+	x1 = _mm_xor_si128( _mm_xor_si128( _mm_clmulepi64_si128( x1, k, 0x11 ), x3 ), x5 );
+	x5 = _mm_clmulepi64_si128( x1, k, 0x00 );
+	x1 = _mm_xor_si128( _mm_xor_si128( _mm_clmulepi64_si128( x1, k, 0x11 ), x4 ), x5 );
+
+	// the remaining whole 16 byte blocks
+	while ( pb < pEnd )
+	{
+		x5 = _mm_clmulepi64_si128( x1, k, 0x00 );
+		x1 = _mm_xor_si128( _mm_xor_si128( _mm_clmulepi64_si128( x1, k, 0x11 ), _mm_loadu_si128( (const __m128i *)pb ) ), x5 );
+		pb += 16;
+	}
+
+	// 128 bits to 64
+	const __m128i mask32 = _mm_setr_epi32( ~0, 0, ~0, 0 );
+	x2 = _mm_clmulepi64_si128( x1, k, 0x10 );
+	x1 = _mm_xor_si128( _mm_srli_si128( x1, 8 ), x2 );
+	k = _mm_loadl_epi64( (const __m128i *)s_CRCFold64 );
+	x2 = _mm_srli_si128( x1, 4 );
+	x1 = _mm_xor_si128( _mm_clmulepi64_si128( _mm_and_si128( x1, mask32 ), k, 0x00 ), x2 );
+
+	// Barrett reduction to 32
+	k = _mm_load_si128( (const __m128i *)s_CRCBarrett );
+	x2 = _mm_clmulepi64_si128( _mm_and_si128( x1, mask32 ), k, 0x10 );
+	x2 = _mm_clmulepi64_si128( _mm_and_si128( x2, mask32 ), k, 0x00 );
+	x1 = _mm_xor_si128( x1, x2 );
+	ulCrc = (CRC32_t)_mm_cvtsi128_si32( _mm_srli_si128( x1, 4 ) );
+
+	return CRC32_ProcessSliceBy8( ulCrc, pb, nBuffer - nFold );
+}
+
+// Starts at a stub which picks the implementation, so it works during static init too
+static CRC32_t CRC32_ProcessSelect( CRC32_t ulCrc, const unsigned char *pb, int nBuffer );
+static CRC32_t ( *s_pfnCRC32Process )( CRC32_t, const unsigned char *, int ) = CRC32_ProcessSelect;
+
+static CRC32_t CRC32_ProcessSelect( CRC32_t ulCrc, const unsigned char *pb, int nBuffer )
+{
+	s_pfnCRC32Process = CheckPCLMULQDQTechnology() ? CRC32_ProcessPCLMUL : CRC32_ProcessSliceBy8;
+	return s_pfnCRC32Process( ulCrc, pb, nBuffer );
+}
+
 void CRC32_ProcessBuffer(CRC32_t *pulCRC, const void *pBuffer, int nBuffer)
 {
-	CRC32_t ulCrc = *pulCRC;
-	unsigned char *pb = (unsigned char *)pBuffer;
-    unsigned int nFront;
-    int nMain;
-
-JustAfew:
-
-    switch (nBuffer)
-    {
-    case 7:
-        ulCrc  = pulCRCTable[*pb++ ^ (unsigned char)ulCrc] ^ (ulCrc >> 8);
-
-    case 6:
-        ulCrc  = pulCRCTable[*pb++ ^ (unsigned char)ulCrc] ^ (ulCrc >> 8);
-
-    case 5:
-        ulCrc  = pulCRCTable[*pb++ ^ (unsigned char)ulCrc] ^ (ulCrc >> 8);
-
-    case 4:
-        ulCrc ^= LittleLong( *(CRC32_t *)pb );
-        ulCrc  = pulCRCTable[(unsigned char)ulCrc] ^ (ulCrc >> 8);
-        ulCrc  = pulCRCTable[(unsigned char)ulCrc] ^ (ulCrc >> 8);
-        ulCrc  = pulCRCTable[(unsigned char)ulCrc] ^ (ulCrc >> 8);
-        ulCrc  = pulCRCTable[(unsigned char)ulCrc] ^ (ulCrc >> 8);
-		*pulCRC = ulCrc;
-        return;
-
-    case 3:
-        ulCrc  = pulCRCTable[*pb++ ^ (unsigned char)ulCrc] ^ (ulCrc >> 8);
-
-    case 2:
-        ulCrc  = pulCRCTable[*pb++ ^ (unsigned char)ulCrc] ^ (ulCrc >> 8);
-
-    case 1:
-        ulCrc  = pulCRCTable[*pb++ ^ (unsigned char)ulCrc] ^ (ulCrc >> 8);
-
-    case 0:
-		*pulCRC = ulCrc;
-        return;
-    }
-
-    // We may need to do some alignment work up front, and at the end, so that
-    // the main loop is aligned and only has to worry about 8 byte at a time.
-    //
-    // The low-order two bits of pb and nBuffer in total control the
-    // upfront work.
-    //
-    nFront = ((unsigned int)pb) & 3;
-    nBuffer -= nFront;
-    switch (nFront)
-    {
-    case 3:
-        ulCrc  = pulCRCTable[*pb++ ^ (unsigned char)ulCrc] ^ (ulCrc >> 8);
-    case 2:
-        ulCrc  = pulCRCTable[*pb++ ^ (unsigned char)ulCrc] ^ (ulCrc >> 8);
-    case 1:
-        ulCrc  = pulCRCTable[*pb++ ^ (unsigned char)ulCrc] ^ (ulCrc >> 8);
-    }
-
-    nMain = nBuffer >> 3;
-    while (nMain--)
-    {
-        ulCrc ^= LittleLong( *(CRC32_t *)pb );
-        ulCrc  = pulCRCTable[(unsigned char)ulCrc] ^ (ulCrc >> 8);
-        ulCrc  = pulCRCTable[(unsigned char)ulCrc] ^ (ulCrc >> 8);
-        ulCrc  = pulCRCTable[(unsigned char)ulCrc] ^ (ulCrc >> 8);
-        ulCrc  = pulCRCTable[(unsigned char)ulCrc] ^ (ulCrc >> 8);
-        ulCrc ^= LittleLong( *(CRC32_t *)(pb + 4) );
-        ulCrc  = pulCRCTable[(unsigned char)ulCrc] ^ (ulCrc >> 8);
-        ulCrc  = pulCRCTable[(unsigned char)ulCrc] ^ (ulCrc >> 8);
-        ulCrc  = pulCRCTable[(unsigned char)ulCrc] ^ (ulCrc >> 8);
-        ulCrc  = pulCRCTable[(unsigned char)ulCrc] ^ (ulCrc >> 8);
-        pb += 8;
-    }
-
-    nBuffer &= 7;
-    goto JustAfew;
+	*pulCRC = s_pfnCRC32Process( *pulCRC, (const unsigned char *)pBuffer, nBuffer );
 }
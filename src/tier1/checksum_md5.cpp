@@ -9,8 +9,10 @@
 #include "commonmacros.h"
 #include "tier0/dbg.h"
 #include "tier1/strtools.h"
+#include "checksum_multibuffer.h"
 #include <stdio.h>
 #include <string.h>
+#include <emmintrin.h>
 
 // memdbgon must be the last include file in a .cpp file!!!
 #include "tier0/memdbgon.h"
@@ -286,3 +288,157 @@ void MD5_ProcessSingleBuffer( const void* p, int len, MD5Value_t& md5Result ) {
 	MD5Update( &ctx, (unsigned char const*) p, len );
 	MD5Final( md5Result.bits, &ctx );
 }
+
+//-----------------------------------------------------------------------------
+// Four buffers at once, a SSE2 lane each; the rounds are the same as
+// MD5Transform's, on vectors of four words.
+//-----------------------------------------------------------------------------
+#define F1x4( x, y, z ) _mm_xor_si128( z, _mm_and_si128( x, _mm_xor_si128( y, z ) ) )
+#define F2x4( x, y, z ) F1x4( z, x, y )
+#define F3x4( x, y, z ) _mm_xor_si128( _mm_xor_si128( x, y ), z )
+#define F4x4( x, y, z ) _mm_xor_si128( y, _mm_or_si128( x, _mm_xor_si128( z, allOnes ) ) )
+
+#define MD5STEPx4( f, w, x, y, z, data, k, s )                                                      \
+	( w = _mm_add_epi32( w, _mm_add_epi32( f( x, y, z ), _mm_add_epi32( data, _mm_set1_epi32( (int) k ) ) ) ), \
+	  w = _mm_or_si128( _mm_slli_epi32( w, s ), _mm_srli_epi32( w, 32 - s ) ),                     \
+	  w = _mm_add_epi32( w, x ) )
+
+class CMD5MultiBuffer {
+public:
+	static constexpr int LANES{ 4 };
+	static constexpr bool BIG_ENDIAN_LENGTH{ false };
+
+	explicit CMD5MultiBuffer( MD5Value_t* pResults ) : m_pResults( pResults ) { }
+
+	void ResetLane( int lane ) {
+		m_State[ 0 ][ lane ] = 0x67452301;
+		m_State[ 1 ][ lane ] = 0xefcdab89;
+		m_State[ 2 ][ lane ] = 0x98badcfe;
+		m_State[ 3 ][ lane ] = 0x10325476;
+	}
+
+	void Transform( const unsigned char* blocks[ LANES ] ) {
+		// word i of every lane in in[ i ]
+		__m128i in[ 16 ];
+		for ( int i = 0; i < 4; i++ ) {
+			const __m128i r0 = _mm_loadu_si128( (const __m128i*) ( blocks[ 0 ] + i * 16 ) );
+			const __m128i r1 = _mm_loadu_si128( (const __m128i*) ( blocks[ 1 ] + i * 16 ) );
+			const __m128i r2 = _mm_loadu_si128( (const __m128i*) ( blocks[ 2 ] + i * 16 ) );
+			const __m128i r3 = _mm_loadu_si128( (const __m128i*) ( blocks[ 3 ] + i * 16 ) );
+			const __m128i t0 = _mm_unpacklo_epi32( r0, r1 );
+			const __m128i t1 = _mm_unpacklo_epi32( r2, r3 );
+			const __m128i t2 = _mm_unpackhi_epi32( r0, r1 );
+			const __m128i t3 = _mm_unpackhi_epi32( r2, r3 );
+			in[ i * 4 + 0 ] = _mm_unpacklo_epi64( t0, t1 );
+			in[ i * 4 + 1 ] = _mm_unpackhi_epi64( t0, t1 );
+			in[ i * 4 + 2 ] = _mm_unpacklo_epi64( t2, t3 );
+			in[ i * 4 + 3 ] = _mm_unpackhi_epi64( t2, t3 );
+		}
+
+		const __m128i allOnes = _mm_set1_epi32( -1 );
+		__m128i a = _mm_load_si128( (const __m128i*) m_State[ 0 ] );
+		__m128i b = _mm_load_si128( (const __m128i*) m_State[ 1 ] );
+		__m128i c = _mm_load_si128( (const __m128i*) m_State[ 2 ] );
+		__m128i d = _mm_load_si128( (const __m128i*) m_State[ 3 ] );
+
+		MD5STEPx4( F1x4, a, b, c, d, in[ 0 ], 0xd76aa478, 7 );
+		MD5STEPx4( F1x4, d, a, b, c, in[ 1 ], 0xe8c7b756, 12 );
+		MD5STEPx4( F1x4, c, d, a, b, in[ 2 ], 0x242070db, 17 );
+		MD5STEPx4( F1x4, b, c, d, a, in[ 3 ], 0xc1bdceee, 22 );
+		MD5STEPx4( F1x4, a, b, c, d, in[ 4 ], 0xf57c0faf, 7 );
+		MD5STEPx4( F1x4, d, a, b, c, in[ 5 ], 0x4787c62a, 12 );
+		MD5STEPx4( F1x4, c, d, a, b, in[ 6 ], 0xa8304613, 17 );
+		MD5STEPx4( F1x4, b, c, d, a, in[ 7 ], 0xfd469501, 22 );
+		MD5STEPx4( F1x4, a, b, c, d, in[ 8 ], 0x698098d8, 7 );
+		MD5STEPx4( F1x4, d, a, b, c, in[ 9 ], 0x8b44f7af, 12 );
+		MD5STEPx4( F1x4, c, d, a, b, in[ 10 ], 0xffff5bb1, 17 );
+		MD5STEPx4( F1x4, b, c, d, a, in[ 11 ], 0x895cd7be, 22 );
+		MD5STEPx4( F1x4, a, b, c, d, in[ 12 ], 0x6b901122, 7 );
+		MD5STEPx4( F1x4, d, a, b, c, in[ 13 ], 0xfd987193, 12 );
+		MD5STEPx4( F1x4, c, d, a, b, in[ 14 ], 0xa679438e, 17 );
+		MD5STEPx4( F1x4, b, c, d, a, in[ 15 ], 0x49b40821, 22 );
+
+		MD5STEPx4( F2x4, a, b, c, d, in[ 1 ], 0xf61e2562, 5 );
+		MD5STEPx4( F2x4, d, a, b, c, in[ 6 ], 0xc040b340, 9 );
+		MD5STEPx4( F2x4, c, d, a, b, in[ 11 ], 0x265e5a51, 14 );
+		MD5STEPx4( F2x4, b, c, d, a, in[ 0 ], 0xe9b6c7aa, 20 );
+		MD5STEPx4( F2x4, a, b, c, d, in[ 5 ], 0xd62f105d, 5 );
+		MD5STEPx4( F2x4, d, a, b, c, in[ 10 ], 0x02441453, 9 );
+		MD5STEPx4( F2x4, c, d, a, b, in[ 15 ], 0xd8a1e681, 14 );
+		MD5STEPx4( F2x4, b, c, d, a, in[ 4 ], 0xe7d3fbc8, 20 );
+		MD5STEPx4( F2x4, a, b, c, d, in[ 9 ], 0x21e1cde6, 5 );
+		MD5STEPx4( F2x4, d, a, b, c, in[ 14 ], 0xc33707d6, 9 );
+		MD5STEPx4( F2x4, c, d, a, b, in[ 3 ], 0xf4d50d87, 14 );
+		MD5STEPx4( F2x4, b, c, d, a, in[ 8 ], 0x455a14ed, 20 );
+		MD5STEPx4( F2x4, a, b, c, d, in[ 13 ], 0xa9e3e905, 5 );
+		MD5STEPx4( F2x4, d, a, b, c, in[ 2 ], 0xfcefa3f8, 9 );
+		MD5STEPx4( F2x4, c, d, a, b, in[ 7 ], 0x676f02d9, 14 );
+		MD5STEPx4( F2x4, b, c, d, a, in[ 12 ], 0x8d2a4c8a, 20 );
+
+		MD5STEPx4( F3x4, a, b, c, d, in[ 5 ], 0xfffa3942, 4 );
+		MD5STEPx4( F3x4, d, a, b, c, in[ 8 ], 0x8771f681, 11 );
+		MD5STEPx4( F3x4, c, d, a, b, in[ 11 ], 0x6d9d6122, 16 );
+		MD5STEPx4( F3x4, b, c, d, a, in[ 14 ], 0xfde5380c, 23 );
+		MD5STEPx4( F3x4, a, b, c, d, in[ 1 ], 0xa4beea44, 4 );
+		MD5STEPx4( F3x4, d, a, b, c, in[ 4 ], 0x4bdecfa9, 11 );
+		MD5STEPx4( F3x4, c, d, a, b, in[ 7 ], 0xf6bb4b60, 16 );
+		MD5STEPx4( F3x4, b, c, d, a, in[ 10 ], 0xbebfbc70, 23 );
+		MD5STEPx4( F3x4, a, b, c, d, in[ 13 ], 0x289b7ec6, 4 );
+		MD5STEPx4( F3x4, d, a, b, c, in[ 0 ], 0xeaa127fa, 11 );
+		MD5STEPx4( F3x4, c, d, a, b, in[ 3 ], 0xd4ef3085, 16 );
+		MD5STEPx4( F3x4, b, c, d, a, in[ 6 ], 0x04881d05, 23 );
+		MD5STEPx4( F3x4, a, b, c, d, in[ 9 ], 0xd9d4d039, 4 );
+		MD5STEPx4( F3x4, d, a, b, c, in[ 12 ], 0xe6db99e5, 11 );
+		MD5STEPx4( F3x4, c, d, a, b, in[ 15 ], 0x1fa27cf8, 16 );
+		MD5STEPx4( F3x4, b, c, d, a, in[ 2 ], 0xc4ac5665, 23 );
+
+		MD5STEPx4( F4x4, a, b, c, d, in[ 0 ], 0xf4292244, 6 );
+		MD5STEPx4( F4x4, d, a, b, c, in[ 7 ], 0x432aff97, 10 );
+		MD5STEPx4( F4x4, c, d, a, b, in[ 14 ], 0xab9423a7, 15 );
+		MD5STEPx4( F4x4, b, c, d, a, in[ 5 ], 0xfc93a039, 21 );
+		MD5STEPx4( F4x4, a, b, c, d, in[ 12 ], 0x655b59c3, 6 );
+		MD5STEPx4( F4x4, d, a, b, c, in[ 3 ], 0x8f0ccc92, 10 );
+		MD5STEPx4( F4x4, c, d, a, b, in[ 10 ], 0xffeff47d, 15 );
+		MD5STEPx4( F4x4, b, c, d, a, in[ 1 ], 0x85845dd1, 21 );
+		MD5STEPx4( F4x4, a, b, c, d, in[ 8 ], 0x6fa87e4f, 6 );
+		MD5STEPx4( F4x4, d, a, b, c, in[ 15 ], 0xfe2ce6e0, 10 );
+		MD5STEPx4( F4x4, c, d, a, b, in[ 6 ], 0xa3014314, 15 );
+		MD5STEPx4( F4x4, b, c, d, a, in[ 13 ], 0x4e0811a1, 21 );
+		MD5STEPx4( F4x4, a, b, c, d, in[ 4 ], 0xf7537e82, 6 );
+		MD5STEPx4( F4x4, d, a, b, c, in[ 11 ], 0xbd3af235, 10 );
+		MD5STEPx4( F4x4, c, d, a, b, in[ 2 ], 0x2ad7d2bb, 15 );
+		MD5STEPx4( F4x4, b, c, d, a, in[ 9 ], 0xeb86d391, 21 );
+
+		_mm_store_si128( (__m128i*) m_State[ 0 ], _mm_add_epi32( a, _mm_load_si128( (const __m128i*) m_State[ 0 ] ) ) );
+		_mm_store_si128( (__m128i*) m_State[ 1 ], _mm_add_epi32( b, _mm_load_si128( (const __m128i*) m_State[ 1 ] ) ) );
+		_mm_store_si128( (__m128i*) m_State[ 2 ], _mm_add_epi32( c, _mm_load_si128( (const __m128i*) m_State[ 2 ] ) ) );
+		_mm_store_si128( (__m128i*) m_State[ 3 ], _mm_add_epi32( d, _mm_load_si128( (const __m128i*) m_State[ 3 ] ) ) );
+	}
+
+	void FinishLane( int lane, int buffer ) {
+		for ( int i = 0; i < 4; i++ ) {
+			memcpy( m_pResults[ buffer ].bits + i * 4, &m_State[ i ][ lane ], 4 );
+		}
+	}
+
+	// the context carries on from where the lane is
+	void DrainLane( int lane, int buffer, const unsigned char* pData, int nConsumed, int nLength ) {
+		MD5Context_t ctx;
+		for ( int i = 0; i < 4; i++ ) {
+			ctx.buf[ i ] = m_State[ i ][ lane ];
+		}
+		ctx.bits[ 0 ] = (unsigned int) nConsumed << 3;
+		ctx.bits[ 1 ] = (unsigned int) nConsumed >> 29;
+		MD5Update( &ctx, pData + nConsumed, nLength - nConsumed );
+		MD5Final( m_pResults[ buffer ].bits, &ctx );
+	}
+private:
+	alignas( 16 ) unsigned int m_State[ 4 ][ LANES ];
+	MD5Value_t* m_pResults;
+};
+
+//-----------------------------------------------------------------------------
+void MD5_ProcessBuffers( const void* const* ppBuffers, const int* pLengths, int nBuffers, MD5Value_t* pResults ) {
+	CMD5MultiBuffer hasher( pResults );
+	MultiBuffer_Process( hasher, ppBuffers, pLengths, nBuffers );
+}
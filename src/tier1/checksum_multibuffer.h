@@ -0,0 +1,118 @@
+//
+// Created by ENDERZOMBI102 on 18/10/2026.
+//
+// Purpose: Lane scheduling for hashing several independent buffers at once.
+//          Every SIMD lane hashes its own buffer, a lane which is done
+//          gets the next buffer, and the last one standing is finished by
+//          the scalar implementation, as a single lane is slower than it.
+//
+#pragma once
+#include "basetypes.h"
+#include "tier0/dbg.h"
+#include <cstring>
+
+
+/**
+ * What `MultiBuffer_Process()` wants from a hash:
+ *  - `LANES`, and `BIG_ENDIAN_LENGTH` for how the message length is padded in
+ *  - `ResetLane( lane )`: sets a lane back to the initial state
+ *  - `Transform( blocks )`: hashes a 64 byte block into every lane
+ *  - `FinishLane( lane, buffer )`: writes the digest of the lane's buffer out
+ *  - `DrainLane( lane, buffer, pData, nConsumed, nLength )`: finishes the buffer
+ *     from the lane's state, of which `nConsumed` bytes have been hashed
+ */
+template<typename Hasher>
+void MultiBuffer_Process( Hasher& hasher, const void* const* ppBuffers, const int* pLengths, int nBuffers ) {
+	struct Lane_t {
+		int m_nBuffer;
+		const unsigned char* m_pData;
+		int m_nLength;
+		int m_nConsumed;  // whole blocks of the data hashed so far
+		int m_nTailBlocks;
+		int m_nTailDone;
+		unsigned char m_Tail[ 128 ];  // the last partial block, and the padding
+	};
+	alignas( 16 ) static const unsigned char s_IdleBlock[ 64 ]{};
+
+	Lane_t lanes[ Hasher::LANES ];
+	auto nNext{ 0 };
+	const auto LoadLane{ [ & ]( int lane ) {
+		auto& l{ lanes[ lane ] };
+		if ( nNext == nBuffers ) {
+			l.m_nBuffer = -1;
+			return;
+		}
+
+		l.m_nBuffer = nNext;
+		l.m_pData = static_cast<const unsigned char*>( ppBuffers[ nNext ] );
+		l.m_nLength = pLengths[ nNext ];
+		l.m_nConsumed = 0;
+		l.m_nTailDone = 0;
+		nNext += 1;
+		Assert( l.m_nLength >= 0 );
+
+		const auto nRest{ l.m_nLength & 63 };
+		l.m_nTailBlocks = nRest < 56 ? 1 : 2;
+		memcpy( l.m_Tail, l.m_pData + ( l.m_nLength - nRest ), nRest );
+		l.m_Tail[ nRest ] = 0x80;
+		memset( l.m_Tail + nRest + 1, 0, l.m_nTailBlocks * 64 - nRest - 1 );
+
+		const auto nBits{ static_cast<uint64>( l.m_nLength ) << 3 };
+		auto pLength{ l.m_Tail + l.m_nTailBlocks * 64 - 8 };
+		for ( auto i{ 0 }; i < 8; i += 1 ) {
+			pLength[ Hasher::BIG_ENDIAN_LENGTH ? 7 - i : i ] = static_cast<unsigned char>( nBits >> ( i * 8 ) );
+		}
+		hasher.ResetLane( lane );
+	} };
+
+	for ( auto lane{ 0 }; lane < Hasher::LANES; lane += 1 ) {
+		LoadLane( lane );
+	}
+
+	while ( true ) {
+		auto nActive{ 0 };
+		auto nLast{ 0 };
+		for ( auto lane{ 0 }; lane < Hasher::LANES; lane += 1 ) {
+			if ( lanes[ lane ].m_nBuffer != -1 ) {
+				nActive += 1;
+				nLast = lane;
+			}
+		}
+		if ( nActive == 0 ) {
+			break;
+		}
+
+		// nothing left to share the lanes with, and still in the data
+		if ( nActive == 1 and nNext == nBuffers and lanes[ nLast ].m_nTailDone == 0 ) {
+			const auto& l{ lanes[ nLast ] };
+			hasher.DrainLane( nLast, l.m_nBuffer, l.m_pData, l.m_nConsumed, l.m_nLength );
+			break;
+		}
+
+		const unsigned char* blocks[ Hasher::LANES ];
+		for ( auto lane{ 0 }; lane < Hasher::LANES; lane += 1 ) {
+			const auto& l{ lanes[ lane ] };
+			if ( l.m_nBuffer == -1 ) {
+				blocks[ lane ] = s_IdleBlock;
+			} else if ( l.m_nLength - l.m_nConsumed >= 64 ) {
+				blocks[ lane ] = l.m_pData + l.m_nConsumed;
+			} else {
+				blocks[ lane ] = l.m_Tail + l.m_nTailDone * 64;
+			}
+		}
+		hasher.Transform( blocks );
+
+		for ( auto lane{ 0 }; lane < Hasher::LANES; lane += 1 ) {
+			auto& l{ lanes[ lane ] };
+			if ( l.m_nBuffer == -1 ) {
+				continue;
+			}
+			if ( l.m_nLength - l.m_nConsumed >= 64 ) {
+				l.m_nConsumed += 64;
+			} else if ( ( l.m_nTailDone += 1 ) == l.m_nTailBlocks ) {
+				hasher.FinishLane( lane, l.m_nBuffer );
+				LoadLane( lane );
+			}
+		}
+	}
+}
@@ -23,6 +23,10 @@
 
 #if !defined(_MINIMUM_BUILD_)
 #include "checksum_sha1.h"
+#include "tier1/processor_detect.h"
+#include "checksum_multibuffer.h"
+#include <emmintrin.h>
+#include <immintrin.h>
 #else
 //
 //	This path is build in the CEG/DRM projects where we require that no CRT references are made !
@@ -39,14 +43,14 @@
 #endif
 
 #ifdef SHA1_LITTLE_ENDIAN
-	#define SHABLK0(i) (m_block->l[i] = \
-		(ROL32(m_block->l[i],24) & 0xFF00FF00) | (ROL32(m_block->l[i],8) & 0x00FF00FF))
+	#define SHABLK0(i) (block.l[i] = \
+		(ROL32(block.l[i],24) & 0xFF00FF00) | (ROL32(block.l[i],8) & 0x00FF00FF))
 #else
-	#define SHABLK0(i) (m_block->l[i])
+	#define SHABLK0(i) (block.l[i])
 #endif
 
-#define SHABLK(i) (m_block->l[i&15] = ROL32(m_block->l[(i+13)&15] ^ m_block->l[(i+8)&15] \
-	^ m_block->l[(i+2)&15] ^ m_block->l[i&15],1))
+#define SHABLK(i) (block.l[i&15] = ROL32(block.l[(i+13)&15] ^ block.l[(i+8)&15] \
+	^ block.l[(i+2)&15] ^ block.l[i&15],1))
 
 // SHA-1 rounds
 #define _R0(v,w,x,y,z,i) { z+=((w&(x^y))^y)+SHABLK0(i)+0x5A827999+ROL32(v,5); w=ROL32(w,30); }
@@ -61,8 +65,6 @@ Minimum_CSHA1::Minimum_CSHA1()
 CSHA1::CSHA1()
 #endif
 {
-	m_block = (SHA1_WORKSPACE_BLOCK *)m_workspace;
-
 	Reset();
 }
 #ifdef	_MINIMUM_BUILD_
@@ -90,15 +92,12 @@ void CSHA1::Reset()
 	m_count[1] = 0;
 }
 
-#ifdef	_MINIMUM_BUILD_
-void Minimum_CSHA1::Transform(unsigned long state[5], unsigned char buffer[64])
-#else
-void CSHA1::Transform(unsigned long state[5], unsigned char buffer[64])
-#endif
+static void SHA1_Transform(unsigned long state[5], const unsigned char *buffer)
 {
 	unsigned long a = 0, b = 0, c = 0, d = 0, e = 0;
+	SHA1_WORKSPACE_BLOCK block;
 
-	memcpy(m_block, buffer, 64);
+	memcpy(&block, buffer, 64);
 
 	// Copy state[] to working vars
 	a = state[0];
@@ -138,6 +137,108 @@ void CSHA1::Transform(unsigned long state[5], unsigned char buffer[64])
 
 	// Wipe variables
 	a = b = c = d = e = 0;
+	memset(&block, 0, sizeof(block));
+}
+
+static void SHA1_ProcessBlocksScalar(unsigned long state[5], const unsigned char *data, unsigned int nBlocks)
+{
+	for (; nBlocks > 0; nBlocks--, data += 64)
+		SHA1_Transform(state, data);
+}
+
+#if !defined(_MINIMUM_BUILD_)
+//-----------------------------------------------------------------------------
+// SHA-NI, see Intel's "New Instructions Supporting the Secure Hash Algorithm
+// on Intel Architecture Processors". sha1rnds4 does four rounds at a time, and
+// sha1msg1/sha1msg2 compute the schedule four words at a time; a group of
+// rounds rotates through the four message registers.
+//-----------------------------------------------------------------------------
+#if defined( COMPILER_MSVC )
+	#define SHA1_TARGET_SHANI
+#else
+	#define SHA1_TARGET_SHANI __attribute__(( target( "sha,sse4.1" ) ))
+#endif
+
+// Rounds 4*g to 4*g+3, the schedule for the next groups is computed along the way
+#define SHA1_SHANI_ROUNDS4( g, eIn, eOut, cur, next, prev, prev2 ) \
+	eIn = ( g == 0 ) ? _mm_add_epi32( eIn, cur ) : _mm_sha1nexte_epu32( eIn, cur ); \
+	eOut = abcd; \
+	if ( g >= 3 && g <= 18 ) next = _mm_sha1msg2_epu32( next, cur ); \
+	abcd = _mm_sha1rnds4_epu32( abcd, eIn, g / 5 ); \
+	if ( g >= 1 && g <= 16 ) prev = _mm_sha1msg1_epu32( prev, cur ); \
+	if ( g >= 2 && g <= 17 ) prev2 = _mm_xor_si128( prev2, cur );
+
+SHA1_TARGET_SHANI static void SHA1_ProcessBlocksSHANI(unsigned long state[5], const unsigned char *data, unsigned int nBlocks)
+{
+	// the state is kept as abcd from the high word down, and e in the high word of its own register
+	const __m128i byteSwap = _mm_setr_epi8( 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0 );
+	__m128i abcd = _mm_shuffle_epi32( _mm_setr_epi32( (int)state[0], (int)state[1], (int)state[2], (int)state[3] ), 0x1B );
+	__m128i e0 = _mm_setr_epi32( 0, 0, 0, (int)state[4] );
+	__m128i e1;
+
+	for (; nBlocks > 0; nBlocks--, data += 64)
+	{
+		const __m128i abcdSave = abcd;
+		const __m128i eSave = e0;
+
+		__m128i msg0 = _mm_shuffle_epi8( _mm_loadu_si128( (const __m128i *)( data + 0x00 ) ), byteSwap );
+		__m128i msg1 = _mm_shuffle_epi8( _mm_loadu_si128( (const __m128i *)( data + 0x10 ) ), byteSwap );
+		__m128i msg2 = _mm_shuffle_epi8( _mm_loadu_si128( (const __m128i *)( data + 0x20 ) ), byteSwap );
+		__m128i msg3 = _mm_shuffle_epi8( _mm_loadu_si128( (const __m128i *)( data + 0x30 ) ), byteSwap );
+
+		SHA1_SHANI_ROUNDS4(  0, e0, e1, msg0, msg1, msg3, msg2 );
+		SHA1_SHANI_ROUNDS4(  1, e1, e0, msg1, msg2, msg0, msg3 );
+		SHA1_SHANI_ROUNDS4(  2, e0, e1, msg2, msg3, msg1, msg0 );
+		SHA1_SHANI_ROUNDS4(  3, e1, e0, msg3, msg0, msg2, msg1 );
+		SHA1_SHANI_ROUNDS4(  4, e0, e1, msg0, msg1, msg3, msg2 );
+		SHA1_SHANI_ROUNDS4(  5, e1, e0, msg1, msg2, msg0, msg3 );
+		SHA1_SHANI_ROUNDS4(  6, e0, e1, msg2, msg3, msg1, msg0 );
+		SHA1_SHANI_ROUNDS4(  7, e1, e0, msg3, msg0, msg2, msg1 );
+		SHA1_SHANI_ROUNDS4(  8, e0, e1, msg0, msg1, msg3, msg2 );
+		SHA1_SHANI_ROUNDS4(  9, e1, e0, msg1, msg2, msg0, msg3 );
+		SHA1_SHANI_ROUNDS4( 10, e0, e1, msg2, msg3, msg1, msg0 );
+		SHA1_SHANI_ROUNDS4( 11, e1, e0, msg3, msg0, msg2, msg1 );
+		SHA1_SHANI_ROUNDS4( 12, e0, e1, msg0, msg1, msg3, msg2 );
+		SHA1_SHANI_ROUNDS4( 13, e1, e0, msg1, msg2, msg0, msg3 );
+		SHA1_SHANI_ROUNDS4( 14, e0, e1, msg2, msg3, msg1, msg0 );
+		SHA1_SHANI_ROUNDS4( 15, e1, e0, msg3, msg0, msg2, msg1 );
+		SHA1_SHANI_ROUNDS4( 16, e0, e1, msg0, msg1, msg3, msg2 );
+		SHA1_SHANI_ROUNDS4( 17, e1, e0, msg1, msg2, msg0, msg3 );
+		SHA1_SHANI_ROUNDS4( 18, e0, e1, msg2, msg3, msg1, msg0 );
+		SHA1_SHANI_ROUNDS4( 19, e1, e0, msg3, msg0, msg2, msg1 );
+
+		e0 = _mm_sha1nexte_epu32( e0, eSave );
+		abcd = _mm_add_epi32( abcd, abcdSave );
+	}
+
+	abcd = _mm_shuffle_epi32( abcd, 0x1B );
+	state[0] = (unsigned int)_mm_cvtsi128_si32( abcd );
+	state[1] = (unsigned int)_mm_extract_epi32( abcd, 1 );
+	state[2] = (unsigned int)_mm_extract_epi32( abcd, 2 );
+	state[3] = (unsigned int)_mm_extract_epi32( abcd, 3 );
+	state[4] = (unsigned int)_mm_extract_epi32( e0, 3 );
+}
+
+// Starts at a stub which picks the implementation, so it works during static init too
+static void SHA1_ProcessBlocksSelect(unsigned long state[5], const unsigned char *data, unsigned int nBlocks);
+static void (*s_pfnSHA1ProcessBlocks)(unsigned long state[5], const unsigned char *data, unsigned int nBlocks) = SHA1_ProcessBlocksSelect;
+
+static void SHA1_ProcessBlocksSelect(unsigned long state[5], const unsigned char *data, unsigned int nBlocks)
+{
+	s_pfnSHA1ProcessBlocks = CheckSHATechnology() ? SHA1_ProcessBlocksSHANI : SHA1_ProcessBlocksScalar;
+	s_pfnSHA1ProcessBlocks(state, data, nBlocks);
+}
+#else
+static void (*const s_pfnSHA1ProcessBlocks)(unsigned long state[5], const unsigned char *data, unsigned int nBlocks) = SHA1_ProcessBlocksScalar;
+#endif
+
+#ifdef	_MINIMUM_BUILD_
+void Minimum_CSHA1::Transform(unsigned long state[5], unsigned char buffer[64])
+#else
+void CSHA1::Transform(unsigned long state[5], unsigned char buffer[64])
+#endif
+{
+	s_pfnSHA1ProcessBlocks(state, buffer, 1);
 }
 
 // Use this function to hash in binary data and strings
@@ -160,8 +261,13 @@ void CSHA1::Update(unsigned char *data, unsigned int len)
 		memcpy(&m_buffer[j], data, (i = 64 - j));
 		Transform(m_state, m_buffer);
 
-		for (; i+63 < len; i += 64)
-			Transform(m_state, &data[i]);
+		// all the whole blocks in one go
+		unsigned int nBlocks = (len - i) / 64;
+		if (nBlocks > 0)
+		{
+			s_pfnSHA1ProcessBlocks(m_state, &data[i], nBlocks);
+			i += nBlocks * 64;
+		}
 
 		j = 0;
 	}
@@ -289,6 +395,136 @@ void CSHA1::GetHash(unsigned char *uDest)
 	memcpy(uDest, m_digest, k_cubHash);
 }
 
+#ifndef	_MINIMUM_BUILD_
+//-----------------------------------------------------------------------------
+// Four buffers at once, a SSE2 lane each. With SHA-NI a single buffer is
+// about as fast as four of these, so the bulk hash just goes through CSHA1.
+//-----------------------------------------------------------------------------
+#define ROL32x4(_val, _nBits) _mm_or_si128(_mm_slli_epi32(_val, _nBits), _mm_srli_epi32(_val, 32-(_nBits)))
+
+class CSHA1MultiBuffer
+{
+public:
+	static constexpr int LANES = 4;
+	static constexpr bool BIG_ENDIAN_LENGTH = true;
+
+	explicit CSHA1MultiBuffer(SHADigest_t *pDigests) : m_pDigests(pDigests) {}
+
+	void ResetLane(int lane)
+	{
+		m_State[0][lane] = 0x67452301;
+		m_State[1][lane] = 0xEFCDAB89;
+		m_State[2][lane] = 0x98BADCFE;
+		m_State[3][lane] = 0x10325476;
+		m_State[4][lane] = 0xC3D2E1F0;
+	}
+
+	void Transform(const unsigned char *blocks[LANES])
+	{
+		// word i of every lane in w[i], byteswapped to big endian
+		__m128i w[16];
+		for (int i = 0; i < 4; i++)
+		{
+			__m128i r0 = _mm_loadu_si128((const __m128i *)(blocks[0] + i * 16));
+			__m128i r1 = _mm_loadu_si128((const __m128i *)(blocks[1] + i * 16));
+			__m128i r2 = _mm_loadu_si128((const __m128i *)(blocks[2] + i * 16));
+			__m128i r3 = _mm_loadu_si128((const __m128i *)(blocks[3] + i * 16));
+			__m128i t0 = _mm_unpacklo_epi32(r0, r1);
+			__m128i t1 = _mm_unpacklo_epi32(r2, r3);
+			__m128i t2 = _mm_unpackhi_epi32(r0, r1);
+			__m128i t3 = _mm_unpackhi_epi32(r2, r3);
+			w[i * 4 + 0] = ByteSwap(_mm_unpacklo_epi64(t0, t1));
+			w[i * 4 + 1] = ByteSwap(_mm_unpackhi_epi64(t0, t1));
+			w[i * 4 + 2] = ByteSwap(_mm_unpacklo_epi64(t2, t3));
+			w[i * 4 + 3] = ByteSwap(_mm_unpackhi_epi64(t2, t3));
+		}
+
+		__m128i a = _mm_load_si128((const __m128i *)m_State[0]);
+		__m128i b = _mm_load_si128((const __m128i *)m_State[1]);
+		__m128i c = _mm_load_si128((const __m128i *)m_State[2]);
+		__m128i d = _mm_load_si128((const __m128i *)m_State[3]);
+		__m128i e = _mm_load_si128((const __m128i *)m_State[4]);
+
+		int i = 0;
+		for (; i < 20; i++)
+			Round(a, b, c, d, e, _mm_xor_si128(d, _mm_and_si128(b, _mm_xor_si128(c, d))), 0x5A827999, w, i);
+		for (; i < 40; i++)
+			Round(a, b, c, d, e, _mm_xor_si128(_mm_xor_si128(b, c), d), 0x6ED9EBA1, w, i);
+		for (; i < 60; i++)
+			Round(a, b, c, d, e, _mm_or_si128(_mm_and_si128(b, c), _mm_and_si128(d, _mm_or_si128(b, c))), 0x8F1BBCDC, w, i);
+		for (; i < 80; i++)
+			Round(a, b, c, d, e, _mm_xor_si128(_mm_xor_si128(b, c), d), 0xCA62C1D6, w, i);
+
+		_mm_store_si128((__m128i *)m_State[0], _mm_add_epi32(a, _mm_load_si128((const __m128i *)m_State[0])));
+		_mm_store_si128((__m128i *)m_State[1], _mm_add_epi32(b, _mm_load_si128((const __m128i *)m_State[1])));
+		_mm_store_si128((__m128i *)m_State[2], _mm_add_epi32(c, _mm_load_si128((const __m128i *)m_State[2])));
+		_mm_store_si128((__m128i *)m_State[3], _mm_add_epi32(d, _mm_load_si128((const __m128i *)m_State[3])));
+		_mm_store_si128((__m128i *)m_State[4], _mm_add_epi32(e, _mm_load_si128((const __m128i *)m_State[4])));
+	}
+
+	void FinishLane(int lane, int buffer)
+	{
+		for (unsigned int i = 0; i < k_cubHash; i++)
+			m_pDigests[buffer][i] = (unsigned char)((m_State[i >> 2][lane] >> ((3 - (i & 3)) * 8)) & 255);
+	}
+
+	// CSHA1 carries on from where the lane is
+	void DrainLane(int lane, int buffer, const unsigned char *pData, int nConsumed, int nLength)
+	{
+		CSHA1 sha1;
+		for (int i = 0; i < 5; i++)
+			sha1.m_state[i] = m_State[i][lane];
+		sha1.m_count[0] = (unsigned int)nConsumed << 3;
+		sha1.m_count[1] = (unsigned int)nConsumed >> 29;
+		sha1.Update((unsigned char *)pData + nConsumed, nLength - nConsumed);
+		sha1.Final();
+		sha1.GetHash(m_pDigests[buffer]);
+	}
+
+private:
+	static inline void Round(__m128i &a, __m128i &b, __m128i &c, __m128i &d, __m128i &e, __m128i f, unsigned int k, __m128i w[16], int i)
+	{
+		if (i >= 16)
+			w[i&15] = ROL32x4(_mm_xor_si128(_mm_xor_si128(w[(i+13)&15], w[(i+8)&15]), _mm_xor_si128(w[(i+2)&15], w[i&15])), 1);
+
+		__m128i t = _mm_add_epi32(_mm_add_epi32(ROL32x4(a, 5), f), _mm_add_epi32(_mm_add_epi32(e, _mm_set1_epi32((int)k)), w[i&15]));
+		e = d;
+		d = c;
+		c = ROL32x4(b, 30);
+		b = a;
+		a = t;
+	}
+
+	static __m128i ByteSwap(__m128i x)
+	{
+		x = _mm_or_si128(_mm_slli_epi16(x, 8), _mm_srli_epi16(x, 8));
+		return _mm_shufflehi_epi16(_mm_shufflelo_epi16(x, 0xB1), 0xB1);
+	}
+
+	alignas(16) unsigned int m_State[5][LANES];
+	SHADigest_t *m_pDigests;
+};
+
+void SHA1_ProcessBuffers(const void *const *ppBuffers, const int *pLengths, int nBuffers, SHADigest_t *pDigests)
+{
+	static const bool s_bSHANI = CheckSHATechnology();
+	if (s_bSHANI)
+	{
+		for (int i = 0; i < nBuffers; i++)
+		{
+			CSHA1 sha1;
+			sha1.Update((unsigned char *)ppBuffers[i], pLengths[i]);
+			sha1.Final();
+			sha1.GetHash(pDigests[i]);
+		}
+		return;
+	}
+
+	CSHA1MultiBuffer hasher(pDigests);
+	MultiBuffer_Process(hasher, ppBuffers, pLengths, nBuffers);
+}
+#endif
+
 #ifndef	_MINIMUM_BUILD_
 // utility hash comparison function
 bool HashLessFunc( SHADigest_t const &lhs, SHADigest_t const &rhs )
@@ -409,3 +409,585 @@ void CDataManagerBase::GetLockHandleList( CUtlVector< memhandle_t >& list )
 	}
 }
 
+
+
+//-----------------------------------------------------------------------------
+// CDataManagerConcurrentBase
+//-----------------------------------------------------------------------------
+CDataManagerConcurrentBase::CDataManagerConcurrentBase( unsigned int maxSize ) : m_nTargetSize( maxSize )
+{
+}
+
+CDataManagerConcurrentBase::~CDataManagerConcurrentBase()
+{
+	Assert( m_bListsAreFreed );
+	for ( Shard_t &shard : m_Shards )
+	{
+		for ( std::atomic<Element_t *> &block : shard.m_pBlocks )
+		{
+			delete[] block.load( std::memory_order_relaxed );
+		}
+	}
+}
+
+memhandle_t CDataManagerConcurrentBase::ToHandle( int nShard, uint16 index, uint32 nSerial )
+{
+	const uint32 nBits = ( nSerial << ( SHARD_BITS + INDEX_BITS ) ) | ( (uint32)index << SHARD_BITS ) | nShard;
+	return (memhandle_t)(uintp)nBits;
+}
+
+CDataManagerConcurrentBase::Element_t *CDataManagerConcurrentBase::Resolve( Shard_t &shard, uint32 nBits )
+{
+	const uint16 index = IndexOf( nBits );
+	Element_t *pBlock = index != INVALID_INDEX ? shard.m_pBlocks[ index >> BLOCK_BITS ].load( std::memory_order_acquire ) : NULL;
+	if ( !pBlock || SerialOf( nBits ) == 0 )
+	{
+		shard.m_nMisses.fetch_add( 1, std::memory_order_relaxed );
+		return NULL;
+	}
+	return &pBlock[ index & ( BLOCK_SIZE - 1 ) ];
+}
+
+void CDataManagerConcurrentBase::Link( Shard_t &shard, EList list, uint16 index, bool bToHead )
+{
+	Element_t &elem = At( shard, index );
+	List_t &target = shard.m_Lists[ list ];
+	Assert( elem.m_nList == LIST_NONE );
+
+	if ( bToHead )
+	{
+		elem.m_nPrev = INVALID_INDEX;
+		elem.m_nNext = target.m_nHead;
+		if ( target.m_nHead != INVALID_INDEX )
+			At( shard, target.m_nHead ).m_nPrev = index;
+		else
+			target.m_nTail = index;
+		target.m_nHead = index;
+	}
+	else
+	{
+		elem.m_nNext = INVALID_INDEX;
+		elem.m_nPrev = target.m_nTail;
+		if ( target.m_nTail != INVALID_INDEX )
+			At( shard, target.m_nTail ).m_nNext = index;
+		else
+			target.m_nHead = index;
+		target.m_nTail = index;
+	}
+	elem.m_nList = list;
+	target.m_nCount++;
+}
+
+void CDataManagerConcurrentBase::Unlink( Shard_t &shard, uint16 index )
+{
+	Element_t &elem = At( shard, index );
+	if ( elem.m_nList == LIST_NONE )
+		return;
+
+	List_t &source = shard.m_Lists[ elem.m_nList ];
+	if ( elem.m_nPrev != INVALID_INDEX )
+		At( shard, elem.m_nPrev ).m_nNext = elem.m_nNext;
+	else
+		source.m_nHead = elem.m_nNext;
+	if ( elem.m_nNext != INVALID_INDEX )
+		At( shard, elem.m_nNext ).m_nPrev = elem.m_nPrev;
+	else
+		source.m_nTail = elem.m_nPrev;
+
+	elem.m_nPrev = elem.m_nNext = INVALID_INDEX;
+	elem.m_nList = LIST_NONE;
+	source.m_nCount--;
+}
+
+// free this resource and move the handle to the free list, must be unlocked
+void *CDataManagerConcurrentBase::FreeElement( Shard_t &shard, uint16 index )
+{
+	Element_t &elem = At( shard, index );
+	Assert( ( elem.m_nState.load( std::memory_order_relaxed ) & LOCK_MASK ) == 0 );
+
+	Unlink( shard, index );
+	shard.m_nBytes.fetch_sub( elem.m_nSize, std::memory_order_relaxed );
+	m_nMemUsed.fetch_sub( elem.m_nSize, std::memory_order_relaxed );
+	elem.m_nSize = 0;
+
+	void *p = elem.m_pStore.exchange( NULL, std::memory_order_relaxed );
+	// serial 0 is never used, so no handle is ever 0
+	uint32 nSerial = ( ( elem.m_nState.load( std::memory_order_relaxed ) >> LOCK_BITS ) + 1 ) & SERIAL_MASK;
+	if ( nSerial == 0 )
+		nSerial = 1;
+	elem.m_nState.store( nSerial << LOCK_BITS, std::memory_order_release );
+
+	Link( shard, LIST_FREE, index );
+	return p;
+}
+
+int CDataManagerConcurrentBase::FlushList( Shard_t &shard, EList list, CUtlVector<void *> &destroyList )
+{
+	int nFlushed = 0;
+	while ( shard.m_Lists[ list ].m_nHead != INVALID_INDEX )
+	{
+		const uint16 index = shard.m_Lists[ list ].m_nHead;
+		Element_t &elem = At( shard, index );
+		elem.m_nState.store( elem.m_nState.load( std::memory_order_relaxed ) & ~LOCK_MASK, std::memory_order_relaxed );
+		destroyList.AddToTail( FreeElement( shard, index ) );
+		nFlushed++;
+	}
+	return nFlushed;
+}
+
+void CDataManagerConcurrentBase::DestroyAll( const CUtlVector<void *> &destroyList )
+{
+	for ( int i = 0; i < destroyList.Count(); i++ )
+	{
+		if ( destroyList[i] )
+		{
+			DestroyResourceStorage( destroyList[i] );
+		}
+	}
+}
+
+memhandle_t CDataManagerConcurrentBase::CreateHandle( bool bCreateLocked )
+{
+	// consecutive resources go to different shards
+	const uint32 nFirstShard = m_nNextShard.fetch_add( 1, std::memory_order_relaxed );
+	for ( int i = 0; i < NUM_SHARDS; i++ )
+	{
+		const int nShard = ( nFirstShard + i ) & ( NUM_SHARDS - 1 );
+		Shard_t &shard = m_Shards[ nShard ];
+		AUTO_LOCK_FM( shard.m_Mutex );
+
+		uint16 index = shard.m_Lists[ LIST_FREE ].m_nHead;
+		if ( index != INVALID_INDEX )
+		{
+			Unlink( shard, index );
+		}
+		else
+		{
+			if ( shard.m_nElements == INVALID_INDEX )
+				continue;  // full
+
+			index = (uint16)shard.m_nElements;
+			if ( ( index & ( BLOCK_SIZE - 1 ) ) == 0 )
+			{
+				shard.m_pBlocks[ index >> BLOCK_BITS ].store( new Element_t[ BLOCK_SIZE ], std::memory_order_release );
+			}
+			shard.m_nElements++;
+		}
+
+		Element_t &elem = At( shard, index );
+		const uint32 nState = elem.m_nState.load( std::memory_order_relaxed );
+		elem.m_nState.store( bCreateLocked ? nState + 1 : nState, std::memory_order_release );
+		return ToHandle( nShard, index, nState >> LOCK_BITS );
+	}
+
+	AssertMsg( false, "Data manager out of handles" );
+	return INVALID_MEMHANDLE;
+}
+
+memhandle_t CDataManagerConcurrentBase::StoreResourceInHandle( memhandle_t handle, void *pStore, unsigned int realSize )
+{
+	const uint32 nBits = ToBits( handle );
+	Shard_t &shard = ShardOf( nBits );
+	AUTO_LOCK_FM( shard.m_Mutex );
+
+	Element_t &elem = At( shard, IndexOf( nBits ) );
+	Assert( elem.m_nList == LIST_NONE );
+	elem.m_pStore.store( pStore, std::memory_order_release );
+	elem.m_nSize = realSize;
+	shard.m_nBytes.fetch_add( realSize, std::memory_order_relaxed );
+	m_nMemUsed.fetch_add( realSize, std::memory_order_relaxed );
+
+	// may have been locked in the meantime too
+	const bool bLocked = ( elem.m_nState.load( std::memory_order_relaxed ) & LOCK_MASK ) != 0;
+	Link( shard, bLocked ? LIST_LOCKED : LIST_LRU, IndexOf( nBits ) );
+	return handle;
+}
+
+void *CDataManagerConcurrentBase::LockResource( memhandle_t handle )
+{
+	const uint32 nBits = ToBits( handle );
+	Shard_t &shard = ShardOf( nBits );
+	Element_t *pElem = Resolve( shard, nBits );
+	if ( !pElem )
+		return NULL;
+
+	const uint32 nSerial = SerialOf( nBits );
+	uint32 nState = pElem->m_nState.load( std::memory_order_acquire );
+
+	// already locked: it's in the lock list and stays there, just count
+	while ( ( nState >> LOCK_BITS ) == nSerial && ( nState & LOCK_MASK ) != 0 )
+	{
+		Assert( ( nState & LOCK_MASK ) != LOCK_MASK );
+		if ( pElem->m_nState.compare_exchange_weak( nState, nState + 1, std::memory_order_acquire ) )
+		{
+			shard.m_nHits.fetch_add( 1, std::memory_order_relaxed );
+			return pElem->m_pStore.load( std::memory_order_acquire );
+		}
+	}
+
+	AUTO_LOCK_FM( shard.m_Mutex );
+	nState = pElem->m_nState.load( std::memory_order_relaxed );
+	if ( ( nState >> LOCK_BITS ) != nSerial )
+	{
+		shard.m_nMisses.fetch_add( 1, std::memory_order_relaxed );
+		return NULL;
+	}
+
+	// nobody can take the first lock but us now
+	if ( ( nState & LOCK_MASK ) == 0 && pElem->m_nList == LIST_LRU )
+	{
+		Unlink( shard, IndexOf( nBits ) );
+		Link( shard, LIST_LOCKED, IndexOf( nBits ) );
+	}
+	pElem->m_nState.fetch_add( 1, std::memory_order_acquire );
+	shard.m_nHits.fetch_add( 1, std::memory_order_relaxed );
+	return pElem->m_pStore.load( std::memory_order_relaxed );
+}
+
+int CDataManagerConcurrentBase::UnlockResource( memhandle_t handle )
+{
+	const uint32 nBits = ToBits( handle );
+	Shard_t &shard = ShardOf( nBits );
+	Element_t *pElem = Resolve( shard, nBits );
+	if ( !pElem )
+		return 0;
+
+	const uint32 nSerial = SerialOf( nBits );
+	uint32 nState = pElem->m_nState.load( std::memory_order_relaxed );
+
+	// not the last lock: it stays in the lock list
+	while ( ( nState >> LOCK_BITS ) == nSerial && ( nState & LOCK_MASK ) > 1 )
+	{
+		if ( pElem->m_nState.compare_exchange_weak( nState, nState - 1, std::memory_order_release ) )
+			return ( nState & LOCK_MASK ) - 1;
+	}
+
+	AUTO_LOCK_FM( shard.m_Mutex );
+	nState = pElem->m_nState.load( std::memory_order_relaxed );
+	while ( ( nState >> LOCK_BITS ) == nSerial )
+	{
+		const uint32 nLocks = nState & LOCK_MASK;
+		Assert( nLocks > 0 );
+		if ( nLocks == 0 )
+			return 0;
+
+		if ( pElem->m_nState.compare_exchange_weak( nState, nState - 1, std::memory_order_release ) )
+		{
+			if ( nLocks == 1 && pElem->m_nList == LIST_LOCKED )
+			{
+				Unlink( shard, IndexOf( nBits ) );
+				Link( shard, LIST_LRU, IndexOf( nBits ) );
+			}
+			return nLocks - 1;
+		}
+	}
+	return 0;
+}
+
+void *CDataManagerConcurrentBase::GetResource_NoLockNoLRUTouch( memhandle_t handle )
+{
+	const uint32 nBits = ToBits( handle );
+	Shard_t &shard = ShardOf( nBits );
+	Element_t *pElem = Resolve( shard, nBits );
+	if ( !pElem )
+		return NULL;
+
+	// a locked resource can't go away under us
+	const uint32 nState = pElem->m_nState.load( std::memory_order_acquire );
+	if ( ( nState >> LOCK_BITS ) == SerialOf( nBits ) && ( nState & LOCK_MASK ) != 0 )
+	{
+		shard.m_nHits.fetch_add( 1, std::memory_order_relaxed );
+		return pElem->m_pStore.load( std::memory_order_acquire );
+	}
+
+	AUTO_LOCK_FM( shard.m_Mutex );
+	if ( ( pElem->m_nState.load( std::memory_order_relaxed ) >> LOCK_BITS ) != SerialOf( nBits ) )
+	{
+		shard.m_nMisses.fetch_add( 1, std::memory_order_relaxed );
+		return NULL;
+	}
+	shard.m_nHits.fetch_add( 1, std::memory_order_relaxed );
+	return pElem->m_pStore.load( std::memory_order_relaxed );
+}
+
+void *CDataManagerConcurrentBase::GetResource_NoLock( memhandle_t handle )
+{
+	const uint32 nBits = ToBits( handle );
+	Shard_t &shard = ShardOf( nBits );
+	Element_t *pElem = Resolve( shard, nBits );
+	if ( !pElem )
+		return NULL;
+
+	// locked ones aren't in the LRU, nothing to touch
+	const uint32 nState = pElem->m_nState.load( std::memory_order_acquire );
+	if ( ( nState >> LOCK_BITS ) == SerialOf( nBits ) && ( nState & LOCK_MASK ) != 0 )
+	{
+		shard.m_nHits.fetch_add( 1, std::memory_order_relaxed );
+		return pElem->m_pStore.load( std::memory_order_acquire );
+	}
+
+	AUTO_LOCK_FM( shard.m_Mutex );
+	if ( ( pElem->m_nState.load( std::memory_order_relaxed ) >> LOCK_BITS ) != SerialOf( nBits ) )
+	{
+		shard.m_nMisses.fetch_add( 1, std::memory_order_relaxed );
+		return NULL;
+	}
+	if ( pElem->m_nList == LIST_LRU )
+	{
+		Unlink( shard, IndexOf( nBits ) );
+		Link( shard, LIST_LRU, IndexOf( nBits ) );
+	}
+	shard.m_nHits.fetch_add( 1, std::memory_order_relaxed );
+	return pElem->m_pStore.load( std::memory_order_relaxed );
+}
+
+void CDataManagerConcurrentBase::TouchResource( memhandle_t handle )
+{
+	GetResource_NoLock( handle );
+}
+
+void CDataManagerConcurrentBase::MarkAsStale( memhandle_t handle )
+{
+	const uint32 nBits = ToBits( handle );
+	Shard_t &shard = ShardOf( nBits );
+	Element_t *pElem = Resolve( shard, nBits );
+	if ( !pElem )
+		return;
+
+	AUTO_LOCK_FM( shard.m_Mutex );
+	if ( ( pElem->m_nState.load( std::memory_order_relaxed ) >> LOCK_BITS ) == SerialOf( nBits ) && pElem->m_nList == LIST_LRU )
+	{
+		Unlink( shard, IndexOf( nBits ) );
+		Link( shard, LIST_LRU, IndexOf( nBits ), true );
+	}
+}
+
+int CDataManagerConcurrentBase::LockCount( memhandle_t handle )
+{
+	const uint32 nBits = ToBits( handle );
+	Element_t *pElem = Resolve( ShardOf( nBits ), nBits );
+	if ( !pElem )
+		return 0;
+
+	const uint32 nState = pElem->m_nState.load( std::memory_order_relaxed );
+	return ( nState >> LOCK_BITS ) == SerialOf( nBits ) ? nState & LOCK_MASK : 0;
+}
+
+int CDataManagerConcurrentBase::BreakLock( memhandle_t handle )
+{
+	const uint32 nBits = ToBits( handle );
+	Shard_t &shard = ShardOf( nBits );
+	Element_t *pElem = Resolve( shard, nBits );
+	if ( !pElem )
+		return 0;
+
+	AUTO_LOCK_FM( shard.m_Mutex );
+	uint32 nState = pElem->m_nState.load( std::memory_order_relaxed );
+	do
+	{
+		if ( ( nState >> LOCK_BITS ) != SerialOf( nBits ) )
+			return 0;
+	}
+	while ( !pElem->m_nState.compare_exchange_weak( nState, nState & ~LOCK_MASK, std::memory_order_acq_rel ) );
+
+	if ( pElem->m_nList == LIST_LOCKED )
+	{
+		Unlink( shard, IndexOf( nBits ) );
+		Link( shard, LIST_LRU, IndexOf( nBits ) );
+	}
+	return nState & LOCK_MASK;
+}
+
+int CDataManagerConcurrentBase::BreakAllLocks()
+{
+	int nBroken = 0;
+	for ( Shard_t &shard : m_Shards )
+	{
+		AUTO_LOCK_FM( shard.m_Mutex );
+		while ( shard.m_Lists[ LIST_LOCKED ].m_nHead != INVALID_INDEX )
+		{
+			const uint16 index = shard.m_Lists[ LIST_LOCKED ].m_nHead;
+			Element_t &elem = At( shard, index );
+			elem.m_nState.fetch_and( ~LOCK_MASK, std::memory_order_acq_rel );
+			Unlink( shard, index );
+			Link( shard, LIST_LRU, index );
+			nBroken++;
+		}
+	}
+	return nBroken;
+}
+
+void CDataManagerConcurrentBase::DestroyResource( memhandle_t handle )
+{
+	const uint32 nBits = ToBits( handle );
+	Shard_t &shard = ShardOf( nBits );
+	Element_t *pElem = Resolve( shard, nBits );
+	if ( !pElem )
+		return;
+
+	void *p;
+	{
+		AUTO_LOCK_FM( shard.m_Mutex );
+		const uint32 nState = pElem->m_nState.load( std::memory_order_relaxed );
+		if ( ( nState >> LOCK_BITS ) != SerialOf( nBits ) )
+			return;
+
+		Assert( ( nState & LOCK_MASK ) == 0 );
+		pElem->m_nState.store( nState & ~LOCK_MASK, std::memory_order_relaxed );
+		p = FreeElement( shard, IndexOf( nBits ) );
+	}
+
+	if ( p )
+	{
+		DestroyResourceStorage( p );
+	}
+}
+
+void CDataManagerConcurrentBase::NotifySizeChanged( memhandle_t handle, unsigned int oldSize, unsigned int newSize )
+{
+	const uint32 nBits = ToBits( handle );
+	Shard_t &shard = ShardOf( nBits );
+	Element_t *pElem = Resolve( shard, nBits );
+
+	AUTO_LOCK_FM( shard.m_Mutex );
+	if ( pElem && ( pElem->m_nState.load( std::memory_order_relaxed ) >> LOCK_BITS ) == SerialOf( nBits ) )
+	{
+		pElem->m_nSize += newSize - oldSize;
+	}
+	shard.m_nBytes.fetch_add( newSize - oldSize, std::memory_order_relaxed );
+	m_nMemUsed.fetch_add( newSize - oldSize, std::memory_order_relaxed );
+}
+
+unsigned int CDataManagerConcurrentBase::FlushAllUnlocked()
+{
+	const unsigned nBytesInitial = UsedSize();
+	CUtlVector<void *> destroyList;
+	for ( Shard_t &shard : m_Shards )
+	{
+		{
+			AUTO_LOCK_FM( shard.m_Mutex );
+			FlushList( shard, LIST_LRU, destroyList );
+		}
+		DestroyAll( destroyList );
+		destroyList.RemoveAll();
+	}
+	return nBytesInitial - UsedSize();
+}
+
+// Frees everything!  The LRU AND the LOCKED items.  This is only used to forcibly free the resources,
+// not to make space.
+unsigned int CDataManagerConcurrentBase::FlushAll()
+{
+	const unsigned result = UsedSize();
+	CUtlVector<void *> destroyList;
+	for ( Shard_t &shard : m_Shards )
+	{
+		{
+			AUTO_LOCK_FM( shard.m_Mutex );
+			FlushList( shard, LIST_LRU, destroyList );
+			FlushList( shard, LIST_LOCKED, destroyList );
+		}
+		DestroyAll( destroyList );
+		destroyList.RemoveAll();
+	}
+	m_bListsAreFreed = false;
+	return result;
+}
+
+unsigned int CDataManagerConcurrentBase::Purge( unsigned int nBytesToPurge )
+{
+	const unsigned int nUsed = UsedSize();
+	const unsigned int nTargetSize = nUsed < nBytesToPurge ? 0 : nUsed - nBytesToPurge;
+	return EnsureCapacity( TargetSize() - nTargetSize );
+}
+
+// free resources until there is enough space to hold "size"
+unsigned int CDataManagerConcurrentBase::EnsureCapacity( unsigned int size )
+{
+	const unsigned nBytesInitial = UsedSize();
+	void *destroy[ EVICTION_BATCH ];
+
+	while ( UsedSize() > TargetSize() || AvailableSize() < size )
+	{
+		const unsigned nNeeded = UsedSize() + size - TargetSize();
+
+		// a batch from the next shard with something to evict, their LRUs take turns
+		int nDestroy = 0;
+		for ( int i = 0; i < NUM_SHARDS && nDestroy == 0; i++ )
+		{
+			Shard_t &shard = m_Shards[ m_nEvictionCursor.fetch_add( 1, std::memory_order_relaxed ) & ( NUM_SHARDS - 1 ) ];
+			AUTO_LOCK_FM( shard.m_Mutex );
+
+			unsigned nFreed = 0;
+			while ( nDestroy < EVICTION_BATCH && nFreed < nNeeded && shard.m_Lists[ LIST_LRU ].m_nHead != INVALID_INDEX )
+			{
+				const uint16 index = shard.m_Lists[ LIST_LRU ].m_nHead;
+				nFreed += At( shard, index ).m_nSize;
+				destroy[ nDestroy++ ] = FreeElement( shard, index );
+			}
+			shard.m_nEvictions.fetch_add( nDestroy, std::memory_order_relaxed );
+		}
+
+		// everything left is locked
+		if ( nDestroy == 0 )
+			break;
+
+		for ( int i = 0; i < nDestroy; i++ )
+		{
+			if ( destroy[i] )
+			{
+				DestroyResourceStorage( destroy[i] );
+			}
+		}
+	}
+	return nBytesInitial - UsedSize();
+}
+
+void CDataManagerConcurrentBase::GetShardStats( int nShard, DataManagerShardStats_t &stats ) const
+{
+	Assert( nShard >= 0 && nShard < NUM_SHARDS );
+	const Shard_t &shard = m_Shards[ nShard ];
+	stats.m_nHits = shard.m_nHits.load( std::memory_order_relaxed );
+	stats.m_nMisses = shard.m_nMisses.load( std::memory_order_relaxed );
+	stats.m_nEvictions = shard.m_nEvictions.load( std::memory_order_relaxed );
+	stats.m_nBytes = shard.m_nBytes.load( std::memory_order_relaxed );
+	stats.m_nResources = shard.m_Lists[ LIST_LRU ].m_nCount + shard.m_Lists[ LIST_LOCKED ].m_nCount;
+}
+
+void CDataManagerConcurrentBase::ResetStats()
+{
+	for ( Shard_t &shard : m_Shards )
+	{
+		shard.m_nHits.store( 0, std::memory_order_relaxed );
+		shard.m_nMisses.store( 0, std::memory_order_relaxed );
+		shard.m_nEvictions.store( 0, std::memory_order_relaxed );
+	}
+}
+
+// get a list of everything in the LRU, most recently used first within each shard
+void CDataManagerConcurrentBase::GetLRUHandleList( CUtlVector< memhandle_t >& list )
+{
+	for ( int nShard = 0; nShard < NUM_SHARDS; nShard++ )
+	{
+		Shard_t &shard = m_Shards[ nShard ];
+		AUTO_LOCK_FM( shard.m_Mutex );
+		for ( uint16 node = shard.m_Lists[ LIST_LRU ].m_nTail; node != INVALID_INDEX; node = At( shard, node ).m_nPrev )
+		{
+			list.AddToTail( ToHandle( nShard, node, At( shard, node ).m_nState.load( std::memory_order_relaxed ) >> LOCK_BITS ) );
+		}
+	}
+}
+
+// get a list of everything locked
+void CDataManagerConcurrentBase::GetLockHandleList( CUtlVector< memhandle_t >& list )
+{
+	for ( int nShard = 0; nShard < NUM_SHARDS; nShard++ )
+	{
+		Shard_t &shard = m_Shards[ nShard ];
+		AUTO_LOCK_FM( shard.m_Mutex );
+		for ( uint16 node = shard.m_Lists[ LIST_LOCKED ].m_nHead; node != INVALID_INDEX; node = At( shard, node ).m_nNext )
+		{
+			list.AddToTail( ToHandle( nShard, node, At( shard, node ).m_nState.load( std::memory_order_relaxed ) >> LOCK_BITS ) );
+		}
+	}
+}
@@ -8,6 +8,9 @@
 #include "mathlib/mathlib.h"
 #include "tier0/dbg.h"
 #include "tier0/platform.h"
+#include "tier1/utlbuffer.h"
+#include <bit>
+#include <emmintrin.h>
 
 // memdbgon must be the last include file in a .cpp file!!!
 #include "tier0/memdbgon.h"
@@ -24,23 +27,19 @@
 //
 // available codes (could be used for additonal compression ops)
 // long offset form whose offset could have fit in short offset
+//
+// offsets further than 32767 are reached with big copies of 0 bytes.
+//
+// format of compact diff output, all numbers are LEB128 varints:
+// (N << 1)        copy next N literaly
+// (N << 1) | 1, ofs (zigzag)  copy next N bytes from original, changing offset by ofs from last copy end
 
-// note - this algorithm uses storage equal to 8* the old buffer size. 64k=.5mb
-
-
-#define MIN_MATCH_LEN 8
-#define ACCEPTABLE_MATCH_LEN 4096
-
-struct BlockPtr {
-	BlockPtr* Next;
-	const uint8* dataptr;
-};
 
-template<class T, class V>
-static inline void AddToHead( T*& head, V* node ) {
-	node->Next = head;
-	head = node;
-}
+// windows of new data are hashed at every byte, the old data only every stride bytes
+#define DELTA_HASH_PRIME 0x01000193u
+#define DELTA_INDEX_PROBES 4
+// literals are written out once there's this many, to keep the encoder's memory bounded
+#define DELTA_MAX_PENDING_LITERALS 65536
 
 void Fail( const char* msg ) {
 	Assert( 0 );
@@ -111,348 +110,381 @@ void ApplyDiffs( const uint8* OldBlock, const uint8* DiffList, int OldSize, int
 	ResultListSize = Output - obuf;
 }
 
-static void CopyPending( int len, const uint8* rawbytes, uint8*& outbuf, const uint8* limit ) {
+static void CopyPending( int len, const uint8* rawbytes, CUtlBuffer& out ) {
 	//    printf("copy raw len=%d\n",len);
-	if ( len < 128 ) {
-		if ( limit - outbuf < len + 1 )
-			Fail( "diff buffer overrun" );
-		*( outbuf++ ) = len;
-		memcpy( outbuf, rawbytes, len );
-		outbuf += len;
-	} else {
-		if ( limit - outbuf < len + 5 )
-			Fail( "diff buffer overrun" );
-		*( outbuf++ ) = 0x80;
-		*( outbuf++ ) = 0x00;
-		*( outbuf++ ) = ( len & 255 );
-		*( outbuf++ ) = ( ( len >> 8 ) & 255 );
-		*( outbuf++ ) = ( ( len >> 16 ) & 255 );
-		memcpy( outbuf, rawbytes, len );
-		outbuf += len;
+	while ( len > 0 ) {
+		if ( len < 128 ) {
+			out.PutUnsignedChar( len );
+			out.Put( rawbytes, len );
+			return;
+		}
+		const int chunk = std::min( len, 0xffffff );
+		out.PutUnsignedChar( 0x80 );
+		out.PutUnsignedChar( 0x00 );
+		out.PutUnsignedChar( chunk & 255 );
+		out.PutUnsignedChar( ( chunk >> 8 ) & 255 );
+		out.PutUnsignedChar( ( chunk >> 16 ) & 255 );
+		out.Put( rawbytes, chunk );
+		rawbytes += chunk;
+		len -= chunk;
 	}
 }
 
-static uint32 hasher( uint8 const* mdata ) {
-	// attempt to scramble the bits of h1 and h2 together
-	uint32 ret = 0;
-	for ( int i = 0; i < MIN_MATCH_LEN; i++ ) {
-		ret = ret << 4;
-		ret += ( *mdata++ );
+static void PutVarInt( CUtlBuffer& out, uint32 value ) {
+	while ( value >= 0x80 ) {
+		out.PutUnsignedChar( ( value & 0x7f ) | 0x80 );
+		value >>= 7;
 	}
-	return ret;
+	out.PutUnsignedChar( value );
 }
 
-int FindDiffsForLargeFiles( const uint8* NewBlock, const uint8* OldBlock, int NewSize, int OldSize, int& DiffListSize, uint8* Output, uint32 OutSize, int hashsize ) {
-	int ret = 0;
-	if ( OldSize != NewSize )
-		ret = 1;
-	// first, build the hash table
-	auto** HashedMatches = new BlockPtr*[ hashsize ];
-	memset( HashedMatches, 0, sizeof( HashedMatches[ 0 ] ) * hashsize );
-	BlockPtr* Blocks = nullptr;
-	if ( OldSize )
-		Blocks = new BlockPtr[ OldSize ];
-	BlockPtr* FreeList = Blocks;
-	// now, build the hash table
-	const uint8* walk = OldBlock;
-	if ( OldBlock && OldSize )
-		while ( walk < OldBlock + OldSize - MIN_MATCH_LEN ) {
-			uint32 hash1 = hasher( walk );
-			hash1 &= ( hashsize - 1 );
-			BlockPtr* newnode = FreeList;
-			FreeList++;
-			newnode->dataptr = walk;
-			AddToHead( HashedMatches[ hash1 ], newnode );
-			walk++;
+static int VarIntSize( uint32 value ) {
+	int size = 1;
+	while ( value >= 0x80 ) {
+		value >>= 7;
+		size++;
+	}
+	return size;
+}
+
+static uint32 ZigZag( int value ) {
+	return ( static_cast<uint32>( value ) << 1 ) ^ static_cast<uint32>( value >> 31 );
+}
+
+static bool GetVarInt( const uint8*& data, const uint8* end, uint32& value ) {
+	value = 0;
+	for ( int shift = 0; shift < 35; shift += 7 ) {
+		if ( data >= end )
+			return false;
+		const uint8 byte = *( data++ );
+		value |= static_cast<uint32>( byte & 0x7f ) << shift;
+		if ( !( byte & 0x80 ) )
+			return true;
+	}
+	return false;
+}
+
+// Number of equal bytes at the start of both, 16 at a time
+static int MatchLength( const uint8* a, const uint8* b, int max ) {
+	int n = 0;
+	while ( n + 16 <= max ) {
+		const int equal = _mm_movemask_epi8( _mm_cmpeq_epi8( _mm_loadu_si128( reinterpret_cast<const __m128i*>( a + n ) ), _mm_loadu_si128( reinterpret_cast<const __m128i*>( b + n ) ) ) );
+		if ( equal != 0xffff )
+			return n + std::countr_zero( static_cast<uint32>( ~equal ) );
+		n += 16;
+	}
+	while ( n < max && a[ n ] == b[ n ] )
+		n++;
+	return n;
+}
+
+static uint32 HashWindow( const uint8* data, int len ) {
+	uint32 hash = 0;
+	for ( int i = 0; i < len; i++ )
+		hash = hash * DELTA_HASH_PRIME + data[ i ];
+	return hash;
+}
+
+
+bool ApplyDiffsCompact( const uint8* OldBlock, const uint8* DiffList, int OldSize, int DiffListSize, int& ResultListSize, uint8* Output, uint32 OutSize ) {
+	const uint8* end_of_diff_list = DiffList + DiffListSize;
+	int copy_src = 0;
+	uint32 written = 0;
+	ResultListSize = 0;
+	while ( DiffList < end_of_diff_list ) {
+		uint32 op;
+		if ( !GetVarInt( DiffList, end_of_diff_list, op ) )
+			return false;
+		const uint32 len = op >> 1;
+		if ( len > OutSize - written )
+			return false;
+		if ( op & 1 ) {
+			uint32 zigzag;
+			if ( !GetVarInt( DiffList, end_of_diff_list, zigzag ) )
+				return false;
+			const int64 start = static_cast<int64>( copy_src ) + static_cast<int32>( ( zigzag >> 1 ) ^ -static_cast<int32>( zigzag & 1 ) );
+			if ( start < 0 || start + len > static_cast<uint32>( OldSize ) )
+				return false;
+			memcpy( Output + written, OldBlock + start, len );
+			copy_src = static_cast<int>( start + len );
+		} else {
+			if ( len > static_cast<uint32>( end_of_diff_list - DiffList ) )
+				return false;
+			memcpy( Output + written, DiffList, len );
+			DiffList += len;
 		}
-	else
-		ret = 1;
-	// now, we have the hash table which may be used to search. begin the output step
-	int pending_raw_len = 0;
-	walk = NewBlock;
-	uint8* outbuf = Output;
-	const uint8* lastmatchend = OldBlock;
-	while ( walk < NewBlock + NewSize ) {
-		int longest = 0;
-		BlockPtr* longest_block = 0;
-		if ( walk < NewBlock + NewSize - MIN_MATCH_LEN ) {
-			// check for a match
-			uint32 hash1 = hasher( walk );
-			hash1 &= ( hashsize - 1 );
-			// now, find the longest match in the hash table. If we find one >MIN_MATCH_LEN, take it
-			for ( BlockPtr* b = HashedMatches[ hash1 ]; b; b = b->Next ) {
-				// find the match length
-				int match_of = b->dataptr - lastmatchend;
-				if ( ( match_of > -32768 ) && ( match_of < 32767 ) ) {
-					int max_mlength = std::min( 65535, OldBlock + OldSize - b->dataptr );
-					max_mlength = std::min( max_mlength, NewBlock + NewSize - walk );
-					int i;
-					for ( i = 0; i < max_mlength; i++ )
-						if ( walk[ i ] != b->dataptr[ i ] )
-							break;
-					if ( ( i > MIN_MATCH_LEN ) && ( i > longest ) ) {
-						longest = i;
-						longest_block = b;
-						if ( longest > ACCEPTABLE_MATCH_LEN )
-							break;
-					}
-				}
+		written += len;
+	}
+	ResultListSize = written;
+	return true;
+}
+
+
+CDeltaEncoder::CDeltaEncoder( Format_t format, int nBlockSize, int nMaxIndexBytes )
+	: m_Format( format ), m_nBlockSize( std::max( nBlockSize, 4 ) ), m_nMaxIndexEntries( std::max( nMaxIndexBytes / static_cast<int>( sizeof( uint32 ) ), 1024 ) ) {
+	m_nHashOutFactor = 1;
+	for ( int i = 1; i < m_nBlockSize; i++ )
+		m_nHashOutFactor *= DELTA_HASH_PRIME;
+}
+
+void CDeltaEncoder::SetSource( const uint8* pOld, int nOldSize ) {
+	m_pOld = pOld;
+	m_nOldSize = pOld ? nOldSize : 0;
+	m_Literals.RemoveAll();
+	m_nLiteralsSinceCopy = 0;
+	m_nCopyStart = 0;
+	m_nCopyLength = 0;
+	m_nCopySource = 0;
+	m_nNewSize = 0;
+	m_bDifferent = false;
+
+	const int windows = m_nOldSize - m_nBlockSize + 1;
+	if ( windows <= 0 ) {
+		m_Index.RemoveAll();
+		return;
+	}
+
+	// at most half full, sample sparser than a block apart if it doesn't fit
+	const int capacity = std::min( static_cast<int>( std::bit_ceil( static_cast<uint32>( 2 * ( windows / m_nBlockSize + 1 ) ) ) ), static_cast<int>( std::bit_floor( static_cast<uint32>( m_nMaxIndexEntries ) ) ) );
+	const int stride = std::max( m_nBlockSize, ( windows + capacity / 2 - 1 ) / ( capacity / 2 ) );
+	m_nIndexShift = 32 - std::countr_zero( static_cast<uint32>( capacity ) );
+	m_Index.SetCount( capacity );
+	memset( m_Index.Base(), 0, capacity * sizeof( uint32 ) );
+
+	for ( int pos = 0; pos < windows; pos += stride ) {
+		const uint32 slot = ( HashWindow( pOld + pos, m_nBlockSize ) * 0x9E3779B1u ) >> m_nIndexShift;
+		// keep the first occurrence, unless its neighbors are full too
+		for ( int probe = 0; probe < DELTA_INDEX_PROBES; probe++ ) {
+			uint32& entry = m_Index[ ( slot + probe ) & ( capacity - 1 ) ];
+			if ( entry == 0 || probe == DELTA_INDEX_PROBES - 1 ) {
+				if ( entry == 0 )
+					entry = pos + 1;
+				break;
 			}
 		}
-		// now, we have a match maybe
-		if ( longest_block ) {
-			if ( pending_raw_len ) { // must output
-				ret = 1;
-				CopyPending( pending_raw_len, walk - pending_raw_len, outbuf, Output + OutSize );
-				pending_raw_len = 0;
-			}
-			// now, output copy block
-			int match_of = longest_block->dataptr - lastmatchend;
-			int nremaining = OutSize - ( outbuf - Output );
-
-			if ( match_of )
-				ret = 1;
-			//        printf("copy from %x to %x len=%d\n", match_of,outbuf-Output,longest);
-			if ( longest > 127 ) {
-				// use really long encoding
-				if ( nremaining < 5 )
-					Fail( "diff buff needs increase" );
-				*( outbuf++ ) = 00;
-				*( outbuf++ ) = ( longest & 255 );
-				*( outbuf++ ) = ( ( longest >> 8 ) & 255 );
-				*( outbuf++ ) = ( match_of & 255 );
-				*( outbuf++ ) = ( ( match_of >> 8 ) & 255 );
-			} else {
-				if ( ( match_of >= -128 ) && ( match_of < 128 ) ) {
-					if ( nremaining < 2 )
-						Fail( "diff buff needs increase" );
-					*( outbuf++ ) = 128 + longest;
-					*( outbuf++ ) = ( match_of & 255 );
-				} else {
-					// use long encoding
-					if ( nremaining < 4 )
-						Fail( "diff buff needs increase" );
-					*( outbuf++ ) = 0x80;
-					*( outbuf++ ) = longest;
-					*( outbuf++ ) = ( match_of & 255 );
-					*( outbuf++ ) = ( ( match_of >> 8 ) & 255 );
-				}
-			}
-			lastmatchend = longest_block->dataptr + longest;
-			walk += longest;
-		} else {
-			walk++;
-			pending_raw_len++;
+	}
+}
+
+int CDeltaEncoder::FindMatch( const uint8* pNew, int nAvailable, uint32 hash, int& nOldStart, int& nBackward ) const {
+	if ( m_Index.Count() == 0 )
+		return 0;
+
+	int longest = 0;
+	const uint32 slot = ( hash * 0x9E3779B1u ) >> m_nIndexShift;
+	for ( int probe = 0; probe < DELTA_INDEX_PROBES; probe++ ) {
+		const uint32 entry = m_Index[ ( slot + probe ) & ( m_Index.Count() - 1 ) ];
+		if ( entry == 0 )
+			break;
+
+		const int candidate = entry - 1;
+		const int forward = MatchLength( pNew, m_pOld + candidate, std::min( nAvailable, m_nOldSize - candidate ) );
+		if ( forward < m_nBlockSize )
+			continue;
+
+		// the start of the match may be in the pending literals
+		int backward = 0;
+		const int maxBackward = std::min( m_Literals.Count(), candidate );
+		while ( backward < maxBackward && m_Literals[ m_Literals.Count() - 1 - backward ] == m_pOld[ candidate - 1 - backward ] )
+			backward++;
+
+		if ( forward + backward > longest ) {
+			longest = forward + backward;
+			nOldStart = candidate;
+			nBackward = backward;
 		}
 	}
-	// now, flush pending raw copy
-	if ( pending_raw_len ) {  // must output
-		ret = 1;
-		CopyPending( pending_raw_len, walk - pending_raw_len, outbuf, Output + OutSize );
-		pending_raw_len = 0;
+	return longest;
+}
+
+bool CDeltaEncoder::IsWorthCopying( int nOldStart, int nLength ) const {
+	const int offset = nOldStart - m_nCopySource;
+	int cost;
+	if ( m_Format == FORMAT_COMPACT ) {
+		cost = VarIntSize( ( nLength << 1 ) | 1 ) + VarIntSize( ZigZag( offset ) );
+	} else {
+		// far offsets need empty copies to get there
+		cost = ( std::abs( offset ) - 1 ) / 32767 * 5 + ( nLength > 127 ? 5 : ( offset >= -128 && offset < 128 ? 2 : 4 ) );
 	}
-	delete[] HashedMatches;
-	if ( Blocks )
-		delete[] Blocks;
-	DiffListSize = outbuf - Output;
-	return ret;
+	// splitting a literal run costs another literal op
+	return nLength > cost + 1;
 }
 
+void CDeltaEncoder::Encode( const uint8* pNew, int nNewSize, CUtlBuffer& out ) {
+	m_nNewSize += nNewSize;
 
-int FindDiffs( const uint8* NewBlock, const uint8* OldBlock, int NewSize, int OldSize, int& DiffListSize, uint8* Output, uint32 OutSize ) {
-	int ret = 0;
-	if ( OldSize != NewSize )
-		ret = 1;
-	// first, build the hash table
-	BlockPtr* HashedMatches[ 65536 ];
-	memset( HashedMatches, 0, sizeof( HashedMatches ) );
-	BlockPtr* Blocks = 0;
-	if ( OldSize )
-		Blocks = new BlockPtr[ OldSize ];
-	BlockPtr* FreeList = Blocks;
-	// now, build the hash table
-	const uint8* walk = OldBlock;
-	if ( OldBlock && OldSize )
-		while ( walk < OldBlock + OldSize - MIN_MATCH_LEN ) {
-			uint16 hash1 = *( (const uint16*) walk ) + *( (const uint16*) walk + 2 );
-			BlockPtr* newnode = FreeList;
-			FreeList++;
-			newnode->dataptr = walk;
-			AddToHead( HashedMatches[ hash1 ], newnode );
-			walk++;
+	int i = 0;
+	bool hashValid = false;
+	uint32 hash = 0;
+	while ( i < nNewSize ) {
+		// carry on copying while the data keeps matching, this also continues matches over pieces
+		if ( m_nCopyLength > 0 ) {
+			const int copyEnd = m_nCopyStart + m_nCopyLength;
+			const int extra = MatchLength( pNew + i, m_pOld + copyEnd, std::min( nNewSize - i, m_nOldSize - copyEnd ) );
+			if ( extra > 0 ) {
+				m_nCopyLength += extra;
+				i += extra;
+				hashValid = false;
+				continue;
+			}
 		}
-	else
-		ret = 1;
-	// now, we have the hash table which may be used to search. begin the output step
-	int pending_raw_len = 0;
-	walk = NewBlock;
-	uint8* outbuf = Output;
-	const uint8* lastmatchend = OldBlock;
-	while ( walk < NewBlock + NewSize ) {
-		int longest = 0;
-		BlockPtr* longest_block = 0;
-		if ( walk < NewBlock + NewSize - MIN_MATCH_LEN ) {
-			// check for a match
-			uint16 hash1 = *( (const uint16*) walk ) + *( (const uint16*) walk + 2 );
-			// now, find the longest match in the hash table. If we find one >MIN_MATCH_LEN, take it
-			for ( BlockPtr* b = HashedMatches[ hash1 ]; b; b = b->Next ) {
-				// find the match length
-				int match_of = b->dataptr - lastmatchend;
-				if ( ( match_of > -32768 ) && ( match_of < 32767 ) ) {
-					int max_mlength = std::min( 65535, OldBlock + OldSize - b->dataptr );
-					max_mlength = std::min( max_mlength, NewBlock + NewSize - walk );
-					int i;
-					for ( i = 0; i < max_mlength; i++ )
-						if ( walk[ i ] != b->dataptr[ i ] )
-							break;
-					if ( ( i > MIN_MATCH_LEN ) && ( i > longest ) ) {
-						longest = i;
-						longest_block = b;
-					}
+
+		// an edit in place leaves the data after it where it was
+		if ( m_nCopyLength == 0 && m_nLiteralsSinceCopy > 0 ) {
+			const int aligned = m_nCopySource + m_nLiteralsSinceCopy;
+			if ( aligned < m_nOldSize ) {
+				const int length = MatchLength( pNew + i, m_pOld + aligned, std::min( nNewSize - i, m_nOldSize - aligned ) );
+				if ( length > 0 && IsWorthCopying( aligned, length ) ) {
+					FlushLiterals( out );
+					m_nCopyStart = aligned;
+					m_nCopyLength = length;
+					i += length;
+					hashValid = false;
+					continue;
 				}
 			}
 		}
-		// now, we have a match maybe
-		if ( longest_block ) {
-			if ( pending_raw_len ) { // must output
-				ret = 1;
-				CopyPending( pending_raw_len, walk - pending_raw_len, outbuf, Output + OutSize );
-				pending_raw_len = 0;
+
+		if ( i + m_nBlockSize <= nNewSize ) {
+			if ( !hashValid ) {
+				hash = HashWindow( pNew + i, m_nBlockSize );
+				hashValid = true;
 			}
-			// now, output copy block
-			int match_of = longest_block->dataptr - lastmatchend;
-			int nremaining = OutSize - ( outbuf - Output );
-			if ( match_of )
-				ret = 1;
-			if ( longest > 127 ) {
-				// use really long encoding
-				if ( nremaining < 5 )
-					Fail( "diff buff needs increase" );
-				*( outbuf++ ) = 00;
-				*( outbuf++ ) = ( longest & 255 );
-				*( outbuf++ ) = ( ( longest >> 8 ) & 255 );
-				*( outbuf++ ) = ( match_of & 255 );
-				*( outbuf++ ) = ( ( match_of >> 8 ) & 255 );
-			} else {
-				if ( ( match_of >= -128 ) && ( match_of < 128 ) ) {
-					if ( nremaining < 2 )
-						Fail( "diff buff needs increase" );
-					*( outbuf++ ) = 128 + longest;
-					*( outbuf++ ) = ( match_of & 255 );
-				} else {
-					// use long encoding
-					if ( nremaining < 4 )
-						Fail( "diff buff needs increase" );
-					*( outbuf++ ) = 0x80;
-					*( outbuf++ ) = longest;
-					*( outbuf++ ) = ( match_of & 255 );
-					*( outbuf++ ) = ( ( match_of >> 8 ) & 255 );
-				}
+
+			int oldStart = 0;
+			int backward = 0;
+			const int length = FindMatch( pNew + i, nNewSize - i, hash, oldStart, backward );
+			if ( length > 0 && IsWorthCopying( oldStart - backward, length ) ) {
+				m_Literals.RemoveMultipleFromTail( backward );
+				m_nLiteralsSinceCopy -= backward;
+				FlushLiterals( out );
+				FlushCopy( out );
+				m_nCopyStart = oldStart - backward;
+				m_nCopyLength = length;
+				i += length - backward;
+				hashValid = false;
+				continue;
 			}
-			lastmatchend = longest_block->dataptr + longest;
-			walk += longest;
-		} else {
-			walk++;
-			pending_raw_len++;
 		}
+
+		// no match, it's a literal
+		FlushCopy( out );
+		m_Literals.AddToTail( pNew[ i ] );
+		m_nLiteralsSinceCopy++;
+		if ( m_Literals.Count() >= DELTA_MAX_PENDING_LITERALS )
+			FlushLiterals( out );
+
+		if ( hashValid && i + m_nBlockSize < nNewSize )
+			hash = ( hash - pNew[ i ] * m_nHashOutFactor ) * DELTA_HASH_PRIME + pNew[ i + m_nBlockSize ];
+		else
+			hashValid = false;
+		i++;
 	}
-	// now, flush pending raw copy
-	if ( pending_raw_len ) {// must output
-		ret = 1;
-		CopyPending( pending_raw_len, walk - pending_raw_len, outbuf, Output + OutSize );
-		pending_raw_len = 0;
+}
+
+bool CDeltaEncoder::Finish( CUtlBuffer& out ) {
+	FlushLiterals( out );
+	FlushCopy( out );
+	if ( m_nNewSize != m_nOldSize )
+		m_bDifferent = true;
+	m_pOld = nullptr;
+	return m_bDifferent;
+}
+
+void CDeltaEncoder::FlushLiterals( CUtlBuffer& out ) {
+	if ( m_Literals.Count() == 0 )
+		return;
+
+	m_bDifferent = true;
+	if ( m_Format == FORMAT_COMPACT ) {
+		PutVarInt( out, m_Literals.Count() << 1 );
+		out.Put( m_Literals.Base(), m_Literals.Count() );
+	} else {
+		CopyPending( m_Literals.Count(), m_Literals.Base(), out );
 	}
-	if ( Blocks )
-		delete[] Blocks;
-	DiffListSize = outbuf - Output;
-	return ret;
+	m_Literals.RemoveAll();
 }
 
+void CDeltaEncoder::FlushCopy( CUtlBuffer& out ) {
+	if ( m_nCopyLength == 0 )
+		return;
 
-int FindDiffsLowMemory( const uint8* NewBlock, const uint8* OldBlock, int NewSize, int OldSize, int& DiffListSize, uint8* Output, uint32 OutSize ) {
-	int ret = 0;
-	if ( OldSize != NewSize )
-		ret = 1;
-	const uint8* old_data_hash[ 256 ];
-	memset( old_data_hash, 0, sizeof( old_data_hash ) );
-	int pending_raw_len = 0;
-	const uint8* walk = NewBlock;
-	const uint8* oldptr = OldBlock;
-	uint8* outbuf = Output;
-	const uint8* lastmatchend = OldBlock;
-	while ( walk < NewBlock + NewSize ) {
-		while ( ( oldptr - OldBlock < walk - NewBlock + 40 ) && ( oldptr - OldBlock < OldSize - MIN_MATCH_LEN ) ) {
-			uint16 hash1 = ( oldptr[ 0 ] + oldptr[ 1 ] + oldptr[ 2 ] + oldptr[ 3 ] ) & ( NELEMS( old_data_hash ) - 1 );
-			old_data_hash[ hash1 ] = oldptr;
-			oldptr++;
-		}
-		int longest = 0;
-		const uint8* longest_block = nullptr;
-		if ( walk < NewBlock + NewSize - MIN_MATCH_LEN ) {
-			// check for a match
-			uint16 hash1 = ( walk[ 0 ] + walk[ 1 ] + walk[ 2 ] + walk[ 3 ] ) & ( NELEMS( old_data_hash ) - 1 );
-			if ( old_data_hash[ hash1 ] ) {
-				int max_bytes_to_compare = std::min( NewBlock + NewSize - walk, OldBlock + OldSize - old_data_hash[ hash1 ] );
-				int nmatches;
-				for ( nmatches = 0; nmatches < max_bytes_to_compare; nmatches++ )
-					if ( walk[ nmatches ] != old_data_hash[ hash1 ][ nmatches ] )
-						break;
-				if ( nmatches > MIN_MATCH_LEN ) {
-					longest_block = old_data_hash[ hash1 ];
-					longest = nmatches;
-				}
-			}
-		}
-		// now, we have a match maybe
-		if ( longest_block ) {
-			if ( pending_raw_len ) {  // must output
-				ret = 1;
-				CopyPending( pending_raw_len, walk - pending_raw_len, outbuf, Output + OutSize );
-				pending_raw_len = 0;
-			}
-			// now, output copy block
-			int match_of = longest_block - lastmatchend;
-			int nremaining = OutSize - ( outbuf - Output );
-			if ( match_of )
-				ret = 1;
-			if ( longest > 127 ) {
-				// use really long encoding
-				if ( nremaining < 5 )
-					Fail( "diff buff needs increase" );
-				*( outbuf++ ) = 00;
-				*( outbuf++ ) = ( longest & 255 );
-				*( outbuf++ ) = ( ( longest >> 8 ) & 255 );
-				*( outbuf++ ) = ( match_of & 255 );
-				*( outbuf++ ) = ( ( match_of >> 8 ) & 255 );
-			} else {
-				if ( ( match_of >= -128 ) && ( match_of < 128 ) ) {
-					if ( nremaining < 2 )
-						Fail( "diff buff needs increase" );
-					*( outbuf++ ) = 128 + longest;
-					*( outbuf++ ) = ( match_of & 255 );
-				} else {
-					// use long encoding
-					if ( nremaining < 4 )
-						Fail( "diff buff needs increase" );
-					*( outbuf++ ) = 0x80;
-					*( outbuf++ ) = longest;
-					*( outbuf++ ) = ( match_of & 255 );
-					*( outbuf++ ) = ( ( match_of >> 8 ) & 255 );
-				}
-			}
-			lastmatchend = longest_block + longest;
-			walk += longest;
+	const int offset = m_nCopyStart - m_nCopySource;
+	if ( offset )
+		m_bDifferent = true;
+	EmitCopy( out, offset, m_nCopyLength );
+	m_nCopySource = m_nCopyStart + m_nCopyLength;
+	m_nCopyLength = 0;
+	m_nLiteralsSinceCopy = 0;
+}
+
+void CDeltaEncoder::EmitCopy( CUtlBuffer& out, int nOffset, int nLength ) {
+	if ( m_Format == FORMAT_COMPACT ) {
+		PutVarInt( out, ( static_cast<uint32>( nLength ) << 1 ) | 1 );
+		PutVarInt( out, ZigZag( nOffset ) );
+		return;
+	}
+
+	// get within reach with empty copies
+	while ( nOffset > 32767 || nOffset < -32767 ) {
+		const int step = nOffset > 0 ? 32767 : -32767;
+		out.PutUnsignedChar( 0 );
+		out.PutUnsignedChar( 0 );
+		out.PutUnsignedChar( 0 );
+		out.PutUnsignedChar( step & 255 );
+		out.PutUnsignedChar( ( step >> 8 ) & 255 );
+		nOffset -= step;
+	}
+
+	while ( nLength > 0 ) {
+		const int chunk = std::min( nLength, 65535 );
+		//        printf("copy from %x len=%d\n", nOffset,chunk);
+		if ( chunk > 127 ) {
+			// use really long encoding
+			out.PutUnsignedChar( 0 );
+			out.PutUnsignedChar( chunk & 255 );
+			out.PutUnsignedChar( ( chunk >> 8 ) & 255 );
+			out.PutUnsignedChar( nOffset & 255 );
+			out.PutUnsignedChar( ( nOffset >> 8 ) & 255 );
+		} else if ( nOffset >= -128 && nOffset < 128 ) {
+			out.PutUnsignedChar( 128 + chunk );
+			out.PutUnsignedChar( nOffset & 255 );
 		} else {
-			walk++;
-			pending_raw_len++;
+			// use long encoding
+			out.PutUnsignedChar( 0x80 );
+			out.PutUnsignedChar( chunk );
+			out.PutUnsignedChar( nOffset & 255 );
+			out.PutUnsignedChar( ( nOffset >> 8 ) & 255 );
 		}
+		// the rest follows right after
+		nOffset = 0;
+		nLength -= chunk;
 	}
-	// now, flush pending raw copy
-	if ( pending_raw_len ) {// must output
-		ret = 1;
-		CopyPending( pending_raw_len, walk - pending_raw_len, outbuf, Output + OutSize );
-		pending_raw_len = 0;
-	}
-	DiffListSize = outbuf - Output;
-	return ret;
+}
+
+
+static int FindDiffsWithEncoder( const uint8* NewBlock, const uint8* OldBlock, int NewSize, int OldSize, int& DiffListSize, uint8* Output, uint32 OutSize, int nBlockSize, int nMaxIndexBytes ) {
+	CUtlBuffer out;
+	out.SetExternalBuffer( Output, OutSize, 0 );
+
+	CDeltaEncoder encoder( CDeltaEncoder::FORMAT_LEGACY, nBlockSize, nMaxIndexBytes );
+	encoder.SetSource( OldBlock, OldSize );
+	encoder.Encode( NewBlock, NewSize, out );
+	const bool different = encoder.Finish( out );
+	if ( !out.IsValid() )
+		Fail( "diff buffer overrun" );
+
+	DiffListSize = out.TellPut();
+	return different || !OldBlock || !OldSize;
+}
+
+int FindDiffsForLargeFiles( const uint8* NewBlock, const uint8* OldBlock, int NewSize, int OldSize, int& DiffListSize, uint8* Output, uint32 OutSize, int hashsize ) {
+	return FindDiffsWithEncoder( NewBlock, OldBlock, NewSize, OldSize, DiffListSize, Output, OutSize, 8, hashsize * 64 );
+}
+
+int FindDiffs( const uint8* NewBlock, const uint8* OldBlock, int NewSize, int OldSize, int& DiffListSize, uint8* Output, uint32 OutSize ) {
+	return FindDiffsWithEncoder( NewBlock, OldBlock, NewSize, OldSize, DiffListSize, Output, OutSize, 8, 16 * 1024 * 1024 );
+}
+
+int FindDiffsLowMemory( const uint8* NewBlock, const uint8* OldBlock, int NewSize, int OldSize, int& DiffListSize, uint8* Output, uint32 OutSize ) {
+	return FindDiffsWithEncoder( NewBlock, OldBlock, NewSize, OldSize, DiffListSize, Output, OutSize, 16, 64 * 1024 );
 }
@@ -0,0 +1,61 @@
+//
+// Created by ENDERZOMBI102 on 18/10/2026.
+//
+#include "tier1/functorarena.h"
+
+
+CFunctorArena::CFunctorArena() {
+	for ( auto i{ 0 }; i < NUM_SIZE_CLASSES; i += 1 ) {
+		m_pPools[ i ] = new CMemoryPoolMagazineMT( SIZE_CLASSES[ i ], 256, UTLMEMORYPOOL_GROW_FAST, "CFunctorArena", alignof( Header_t ) );
+	}
+}
+
+CFunctorArena::~CFunctorArena() {
+	for ( auto pPool : m_pPools ) {
+		delete pPool;
+	}
+}
+
+CFunctorArena& CFunctorArena::GetDefault() {
+	static CFunctorArena s_Arena{};
+	return s_Arena;
+}
+
+void* CFunctorArena::Alloc( size_t nBytes ) {
+	const auto nTotal{ nBytes + sizeof( Header_t ) };
+
+	Header_t* pHeader{ nullptr };
+	for ( auto i{ 0 }; i < NUM_SIZE_CLASSES; i += 1 ) {
+		if ( nTotal <= static_cast<size_t>( SIZE_CLASSES[ i ] ) ) {
+			pHeader = static_cast<Header_t*>( m_pPools[ i ]->Alloc() );
+			pHeader->m_pPool = m_pPools[ i ];
+			break;
+		}
+	}
+	if ( pHeader == nullptr ) {
+		pHeader = static_cast<Header_t*>( MemAlloc_AllocAligned( nTotal, alignof( Header_t ) ) );
+		pHeader->m_pPool = nullptr;
+	}
+	return pHeader + 1;
+}
+
+void CFunctorArena::Free( void* pMem ) {
+	const auto pHeader{ static_cast<Header_t*>( pMem ) - 1 };
+	if ( pHeader->m_pPool ) {
+		pHeader->m_pPool->Free( pHeader );
+	} else {
+		MemAlloc_FreeAligned( pHeader );
+	}
+}
+
+
+int CArenaFunctorBase::Release() {
+	const auto nRefs{ m_nRefs.fetch_sub( 1, std::memory_order_acq_rel ) - 1 };
+	if ( nRefs == 0 ) {
+		// the arena gave out the memory of the whole functor, not just of this base
+		const auto pMem{ dynamic_cast<void*>( this ) };
+		this->~CArenaFunctorBase();
+		CFunctorArena::Free( pMem );
+	}
+	return nRefs;
+}
@@ -9,8 +9,13 @@
 #include "tier0/platform.h"
 #include "generichash.h"
 #include <cctype>
+#include <cstring>
 #include <utility>
+#include <emmintrin.h>
 #include "tier0/dbg.h"
+#if defined( COMPILER_MSVC )
+	#include <intrin.h>
+#endif
 
 // NOTE: This has to be the last file included!
 #include "tier0/memdbgon.h"
@@ -288,7 +293,7 @@ uint32 MurmurHash2( const void* key, int32 len, uint32 seed ) {
 
 	// Mix 4 bytes at a time into the hash
 
-	const auto* data = reinterpret_cast<const uint8*>( key );
+	const auto* data{ reinterpret_cast<const uint8*>( key ) };
 
 	while ( len >= 4 ) {
 		uint32 k = LittleDWord( *(uint32*) data );
@@ -408,3 +413,346 @@ uint64 MurmurHash64( const void* key, int32 len, uint32 seed ) {
 
 	return h;
 }
+
+
+//-----------------------------------------------------------------------------
+// xxHash3, 64 bit
+// Inputs up to 240 bytes are mixed 16 bytes at a time against the secret, longer ones
+// go through 8 accumulators in 64 byte stripes, scrambled every 16 stripes.
+//-----------------------------------------------------------------------------
+namespace {
+	constexpr uint32 XXH_PRIME32_1{ 0x9E3779B1U };
+	constexpr uint32 XXH_PRIME32_2{ 0x85EBCA77U };
+	constexpr uint32 XXH_PRIME32_3{ 0xC2B2AE3DU };
+	constexpr uint64 XXH_PRIME64_1{ 0x9E3779B185EBCA87ULL };
+	constexpr uint64 XXH_PRIME64_2{ 0xC2B2AE3D27D4EB4FULL };
+	constexpr uint64 XXH_PRIME64_3{ 0x165667B19E3779F9ULL };
+	constexpr uint64 XXH_PRIME64_4{ 0x85EBCA77C2B2AE63ULL };
+	constexpr uint64 XXH_PRIME64_5{ 0x27D4EB2F165667C5ULL };
+	constexpr uint64 XXH_PRIME_MX1{ 0x165667919E3779F9ULL };
+	constexpr uint64 XXH_PRIME_MX2{ 0x9FB21C651E98DF25ULL };
+
+	constexpr int32 XXH_STRIPE_LEN{ 64 };
+	constexpr int32 XXH_SECRET_SIZE{ 192 };
+	constexpr int32 XXH_SECRET_CONSUME_RATE{ 8 };
+	constexpr int32 XXH_STRIPES_PER_BLOCK{ ( XXH_SECRET_SIZE - XXH_STRIPE_LEN ) / XXH_SECRET_CONSUME_RATE };
+	constexpr int32 XXH_MIDSIZE_MAX{ 240 };
+
+	alignas( 16 ) constexpr uint8 XXH_DEFAULT_SECRET[ XXH_SECRET_SIZE ] {
+		0xb8, 0xfe, 0x6c, 0x39, 0x23, 0xa4, 0x4b, 0xbe, 0x7c, 0x01, 0x81, 0x2c, 0xf7, 0x21, 0xad, 0x1c,
+		0xde, 0xd4, 0x6d, 0xe9, 0x83, 0x90, 0x97, 0xdb, 0x72, 0x40, 0xa4, 0xa4, 0xb7, 0xb3, 0x67, 0x1f,
+		0xcb, 0x79, 0xe6, 0x4e, 0xcc, 0xc0, 0xe5, 0x78, 0x82, 0x5a, 0xd0, 0x7d, 0xcc, 0xff, 0x72, 0x21,
+		0xb8, 0x08, 0x46, 0x74, 0xf7, 0x43, 0x24, 0x8e, 0xe0, 0x35, 0x90, 0xe6, 0x81, 0x3a, 0x26, 0x4c,
+		0x3c, 0x28, 0x52, 0xbb, 0x91, 0xc3, 0x00, 0xcb, 0x88, 0xd0, 0x65, 0x8b, 0x1b, 0x53, 0x2e, 0xa3,
+		0x71, 0x64, 0x48, 0x97, 0xa2, 0x0d, 0xf9, 0x4e, 0x38, 0x19, 0xef, 0x46, 0xa9, 0xde, 0xac, 0xd8,
+		0xa8, 0xfa, 0x76, 0x3f, 0xe3, 0x9c, 0x34, 0x3f, 0xf9, 0xdc, 0xbb, 0xc7, 0xc7, 0x0b, 0x4f, 0x1d,
+		0x8a, 0x51, 0xe0, 0x4b, 0xcd, 0xb4, 0x59, 0x31, 0xc8, 0x9f, 0x7e, 0xc9, 0xd9, 0x78, 0x73, 0x64,
+		0xea, 0xc5, 0xac, 0x83, 0x34, 0xd3, 0xeb, 0xc3, 0xc5, 0x81, 0xa0, 0xff, 0xfa, 0x13, 0x63, 0xeb,
+		0x17, 0x0d, 0xdd, 0x51, 0xb7, 0xf0, 0xda, 0x49, 0xd3, 0x16, 0x55, 0x26, 0x29, 0xd4, 0x68, 0x9e,
+		0x2b, 0x16, 0xbe, 0x58, 0x7d, 0x47, 0xa1, 0xfc, 0x8f, 0xf8, 0xb8, 0xd1, 0x7a, 0xd0, 0x31, 0xce,
+		0x45, 0xcb, 0x3a, 0x8f, 0x95, 0x16, 0x04, 0x28, 0xaf, 0xd7, 0xfb, 0xca, 0xbb, 0x4b, 0x40, 0x7e,
+	};
+
+	ALWAYS_INLINE uint32 XXH_Read32( const uint8* p ) {
+		uint32 value;
+		memcpy( &value, p, sizeof( value ) );
+		return LittleDWord( value );
+	}
+
+	ALWAYS_INLINE uint64 XXH_Read64( const uint8* p ) {
+		uint64 value;
+		memcpy( &value, p, sizeof( value ) );
+		return LittleQWord( value );
+	}
+
+	ALWAYS_INLINE void XXH_Write64( uint8* p, uint64 value ) {
+		value = LittleQWord( value );
+		memcpy( p, &value, sizeof( value ) );
+	}
+
+	ALWAYS_INLINE uint64 XXH_Rotl64( uint64 value, int bits ) {
+		return ( value << bits ) | ( value >> ( 64 - bits ) );
+	}
+
+	ALWAYS_INLINE uint32 XXH_Swap32( uint32 value ) {
+		return ( value << 24 ) | ( ( value << 8 ) & 0x00FF0000 ) | ( ( value >> 8 ) & 0x0000FF00 ) | ( value >> 24 );
+	}
+
+	ALWAYS_INLINE uint64 XXH_Swap64( uint64 value ) {
+		return ( static_cast<uint64>( XXH_Swap32( static_cast<uint32>( value ) ) ) << 32 ) | XXH_Swap32( static_cast<uint32>( value >> 32 ) );
+	}
+
+	// 64x64 -> 128 multiply, the two halves xor'd together
+	ALWAYS_INLINE uint64 XXH_Mul128Fold64( uint64 lhs, uint64 rhs ) {
+		#if defined( __SIZEOF_INT128__ )
+			const auto product{ static_cast<unsigned __int128>( lhs ) * rhs };
+			return static_cast<uint64>( product ) ^ static_cast<uint64>( product >> 64 );
+		#elif defined( COMPILER_MSVC ) && defined( _M_X64 )
+			uint64 high;
+			const uint64 low{ _umul128( lhs, rhs, &high ) };
+			return low ^ high;
+		#else
+			const uint64 loLo{ ( lhs & 0xFFFFFFFF ) * ( rhs & 0xFFFFFFFF ) };
+			const uint64 hiLo{ ( lhs >> 32 ) * ( rhs & 0xFFFFFFFF ) };
+			const uint64 loHi{ ( lhs & 0xFFFFFFFF ) * ( rhs >> 32 ) };
+			const uint64 hiHi{ ( lhs >> 32 ) * ( rhs >> 32 ) };
+			const uint64 cross{ ( loLo >> 32 ) + ( hiLo & 0xFFFFFFFF ) + loHi };
+			const uint64 high{ ( hiLo >> 32 ) + ( cross >> 32 ) + hiHi };
+			const uint64 low{ ( cross << 32 ) | ( loLo & 0xFFFFFFFF ) };
+			return low ^ high;
+		#endif
+	}
+
+	ALWAYS_INLINE uint64 XXH64_Avalanche( uint64 hash ) {
+		hash ^= hash >> 33;
+		hash *= XXH_PRIME64_2;
+		hash ^= hash >> 29;
+		hash *= XXH_PRIME64_3;
+		hash ^= hash >> 32;
+		return hash;
+	}
+
+	ALWAYS_INLINE uint64 XXH3_Avalanche( uint64 hash ) {
+		hash ^= hash >> 37;
+		hash *= XXH_PRIME_MX1;
+		hash ^= hash >> 32;
+		return hash;
+	}
+
+	ALWAYS_INLINE uint64 XXH3_RRMXMX( uint64 hash, uint64 len ) {
+		hash ^= XXH_Rotl64( hash, 49 ) ^ XXH_Rotl64( hash, 24 );
+		hash *= XXH_PRIME_MX2;
+		hash ^= ( hash >> 35 ) + len;
+		hash *= XXH_PRIME_MX2;
+		return hash ^ ( hash >> 28 );
+	}
+
+	ALWAYS_INLINE uint64 XXH3_Mix16B( const uint8* pData, const uint8* pSecret, uint64 seed ) {
+		const uint64 low{ XXH_Read64( pData ) };
+		const uint64 high{ XXH_Read64( pData + 8 ) };
+		return XXH_Mul128Fold64( low ^ ( XXH_Read64( pSecret ) + seed ), high ^ ( XXH_Read64( pSecret + 8 ) - seed ) );
+	}
+
+	uint64 XXH3_Len0To16( const uint8* pData, int32 len, const uint8* pSecret, uint64 seed ) {
+		if ( len > 8 ) {
+			const uint64 bitflip1{ ( XXH_Read64( pSecret + 24 ) ^ XXH_Read64( pSecret + 32 ) ) + seed };
+			const uint64 bitflip2{ ( XXH_Read64( pSecret + 40 ) ^ XXH_Read64( pSecret + 48 ) ) - seed };
+			const uint64 low{ XXH_Read64( pData ) ^ bitflip1 };
+			const uint64 high{ XXH_Read64( pData + len - 8 ) ^ bitflip2 };
+			const uint64 acc{ len + XXH_Swap64( low ) + high + XXH_Mul128Fold64( low, high ) };
+			return XXH3_Avalanche( acc );
+		}
+		if ( len >= 4 ) {
+			seed ^= static_cast<uint64>( XXH_Swap32( static_cast<uint32>( seed ) ) ) << 32;
+			const uint32 input1{ XXH_Read32( pData ) };
+			const uint32 input2{ XXH_Read32( pData + len - 4 ) };
+			const uint64 bitflip{ ( XXH_Read64( pSecret + 8 ) ^ XXH_Read64( pSecret + 16 ) ) - seed };
+			const uint64 input64{ input2 + ( static_cast<uint64>( input1 ) << 32 ) };
+			return XXH3_RRMXMX( input64 ^ bitflip, len );
+		}
+		if ( len > 0 ) {
+			const uint32 combined{ ( static_cast<uint32>( pData[ 0 ] ) << 16 ) | ( static_cast<uint32>( pData[ len >> 1 ] ) << 24 ) | pData[ len - 1 ] | ( static_cast<uint32>( len ) << 8 ) };
+			const uint64 bitflip{ ( XXH_Read32( pSecret ) ^ XXH_Read32( pSecret + 4 ) ) + seed };
+			return XXH64_Avalanche( combined ^ bitflip );
+		}
+		return XXH64_Avalanche( seed ^ ( XXH_Read64( pSecret + 56 ) ^ XXH_Read64( pSecret + 64 ) ) );
+	}
+
+	uint64 XXH3_Len17To128( const uint8* pData, int32 len, const uint8* pSecret, uint64 seed ) {
+		uint64 acc{ len * XXH_PRIME64_1 };
+		if ( len > 32 ) {
+			if ( len > 64 ) {
+				if ( len > 96 ) {
+					acc += XXH3_Mix16B( pData + 48, pSecret + 96, seed );
+					acc += XXH3_Mix16B( pData + len - 64, pSecret + 112, seed );
+				}
+				acc += XXH3_Mix16B( pData + 32, pSecret + 64, seed );
+				acc += XXH3_Mix16B( pData + len - 48, pSecret + 80, seed );
+			}
+			acc += XXH3_Mix16B( pData + 16, pSecret + 32, seed );
+			acc += XXH3_Mix16B( pData + len - 32, pSecret + 48, seed );
+		}
+		acc += XXH3_Mix16B( pData, pSecret, seed );
+		acc += XXH3_Mix16B( pData + len - 16, pSecret + 16, seed );
+		return XXH3_Avalanche( acc );
+	}
+
+	uint64 XXH3_Len129To240( const uint8* pData, int32 len, const uint8* pSecret, uint64 seed ) {
+		uint64 acc{ len * XXH_PRIME64_1 };
+		for ( int32 i{ 0 }; i < 8; i += 1 ) {
+			acc += XXH3_Mix16B( pData + 16 * i, pSecret + 16 * i, seed );
+		}
+		acc = XXH3_Avalanche( acc );
+
+		// the rest use the secret from a 3 bytes offset, and the last 16 bytes its end
+		uint64 accEnd{ XXH3_Mix16B( pData + len - 16, pSecret + 136 - 17, seed ) };
+		for ( int32 i{ 8 }; i < len / 16; i += 1 ) {
+			accEnd += XXH3_Mix16B( pData + 16 * i, pSecret + 16 * ( i - 8 ) + 3, seed );
+		}
+		return XXH3_Avalanche( acc + accEnd );
+	}
+
+	// One stripe into the accumulators, two lanes per register
+	ALWAYS_INLINE void XXH3_Accumulate512( uint64* RESTRICT pAcc, const uint8* RESTRICT pData, const uint8* RESTRICT pSecret ) {
+		auto* xacc{ reinterpret_cast<__m128i*>( pAcc ) };
+		for ( int32 i{ 0 }; i < 4; i += 1 ) {
+			const auto data{ _mm_loadu_si128( reinterpret_cast<const __m128i*>( pData ) + i ) };
+			const auto key{ _mm_loadu_si128( reinterpret_cast<const __m128i*>( pSecret ) + i ) };
+			const auto dataKey{ _mm_xor_si128( data, key ) };
+			// low 32 bits times high 32 bits of each lane
+			const auto product{ _mm_mul_epu32( dataKey, _mm_shuffle_epi32( dataKey, _MM_SHUFFLE( 0, 3, 0, 1 ) ) ) };
+			// the input goes to the other lane
+			const auto sum{ _mm_add_epi64( xacc[ i ], _mm_shuffle_epi32( data, _MM_SHUFFLE( 1, 0, 3, 2 ) ) ) };
+			xacc[ i ] = _mm_add_epi64( product, sum );
+		}
+	}
+
+	ALWAYS_INLINE void XXH3_Scramble( uint64* RESTRICT pAcc, const uint8* RESTRICT pSecret ) {
+		auto* xacc{ reinterpret_cast<__m128i*>( pAcc ) };
+		const auto prime{ _mm_set1_epi32( static_cast<int>( XXH_PRIME32_1 ) ) };
+		for ( int32 i{ 0 }; i < 4; i += 1 ) {
+			const auto acc{ xacc[ i ] };
+			const auto key{ _mm_loadu_si128( reinterpret_cast<const __m128i*>( pSecret ) + i ) };
+			const auto dataKey{ _mm_xor_si128( _mm_xor_si128( acc, _mm_srli_epi64( acc, 47 ) ), key ) };
+			// 64x32 multiply from two 32x32 ones
+			const auto productLow{ _mm_mul_epu32( dataKey, prime ) };
+			const auto productHigh{ _mm_mul_epu32( _mm_shuffle_epi32( dataKey, _MM_SHUFFLE( 0, 3, 0, 1 ) ), prime ) };
+			xacc[ i ] = _mm_add_epi64( productLow, _mm_slli_epi64( productHigh, 32 ) );
+		}
+	}
+
+	void XXH3_InitAccumulators( uint64* pAcc ) {
+		pAcc[ 0 ] = XXH_PRIME32_3;
+		pAcc[ 1 ] = XXH_PRIME64_1;
+		pAcc[ 2 ] = XXH_PRIME64_2;
+		pAcc[ 3 ] = XXH_PRIME64_3;
+		pAcc[ 4 ] = XXH_PRIME64_4;
+		pAcc[ 5 ] = XXH_PRIME32_2;
+		pAcc[ 6 ] = XXH_PRIME64_5;
+		pAcc[ 7 ] = XXH_PRIME32_1;
+	}
+
+	// The secret used for long inputs, the default one with the seed mixed in
+	void XXH3_InitSecret( uint8* pSecret, uint64 seed ) {
+		for ( int32 i{ 0 }; i < XXH_SECRET_SIZE; i += 16 ) {
+			XXH_Write64( pSecret + i, XXH_Read64( XXH_DEFAULT_SECRET + i ) + seed );
+			XXH_Write64( pSecret + i + 8, XXH_Read64( XXH_DEFAULT_SECRET + i + 8 ) - seed );
+		}
+	}
+
+	// The final stripe is always the last 64 bytes of the input, even if they were consumed already
+	uint64 XXH3_Finish( uint64* pAcc, const uint8* pLastStripe, const uint8* pSecret, uint64 len ) {
+		XXH3_Accumulate512( pAcc, pLastStripe, pSecret + XXH_SECRET_SIZE - XXH_STRIPE_LEN - 7 );
+
+		uint64 result{ len * XXH_PRIME64_1 };
+		for ( int32 i{ 0 }; i < 4; i += 1 ) {
+			const uint8* pKey{ pSecret + 11 + 16 * i };
+			result += XXH_Mul128Fold64( pAcc[ 2 * i ] ^ XXH_Read64( pKey ), pAcc[ 2 * i + 1 ] ^ XXH_Read64( pKey + 8 ) );
+		}
+		return XXH3_Avalanche( result );
+	}
+
+	uint64 XXH3_HashLong( const uint8* pData, int32 len, uint64 seed ) {
+		alignas( 16 ) uint8 secret[ XXH_SECRET_SIZE ];
+		XXH3_InitSecret( secret, seed );
+
+		alignas( 16 ) uint64 acc[ 8 ];
+		XXH3_InitAccumulators( acc );
+
+		// every stripe which ends before the last byte, scrambling after each block
+		const int32 nStripes{ ( len - 1 ) / XXH_STRIPE_LEN };
+		for ( int32 i{ 0 }; i < nStripes; i += 1 ) {
+			const int32 nInBlock{ i % XXH_STRIPES_PER_BLOCK };
+			XXH3_Accumulate512( acc, pData + i * XXH_STRIPE_LEN, secret + nInBlock * XXH_SECRET_CONSUME_RATE );
+			if ( nInBlock == XXH_STRIPES_PER_BLOCK - 1 ) {
+				XXH3_Scramble( acc, secret + XXH_SECRET_SIZE - XXH_STRIPE_LEN );
+			}
+		}
+		return XXH3_Finish( acc, pData + len - XXH_STRIPE_LEN, secret, len );
+	}
+
+	uint64 XXH3_HashShort( const uint8* pData, int32 len, uint64 seed ) {
+		if ( len <= 16 ) {
+			return XXH3_Len0To16( pData, len, XXH_DEFAULT_SECRET, seed );
+		}
+		if ( len <= 128 ) {
+			return XXH3_Len17To128( pData, len, XXH_DEFAULT_SECRET, seed );
+		}
+		return XXH3_Len129To240( pData, len, XXH_DEFAULT_SECRET, seed );
+	}
+}
+
+uint64 XXHash3_64( const void* key, int32 len, uint64 seed ) {
+	Assert( len >= 0 );
+	const auto* data{ reinterpret_cast<const uint8*>( key ) };
+	if ( len <= XXH_MIDSIZE_MAX ) {
+		return XXH3_HashShort( data, len, seed );
+	}
+	return XXH3_HashLong( data, len, seed );
+}
+
+void CXXHash3Stream::Reset( uint64 seed ) {
+	XXH3_InitAccumulators( m_Acc );
+	XXH3_InitSecret( m_Secret, seed );
+	m_nBuffered = 0;
+	m_nStripesInBlock = 0;
+	m_nTotalLen = 0;
+	m_nSeed = seed;
+}
+
+void CXXHash3Stream::ConsumeStripes( const uint8* pData, int32 nStripes ) {
+	for ( int32 i{ 0 }; i < nStripes; i += 1 ) {
+		XXH3_Accumulate512( m_Acc, pData + i * XXH_STRIPE_LEN, m_Secret + m_nStripesInBlock * XXH_SECRET_CONSUME_RATE );
+		m_nStripesInBlock += 1;
+		if ( m_nStripesInBlock == XXH_STRIPES_PER_BLOCK ) {
+			XXH3_Scramble( m_Acc, m_Secret + XXH_SECRET_SIZE - XXH_STRIPE_LEN );
+			m_nStripesInBlock = 0;
+		}
+	}
+}
+
+void CXXHash3Stream::Update( const void* pData, int32 len ) {
+	Assert( len >= 0 );
+	const auto* data{ reinterpret_cast<const uint8*>( pData ) };
+	m_nTotalLen += len;
+
+	while ( len > 0 ) {
+		const int32 nCopy{ Min( len, static_cast<int32>( sizeof( m_Buffer ) ) - m_nBuffered ) };
+		memcpy( m_Buffer + m_nBuffered, data, nCopy );
+		m_nBuffered += nCopy;
+		data += nCopy;
+		len -= nCopy;
+
+		// only consume a full buffer once we know more follows, the last stripe is special
+		if ( len > 0 ) {
+			ConsumeStripes( m_Buffer, m_nBuffered / XXH_STRIPE_LEN );
+			memcpy( m_LastStripe, m_Buffer + m_nBuffered - XXH_STRIPE_LEN, XXH_STRIPE_LEN );
+			m_nBuffered = 0;
+		}
+	}
+}
+
+uint64 CXXHash3Stream::Digest() const {
+	// short inputs never left the buffer
+	if ( m_nTotalLen <= static_cast<uint64>( XXH_MIDSIZE_MAX ) ) {
+		return XXH3_HashShort( m_Buffer, m_nBuffered, m_nSeed );
+	}
+
+	// finish on a copy, so more data can still be added
+	CXXHash3Stream state{ *this };
+	state.ConsumeStripes( m_Buffer, ( m_nBuffered - 1 ) / XXH_STRIPE_LEN );
+
+	alignas( 16 ) uint8 lastStripe[ XXH_STRIPE_LEN ];
+	if ( m_nBuffered >= XXH_STRIPE_LEN ) {
+		memcpy( lastStripe, m_Buffer + m_nBuffered - XXH_STRIPE_LEN, XXH_STRIPE_LEN );
+	} else {
+		const int32 nOld{ XXH_STRIPE_LEN - m_nBuffered };
+		memcpy( lastStripe, m_LastStripe + XXH_STRIPE_LEN - nOld, nOld );
+		memcpy( lastStripe + nOld, m_Buffer, m_nBuffered );
+	}
+	return XXH3_Finish( state.m_Acc, lastStripe, m_Secret, m_nTotalLen );
+}
+
+unsigned int XXHash3StringHashFunctor::operator()( const char* pszKey ) const {
+	return static_cast<uint32>( XXHash3_64( pszKey, static_cast<int32>( strlen( pszKey ) ) ) );
+}
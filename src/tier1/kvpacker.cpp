@@ -11,6 +11,8 @@
 
 #include "tier0/dbg.h"
 #include "utlbuffer.h"
+#include "utldict.h"
+#include <algorithm>
 
 // memdbgon must be the last include file in a .cpp file!!!
 #include <tier0/memdbgon.h>
@@ -283,3 +285,574 @@ bool KVPacker::ReadAsBinary( KeyValues *pNode, CUtlBuffer &buffer )
 	return buffer.IsValid();
 }
 
+
+
+//-----------------------------------------------------------------------------
+// Flat format
+//-----------------------------------------------------------------------------
+
+// Builds the string blob of a flat file, each distinct string is stored once
+class CKVFlatBlob
+{
+public:
+	CKVFlatBlob() : m_Offsets( k_eDictCompareTypeCaseSensitive ) {}
+
+	uint32 AddString( const char *pString )
+	{
+		int i = m_Offsets.Find( pString );
+		if ( i != m_Offsets.InvalidIndex() )
+			return m_Offsets[ i ];
+
+		uint32 nOffset = m_Data.Count();
+		m_Data.AddMultipleToTail( Q_strlen( pString ) + 1, pString );
+		m_Offsets.Insert( pString, nOffset );
+		return nOffset;
+	}
+
+	uint32 AddUint64( uint64 value )
+	{
+		while ( m_Data.Count() % sizeof( uint64 ) )
+			m_Data.AddToTail( 0 );
+
+		uint32 nOffset = m_Data.Count();
+		m_Data.AddMultipleToTail( sizeof( uint64 ), (const char *)&value );
+		return nOffset;
+	}
+
+	CUtlVector< char > m_Data;
+	CUtlDict< uint32, int > m_Offsets;
+};
+
+// writes KeyValue and its peers as a flat file to buffer
+bool KVPacker::WriteAsFlat( KeyValues *pNode, CUtlBuffer &buffer )
+{
+	if ( buffer.IsText() ) // must be a binary buffer
+		return false;
+
+	if ( !buffer.IsValid() ) // must be valid, no overflows etc
+		return false;
+
+	CUtlVector< KVFlatNode_t > nodes;
+	CUtlVector< KeyValues * > keys;	// the key of each node, nullptr for the root
+	CUtlVector< uint32 > index;
+	CKVFlatBlob blob;
+	CUtlVector< char > wideBuf;
+
+	KVFlatNode_t root = {};
+	root.m_nName = blob.AddString( "" );
+	root.m_nType = KeyValues::TYPE_NONE;
+	nodes.AddToTail( root );
+	keys.AddToTail( nullptr );
+
+	// breadth first, so that the children of a key are contiguous
+	for ( int i = 0; i < nodes.Count(); i++ )
+	{
+		KeyValues *dat = keys[ i ];
+		if ( nodes[ i ].m_nType != KeyValues::TYPE_NONE )
+			continue;
+
+		int nFirst = nodes.Count();
+		KeyValues *pFirst = i == 0 ? pNode : ( dat ? dat->GetFirstSubKey() : nullptr );
+		for ( KeyValues *pChild = pFirst; pChild; pChild = pChild->GetNextKey() )
+		{
+			KeyValues *pKey = pChild;
+			KVFlatNode_t node = {};
+			node.m_nName = blob.AddString( pChild->GetName() );
+			node.m_nType = pChild->GetDataType();
+
+			char buf[64];
+			switch ( pChild->GetDataType() )
+			{
+			case KeyValues::TYPE_NONE:
+				break;
+			case KeyValues::TYPE_STRING:
+				node.m_nString = blob.AddString( pChild->GetString() );
+				break;
+			case KeyValues::TYPE_WSTRING:
+				{
+					// stored as UTF-8, the size of wchar_t isn't the same everywhere
+					const wchar_t *pWString = pChild->GetWString();
+					wideBuf.SetCount( Q_wcslen( pWString ) * 4 + 1 );
+					Q_UnicodeToUTF8( pWString, wideBuf.Base(), wideBuf.Count() );
+					node.m_nString = blob.AddString( wideBuf.Base() );
+					break;
+				}
+			case KeyValues::TYPE_INT:
+				node.m_nValue = pChild->GetInt();
+				Q_snprintf( buf, sizeof( buf ), "%d", pChild->GetInt() );
+				node.m_nString = blob.AddString( buf );
+				break;
+			case KeyValues::TYPE_FLOAT:
+				{
+					float flValue = pChild->GetFloat();
+					Q_memcpy( &node.m_nValue, &flValue, sizeof( flValue ) );
+					Q_snprintf( buf, sizeof( buf ), "%f", flValue );
+					node.m_nString = blob.AddString( buf );
+					break;
+				}
+			case KeyValues::TYPE_UINT64:
+				node.m_nValue = blob.AddUint64( pChild->GetUint64() );
+				Q_snprintf( buf, sizeof( buf ), "%llu", pChild->GetUint64() );
+				node.m_nString = blob.AddString( buf );
+				break;
+			case KeyValues::TYPE_COLOR:
+				{
+					Color color = pChild->GetColor();
+					uint8 rgba[4] = { (uint8)color[0], (uint8)color[1], (uint8)color[2], (uint8)color[3] };
+					Q_memcpy( &node.m_nValue, rgba, sizeof( rgba ) );
+					node.m_nString = blob.AddString( "" );
+					break;
+				}
+			default:
+				// pointers mean nothing outside of this process, keep an empty key in their place
+				node.m_nType = KeyValues::TYPE_NONE;
+				pKey = nullptr;
+				break;
+			}
+
+			nodes.AddToTail( node );
+			keys.AddToTail( pKey );
+		}
+
+		int nLast = nodes.Count() - 1;
+		if ( nLast >= nFirst )
+			nodes[ nLast ].m_nFlags |= KVFLAT_NODE_LAST_CHILD;
+		nodes[ i ].m_nValue = nLast >= nFirst ? nFirst : 0;
+
+		// children by name, equal names keep their order so the first one is found first
+		nodes[ i ].m_nString = index.Count();
+		index.AddToTail( nodes.Count() - nFirst );
+		int nSorted = index.Count();
+		for ( int j = nFirst; j <= nLast; j++ )
+			index.AddToTail( j );
+
+		const char *pBlob = blob.m_Data.Base();
+		std::stable_sort( index.Base() + nSorted, index.Base() + index.Count(), [&]( uint32 a, uint32 b )
+		{
+			return Q_stricmp( pBlob + nodes[ a ].m_nName, pBlob + nodes[ b ].m_nName ) < 0;
+		} );
+	}
+
+	KVFlatHeader_t header = {};
+	header.m_nMagic = KVFLAT_MAGIC;
+	header.m_nVersion = KVFLAT_VERSION;
+	header.m_nNodeCount = nodes.Count();
+	header.m_nNodesOffset = sizeof( KVFlatHeader_t );
+	header.m_nIndexOffset = header.m_nNodesOffset + nodes.Count() * sizeof( KVFlatNode_t );
+	header.m_nIndexCount = index.Count();
+	header.m_nBlobOffset = ALIGN_VALUE( header.m_nIndexOffset + index.Count() * sizeof( uint32 ), sizeof( uint64 ) );
+	header.m_nBlobSize = blob.m_Data.Count();
+	header.m_nSize = header.m_nBlobOffset + header.m_nBlobSize;
+
+	int nStart = buffer.TellPut();
+	buffer.Put( &header, sizeof( header ) );
+	buffer.Put( nodes.Base(), nodes.Count() * sizeof( KVFlatNode_t ) );
+	buffer.Put( index.Base(), index.Count() * sizeof( uint32 ) );
+	while ( (uint32)( buffer.TellPut() - nStart ) < header.m_nBlobOffset )
+		buffer.PutUnsignedChar( 0 );
+	buffer.Put( blob.m_Data.Base(), blob.m_Data.Count() );
+
+	return buffer.IsValid();
+}
+
+// builds the KeyValues of a view and its peers, returns false if nested too deep
+static bool ReadFlatKeys( KeyValues *pNode, CKeyValuesView view, int nStackDepth )
+{
+	if ( nStackDepth > 100 )
+	{
+		AssertMsgOnce( false, "KVPacker::ReadAsFlat() stack depth > 100\n" );
+		return false;
+	}
+
+	KeyValues *dat = pNode;
+	for ( ; view.IsValid(); view = view.GetNextKey() )
+	{
+		dat->SetName( view.GetName() );
+
+		switch ( view.GetDataType() )
+		{
+		case KeyValues::TYPE_NONE:
+			{
+				CKeyValuesView sub = view.GetFirstSubKey();
+				if ( sub.IsValid() )
+				{
+					KeyValues *pNewNode = new KeyValues( "" );
+					dat->AddSubKey( pNewNode );
+					if ( !ReadFlatKeys( pNewNode, sub, nStackDepth + 1 ) )
+						return false;
+				}
+				break;
+			}
+		case KeyValues::TYPE_STRING:
+			dat->SetStringValue( view.GetString() );
+			break;
+		case KeyValues::TYPE_WSTRING:
+			{
+				const char *pString = view.GetString();
+				int nLength = Q_strlen( pString ) + 1;
+				wchar_t *pTemp = (wchar_t *)malloc( sizeof( wchar_t ) * nLength );
+				Q_UTF8ToUnicode( pString, pTemp, sizeof( wchar_t ) * nLength );
+				dat->SetWString( NULL, pTemp );
+				free( pTemp );
+				break;
+			}
+		case KeyValues::TYPE_INT:
+			dat->SetInt( NULL, view.GetInt() );
+			break;
+		case KeyValues::TYPE_UINT64:
+			dat->SetUint64( NULL, view.GetUint64() );
+			break;
+		case KeyValues::TYPE_FLOAT:
+			dat->SetFloat( NULL, view.GetFloat() );
+			break;
+		case KeyValues::TYPE_COLOR:
+			dat->SetColor( NULL, view.GetColor() );
+			break;
+		default:
+			break;
+		}
+
+		if ( !view.GetNextKey().IsValid() )
+			break;
+
+		// new peer follows
+		KeyValues *pNewPeer = new KeyValues( "" );
+		dat->SetNextKey( pNewPeer );
+		dat = pNewPeer;
+	}
+	return true;
+}
+
+// read KeyValues from a flat file, returns true if it was well-formed
+bool KVPacker::ReadAsFlat( KeyValues *pNode, const void *pData, int nSize )
+{
+	CKeyValuesView view = CKeyValuesView::FromBuffer( pData, nSize );
+	if ( !view.IsValid() )
+		return false;
+
+	pNode->Clear();
+	return ReadFlatKeys( pNode, view, 0 );
+}
+
+
+//-----------------------------------------------------------------------------
+// Purpose: Validates everything up front, so that accessors can trust offsets
+//-----------------------------------------------------------------------------
+CKeyValuesView CKeyValuesView::FromBuffer( const void *pData, int nSize )
+{
+	const KVFlatHeader_t *pHeader = (const KVFlatHeader_t *)pData;
+	if ( !pData || nSize < (int)sizeof( KVFlatHeader_t ) || ( (uintp)pData & 3 ) )
+		return {};
+
+	if ( pHeader->m_nMagic != KVFLAT_MAGIC || pHeader->m_nVersion != KVFLAT_VERSION || pHeader->m_nSize > (uint32)nSize )
+		return {};
+
+	// sections must be in order, and within the buffer
+	uint64 nNodesEnd = pHeader->m_nNodesOffset + (uint64)pHeader->m_nNodeCount * sizeof( KVFlatNode_t );
+	uint64 nIndexEnd = pHeader->m_nIndexOffset + (uint64)pHeader->m_nIndexCount * sizeof( uint32 );
+	if ( pHeader->m_nNodesOffset < sizeof( KVFlatHeader_t ) || ( pHeader->m_nNodesOffset & 3 ) || ( pHeader->m_nIndexOffset & 3 ) ||
+		nNodesEnd > pHeader->m_nIndexOffset || nIndexEnd > pHeader->m_nBlobOffset ||
+		(uint64)pHeader->m_nBlobOffset + pHeader->m_nBlobSize > pHeader->m_nSize )
+		return {};
+
+	// the blob ends with a terminator, so every offset in it is a valid string
+	const char *pBlob = (const char *)pData + pHeader->m_nBlobOffset;
+	if ( pHeader->m_nNodeCount == 0 || pHeader->m_nBlobSize == 0 || pBlob[ pHeader->m_nBlobSize - 1 ] != 0 )
+		return {};
+
+	const KVFlatNode_t *pNodes = (const KVFlatNode_t *)( (const byte *)pData + pHeader->m_nNodesOffset );
+	const uint32 *pIndex = (const uint32 *)( (const byte *)pData + pHeader->m_nIndexOffset );
+	for ( uint32 i = 0; i < pHeader->m_nNodeCount; i++ )
+	{
+		const KVFlatNode_t &node = pNodes[ i ];
+		if ( node.m_nName >= pHeader->m_nBlobSize )
+			return {};
+
+		switch ( node.m_nType )
+		{
+		case KeyValues::TYPE_NONE:
+			{
+				if ( node.m_nString >= pHeader->m_nIndexCount )
+					return {};
+
+				// children come after their parent, and their sorted indices must stay within them
+				uint32 nCount = pIndex[ node.m_nString ];
+				if ( (uint64)node.m_nString + 1 + nCount > pHeader->m_nIndexCount )
+					return {};
+				if ( nCount && ( node.m_nValue <= i || (uint64)node.m_nValue + nCount > pHeader->m_nNodeCount ||
+					!( pNodes[ node.m_nValue + nCount - 1 ].m_nFlags & KVFLAT_NODE_LAST_CHILD ) ) )
+					return {};
+				for ( uint32 j = 1; j <= nCount; j++ )
+				{
+					uint32 nChild = pIndex[ node.m_nString + j ];
+					if ( nChild < node.m_nValue || nChild >= node.m_nValue + nCount )
+						return {};
+				}
+				break;
+			}
+		case KeyValues::TYPE_UINT64:
+			if ( (uint64)node.m_nValue + sizeof( uint64 ) > pHeader->m_nBlobSize )
+				return {};
+			[[fallthrough]];
+		case KeyValues::TYPE_STRING:
+		case KeyValues::TYPE_WSTRING:
+		case KeyValues::TYPE_INT:
+		case KeyValues::TYPE_FLOAT:
+		case KeyValues::TYPE_COLOR:
+			if ( node.m_nString >= pHeader->m_nBlobSize )
+				return {};
+			break;
+		default:
+			return {};
+		}
+	}
+
+	// the root has to be a key list, and the top level keys are its children
+	if ( pNodes[ 0 ].m_nType != KeyValues::TYPE_NONE || pIndex[ pNodes[ 0 ].m_nString ] == 0 )
+		return {};
+
+	return CKeyValuesView( pHeader, pNodes[ 0 ].m_nValue );
+}
+
+const KVFlatNode_t &CKeyValuesView::Node( uint32 nNode ) const
+{
+	return ( (const KVFlatNode_t *)( (const byte *)m_pHeader + m_pHeader->m_nNodesOffset ) )[ nNode ];
+}
+
+const char *CKeyValuesView::String( uint32 nOffset ) const
+{
+	return (const char *)m_pHeader + m_pHeader->m_nBlobOffset + nOffset;
+}
+
+const uint32 *CKeyValuesView::Index( uint32 nOffset ) const
+{
+	return (const uint32 *)( (const byte *)m_pHeader + m_pHeader->m_nIndexOffset ) + nOffset;
+}
+
+const char *CKeyValuesView::GetName() const
+{
+	return IsValid() ? String( Node( m_nNode ).m_nName ) : "";
+}
+
+KeyValues::types_t CKeyValuesView::GetDataType() const
+{
+	return IsValid() ? (KeyValues::types_t)Node( m_nNode ).m_nType : KeyValues::TYPE_NONE;
+}
+
+CKeyValuesView CKeyValuesView::GetFirstSubKey() const
+{
+	if ( !IsValid() || Node( m_nNode ).m_nType != KeyValues::TYPE_NONE || GetSubKeyCount() == 0 )
+		return {};
+
+	return CKeyValuesView( m_pHeader, Node( m_nNode ).m_nValue );
+}
+
+CKeyValuesView CKeyValuesView::GetNextKey() const
+{
+	if ( !IsValid() || ( Node( m_nNode ).m_nFlags & KVFLAT_NODE_LAST_CHILD ) )
+		return {};
+
+	return CKeyValuesView( m_pHeader, m_nNode + 1 );
+}
+
+int CKeyValuesView::GetSubKeyCount() const
+{
+	if ( !IsValid() || Node( m_nNode ).m_nType != KeyValues::TYPE_NONE )
+		return 0;
+
+	return *Index( Node( m_nNode ).m_nString );
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: Binary search of the sorted children
+//-----------------------------------------------------------------------------
+CKeyValuesView CKeyValuesView::FindSubKey( const char *pName, int nLength ) const
+{
+	int nCount = GetSubKeyCount();
+	if ( nCount == 0 )
+		return {};
+
+	const uint32 *pSorted = Index( Node( m_nNode ).m_nString ) + 1;
+	int nLow = 0;
+	int nHigh = nCount;
+	// lower bound, so that the first of equally named keys is found
+	while ( nLow < nHigh )
+	{
+		int nMid = ( nLow + nHigh ) / 2;
+		const char *pMidName = String( Node( pSorted[ nMid ] ).m_nName );
+		int nCmp = Q_strnicmp( pMidName, pName, nLength );
+		if ( nCmp == 0 && pMidName[ nLength ] != 0 )
+			nCmp = 1;	// longer, so it sorts after
+
+		if ( nCmp < 0 )
+			nLow = nMid + 1;
+		else
+			nHigh = nMid;
+	}
+
+	if ( nLow == nCount )
+		return {};
+
+	const char *pFound = String( Node( pSorted[ nLow ] ).m_nName );
+	if ( Q_strnicmp( pFound, pName, nLength ) != 0 || pFound[ nLength ] != 0 )
+		return {};
+
+	return CKeyValuesView( m_pHeader, pSorted[ nLow ] );
+}
+
+CKeyValuesView CKeyValuesView::FindKey( const char *keyName ) const
+{
+	CKeyValuesView view = *this;
+	if ( !keyName )
+		return view;
+
+	// look for '/' characters deliminating sub fields
+	while ( view.IsValid() && *keyName )
+	{
+		const char *subStr = strchr( keyName, '/' );
+		int nLength = subStr ? subStr - keyName : Q_strlen( keyName );
+		view = view.FindSubKey( keyName, nLength );
+		keyName += subStr ? nLength + 1 : nLength;
+	}
+	return view;
+}
+
+int CKeyValuesView::GetInt( const char *keyName, int defaultValue ) const
+{
+	CKeyValuesView dat = FindKey( keyName );
+	if ( !dat.IsValid() )
+		return defaultValue;
+
+	const KVFlatNode_t &node = dat.Node( dat.m_nNode );
+	switch ( node.m_nType )
+	{
+	case KeyValues::TYPE_STRING:
+	case KeyValues::TYPE_WSTRING:
+		return atoi( dat.String( node.m_nString ) );
+	case KeyValues::TYPE_FLOAT:
+		return (int)dat.GetFloat();
+	case KeyValues::TYPE_UINT64:
+		// can't convert, since it would lose data
+		Assert( 0 );
+		return 0;
+	case KeyValues::TYPE_INT:
+	case KeyValues::TYPE_COLOR:
+		return (int)node.m_nValue;
+	default:
+		return 0;
+	}
+}
+
+uint64 CKeyValuesView::GetUint64( const char *keyName, uint64 defaultValue ) const
+{
+	CKeyValuesView dat = FindKey( keyName );
+	if ( !dat.IsValid() )
+		return defaultValue;
+
+	const KVFlatNode_t &node = dat.Node( dat.m_nNode );
+	switch ( node.m_nType )
+	{
+	case KeyValues::TYPE_STRING:
+	case KeyValues::TYPE_WSTRING:
+		return (uint64)Q_atoi64( dat.String( node.m_nString ) );
+	case KeyValues::TYPE_FLOAT:
+		return (int)dat.GetFloat();
+	case KeyValues::TYPE_UINT64:
+		{
+			// the buffer may only be 4-byte aligned
+			uint64 value;
+			Q_memcpy( &value, dat.String( node.m_nValue ), sizeof( value ) );
+			return value;
+		}
+	case KeyValues::TYPE_INT:
+	case KeyValues::TYPE_COLOR:
+		return (int)node.m_nValue;
+	default:
+		return 0;
+	}
+}
+
+float CKeyValuesView::GetFloat( const char *keyName, float defaultValue ) const
+{
+	CKeyValuesView dat = FindKey( keyName );
+	if ( !dat.IsValid() )
+		return defaultValue;
+
+	const KVFlatNode_t &node = dat.Node( dat.m_nNode );
+	switch ( node.m_nType )
+	{
+	case KeyValues::TYPE_STRING:
+	case KeyValues::TYPE_WSTRING:
+		return (float)atof( dat.String( node.m_nString ) );
+	case KeyValues::TYPE_FLOAT:
+		{
+			float flValue;
+			Q_memcpy( &flValue, &node.m_nValue, sizeof( flValue ) );
+			return flValue;
+		}
+	case KeyValues::TYPE_INT:
+		return (float)(int)node.m_nValue;
+	case KeyValues::TYPE_UINT64:
+		return (float)dat.GetUint64();
+	default:
+		return 0.0f;
+	}
+}
+
+const char *CKeyValuesView::GetString( const char *keyName, const char *defaultValue ) const
+{
+	CKeyValuesView dat = FindKey( keyName );
+	if ( !dat.IsValid() )
+		return defaultValue;
+
+	// numbers have their text form stored next to them
+	const KVFlatNode_t &node = dat.Node( dat.m_nNode );
+	if ( node.m_nType == KeyValues::TYPE_NONE || node.m_nType == KeyValues::TYPE_COLOR )
+		return defaultValue;
+
+	return dat.String( node.m_nString );
+}
+
+Color CKeyValuesView::GetColor( const char *keyName ) const
+{
+	Color color( 0, 0, 0, 0 );
+	CKeyValuesView dat = FindKey( keyName );
+	if ( !dat.IsValid() )
+		return color;
+
+	const KVFlatNode_t &node = dat.Node( dat.m_nNode );
+	switch ( node.m_nType )
+	{
+	case KeyValues::TYPE_COLOR:
+		{
+			uint8 rgba[4];
+			Q_memcpy( rgba, &node.m_nValue, sizeof( rgba ) );
+			color.SetColor( rgba[0], rgba[1], rgba[2], rgba[3] );
+			break;
+		}
+	case KeyValues::TYPE_FLOAT:
+	case KeyValues::TYPE_INT:
+		color[0] = dat.GetInt();
+		break;
+	case KeyValues::TYPE_STRING:
+		{
+			// parse the colors out of the string
+			float a = 0.0f, b = 0.0f, c = 0.0f, d = 0.0f;
+			sscanf( dat.String( node.m_nString ), "%f %f %f %f", &a, &b, &c, &d );
+			color.SetColor( (unsigned char)a, (unsigned char)b, (unsigned char)c, (unsigned char)d );
+			break;
+		}
+	default:
+		break;
+	}
+	return color;
+}
+
+bool CKeyValuesView::IsEmpty( const char *keyName ) const
+{
+	CKeyValuesView dat = FindKey( keyName );
+	if ( !dat.IsValid() )
+		return true;
+
+	return dat.GetDataType() == KeyValues::TYPE_NONE && dat.GetSubKeyCount() == 0;
+}
@@ -13,6 +13,8 @@
 #include "tier0/platform.h"
 #include "tier0/basetypes.h"
 #include "tier0/dbg.h"
+#include "tier1/scratcharena.h"
+#include "vstdlib/jobthread.h"
 
 #include "../utils/lzma/C/7zTypes.h"
 #include "../utils/lzma/C/LzmaEnc.h"
@@ -30,6 +32,41 @@ static void *SzAlloc(void *p, size_t size) { return malloc(size); }
 static void SzFree(void *p, void *address) { free(address); }
 static ISzAlloc g_Alloc = { SzAlloc, SzFree };
 
+// Probabilities of streams with lc + lp <= 4, which covers what LZMA_Compress produces
+#define LZMA_ARENA_PROBS	( 1846 + ( 0x300 << 4 ) )
+
+struct CLZMADecoder::DecoderState_t
+{
+	// must be first, the allocator callbacks get a pointer to it
+	ISzAlloc	m_Alloc;
+	CLzmaDec	m_Decoder;
+	bool		m_bArenaInUse;
+	CLzmaProb	m_Arena[ LZMA_ARENA_PROBS ];
+};
+
+// Hands out the arena when it's free and big enough, the heap otherwise
+void *CLZMADecoder::ArenaAlloc( void *p, size_t size )
+{
+	DecoderState_t *pState = (DecoderState_t *)p;
+	if ( !pState->m_bArenaInUse && size <= sizeof( pState->m_Arena ) )
+	{
+		pState->m_bArenaInUse = true;
+		return pState->m_Arena;
+	}
+	return malloc( size );
+}
+
+void CLZMADecoder::ArenaFree( void *p, void *address )
+{
+	DecoderState_t *pState = (DecoderState_t *)p;
+	if ( address == pState->m_Arena )
+	{
+		pState->m_bArenaInUse = false;
+		return;
+	}
+	free( address );
+}
+
 //-----------------------------------------------------------------------------
 // Returns true if buffer is compressed.
 //-----------------------------------------------------------------------------
@@ -37,7 +74,7 @@ static ISzAlloc g_Alloc = { SzAlloc, SzFree };
 bool CLZMA::IsCompressed( unsigned char *pInput )
 {
 	LzmaHeader*pHeader = (LzmaHeader*)pInput;
-	if ( pHeader && pHeader->id == LZMA_ID )
+	if ( pHeader && ( pHeader->id == LZMA_ID || pHeader->id == LZMA_BLOCKS_ID ) )
 	{
 		return true;
 	}
@@ -46,6 +83,16 @@ bool CLZMA::IsCompressed( unsigned char *pInput )
 	return false;
 }
 
+//-----------------------------------------------------------------------------
+// Returns true if buffer is a container of independently compressed blocks.
+//-----------------------------------------------------------------------------
+/* static */
+bool CLZMA::IsBlockCompressed( unsigned char *pInput )
+{
+	LzmaBlocksHeader *pHeader = (LzmaBlocksHeader*)pInput;
+	return pHeader && pHeader->id == LZMA_BLOCKS_ID;
+}
+
 //-----------------------------------------------------------------------------
 // Returns uncompressed size of compressed input buffer. Used for allocating output
 // buffer for decompression. Returns 0 if input buffer is not compressed.
@@ -58,11 +105,104 @@ unsigned int CLZMA::GetActualSize( unsigned char *pInput )
 	{
 		return LittleLong( pHeader->actualSize );
 	}
+	if ( pHeader && pHeader->id == LZMA_BLOCKS_ID )
+	{
+		return LittleLong( ((LzmaBlocksHeader*)pInput)->actualSize );
+	}
 
 	// unrecognized
 	return 0;
 }
 
+//-----------------------------------------------------------------------------
+// A block of a container, decoded by one of the pool's threads
+//-----------------------------------------------------------------------------
+struct LzmaBlockJob_t
+{
+	unsigned char	*m_pInput;
+	unsigned int	m_nInputSize;
+	unsigned char	*m_pOutput;
+	unsigned int	m_nOutputSize;
+	bool			m_bOK;
+};
+
+static void DecodeLzmaBlock( LzmaBlockJob_t &job )
+{
+	if ( job.m_nInputSize == job.m_nOutputSize )
+	{
+		// didn't compress, stored as is
+		memcpy( job.m_pOutput, job.m_pInput, job.m_nOutputSize );
+		job.m_bOK = true;
+		return;
+	}
+
+	LzmaHeader *pHeader = (LzmaHeader*)job.m_pInput;
+	job.m_bOK = job.m_nInputSize > sizeof( LzmaHeader ) &&
+	            pHeader->id == LZMA_ID &&
+	            LittleLong( pHeader->actualSize ) == job.m_nOutputSize &&
+	            LittleLong( pHeader->lzmaSize ) <= job.m_nInputSize - sizeof( LzmaHeader ) &&
+	            CLZMADecoder::ThreadDecoder().Decode( pHeader->properties, job.m_pInput + sizeof( LzmaHeader ), LittleLong( pHeader->lzmaSize ), job.m_pOutput, job.m_nOutputSize );
+}
+
+static unsigned int UncompressBlocks( unsigned char *pInput, unsigned char *pOutput )
+{
+	LzmaBlocksHeader *pHeader = (LzmaBlocksHeader*)pInput;
+	unsigned int nActualSize = LittleLong( pHeader->actualSize );
+	unsigned int nBlockSize = LittleLong( pHeader->blockSize );
+	unsigned int nBlockCount = LittleLong( pHeader->blockCount );
+
+	// every block but the last is full
+	if ( nBlockCount == 0 || nBlockSize == 0 ||
+	     (uint64)nBlockSize * ( nBlockCount - 1 ) >= nActualSize || (uint64)nBlockSize * nBlockCount < nActualSize )
+	{
+		Warning( "LZMA Decompression failed (bad block container)\n" );
+		return 0;
+	}
+
+	const unsigned int *pOffsets = (const unsigned int *)( pHeader + 1 );
+	unsigned int nDataStart = sizeof( LzmaBlocksHeader ) + ( nBlockCount + 1 ) * sizeof( unsigned int );
+
+	CScratchMark mark;
+	CUtlVectorScratch<LzmaBlockJob_t> jobs( nBlockCount );
+	for ( unsigned int i = 0; i < nBlockCount; i++ )
+	{
+		unsigned int nStart = LittleLong( pOffsets[ i ] );
+		unsigned int nEnd = LittleLong( pOffsets[ i + 1 ] );
+		if ( nStart < nDataStart || nEnd <= nStart )
+		{
+			Warning( "LZMA Decompression failed (bad block offsets)\n" );
+			return 0;
+		}
+
+		LzmaBlockJob_t &job = jobs[ jobs.AddToTail() ];
+		job.m_pInput = pInput + nStart;
+		job.m_nInputSize = nEnd - nStart;
+		job.m_pOutput = pOutput + i * nBlockSize;
+		job.m_nOutputSize = Min( nBlockSize, nActualSize - i * nBlockSize );
+		job.m_bOK = false;
+	}
+
+	if ( jobs.Count() == 1 )
+	{
+		DecodeLzmaBlock( jobs[ 0 ] );
+	}
+	else
+	{
+		ParallelProcess( "CLZMA::Uncompress", jobs.Base(), jobs.Count(), &DecodeLzmaBlock );
+	}
+
+	for ( int i = 0; i < jobs.Count(); i++ )
+	{
+		if ( !jobs[ i ].m_bOK )
+		{
+			Warning( "LZMA Decompression failed (block %i)\n", i );
+			return 0;
+		}
+	}
+
+	return nActualSize;
+}
+
 //-----------------------------------------------------------------------------
 // Uncompress a buffer, Returns the uncompressed size. Caller must provide an
 // adequate sized output buffer or memory corruption will occur.
@@ -71,39 +211,93 @@ unsigned int CLZMA::GetActualSize( unsigned char *pInput )
 unsigned int CLZMA::Uncompress( unsigned char *pInput, unsigned char *pOutput )
 {
 	LzmaHeader*pHeader = (LzmaHeader*)pInput;
+	if ( pHeader->id == LZMA_BLOCKS_ID )
+	{
+		return UncompressBlocks( pInput, pOutput );
+	}
 	if ( pHeader->id != LZMA_ID )
 	{
 		// not ours
 		return false;
 	}
 
-	CLzmaDec state;
+	return CLZMADecoder::ThreadDecoder().Uncompress( pInput, pOutput );
+}
+
+CLZMADecoder::CLZMADecoder()
+{
+	m_pState = new DecoderState_t;
+	m_pState->m_Alloc.Alloc = ArenaAlloc;
+	m_pState->m_Alloc.Free = ArenaFree;
+	m_pState->m_bArenaInUse = false;
+	LzmaDec_Construct( &m_pState->m_Decoder );
+}
+
+CLZMADecoder::~CLZMADecoder()
+{
+	LzmaDec_FreeProbs( &m_pState->m_Decoder, &m_pState->m_Alloc );
+	delete m_pState;
+}
+
+/* static */
+CLZMADecoder &CLZMADecoder::ThreadDecoder()
+{
+	static thread_local CLZMADecoder s_Decoder;
+	return s_Decoder;
+}
 
-	LzmaDec_Construct(&state);
+unsigned int CLZMADecoder::Uncompress( unsigned char *pInput, unsigned char *pOutput )
+{
+	LzmaHeader *pHeader = (LzmaHeader*)pInput;
+	if ( pHeader->id != LZMA_ID )
+	{
+		// not ours
+		return 0;
+	}
 
-	if ( LzmaDec_Allocate(&state, pHeader->properties, LZMA_PROPS_SIZE, &g_Alloc) != SZ_OK )
+	unsigned int nActualSize = LittleLong( pHeader->actualSize );
+	if ( !Decode( pHeader->properties, pInput + sizeof( LzmaHeader ), LittleLong( pHeader->lzmaSize ), pOutput, nActualSize ) )
 	{
-		Assert( false );
 		return 0;
 	}
 
-	// These are in/out variables
-	SizeT outProcessed = pHeader->actualSize;
-	SizeT inProcessed = pHeader->lzmaSize;
-	ELzmaStatus status;
-	SRes result = LzmaDecode( (Byte *)pOutput, &outProcessed, (Byte *)(pInput + sizeof( LzmaHeader ) ),
-	                          &inProcessed, (Byte *)pHeader->properties, LZMA_PROPS_SIZE, LZMA_FINISH_END, &status, &g_Alloc );
+	return nActualSize;
+}
 
+bool CLZMADecoder::Decode( const unsigned char *pProperties, const unsigned char *pInput, unsigned int nInputSize,
+                           unsigned char *pOutput, unsigned int nOutputSize )
+{
+	CLzmaDec &decoder = m_pState->m_Decoder;
 
-	LzmaDec_Free(&state, &g_Alloc);
+	// keeps the probabilities of the last stream if they're the same size
+	if ( LzmaDec_AllocateProbs( &decoder, pProperties, LZMA_PROPS_SIZE, &m_pState->m_Alloc ) != SZ_OK )
+	{
+		Assert( false );
+		return false;
+	}
+
+	// decode straight into the output, it's big enough to be the whole dictionary
+	decoder.dic = pOutput;
+	decoder.dicBufSize = nOutputSize;
+	LzmaDec_Init( &decoder );
+
+	SizeT inProcessed = nInputSize;
+	ELzmaStatus status;
+	SRes result = LzmaDec_DecodeToDic( &decoder, nOutputSize, pInput, &inProcessed, LZMA_FINISH_END, &status );
+	SizeT outProcessed = decoder.dicPos;
+	decoder.dic = NULL;
 
-	if ( result != SZ_OK || pHeader->actualSize != outProcessed )
+	if ( result == SZ_OK && status == LZMA_STATUS_NEEDS_MORE_INPUT )
+	{
+		result = SZ_ERROR_INPUT_EOF;
+	}
+	if ( result != SZ_OK || outProcessed != nOutputSize )
 	{
 		Warning( "LZMA Decompression failed (%i)\n", result );
-		return 0;
+		return false;
 	}
 
-	return outProcessed;
+	return true;
 }
 
 CLZMAStream::CLZMAStream()
@@ -4,6 +4,14 @@
 //
 //===========================================================================//
 
+#if defined( PLATFORM_WINDOWS )
+	#define WIN32_LEAN_AND_MEAN
+	#include <windows.h>
+#elif defined( PLATFORM_LINUX )
+	#include <unistd.h>
+	#include <sys/syscall.h>
+#endif
+
 #include "mempool.h"
 #include <stdio.h>
 #include <malloc.h>
@@ -303,3 +311,438 @@ void CUtlMemoryPool::Free( void *memBlock )
 }
 
 
+//-----------------------------------------------------------------------------
+// CMemoryPoolMagazineMT
+//-----------------------------------------------------------------------------
+
+// Guards the pools' thread cache lists; thread exits and pool destruction meet here
+static CThreadFastMutex &MagazineRegistryMutex()
+{
+	static CThreadFastMutex s_Mutex;
+	return s_Mutex;
+}
+
+// slots of destroyed pools are handed out again, guarded by the registry mutex
+int CMemoryPoolMagazineMT::s_FreeSlots[ CMemoryPoolMagazineMT::MAX_POOLS ];
+int CMemoryPoolMagazineMT::s_nFreeSlots = 0;
+int CMemoryPoolMagazineMT::s_nNextSlot = 0;
+
+static int GetCurrentNumaNode()
+{
+#if defined( PLATFORM_WINDOWS )
+	PROCESSOR_NUMBER processor;
+	GetCurrentProcessorNumberEx( &processor );
+	USHORT node;
+	if ( GetNumaProcessorNodeEx( &processor, &node ) )
+		return node;
+#elif defined( PLATFORM_LINUX )
+	unsigned cpu, node;
+	if ( syscall( SYS_getcpu, &cpu, &node, NULL ) == 0 )
+		return node;
+#endif
+	return 0;
+}
+
+// the owner is the only writer, no need for a locked add
+static inline void BumpCounter( std::atomic<uint32> &counter )
+{
+	counter.store( counter.load( std::memory_order_relaxed ) + 1, std::memory_order_relaxed );
+}
+
+CMemoryPoolMagazineMT::CMemoryPoolMagazineMT( int blockSize, int numElements, int growMode, const char *pszAllocOwner, int nAlignment )
+	: CUtlMemoryPool( blockSize, numElements, growMode, pszAllocOwner, nAlignment )
+{
+	{
+		AUTO_LOCK_FM( MagazineRegistryMutex() );
+		if ( s_nFreeSlots > 0 )
+			m_nSlot = s_FreeSlots[ --s_nFreeSlots ];
+		else if ( s_nNextSlot < MAX_POOLS )
+			m_nSlot = s_nNextSlot++;
+		else
+			m_nSlot = -1;
+	}
+	if ( m_nSlot < 0 )
+	{
+		ExecuteOnce( Warning( "CMemoryPoolMagazineMT: more than %d live pools, '%s' will use a mutex\n", MAX_POOLS, m_pszAllocOwner ) );
+	}
+	m_nEpoch = 0;
+	for ( Depot_t &depot : m_Depots )
+	{
+		depot.m_pFull = depot.m_pEmpty = NULL;
+		depot.m_nFull = 0;
+	}
+	m_pThreadCaches = NULL;
+	m_nRetiredAllocs = m_nRetiredFrees = 0;
+	m_nDepotExchanges = m_nRefills = 0;
+	m_nRetiredThreads = 0;
+}
+
+CMemoryPoolMagazineMT::~CMemoryPoolMagazineMT()
+{
+	// hand every cached block back, so only real leaks get reported
+	AUTO_LOCK_FM( MagazineRegistryMutex() );
+	for ( ThreadCache_t *pCache = m_pThreadCaches; pCache; pCache = pCache->m_pNext )
+	{
+		DrainThreadCache( pCache );
+		pCache->m_pPool = NULL;
+	}
+	m_pThreadCaches = NULL;
+	DrainDepots();
+
+	// the threads find their cache for this slot orphaned, and drop it for the next pool's
+	if ( m_nSlot >= 0 )
+		s_FreeSlots[ s_nFreeSlots++ ] = m_nSlot;
+
+	for ( Depot_t &depot : m_Depots )
+	{
+		while ( depot.m_pEmpty )
+		{
+			Magazine_t *pNext = depot.m_pEmpty->m_pNext;
+			free( depot.m_pEmpty );
+			depot.m_pEmpty = pNext;
+		}
+	}
+}
+
+CMemoryPoolMagazineMT::Magazine_t *CMemoryPoolMagazineMT::NewMagazine()
+{
+	Magazine_t *pMagazine = (Magazine_t *)malloc( sizeof( Magazine_t ) );
+	pMagazine->m_pNext = NULL;
+	pMagazine->m_nCount = 0;
+	return pMagazine;
+}
+
+CMemoryPoolMagazineMT::ThreadCache_t *CMemoryPoolMagazineMT::GetThreadCache()
+{
+	struct ThreadCaches_t
+	{
+		// don't strand our blocks when the thread exits
+		~ThreadCaches_t()
+		{
+			for ( ThreadCache_t *pCache : m_pCaches )
+			{
+				if ( pCache )
+					ReleaseThreadCache( pCache );
+			}
+		}
+		ThreadCache_t *m_pCaches[ MAX_POOLS ] = {};
+	};
+	static thread_local ThreadCaches_t s_Caches;
+
+	if ( m_nSlot < 0 )
+		return NULL;
+
+	ThreadCache_t *pCache = s_Caches.m_pCaches[ m_nSlot ];
+	if ( pCache && pCache->m_pPool != this )
+	{
+		// left over from a destroyed pool which had our slot
+		ReleaseThreadCache( pCache );
+		pCache = NULL;
+	}
+	if ( !pCache )
+	{
+		pCache = CreateThreadCache();
+		s_Caches.m_pCaches[ m_nSlot ] = pCache;
+	}
+	else if ( pCache->m_nEpoch != m_nEpoch.load( std::memory_order_relaxed ) )
+	{
+		// the pool was cleared, what we have points into freed blobs
+		pCache->m_pLoaded->m_nCount = pCache->m_pPrevious->m_nCount = 0;
+		pCache->m_nEpoch = m_nEpoch.load( std::memory_order_relaxed );
+	}
+	return pCache;
+}
+
+CMemoryPoolMagazineMT::ThreadCache_t *CMemoryPoolMagazineMT::CreateThreadCache()
+{
+	ThreadCache_t *pCache = new ThreadCache_t;
+	pCache->m_pPool = this;
+	pCache->m_pLoaded = NewMagazine();
+	pCache->m_pPrevious = NewMagazine();
+	pCache->m_nNode = GetCurrentNumaNode() % MAX_NUMA_NODES;
+	pCache->m_nEpoch = m_nEpoch.load( std::memory_order_relaxed );
+	pCache->m_nAllocs = pCache->m_nFrees = 0;
+
+	AUTO_LOCK_FM( MagazineRegistryMutex() );
+	pCache->m_pNext = m_pThreadCaches;
+	m_pThreadCaches = pCache;
+	return pCache;
+}
+
+void CMemoryPoolMagazineMT::ReleaseThreadCache( ThreadCache_t *pCache )
+{
+	{
+		AUTO_LOCK_FM( MagazineRegistryMutex() );
+		CMemoryPoolMagazineMT *pPool = pCache->m_pPool;
+		if ( pPool )
+		{
+			pPool->DrainThreadCache( pCache );
+			pPool->m_nRetiredAllocs += pCache->m_nAllocs.load( std::memory_order_relaxed );
+			pPool->m_nRetiredFrees += pCache->m_nFrees.load( std::memory_order_relaxed );
+			pPool->m_nRetiredThreads++;
+
+			ThreadCache_t **ppLink = &pPool->m_pThreadCaches;
+			while ( *ppLink != pCache )
+				ppLink = &( *ppLink )->m_pNext;
+			*ppLink = pCache->m_pNext;
+		}
+	}
+
+	free( pCache->m_pLoaded );
+	free( pCache->m_pPrevious );
+	delete pCache;
+}
+
+void CMemoryPoolMagazineMT::DrainThreadCache( ThreadCache_t *pCache )
+{
+	if ( pCache->m_nEpoch == m_nEpoch.load( std::memory_order_relaxed ) )
+	{
+		FreeToBlobs( pCache->m_pLoaded );
+		FreeToBlobs( pCache->m_pPrevious );
+	}
+	pCache->m_pLoaded->m_nCount = pCache->m_pPrevious->m_nCount = 0;
+}
+
+void CMemoryPoolMagazineMT::DrainDepots()
+{
+	for ( Depot_t &depot : m_Depots )
+	{
+		AUTO_LOCK_FM( depot.m_Mutex );
+		while ( depot.m_pFull )
+		{
+			Magazine_t *pMagazine = depot.m_pFull;
+			depot.m_pFull = pMagazine->m_pNext;
+			FreeToBlobs( pMagazine );
+			pMagazine->m_pNext = depot.m_pEmpty;
+			depot.m_pEmpty = pMagazine;
+		}
+		depot.m_nFull = 0;
+	}
+}
+
+void CMemoryPoolMagazineMT::FreeToBlobs( Magazine_t *pMagazine )
+{
+	AUTO_LOCK_FM( m_BlobMutex );
+	for ( int i = 0; i < pMagazine->m_nCount; i++ )
+	{
+		CUtlMemoryPool::Free( pMagazine->m_pBlocks[i] );
+	}
+	pMagazine->m_nCount = 0;
+}
+
+// Both magazines are empty: trade one for a full magazine from the depot, or fill it from the blobs
+bool CMemoryPoolMagazineMT::Reload( ThreadCache_t *pCache )
+{
+	Depot_t &depot = m_Depots[ pCache->m_nNode ];
+	depot.m_Mutex.Lock();
+	if ( depot.m_pFull )
+	{
+		Magazine_t *pFull = depot.m_pFull;
+		depot.m_pFull = pFull->m_pNext;
+		depot.m_nFull--;
+		pCache->m_pPrevious->m_pNext = depot.m_pEmpty;
+		depot.m_pEmpty = pCache->m_pPrevious;
+		depot.m_Mutex.Unlock();
+
+		pCache->m_pPrevious = pCache->m_pLoaded;
+		pCache->m_pLoaded = pFull;
+		m_nDepotExchanges.fetch_add( 1, std::memory_order_relaxed );
+		return true;
+	}
+	depot.m_Mutex.Unlock();
+
+	Magazine_t *pLoaded = pCache->m_pLoaded;
+	{
+		AUTO_LOCK_FM( m_BlobMutex );
+		while ( pLoaded->m_nCount < MAGAZINE_SIZE )
+		{
+			void *pBlock = CUtlMemoryPool::Alloc( m_BlockSize );
+			if ( !pBlock )
+				break;
+			pLoaded->m_pBlocks[ pLoaded->m_nCount++ ] = pBlock;
+		}
+	}
+	m_nRefills.fetch_add( 1, std::memory_order_relaxed );
+	return pLoaded->m_nCount != 0;
+}
+
+// Both magazines are full: the spare goes to the depot, and an empty one takes its place
+void CMemoryPoolMagazineMT::Unload( ThreadCache_t *pCache )
+{
+	Depot_t &depot = m_Depots[ pCache->m_nNode ];
+	depot.m_Mutex.Lock();
+	if ( depot.m_nFull >= MAX_DEPOT_MAGAZINES )
+	{
+		// the depot has plenty already, the blobs take the spare's blocks
+		depot.m_Mutex.Unlock();
+		Magazine_t *pSpare = pCache->m_pPrevious;
+		FreeToBlobs( pSpare );
+		pCache->m_pPrevious = pCache->m_pLoaded;
+		pCache->m_pLoaded = pSpare;
+		return;
+	}
+	pCache->m_pPrevious->m_pNext = depot.m_pFull;
+	depot.m_pFull = pCache->m_pPrevious;
+	depot.m_nFull++;
+
+	Magazine_t *pEmpty = depot.m_pEmpty;
+	if ( pEmpty )
+		depot.m_pEmpty = pEmpty->m_pNext;
+	depot.m_Mutex.Unlock();
+
+	pCache->m_pPrevious = pCache->m_pLoaded;
+	pCache->m_pLoaded = pEmpty ? pEmpty : NewMagazine();
+	pCache->m_pLoaded->m_nCount = 0;
+	m_nDepotExchanges.fetch_add( 1, std::memory_order_relaxed );
+}
+
+void *CMemoryPoolMagazineMT::Alloc( size_t amount )
+{
+	if ( amount > (unsigned int)m_BlockSize )
+		return NULL;
+
+	ThreadCache_t *pCache = GetThreadCache();
+	if ( !pCache )
+	{
+		AUTO_LOCK_FM( m_BlobMutex );
+		void *pBlock = CUtlMemoryPool::Alloc( amount );
+		if ( pBlock )
+			m_nRetiredAllocs.fetch_add( 1, std::memory_order_relaxed );
+		return pBlock;
+	}
+
+	if ( pCache->m_pLoaded->m_nCount == 0 )
+	{
+		if ( pCache->m_pPrevious->m_nCount != 0 )
+		{
+			Magazine_t *pPrevious = pCache->m_pPrevious;
+			pCache->m_pPrevious = pCache->m_pLoaded;
+			pCache->m_pLoaded = pPrevious;
+		}
+		else if ( !Reload( pCache ) )
+		{
+			return NULL;
+		}
+	}
+
+	BumpCounter( pCache->m_nAllocs );
+	Magazine_t *pLoaded = pCache->m_pLoaded;
+	return pLoaded->m_pBlocks[ --pLoaded->m_nCount ];
+}
+
+void *CMemoryPoolMagazineMT::AllocZero( size_t amount )
+{
+	void *mem = Alloc( amount );
+	if ( mem )
+	{
+		V_memset( mem, 0x00, amount );
+	}
+	return mem;
+}
+
+void CMemoryPoolMagazineMT::Free( void *memBlock )
+{
+	if ( !memBlock )
+		return;  // trying to delete NULL pointer, ignore
+
+#if IsDebug()
+	// invalidate the memory
+	memset( memBlock, 0xDD, m_BlockSize );
+#endif
+
+	ThreadCache_t *pCache = GetThreadCache();
+	if ( !pCache )
+	{
+		AUTO_LOCK_FM( m_BlobMutex );
+		CUtlMemoryPool::Free( memBlock );
+		m_nRetiredFrees.fetch_add( 1, std::memory_order_relaxed );
+		return;
+	}
+
+	if ( pCache->m_pLoaded->m_nCount == MAGAZINE_SIZE )
+	{
+		if ( pCache->m_pPrevious->m_nCount == 0 )
+		{
+			Magazine_t *pPrevious = pCache->m_pPrevious;
+			pCache->m_pPrevious = pCache->m_pLoaded;
+			pCache->m_pLoaded = pPrevious;
+		}
+		else
+		{
+			Unload( pCache );
+		}
+	}
+
+	BumpCounter( pCache->m_nFrees );
+	Magazine_t *pLoaded = pCache->m_pLoaded;
+	pLoaded->m_pBlocks[ pLoaded->m_nCount++ ] = memBlock;
+}
+
+void CMemoryPoolMagazineMT::Clear()
+{
+	// what was in use is gone too
+	MemoryPoolStats_t stats;
+	GetStats( stats );
+	m_nRetiredFrees.fetch_add( stats.m_nBlocksInUse, std::memory_order_relaxed );
+
+	// the threads drop their magazines when they see the new epoch
+	m_nEpoch.fetch_add( 1, std::memory_order_relaxed );
+	for ( Depot_t &depot : m_Depots )
+	{
+		AUTO_LOCK_FM( depot.m_Mutex );
+		while ( depot.m_pFull )
+		{
+			Magazine_t *pMagazine = depot.m_pFull;
+			depot.m_pFull = pMagazine->m_pNext;
+			pMagazine->m_nCount = 0;
+			pMagazine->m_pNext = depot.m_pEmpty;
+			depot.m_pEmpty = pMagazine;
+		}
+		depot.m_nFull = 0;
+	}
+
+	AUTO_LOCK_FM( m_BlobMutex );
+	CUtlMemoryPool::Clear();
+}
+
+void CMemoryPoolMagazineMT::FlushThreadCache()
+{
+	ThreadCache_t *pCache = GetThreadCache();
+	if ( pCache )
+	{
+		AUTO_LOCK_FM( MagazineRegistryMutex() );
+		DrainThreadCache( pCache );
+	}
+}
+
+int CMemoryPoolMagazineMT::Count()
+{
+	MemoryPoolStats_t stats;
+	GetStats( stats );
+	return stats.m_nBlocksInUse;
+}
+
+void CMemoryPoolMagazineMT::GetStats( MemoryPoolStats_t &stats )
+{
+	stats.m_nBlockSize = m_BlockSize;
+	stats.m_nThreads = 0;
+	stats.m_nAllocs = m_nRetiredAllocs.load( std::memory_order_relaxed );
+	stats.m_nFrees = m_nRetiredFrees.load( std::memory_order_relaxed );
+	{
+		AUTO_LOCK_FM( MagazineRegistryMutex() );
+		for ( ThreadCache_t *pCache = m_pThreadCaches; pCache; pCache = pCache->m_pNext )
+		{
+			stats.m_nAllocs += pCache->m_nAllocs.load( std::memory_order_relaxed );
+			stats.m_nFrees += pCache->m_nFrees.load( std::memory_order_relaxed );
+			stats.m_nThreads++;
+		}
+	}
+	stats.m_nDepotExchanges = m_nDepotExchanges.load( std::memory_order_relaxed );
+	stats.m_nRefills = m_nRefills.load( std::memory_order_relaxed );
+
+	// the blobs count whatever is out of their free list as allocated, magazines included
+	AUTO_LOCK_FM( m_BlobMutex );
+	stats.m_nBlobs = m_NumBlobs;
+	stats.m_nBlocksInUse = (int)( stats.m_nAllocs - stats.m_nFrees );
+	stats.m_nBlocksCached = m_BlocksAllocated - stats.m_nBlocksInUse;
+}
@@ -33,6 +33,7 @@ CMemoryStack::CMemoryStack()
 	  m_pAllocLimit( nullptr ),
 	  m_pCommitLimit( nullptr ),
 	  m_alignment( 16 ),
+	  m_highWater( 0 ),
 	  #if IsWindows()
 	  	  m_commitSize( 0 ),
 	  	  m_minCommit( 0 ),
@@ -165,6 +166,7 @@ void CMemoryStack::FreeToAllocPoint( MemoryStackMark_t mark, bool bDecommit ) {
 	Assert( pAllocPoint >= m_pBase && pAllocPoint <= m_pNextAlloc );
 
 	if ( pAllocPoint >= m_pBase && pAllocPoint < m_pNextAlloc ) {
+		m_highWater = GetHighWater();
 		if ( bDecommit ) {
 #if IsWindows()
 			unsigned char* pDecommitPoint = AlignValue( (unsigned char*) pAllocPoint, m_commitSize );
@@ -195,6 +197,7 @@ void CMemoryStack::FreeToAllocPoint( MemoryStackMark_t mark, bool bDecommit ) {
 
 void CMemoryStack::FreeAll( bool bDecommit ) {
 	if ( m_pBase && m_pCommitLimit - m_pBase > 0 ) {
+		m_highWater = GetHighWater();
 		if ( bDecommit ) {
 #if IsWindows()
 			MemAlloc_RegisterExternalDeallocation( CMemoryStack, GetBase(), GetSize() );
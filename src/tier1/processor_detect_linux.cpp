@@ -44,3 +44,66 @@ bool Check3DNowTechnology( void ) {
 	}
 	return false;
 }
+
+static bool s_bAVX2Disabled{ false };
+
+void DisableAVX2Technology() {
+	s_bAVX2Disabled = true;
+}
+
+bool CheckAVX2Technology( void ) {
+	if ( s_bAVX2Disabled ) {
+		return false;
+	}
+
+	unsigned long eax, ebx, ecx, unused;
+	cpuid( 0, eax, unused, unused, unused );
+	if ( eax < 7 ) {
+		return false;
+	}
+
+	// the OS has to save the ymm registers too: OSXSAVE, then XCR0 having the SSE and AVX state
+	cpuid( 1, unused, unused, ecx, unused );
+	if (! ( ecx & ( 1 << 27 ) ) ) {
+		return false;
+	}
+	unsigned long xcr0, xcr0High;
+	asm( "xgetbv" : "=a"( xcr0 ), "=d"( xcr0High ) : "c"( 0 ) );
+	if ( ( xcr0 & 6 ) != 6 ) {
+		return false;
+	}
+
+	// leaf 7 wants the subleaf in ecx, which the macro doesn't set
+	asm( "pushl %%ebx\n\t"
+		 "cpuid\n\t"
+		 "movl %%ebx,%%esi\n\t"
+		 "pop %%ebx" : "=a"( eax ), "=S"( ebx ), "=c"( ecx ), "=d"( unused ) : "a"( 7 ), "c"( 0 ) );
+	return ebx & ( 1 << 5 );
+}
+
+bool CheckPCLMULQDQTechnology( void ) {
+	unsigned long ecx, unused;
+	cpuid( 1, unused, unused, ecx, unused );
+
+	return ecx & 0x2;
+}
+
+bool CheckSHATechnology( void ) {
+	unsigned long eax, ebx, ecx, unused;
+	cpuid( 0, eax, unused, unused, unused );
+	if ( eax < 7 ) {
+		return false;
+	}
+
+	// the SHA-NI paths shuffle with SSSE3 and extract with SSE4.1, which every CPU with SHA has anyway
+	cpuid( 1, unused, unused, ecx, unused );
+	if ( ( ecx & ( ( 1 << 9 ) | ( 1 << 19 ) ) ) != ( ( 1 << 9 ) | ( 1 << 19 ) ) ) {
+		return false;
+	}
+
+	asm( "pushl %%ebx\n\t"
+		 "cpuid\n\t"
+		 "movl %%ebx,%%esi\n\t"
+		 "pop %%ebx" : "=a"( eax ), "=S"( ebx ), "=c"( ecx ), "=d"( unused ) : "a"( 7 ), "c"( 0 ) );
+	return ebx & ( 1 << 29 );
+}
@@ -221,3 +221,57 @@
 
 	#pragma optimize( "", on )
 #endif// _WIN32
+
+#if defined( PLATFORM_WINDOWS )
+	#include <intrin.h>
+
+	static bool s_bAVX2Disabled{ false };
+
+	void DisableAVX2Technology() {
+		s_bAVX2Disabled = true;
+	}
+
+	bool CheckAVX2Technology( void ) {
+		if ( s_bAVX2Disabled ) {
+			return false;
+		}
+
+		int info[4];
+		__cpuid( info, 0 );
+		if ( info[0] < 7 ) {
+			return false;
+		}
+
+		// the OS has to save the ymm registers too: OSXSAVE, then XCR0 having the SSE and AVX state
+		__cpuid( info, 1 );
+		if (! ( info[2] & ( 1 << 27 ) ) || ( _xgetbv( 0 ) & 6 ) != 6 ) {
+			return false;
+		}
+
+		__cpuidex( info, 7, 0 );
+		return info[1] & ( 1 << 5 );
+	}
+
+	bool CheckPCLMULQDQTechnology( void ) {
+		int info[4];
+		__cpuid( info, 1 );
+		return info[2] & 0x2;
+	}
+
+	bool CheckSHATechnology( void ) {
+		int info[4];
+		__cpuid( info, 0 );
+		if ( info[0] < 7 ) {
+			return false;
+		}
+
+		// the SHA-NI paths shuffle with SSSE3 and extract with SSE4.1, which every CPU with SHA has anyway
+		__cpuid( info, 1 );
+		if ( ( info[2] & ( ( 1 << 9 ) | ( 1 << 19 ) ) ) != ( ( 1 << 9 ) | ( 1 << 19 ) ) ) {
+			return false;
+		}
+
+		__cpuidex( info, 7, 0 );
+		return info[1] & ( 1 << 29 );
+	}
+#endif
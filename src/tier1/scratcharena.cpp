@@ -0,0 +1,108 @@
+//
+// Created by ENDERZOMBI102 on 18/10/2026.
+//
+#include "tier1/scratcharena.h"
+#include <atomic>
+
+
+namespace {
+	std::atomic<unsigned> s_nDefaultSize{ 4 * 1024 * 1024 };
+	std::atomic<unsigned> s_nPeakHighWater{ 0 };
+
+	constexpr unsigned SCRATCH_COMMIT_SIZE{ 64 * 1024 };
+
+	unsigned AllocatedSize( unsigned nBytes ) {
+		return nBytes ? AlignValue( nBytes, CScratchArena::ALIGNMENT ) : CScratchArena::ALIGNMENT;
+	}
+}
+
+CScratchArena& CScratchArena::ThreadArena() {
+	static thread_local CScratchArena s_Arena{};
+	if ( s_Arena.m_Stack.GetBase() == nullptr ) {
+		s_Arena.m_Stack.Init( s_nDefaultSize, SCRATCH_COMMIT_SIZE, SCRATCH_COMMIT_SIZE, ALIGNMENT );
+	}
+	return s_Arena;
+}
+
+void CScratchArena::SetDefaultSize( unsigned nMaxSize ) {
+	s_nDefaultSize = nMaxSize;
+}
+
+unsigned CScratchArena::GetPeakHighWater() {
+	return s_nPeakHighWater;
+}
+
+void* CScratchArena::Alloc( unsigned nBytes, bool bClear ) {
+	// the stack asserts when it runs out, it's fine for us
+	if ( m_Stack.GetUsed() + AllocatedSize( nBytes ) > static_cast<unsigned>( m_Stack.GetMaxSize() ) ) {
+		if ( m_nOverflows == 0 ) {
+			Warning( "CScratchArena: thread arena of %d bytes is full, falling back to the heap\n", m_Stack.GetMaxSize() );
+		}
+		m_nOverflows += 1;
+		return nullptr;
+	}
+	return m_Stack.Alloc( nBytes, bClear );
+}
+
+bool CScratchArena::IsTop( const void* pMem, unsigned nBytes ) const {
+	return static_cast<const byte*>( pMem ) + AllocatedSize( nBytes ) == static_cast<const byte*>( m_Stack.GetBase() ) + m_Stack.GetUsed();
+}
+
+void CScratchArena::Free( void* pMem, unsigned nBytes ) {
+	if ( IsTop( pMem, nBytes ) ) {
+		m_Stack.FreeToAllocPoint( static_cast<byte*>( pMem ) - static_cast<byte*>( m_Stack.GetBase() ), false );
+	}
+}
+
+bool CScratchArena::Extend( void* pMem, unsigned nOldBytes, unsigned nNewBytes ) {
+	if (! IsTop( pMem, nOldBytes ) ) {
+		return false;
+	}
+
+	const auto offset{ static_cast<unsigned>( static_cast<byte*>( pMem ) - static_cast<byte*>( m_Stack.GetBase() ) ) };
+	if ( offset + AllocatedSize( nNewBytes ) > static_cast<unsigned>( m_Stack.GetMaxSize() ) ) {
+		return false;
+	}
+	m_Stack.FreeToAllocPoint( offset, false );
+	if ( m_Stack.Alloc( nNewBytes ) == nullptr ) {
+		// couldn't commit the rest, the old block's pages are still there so it's taken back as is
+		m_Stack.Alloc( nOldBytes );
+		return false;
+	}
+	return true;
+}
+
+bool CScratchArena::Owns( const void* pMem ) const {
+	const auto base{ static_cast<const byte*>( m_Stack.GetBase() ) };
+	return pMem >= base and pMem < base + m_Stack.GetMaxSize();
+}
+
+void CScratchArena::FreeToMark( MemoryStackMark_t mark ) {
+	// keep the pages, they'll be needed again next frame
+	m_Stack.FreeToAllocPoint( mark, false );
+}
+
+void CScratchArena::EndFrame() {
+	AssertMsg( m_Stack.GetUsed() == 0, "Scratch memory still in use at the end of the frame" );
+
+	const auto nFrameHighWater{ m_Stack.GetHighWater() };
+	m_nHighWater = MAX( m_nHighWater, nFrameHighWater );
+	m_Stack.ResetHighWater();
+
+	auto nPeak{ s_nPeakHighWater.load( std::memory_order_relaxed ) };
+	while ( nFrameHighWater > nPeak and not s_nPeakHighWater.compare_exchange_weak( nPeak, nFrameHighWater, std::memory_order_relaxed ) ) { }
+}
+
+void CScratchArena::GetStats( ScratchArenaStats_t& stats ) const {
+	stats.m_nUsed = m_Stack.GetUsed();
+	stats.m_nReserved = m_Stack.GetMaxSize();
+	stats.m_nFrameHighWater = m_Stack.GetHighWater();
+	stats.m_nHighWater = MAX( m_nHighWater, stats.m_nFrameHighWater );
+	stats.m_nOverflows = m_nOverflows;
+}
+
+void CScratchArena::ResetHighWater() {
+	m_nHighWater = 0;
+	m_nOverflows = 0;
+	m_Stack.ResetHighWater();
+}
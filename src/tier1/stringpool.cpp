@@ -305,6 +305,380 @@ void CCountedStringPool::SpewStrings()
 	Msg("\n%d total counted strings.", m_Elements.Count());
 }
 
+//-----------------------------------------------------------------------------
+// Hashed string pool
+//-----------------------------------------------------------------------------
+
+CHashedStringPool::CHashedStringPool( bool bCaseInsensitive )
+	: m_bCaseInsensitive( bCaseInsensitive )
+{
+	m_nUsedSlots = 0;
+	m_nPageUsed = PAGE_SIZE;
+	m_nStringBytes = 0;
+	m_nFreeBytes = 0;
+	m_nLongBytes = 0;
+	memset( m_pFreeBlocks, 0, sizeof( m_pFreeBlocks ) );
+
+	m_Table.SetCount( 1024 );
+	memset( m_Table.Base(), 0, m_Table.Count() * sizeof( Slot_t ) );
+}
+
+CHashedStringPool::~CHashedStringPool()
+{
+	FreeAll();
+}
+
+unsigned int CHashedStringPool::Count() const
+{
+	m_Lock.LockForRead();
+	unsigned int nCount = m_Entries.Count() - m_FreeEntries.Count();
+	m_Lock.UnlockRead();
+	return nCount;
+}
+
+void CHashedStringPool::FreeAll()
+{
+	m_Lock.LockForWrite();
+
+	// long strings have their own allocations, everything else goes with the pages
+	for ( int i = 0; i < m_Entries.Count(); i++ )
+	{
+		if ( m_Entries[i].m_pString && (int)m_Entries[i].m_nLength + 1 > MAX_BLOCK_SIZE )
+			free( m_Entries[i].m_pString );
+	}
+	for ( int i = 0; i < m_Pages.Count(); i++ )
+	{
+		free( m_Pages[i] );
+	}
+
+	m_Pages.RemoveAll();
+	m_Entries.RemoveAll();
+	m_FreeEntries.RemoveAll();
+	memset( m_pFreeBlocks, 0, sizeof( m_pFreeBlocks ) );
+	memset( m_Table.Base(), 0, m_Table.Count() * sizeof( Slot_t ) );
+	m_nUsedSlots = 0;
+	m_nPageUsed = PAGE_SIZE;
+	m_nStringBytes = 0;
+	m_nFreeBytes = 0;
+	m_nLongBytes = 0;
+
+	m_Lock.UnlockWrite();
+}
+
+uint32 CHashedStringPool::HashOf( const char *pszValue, uint32 nLength ) const
+{
+	return m_bCaseInsensitive ? HashStringCaseless( pszValue ) : MurmurHash2( pszValue, nLength, 0x2a5b91c7 );
+}
+
+bool CHashedStringPool::Matches( const Entry_t &entry, const char *pszValue, uint32 nLength, uint32 nHash ) const
+{
+	if ( entry.m_nHash != nHash || entry.m_nLength != nLength )
+		return false;
+
+	return m_bCaseInsensitive ? !Q_strnicmp( entry.m_pString, pszValue, nLength ) : !memcmp( entry.m_pString, pszValue, nLength );
+}
+
+int CHashedStringPool::LookupSlot( const char *pszValue, uint32 nLength, uint32 nHash ) const
+{
+	int nMask = m_Table.Count() - 1;
+	int nProbes = 1;
+	int nFound = -1;
+	for ( int i = nHash & nMask; ; i = ( i + 1 ) & nMask, nProbes++ )
+	{
+		const Slot_t &slot = m_Table[i];
+		if ( slot.m_Handle == STRING_POOL_INVALID_HANDLE )
+			break;
+
+		// the cached hash keeps us from touching most strings
+		if ( slot.m_Handle != TOMBSTONE && slot.m_nHash == nHash && Matches( m_Entries[ slot.m_Handle - 1 ], pszValue, nLength, nHash ) )
+		{
+			nFound = i;
+			break;
+		}
+	}
+
+	++m_nLookups;
+	if ( nFound != -1 )
+		++m_nHits;
+
+	int nLongest = m_nLongestProbe;
+	while ( nProbes > nLongest && !m_nLongestProbe.AssignIf( nLongest, nProbes ) )
+		nLongest = m_nLongestProbe;
+
+	return nFound;
+}
+
+char *CHashedStringPool::AllocBlock( int nSize )
+{
+	if ( nSize > MAX_BLOCK_SIZE )
+	{
+		m_nLongBytes += nSize;
+		return (char *)malloc( nSize );
+	}
+
+	nSize = ALIGN_VALUE( nSize, BLOCK_GRANULARITY );
+	char *&pFree = m_pFreeBlocks[ nSize / BLOCK_GRANULARITY - 1 ];
+	if ( pFree )
+	{
+		char *pBlock = pFree;
+		pFree = *(char **)pBlock;
+		m_nFreeBytes -= nSize;
+		return pBlock;
+	}
+
+	if ( m_nPageUsed + nSize > PAGE_SIZE )
+	{
+		m_Pages.AddToTail( (char *)malloc( PAGE_SIZE ) );
+		m_nPageUsed = 0;
+	}
+
+	char *pBlock = m_Pages.Tail() + m_nPageUsed;
+	m_nPageUsed += nSize;
+	return pBlock;
+}
+
+void CHashedStringPool::FreeBlock( char *pBlock, int nSize )
+{
+	if ( nSize > MAX_BLOCK_SIZE )
+	{
+		m_nLongBytes -= nSize;
+		free( pBlock );
+		return;
+	}
+
+	nSize = ALIGN_VALUE( nSize, BLOCK_GRANULARITY );
+	char *&pFree = m_pFreeBlocks[ nSize / BLOCK_GRANULARITY - 1 ];
+	*(char **)pBlock = pFree;
+	pFree = pBlock;
+	m_nFreeBytes += nSize;
+}
+
+void CHashedStringPool::Rehash( int nCapacity )
+{
+	m_Table.SetCount( nCapacity );
+	memset( m_Table.Base(), 0, m_Table.Count() * sizeof( Slot_t ) );
+	m_nUsedSlots = 0;
+
+	int nMask = nCapacity - 1;
+	for ( int i = 0; i < m_Entries.Count(); i++ )
+	{
+		const Entry_t &entry = m_Entries[i];
+		if ( !entry.m_pString )
+			continue;
+
+		int nSlot = entry.m_nHash & nMask;
+		while ( m_Table[ nSlot ].m_Handle != STRING_POOL_INVALID_HANDLE )
+			nSlot = ( nSlot + 1 ) & nMask;
+
+		m_Table[ nSlot ].m_nHash = entry.m_nHash;
+		m_Table[ nSlot ].m_Handle = i + 1;
+		m_nUsedSlots++;
+	}
+}
+
+StringPoolHandle_t CHashedStringPool::Insert( const char *pszValue, uint32 nLength, uint32 nHash )
+{
+	// keep at most half of the slots used, tombstones included
+	if ( ( m_nUsedSlots + 1 ) * 2 > m_Table.Count() )
+	{
+		int nLive = m_Entries.Count() - m_FreeEntries.Count();
+		Rehash( ( nLive + 1 ) * 4 > m_Table.Count() ? m_Table.Count() * 2 : m_Table.Count() );
+	}
+
+	int nEntry;
+	if ( m_FreeEntries.Count() )
+	{
+		nEntry = m_FreeEntries.Tail();
+		m_FreeEntries.RemoveMultipleFromTail( 1 );
+	}
+	else
+	{
+		nEntry = m_Entries.AddToTail();
+	}
+
+	Entry_t &entry = m_Entries[ nEntry ];
+	entry.m_pString = AllocBlock( nLength + 1 );
+	Q_memcpy( entry.m_pString, pszValue, nLength + 1 );
+	entry.m_nHash = nHash;
+	entry.m_nLength = nLength;
+	entry.m_nRefs = 1;
+	m_nStringBytes += nLength + 1;
+
+	int nMask = m_Table.Count() - 1;
+	int nSlot = nHash & nMask;
+	while ( m_Table[ nSlot ].m_Handle != STRING_POOL_INVALID_HANDLE && m_Table[ nSlot ].m_Handle != TOMBSTONE )
+		nSlot = ( nSlot + 1 ) & nMask;
+
+	if ( m_Table[ nSlot ].m_Handle == STRING_POOL_INVALID_HANDLE )
+		m_nUsedSlots++;
+	m_Table[ nSlot ].m_nHash = nHash;
+	m_Table[ nSlot ].m_Handle = nEntry + 1;
+
+	return nEntry + 1;
+}
+
+void CHashedStringPool::Remove( StringPoolHandle_t handle )
+{
+	Entry_t &entry = m_Entries[ handle - 1 ];
+	int nSlot = LookupSlot( entry.m_pString, entry.m_nLength, entry.m_nHash );
+	Assert( nSlot != -1 && m_Table[ nSlot ].m_Handle == handle );
+	m_Table[ nSlot ].m_Handle = TOMBSTONE;
+
+	FreeBlock( entry.m_pString, entry.m_nLength + 1 );
+	m_nStringBytes -= entry.m_nLength + 1;
+	entry.m_pString = NULL;
+	m_FreeEntries.AddToTail( handle - 1 );
+}
+
+StringPoolHandle_t CHashedStringPool::FindStringHandle( const char *pIntrinsic ) const
+{
+	if ( !pIntrinsic )
+		return STRING_POOL_INVALID_HANDLE;
+
+	uint32 nLength = Q_strlen( pIntrinsic );
+	uint32 nHash = HashOf( pIntrinsic, nLength );
+
+	m_Lock.LockForRead();
+	int nSlot = LookupSlot( pIntrinsic, nLength, nHash );
+	StringPoolHandle_t handle = nSlot != -1 ? m_Table[ nSlot ].m_Handle : STRING_POOL_INVALID_HANDLE;
+	m_Lock.UnlockRead();
+
+	return handle;
+}
+
+StringPoolHandle_t CHashedStringPool::ReferenceStringHandle( const char *pIntrinsic )
+{
+	if ( !pIntrinsic )
+		return STRING_POOL_INVALID_HANDLE;
+
+	uint32 nLength = Q_strlen( pIntrinsic );
+	uint32 nHash = HashOf( pIntrinsic, nLength );
+
+	// strings usually are in already, and referencing those only needs the read lock
+	m_Lock.LockForRead();
+	int nSlot = LookupSlot( pIntrinsic, nLength, nHash );
+	if ( nSlot != -1 )
+	{
+		StringPoolHandle_t handle = m_Table[ nSlot ].m_Handle;
+		++m_Entries[ handle - 1 ].m_nRefs;
+		m_Lock.UnlockRead();
+		return handle;
+	}
+	m_Lock.UnlockRead();
+
+	m_Lock.LockForWrite();
+	// someone may have added it in the meantime
+	StringPoolHandle_t handle;
+	nSlot = LookupSlot( pIntrinsic, nLength, nHash );
+	if ( nSlot != -1 )
+	{
+		handle = m_Table[ nSlot ].m_Handle;
+		++m_Entries[ handle - 1 ].m_nRefs;
+	}
+	else
+	{
+		handle = Insert( pIntrinsic, nLength, nHash );
+	}
+	m_Lock.UnlockWrite();
+
+	return handle;
+}
+
+void CHashedStringPool::DereferenceStringHandle( StringPoolHandle_t handle )
+{
+	if ( handle == STRING_POOL_INVALID_HANDLE )
+		return;
+
+	m_Lock.LockForRead();
+	bool bLast = --m_Entries[ handle - 1 ].m_nRefs == 0;
+	m_Lock.UnlockRead();
+
+	if ( !bLast )
+		return;
+
+	// references are only taken under the read lock, so a count still at zero here stays there
+	m_Lock.LockForWrite();
+	Entry_t &entry = m_Entries[ handle - 1 ];
+	if ( entry.m_pString && entry.m_nRefs == 0 )
+		Remove( handle );
+	m_Lock.UnlockWrite();
+}
+
+void CHashedStringPool::DereferenceString( const char *pIntrinsic )
+{
+	DereferenceStringHandle( FindStringHandle( pIntrinsic ) );
+}
+
+const char *CHashedStringPool::ReferenceString( const char *pIntrinsic )
+{
+	return HandleToString( ReferenceStringHandle( pIntrinsic ) );
+}
+
+const char *CHashedStringPool::HandleToString( StringPoolHandle_t handle ) const
+{
+	if ( handle == STRING_POOL_INVALID_HANDLE )
+		return NULL;
+
+	m_Lock.LockForRead();
+	const char *pString = m_Entries[ handle - 1 ].m_pString;
+	m_Lock.UnlockRead();
+	return pString;
+}
+
+const char *CHashedStringPool::Allocate( const char *pszValue )
+{
+	return ReferenceString( pszValue );
+}
+
+const char *CHashedStringPool::Find( const char *pszValue ) const
+{
+	return HandleToString( FindStringHandle( pszValue ) );
+}
+
+void CHashedStringPool::GetStats( StringPoolStats_t &stats ) const
+{
+	m_Lock.LockForRead();
+	stats.m_nStrings = m_Entries.Count() - m_FreeEntries.Count();
+	stats.m_nStringBytes = m_nStringBytes;
+	stats.m_nPageBytes = m_Pages.Count() * PAGE_SIZE + m_nLongBytes;
+	stats.m_nFreeBytes = m_nFreeBytes;
+	stats.m_nTableCapacity = m_Table.Count();
+	stats.m_nTombstones = m_nUsedSlots - stats.m_nStrings;
+	stats.m_nLongestProbe = m_nLongestProbe;
+	stats.m_nLookups = m_nLookups;
+	stats.m_nHits = m_nHits;
+	m_Lock.UnlockRead();
+}
+
+void CHashedStringPool::GetStrings( CUtlVector< const char * > &strings ) const
+{
+	m_Lock.LockForRead();
+	strings.EnsureCapacity( strings.Count() + m_Entries.Count() - m_FreeEntries.Count() );
+	for ( int i = 0; i < m_Entries.Count(); i++ )
+	{
+		if ( m_Entries[i].m_pString )
+			strings.AddToTail( m_Entries[i].m_pString );
+	}
+	m_Lock.UnlockRead();
+}
+
+void CHashedStringPool::SpewStrings() const
+{
+	m_Lock.LockForRead();
+	for ( int i = 0; i < m_Entries.Count(); i++ )
+	{
+		if ( m_Entries[i].m_pString )
+			Msg( "String %d: ref:%d %s\n", i + 1, (int)m_Entries[i].m_nRefs, m_Entries[i].m_pString );
+	}
+	m_Lock.UnlockRead();
+
+	StringPoolStats_t stats;
+	GetStats( stats );
+	Msg( "%d total strings, %d bytes in %d bytes of storage (%d free), %d/%d slots used, longest probe %d\n",
+		stats.m_nStrings, stats.m_nStringBytes, stats.m_nPageBytes, stats.m_nFreeBytes,
+		stats.m_nStrings + stats.m_nTombstones, stats.m_nTableCapacity, stats.m_nLongestProbe );
+}
+
 #if IsDebug()
 CON_COMMAND( test_stringpool, "Tests the class CStringPool" )
 {
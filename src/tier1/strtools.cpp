@@ -27,12 +27,22 @@
 #include "tier0/basetypes.h"
 #include "tier0/dbg.h"
 #include "tier0/memdbgon.h"
+#include "tier1/processor_detect.h"
 #include "tier1/strtools.h"
 #include "tier1/utldict.h"
+#include <climits>
 #include <cstring>
 #include <ctime>
 #include <filesystem>
 #include <system_error>
+#include <emmintrin.h>
+#include <immintrin.h>
+
+#if defined( COMPILER_MSVC )
+	#define STRTOOLS_TARGET_AVX2
+#else
+	#define STRTOOLS_TARGET_AVX2 __attribute__(( target( "avx2" ) ))
+#endif
 
 static int FastToLower( char c ) {
 	int i = static_cast<unsigned char>( c );
@@ -45,6 +55,247 @@ static int FastToLower( char c ) {
 	return i;
 }
 
+//-----------------------------------------------------------------------------
+// SIMD string primitives
+//
+// Strings have no known length, so blocks are only loaded when they can't cross into the
+// next page: reading past the terminator is then harmless. Near a page boundary we go a byte
+// at a time. The AVX2 versions are picked at runtime, the first time any of them is used.
+//-----------------------------------------------------------------------------
+
+static inline int StrTools_FirstBit( unsigned nMask ) {
+#if defined( COMPILER_MSVC )
+	unsigned long nIndex;
+	_BitScanForward( &nIndex, nMask );
+	return static_cast<int>( nIndex );
+#else
+	return __builtin_ctz( nMask );
+#endif
+}
+
+static inline bool StrTools_IsPageSafe( const void* p, int nSize ) {
+	return ( reinterpret_cast<uintp>( p ) & 4095 ) <= static_cast<uintp>( 4096 - nSize );
+}
+
+// Lowers 'A' to 'Z', anything else (non-ascii included) stays as is
+static inline unsigned char StrTools_FoldAscii( unsigned char c ) {
+	return static_cast<unsigned char>( c - 'A' ) <= ( 'Z' - 'A' ) ? c + ( 'a' - 'A' ) : c;
+}
+
+static inline __m128i StrTools_FoldAscii( __m128i chunk ) {
+	// signed compares, so bytes >= 0x80 are never in range
+	const __m128i upper = _mm_and_si128( _mm_cmpgt_epi8( chunk, _mm_set1_epi8( 'A' - 1 ) ), _mm_cmpgt_epi8( _mm_set1_epi8( 'Z' + 1 ), chunk ) );
+	return _mm_add_epi8( chunk, _mm_and_si128( upper, _mm_set1_epi8( 'a' - 'A' ) ) );
+}
+
+STRTOOLS_TARGET_AVX2 static inline __m256i StrTools_FoldAscii( __m256i chunk ) {
+	const __m256i upper = _mm256_and_si256( _mm256_cmpgt_epi8( chunk, _mm256_set1_epi8( 'A' - 1 ) ), _mm256_cmpgt_epi8( _mm256_set1_epi8( 'Z' + 1 ), chunk ) );
+	return _mm256_add_epi8( chunk, _mm256_and_si256( upper, _mm256_set1_epi8( 'a' - 'A' ) ) );
+}
+
+// Length of the prefix, at most `n` long, which has no terminator and is equal ignoring ascii case
+static int StrTools_CaselessPrefix_SSE2( const unsigned char* s1, const unsigned char* s2, int n ) {
+	int i = 0;
+	while ( i < n ) {
+		if ( n - i >= 16 && StrTools_IsPageSafe( s1 + i, 16 ) && StrTools_IsPageSafe( s2 + i, 16 ) ) {
+			const __m128i a = _mm_loadu_si128( reinterpret_cast<const __m128i*>( s1 + i ) );
+			const __m128i b = _mm_loadu_si128( reinterpret_cast<const __m128i*>( s2 + i ) );
+			const __m128i equal = _mm_cmpeq_epi8( StrTools_FoldAscii( a ), StrTools_FoldAscii( b ) );
+			const __m128i end = _mm_cmpeq_epi8( a, _mm_setzero_si128() );
+			const unsigned nMask = ( _mm_movemask_epi8( equal ) ^ 0xFFFF ) | _mm_movemask_epi8( end );
+			if ( nMask ) {
+				return i + StrTools_FirstBit( nMask );
+			}
+			i += 16;
+		} else {
+			if ( s1[ i ] == 0 || StrTools_FoldAscii( s1[ i ] ) != StrTools_FoldAscii( s2[ i ] ) ) {
+				return i;
+			}
+			i++;
+		}
+	}
+	return n;
+}
+
+STRTOOLS_TARGET_AVX2 static int StrTools_CaselessPrefix_AVX2( const unsigned char* s1, const unsigned char* s2, int n ) {
+	int i = 0;
+	while ( i < n ) {
+		if ( n - i >= 32 && StrTools_IsPageSafe( s1 + i, 32 ) && StrTools_IsPageSafe( s2 + i, 32 ) ) {
+			const __m256i a = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( s1 + i ) );
+			const __m256i b = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( s2 + i ) );
+			const __m256i equal = _mm256_cmpeq_epi8( StrTools_FoldAscii( a ), StrTools_FoldAscii( b ) );
+			const __m256i end = _mm256_cmpeq_epi8( a, _mm256_setzero_si256() );
+			const unsigned nMask = ~static_cast<unsigned>( _mm256_movemask_epi8( equal ) ) | static_cast<unsigned>( _mm256_movemask_epi8( end ) );
+			if ( nMask ) {
+				return i + StrTools_FirstBit( nMask );
+			}
+			i += 32;
+		} else {
+			if ( s1[ i ] == 0 || StrTools_FoldAscii( s1[ i ] ) != StrTools_FoldAscii( s2[ i ] ) ) {
+				return i;
+			}
+			i++;
+		}
+	}
+	return n;
+}
+
+// Whether the string ends within its first 16 bytes, strings near a page boundary never count as short
+static inline bool StrTools_IsShort( const void* str ) {
+	if (! StrTools_IsPageSafe( str, 16 ) ) {
+		return false;
+	}
+	const __m128i chunk = _mm_loadu_si128( static_cast<const __m128i*>( str ) );
+	return _mm_movemask_epi8( _mm_cmpeq_epi8( chunk, _mm_setzero_si128() ) ) != 0;
+}
+
+// Lowers at most `n` bytes, returns nullptr once the terminator is reached
+static inline unsigned char* StrTools_LowerBytes( unsigned char* str, int n ) {
+	for ( const auto* end = str + n; str != end; str++ ) {
+		if (! *str ) {
+			return nullptr;
+		}
+		if ( static_cast<unsigned char>( *str - 'A' ) <= ( 'Z' - 'A' ) )
+			*str += 'a' - 'A';
+		else if ( *str >= 0x80 )// non-ascii, fall back to CRT
+			*str = tolower( *str );
+	}
+	return str;
+}
+
+// Same for the separators, the blocks with a terminator are done this way to never write past it
+static inline char* StrTools_FixSlashesBytes( char* pname, char separator, int n ) {
+	for ( const auto* end = pname + n; pname != end; pname++ ) {
+		if (! *pname ) {
+			return nullptr;
+		}
+		if ( *pname == '/' || *pname == '\\' ) {
+			*pname = separator;
+		}
+	}
+	return pname;
+}
+
+// Lowers ascii blocks in bulk, leaves non-ascii bytes to the CRT.
+// A block which can't be done in bulk is done bytewise as a whole, not probed again for every byte
+static void StrTools_Lower_SSE2( unsigned char* str ) {
+	for ( ;; ) {
+		if ( StrTools_IsPageSafe( str, 16 ) ) {
+			const __m128i chunk = _mm_loadu_si128( reinterpret_cast<const __m128i*>( str ) );
+			// the sign bits are the non-ascii bytes
+			if ( ( _mm_movemask_epi8( chunk ) | _mm_movemask_epi8( _mm_cmpeq_epi8( chunk, _mm_setzero_si128() ) ) ) == 0 ) {
+				const __m128i lower = StrTools_FoldAscii( chunk );
+				if ( _mm_movemask_epi8( _mm_cmpeq_epi8( lower, chunk ) ) != 0xFFFF ) {
+					_mm_storeu_si128( reinterpret_cast<__m128i*>( str ), lower );
+				}
+				str += 16;
+				continue;
+			}
+		}
+		str = StrTools_LowerBytes( str, 16 );
+		if (! str ) {
+			return;
+		}
+	}
+}
+
+STRTOOLS_TARGET_AVX2 static void StrTools_Lower_AVX2( unsigned char* str ) {
+	for ( ;; ) {
+		if ( StrTools_IsPageSafe( str, 32 ) ) {
+			const __m256i chunk = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( str ) );
+			if ( ( _mm256_movemask_epi8( chunk ) | _mm256_movemask_epi8( _mm256_cmpeq_epi8( chunk, _mm256_setzero_si256() ) ) ) == 0 ) {
+				const __m256i lower = StrTools_FoldAscii( chunk );
+				if ( ~static_cast<unsigned>( _mm256_movemask_epi8( _mm256_cmpeq_epi8( lower, chunk ) ) ) ) {
+					_mm256_storeu_si256( reinterpret_cast<__m256i*>( str ), lower );
+				}
+				str += 32;
+				continue;
+			}
+		}
+		str = StrTools_LowerBytes( str, 32 );
+		if (! str ) {
+			return;
+		}
+	}
+}
+
+static void StrTools_FixSlashes_SSE2( char* pname, char separator ) {
+	const __m128i forward = _mm_set1_epi8( '/' );
+	const __m128i backward = _mm_set1_epi8( '\\' );
+	const __m128i replacement = _mm_set1_epi8( separator );
+	for ( ;; ) {
+		if ( StrTools_IsPageSafe( pname, 16 ) ) {
+			const __m128i chunk = _mm_loadu_si128( reinterpret_cast<const __m128i*>( pname ) );
+			if ( _mm_movemask_epi8( _mm_cmpeq_epi8( chunk, _mm_setzero_si128() ) ) == 0 ) {
+				const __m128i slash = _mm_or_si128( _mm_cmpeq_epi8( chunk, forward ), _mm_cmpeq_epi8( chunk, backward ) );
+				if ( _mm_movemask_epi8( slash ) ) {
+					_mm_storeu_si128( reinterpret_cast<__m128i*>( pname ), _mm_or_si128( _mm_and_si128( slash, replacement ), _mm_andnot_si128( slash, chunk ) ) );
+				}
+				pname += 16;
+				continue;
+			}
+		}
+		pname = StrTools_FixSlashesBytes( pname, separator, 16 );
+		if (! pname ) {
+			return;
+		}
+	}
+}
+
+STRTOOLS_TARGET_AVX2 static void StrTools_FixSlashes_AVX2( char* pname, char separator ) {
+	const __m256i forward = _mm256_set1_epi8( '/' );
+	const __m256i backward = _mm256_set1_epi8( '\\' );
+	const __m256i replacement = _mm256_set1_epi8( separator );
+	for ( ;; ) {
+		if ( StrTools_IsPageSafe( pname, 32 ) ) {
+			const __m256i chunk = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( pname ) );
+			if ( _mm256_movemask_epi8( _mm256_cmpeq_epi8( chunk, _mm256_setzero_si256() ) ) == 0 ) {
+				const __m256i slash = _mm256_or_si256( _mm256_cmpeq_epi8( chunk, forward ), _mm256_cmpeq_epi8( chunk, backward ) );
+				if ( _mm256_movemask_epi8( slash ) ) {
+					_mm256_storeu_si256( reinterpret_cast<__m256i*>( pname ), _mm256_blendv_epi8( chunk, replacement, slash ) );
+				}
+				pname += 32;
+				continue;
+			}
+		}
+		pname = StrTools_FixSlashesBytes( pname, separator, 32 );
+		if (! pname ) {
+			return;
+		}
+	}
+}
+
+// Each pointer starts at a stub which picks the implementations, so calls during static init work too
+static int StrTools_CaselessPrefix_Select( const unsigned char* s1, const unsigned char* s2, int n );
+static void StrTools_Lower_Select( unsigned char* str );
+static void StrTools_FixSlashes_Select( char* pname, char separator );
+
+static int ( *s_pfnCaselessPrefix )( const unsigned char*, const unsigned char*, int ) = StrTools_CaselessPrefix_Select;
+static void ( *s_pfnLower )( unsigned char* ) = StrTools_Lower_Select;
+static void ( *s_pfnFixSlashes )( char*, char ) = StrTools_FixSlashes_Select;
+
+static void StrTools_SelectImplementations() {
+	const bool bAVX2 = CheckAVX2Technology();
+	s_pfnCaselessPrefix = bAVX2 ? StrTools_CaselessPrefix_AVX2 : StrTools_CaselessPrefix_SSE2;
+	s_pfnLower = bAVX2 ? StrTools_Lower_AVX2 : StrTools_Lower_SSE2;
+	s_pfnFixSlashes = bAVX2 ? StrTools_FixSlashes_AVX2 : StrTools_FixSlashes_SSE2;
+}
+
+static int StrTools_CaselessPrefix_Select( const unsigned char* s1, const unsigned char* s2, int n ) {
+	StrTools_SelectImplementations();
+	return s_pfnCaselessPrefix( s1, s2, n );
+}
+
+static void StrTools_Lower_Select( unsigned char* str ) {
+	StrTools_SelectImplementations();
+	s_pfnLower( str );
+}
+
+static void StrTools_FixSlashes_Select( char* pname, char separator ) {
+	StrTools_SelectImplementations();
+	s_pfnFixSlashes( pname, separator );
+}
+
 void _V_memset( const char* file, int line, void* dest, int fill, int count ) {
 	Assert( count >= 0 );
 	AssertValidWritePtr( dest, count );
@@ -159,13 +410,12 @@ char* V_strupr( char* start ) {
 }
 
 char* V_strlower( char* start ) {
+	// strings shorter than a vector are done bytewise, without calling into the SIMD run
 	auto* str = reinterpret_cast<unsigned char*>( start );
-	while ( *str ) {
-		if ( static_cast<unsigned char>( *str - 'A' ) <= ( 'Z' - 'A' ) )
-			*str += 'a' - 'A';
-		else if ( static_cast<unsigned char>( *str ) >= 0x80 )// non-ascii, fall back to CRT
-			*str = tolower( *str );
-		str++;
+	if ( StrTools_IsShort( str ) ) {
+		StrTools_LowerBytes( str, 16 );
+	} else {
+		s_pfnLower( str );
 	}
 	return start;
 }
@@ -200,6 +450,10 @@ int V_stricmp( const char* str1, const char* str2 ) {
 	}
 	const auto* s1 = reinterpret_cast<const unsigned char*>( str1 );
 	const auto* s2 = reinterpret_cast<const unsigned char*>( str2 );
+	// skip what compares equal in bulk, the loop below then stops at the terminator or the mismatch
+	const int nEqual = s_pfnCaselessPrefix( s1, s2, INT_MAX );
+	s1 += nEqual;
+	s2 += nEqual;
 	for ( ; *s1; ++s1, ++s2 ) {
 		if ( *s1 != *s2 ) {
 			// in ascii char set, lowercase = uppercase | 0x20
@@ -224,6 +478,12 @@ int V_stricmp( const char* str1, const char* str2 ) {
 int V_strnicmp( const char* str1, const char* str2, int n ) {
 	const auto* s1 = reinterpret_cast<const unsigned char*>( str1 );
 	const auto* s2 = reinterpret_cast<const unsigned char*>( str2 );
+	if ( n > 0 ) {
+		const int nEqual = s_pfnCaselessPrefix( s1, s2, n );
+		s1 += nEqual;
+		s2 += nEqual;
+		n -= nEqual;
+	}
 	for ( ; n > 0 && *s1; --n, ++s1, ++s2 ) {
 		if ( *s1 != *s2 ) {
 			// in ascii char set, lowercase = uppercase | 0x20
@@ -1621,11 +1881,12 @@ void V_StripFilename( char* path ) {
 //			separator -
 //-----------------------------------------------------------------------------
 void V_FixSlashes( char* pname, char separator /* = CORRECT_PATH_SEPARATOR */ ) {
-	while ( *pname ) {
-		if ( *pname == INCORRECT_PATH_SEPARATOR || *pname == CORRECT_PATH_SEPARATOR ) {
-			*pname = separator;
-		}
-		pname++;
+	// the separators are always '/' and '\\', in some order
+	// short paths are done bytewise, like in V_strlower
+	if ( StrTools_IsShort( pname ) ) {
+		StrTools_FixSlashesBytes( pname, separator, 16 );
+	} else {
+		s_pfnFixSlashes( pname, separator );
 	}
 }
 
@@ -7,8 +7,12 @@
 //=============================================================================//
 
 #include <limits.h>
+#include <bit>
 #include "tier0/dbg.h"
+#include "tier1/processor_detect.h"
 #include "tier1/strtools.h"
+#include <emmintrin.h>
+#include <immintrin.h>
 
 // This code was copied from steam
 #define DbgAssert Assert
@@ -207,6 +211,459 @@ int Q_UTF16ToUChar32( const uchar16 *pUTF16, uchar32 &uValueOut, bool &bErrorOut
 	}
 }
 
+//-----------------------------------------------------------------------------
+// SIMD runs
+//
+// A run converts the characters at the start of the input which can be done a
+// block at a time, and stops at the first one which can't: anything invalid,
+// CESU-8 or outside of the BMP is left to the decoders above, so results and
+// error handling are exactly the same. Null terminated input is only loaded a
+// block at a time when the block can't cross into the next page, counted input
+// when it has enough characters left for it.
+// The SSE2 runs do ASCII and BMP blocks, the AVX2 ones 32 byte ASCII blocks
+// and 2 and 3 byte UTF-8 sequences too; they're picked the first time one is used.
+//-----------------------------------------------------------------------------
+#if defined( COMPILER_MSVC )
+	#define UNICODE_TARGET_AVX2
+#else
+	#define UNICODE_TARGET_AVX2 __attribute__(( target( "avx2" ) ))
+#endif
+
+// Shuffles which move the lanes, or bytes, set in the index to the front
+struct UnicodeShuffles_t
+{
+	uint8 m_Lanes[256][16];
+	uint8 m_Bytes[256][8];
+	uint8 m_Encode3First[2][16];	// 8 lanes of 3 byte UTF-8 out of the lead and middle bytes
+	uint8 m_Encode3Third[2][16];	// and out of the last bytes
+};
+
+static constexpr UnicodeShuffles_t Unicode_BuildShuffles()
+{
+	UnicodeShuffles_t shuffles = {};
+	for ( int nMask = 0; nMask < 256; nMask++ )
+	{
+		int nLane = 0;
+		for ( int i = 0; i < 8; i++ )
+		{
+			if ( nMask & ( 1 << i ) )
+			{
+				shuffles.m_Lanes[nMask][nLane * 2] = (uint8)( i * 2 );
+				shuffles.m_Lanes[nMask][nLane * 2 + 1] = (uint8)( i * 2 + 1 );
+				shuffles.m_Bytes[nMask][nLane] = (uint8)i;
+				nLane++;
+			}
+		}
+		for ( int i = nLane; i < 8; i++ )
+		{
+			shuffles.m_Lanes[nMask][i * 2] = shuffles.m_Lanes[nMask][i * 2 + 1] = 0x80;
+			shuffles.m_Bytes[nMask][i] = 0x80;
+		}
+	}
+	for ( int i = 0; i < 32; i++ )
+	{
+		const int nLane = i / 3;
+		const int nByte = i % 3;
+		const bool bUsed = i < 24;
+		shuffles.m_Encode3First[i / 16][i % 16] = bUsed && nByte == 0 ? nLane : bUsed && nByte == 1 ? 8 + nLane : 0x80;
+		shuffles.m_Encode3Third[i / 16][i % 16] = bUsed && nByte == 2 ? nLane : 0x80;
+	}
+	return shuffles;
+}
+
+alignas( 16 ) static constexpr UnicodeShuffles_t s_UnicodeShuffles = Unicode_BuildShuffles();
+
+static inline bool Unicode_CanLoad( const void *p, bool bNullTerm, int nInChars, int nElements, int nBytes )
+{
+	// a character is at least an element, so the scalar loop would read these too
+	if ( !bNullTerm )
+		return nInChars >= nElements;
+	return ( reinterpret_cast<uintp>( p ) & 4095 ) <= static_cast<uintp>( 4096 - nBytes );
+}
+
+// Number of lanes at the start which are set, in a mask with a bit pair per lane
+static inline int Unicode_LanePrefix( unsigned nLanes )
+{
+	return std::countr_one( nLanes & 0xFFFF ) / 2;
+}
+
+static inline __m128i Unicode_CmpLtU16( __m128i a, int b )
+{
+	const __m128i bias = _mm_set1_epi16( (short)0x8000 );
+	return _mm_cmplt_epi16( _mm_xor_si128( a, bias ), _mm_set1_epi16( (short)( b ^ 0x8000 ) ) );
+}
+
+static inline __m128i Unicode_InRangeU8( __m128i a, int nLow, int nHigh )
+{
+	const __m128i offset = _mm_sub_epi8( a, _mm_set1_epi8( (char)nLow ) );
+	return _mm_cmpeq_epi8( _mm_min_epu8( offset, _mm_set1_epi8( (char)( nHigh - nLow ) ) ), offset );
+}
+
+// Lanes which are a character on their own for Q_UTF16ToUChar32, as a _mm_movemask_epi8 mask
+static inline unsigned Unicode_ValidBMPLanes( __m128i v, bool bNullTerm )
+{
+	__m128i invalid = Unicode_CmpLtU16( _mm_sub_epi16( v, _mm_set1_epi16( (short)0xD800 ) ), 0x800 );
+	invalid = _mm_or_si128( invalid, Unicode_CmpLtU16( _mm_sub_epi16( v, _mm_set1_epi16( (short)0xFDD0 ) ), 0x20 ) );
+	invalid = _mm_or_si128( invalid, _mm_cmpeq_epi16( Unicode_CmpLtU16( v, 0xFFFE ), _mm_setzero_si128() ) );
+	if ( bNullTerm )
+		invalid = _mm_or_si128( invalid, _mm_cmpeq_epi16( v, _mm_setzero_si128() ) );
+	return ~_mm_movemask_epi8( invalid ) & 0xFFFF;
+}
+
+// 8 UTF-16 or UTF-32 elements as 16 bit lanes, the ones outside of the BMP are in nInvalid
+static inline __m128i Unicode_LoadBMP( const uchar16 *p, unsigned &nInvalid )
+{
+	nInvalid = 0;
+	return _mm_loadu_si128( (const __m128i *)p );
+}
+
+static inline __m128i Unicode_LoadBMP( const uchar32 *p, unsigned &nInvalid )
+{
+	const __m128i lo = _mm_loadu_si128( (const __m128i *)p );
+	const __m128i hi = _mm_loadu_si128( (const __m128i *)( p + 4 ) );
+	const __m128i high = _mm_set1_epi32( (int)0xFFFF0000 );
+	const __m128i bmp = _mm_packs_epi32( _mm_cmpeq_epi32( _mm_and_si128( lo, high ), _mm_setzero_si128() ), _mm_cmpeq_epi32( _mm_and_si128( hi, high ), _mm_setzero_si128() ) );
+	nInvalid = ~_mm_movemask_epi8( bmp ) & 0xFFFF;
+
+	// biased so the signed pack doesn't saturate
+	const __m128i bias = _mm_set1_epi32( 0x8000 );
+	return _mm_add_epi16( _mm_packs_epi32( _mm_sub_epi32( lo, bias ), _mm_sub_epi32( hi, bias ) ), _mm_set1_epi16( (short)0x8000 ) );
+}
+
+static inline void Unicode_StoreLanes( uchar16 *p, __m128i v )
+{
+	_mm_storeu_si128( (__m128i *)p, v );
+}
+
+static inline void Unicode_StoreLanes( uchar32 *p, __m128i v )
+{
+	_mm_storeu_si128( (__m128i *)p, _mm_unpacklo_epi16( v, _mm_setzero_si128() ) );
+	_mm_storeu_si128( (__m128i *)( p + 4 ), _mm_unpackhi_epi16( v, _mm_setzero_si128() ) );
+}
+
+UNICODE_TARGET_AVX2 static inline void Unicode_StoreAscii( uchar16 *p, __m256i b )
+{
+	_mm256_storeu_si256( (__m256i *)p, _mm256_cvtepu8_epi16( _mm256_castsi256_si128( b ) ) );
+	_mm256_storeu_si256( (__m256i *)( p + 16 ), _mm256_cvtepu8_epi16( _mm256_extracti128_si256( b, 1 ) ) );
+}
+
+UNICODE_TARGET_AVX2 static inline void Unicode_StoreAscii( uchar32 *p, __m256i b )
+{
+	const __m128i lo = _mm256_castsi256_si128( b );
+	const __m128i hi = _mm256_extracti128_si256( b, 1 );
+	_mm256_storeu_si256( (__m256i *)p, _mm256_cvtepu8_epi32( lo ) );
+	_mm256_storeu_si256( (__m256i *)( p + 8 ), _mm256_cvtepu8_epi32( _mm_srli_si128( lo, 8 ) ) );
+	_mm256_storeu_si256( (__m256i *)( p + 16 ), _mm256_cvtepu8_epi32( hi ) );
+	_mm256_storeu_si256( (__m256i *)( p + 24 ), _mm256_cvtepu8_epi32( _mm_srli_si128( hi, 8 ) ) );
+}
+
+// Widens a 16 byte block, returns how many ASCII characters it starts with
+template < typename DstType >
+static inline int Unicode_AsciiPrefix( const uint8 *p, bool bNullTerm, DstType *pOut )
+{
+	const __m128i b = _mm_loadu_si128( (const __m128i *)p );
+	unsigned nStop = _mm_movemask_epi8( b );
+	if ( bNullTerm )
+		nStop |= _mm_movemask_epi8( _mm_cmpeq_epi8( b, _mm_setzero_si128() ) );
+	if ( pOut )
+	{
+		Unicode_StoreLanes( pOut, _mm_unpacklo_epi8( b, _mm_setzero_si128() ) );
+		Unicode_StoreLanes( pOut + 8, _mm_unpackhi_epi8( b, _mm_setzero_si128() ) );
+	}
+	return std::countr_zero( nStop | 0x10000 );
+}
+
+// Decodes the 1, 2 and 3 byte sequences at the start of a 16 byte window, returns the bytes used.
+// Only the leads which can't make an overlong, a surrogate or a noncharacter are taken.
+template < typename DstType >
+UNICODE_TARGET_AVX2 static inline int Unicode_DecodeUTF8Window( const uint8 *p, bool bNullTerm, DstType *pOut, int &nChars )
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i b = _mm_loadu_si128( (const __m128i *)p );
+	const __m128i lead2 = Unicode_InRangeU8( b, 0xC2, 0xDF );
+	const __m128i lead3 = _mm_or_si128( Unicode_InRangeU8( b, 0xE1, 0xEC ), _mm_cmpeq_epi8( b, _mm_set1_epi8( (char)0xEE ) ) );
+	const __m128i cont = _mm_cmpeq_epi8( _mm_and_si128( b, _mm_set1_epi8( (char)0xC0 ) ), _mm_set1_epi8( (char)0x80 ) );
+
+	unsigned nAscii = ~_mm_movemask_epi8( b ) & 0xFFFF;
+	if ( bNullTerm )
+		nAscii &= ~_mm_movemask_epi8( _mm_cmpeq_epi8( b, zero ) );
+	const unsigned nLead2 = _mm_movemask_epi8( lead2 );
+	const unsigned nLead3 = _mm_movemask_epi8( lead3 );
+	const unsigned nCont = _mm_movemask_epi8( cont );
+
+	// everything up to the first byte which isn't taken, or isn't a continuation byte exactly where a lead wants one
+	const unsigned nBad = ( ~( nAscii | nLead2 | nLead3 | nCont ) | ( nCont ^ ( ( nLead2 | nLead3 ) << 1 | nLead3 << 2 ) ) ) | 0x10000;
+	const unsigned nGood = ( 1u << std::countr_zero( nBad ) ) - 1;
+
+	// and without the sequences which don't end before it
+	const unsigned nCut = ( nLead2 & ~( nGood >> 1 ) ) | ( nLead3 & ~( nGood >> 2 ) ) | ( nGood + 1 );
+	const int nBytes = std::countr_zero( nCut );
+	const unsigned nStarts = ( nAscii | nLead2 | nLead3 ) & ( ( 1u << nBytes ) - 1 );
+	nChars = std::popcount( nStarts );
+
+	if ( pOut && nBytes )
+	{
+		const __m128i low6 = _mm_set1_epi8( 0x3F );
+		const __m128i b1 = _mm_and_si128( _mm_srli_si128( b, 1 ), low6 );
+		const __m128i b2 = _mm_and_si128( _mm_srli_si128( b, 2 ), low6 );
+		const __m128i lo6 = _mm_set1_epi16( 0x1F );
+
+		// the value of a sequence starting at every byte, 8 at a time
+		__m128i byte0 = _mm_unpacklo_epi8( b, zero );
+		__m128i byte1 = _mm_unpacklo_epi8( b1, zero );
+		__m128i byte2 = _mm_unpacklo_epi8( b2, zero );
+		__m128i value2 = _mm_or_si128( _mm_slli_epi16( _mm_and_si128( byte0, lo6 ), 6 ), byte1 );
+		__m128i value3 = _mm_or_si128( _mm_or_si128( _mm_slli_epi16( byte0, 12 ), _mm_slli_epi16( byte1, 6 ) ), byte2 );
+		__m128i values = _mm_blendv_epi8( _mm_blendv_epi8( byte0, value2, _mm_unpacklo_epi8( lead2, lead2 ) ), value3, _mm_unpacklo_epi8( lead3, lead3 ) );
+		Unicode_StoreLanes( pOut, _mm_shuffle_epi8( values, _mm_load_si128( (const __m128i *)s_UnicodeShuffles.m_Lanes[nStarts & 0xFF] ) ) );
+
+		byte0 = _mm_unpackhi_epi8( b, zero );
+		byte1 = _mm_unpackhi_epi8( b1, zero );
+		byte2 = _mm_unpackhi_epi8( b2, zero );
+		value2 = _mm_or_si128( _mm_slli_epi16( _mm_and_si128( byte0, lo6 ), 6 ), byte1 );
+		value3 = _mm_or_si128( _mm_or_si128( _mm_slli_epi16( byte0, 12 ), _mm_slli_epi16( byte1, 6 ) ), byte2 );
+		values = _mm_blendv_epi8( _mm_blendv_epi8( byte0, value2, _mm_unpackhi_epi8( lead2, lead2 ) ), value3, _mm_unpackhi_epi8( lead3, lead3 ) );
+		Unicode_StoreLanes( pOut + std::popcount( nStarts & 0xFF ), _mm_shuffle_epi8( values, _mm_load_si128( (const __m128i *)s_UnicodeShuffles.m_Lanes[nStarts >> 8] ) ) );
+	}
+	return nBytes;
+}
+
+// Encodes the first nLanes lanes, all below 0x800, as UTF-8; returns the bytes written
+UNICODE_TARGET_AVX2 static inline int Unicode_EncodeUTF8Short( __m128i v, int nLanes, char *pOut )
+{
+	const __m128i two = _mm_cmpeq_epi16( Unicode_CmpLtU16( v, 0x80 ), _mm_setzero_si128() );
+	unsigned nKeep = _mm_movemask_epi8( _mm_or_si128( _mm_and_si128( two, _mm_set1_epi16( (short)0xFF00 ) ), _mm_set1_epi16( 0x00FF ) ) );
+	nKeep &= ( 1u << ( nLanes * 2 ) ) - 1;
+	const int nLow = std::popcount( nKeep & 0xFF );
+
+	if ( pOut )
+	{
+		const __m128i lead = _mm_blendv_epi8( v, _mm_or_si128( _mm_srli_epi16( v, 6 ), _mm_set1_epi16( 0xC0 ) ), two );
+		const __m128i trail = _mm_or_si128( _mm_and_si128( v, _mm_set1_epi16( 0x3F ) ), _mm_set1_epi16( 0x80 ) );
+		const __m128i bytes = _mm_or_si128( lead, _mm_slli_epi16( trail, 8 ) );
+		_mm_storel_epi64( (__m128i *)pOut, _mm_shuffle_epi8( bytes, _mm_loadl_epi64( (const __m128i *)s_UnicodeShuffles.m_Bytes[nKeep & 0xFF] ) ) );
+		_mm_storel_epi64( (__m128i *)( pOut + nLow ), _mm_shuffle_epi8( _mm_srli_si128( bytes, 8 ), _mm_loadl_epi64( (const __m128i *)s_UnicodeShuffles.m_Bytes[nKeep >> 8] ) ) );
+	}
+	return nLow + std::popcount( nKeep >> 8 );
+}
+
+// Encodes 8 lanes, all 0x800 and above, as 24 bytes of UTF-8
+UNICODE_TARGET_AVX2 static inline void Unicode_EncodeUTF8Long( __m128i v, char *pOut )
+{
+	const __m128i low6 = _mm_set1_epi16( 0x3F );
+	const __m128i cont = _mm_set1_epi16( 0x80 );
+	const __m128i byte0 = _mm_or_si128( _mm_srli_epi16( v, 12 ), _mm_set1_epi16( 0xE0 ) );
+	const __m128i byte1 = _mm_or_si128( _mm_and_si128( _mm_srli_epi16( v, 6 ), low6 ), cont );
+	const __m128i byte2 = _mm_or_si128( _mm_and_si128( v, low6 ), cont );
+	const __m128i first = _mm_packus_epi16( byte0, byte1 );
+	const __m128i third = _mm_packus_epi16( byte2, byte2 );
+
+	const __m128i lo = _mm_or_si128( _mm_shuffle_epi8( first, _mm_load_si128( (const __m128i *)s_UnicodeShuffles.m_Encode3First[0] ) ), _mm_shuffle_epi8( third, _mm_load_si128( (const __m128i *)s_UnicodeShuffles.m_Encode3Third[0] ) ) );
+	const __m128i hi = _mm_or_si128( _mm_shuffle_epi8( first, _mm_load_si128( (const __m128i *)s_UnicodeShuffles.m_Encode3First[1] ) ), _mm_shuffle_epi8( third, _mm_load_si128( (const __m128i *)s_UnicodeShuffles.m_Encode3Third[1] ) ) );
+	_mm_storeu_si128( (__m128i *)pOut, lo );
+	_mm_storel_epi64( (__m128i *)( pOut + 16 ), hi );
+}
+
+template < typename DstType >
+static int Unicode_UTF8Run_SSE2( const uint8 *pIn, int nInChars, DstType *pOut, int nOutRoom, int &nOut )
+{
+	const bool bNullTerm = nInChars < 0;
+	int nIn = 0;
+	nOut = 0;
+	while ( nOutRoom - nOut >= 16 && Unicode_CanLoad( pIn + nIn, bNullTerm, nInChars - nIn, 16, 16 ) )
+	{
+		const int nAscii = Unicode_AsciiPrefix( pIn + nIn, bNullTerm, pOut ? pOut + nOut : NULL );
+		nIn += nAscii;
+		nOut += nAscii;
+		if ( nAscii < 16 )
+			break;
+	}
+	return nIn;
+}
+
+template < typename DstType >
+UNICODE_TARGET_AVX2 static int Unicode_UTF8Run_AVX2( const uint8 *pIn, int nInChars, DstType *pOut, int nOutRoom, int &nOut )
+{
+	const bool bNullTerm = nInChars < 0;
+	int nIn = 0;
+	nOut = 0;
+	for ( ;; )
+	{
+		const uint8 *p = pIn + nIn;
+		if ( nOutRoom - nOut >= 32 && Unicode_CanLoad( p, bNullTerm, nInChars - nIn, 32, 32 ) )
+		{
+			const __m256i b = _mm256_loadu_si256( (const __m256i *)p );
+			unsigned nStop = _mm256_movemask_epi8( b );
+			if ( bNullTerm )
+				nStop |= _mm256_movemask_epi8( _mm256_cmpeq_epi8( b, _mm256_setzero_si256() ) );
+			if ( nStop == 0 )
+			{
+				if ( pOut )
+					Unicode_StoreAscii( pOut + nOut, b );
+				nIn += 32;
+				nOut += 32;
+				continue;
+			}
+		}
+
+		if ( nOutRoom - nOut < 16 || !Unicode_CanLoad( p, bNullTerm, nInChars - nIn, 16, 16 ) )
+			break;
+
+		int nChars;
+		const int nBytes = Unicode_DecodeUTF8Window( p, bNullTerm, pOut ? pOut + nOut : NULL, nChars );
+		if ( nBytes == 0 )
+			break;
+		nIn += nBytes;
+		nOut += nChars;
+	}
+	return nIn;
+}
+
+template < typename SrcType >
+static int Unicode_EncodeUTF8Run_SSE2( const SrcType *pIn, int nInChars, char *pOut, int nOutRoom, int &nOut )
+{
+	const bool bNullTerm = nInChars < 0;
+	int nIn = 0;
+	nOut = 0;
+	while ( nOutRoom - nOut >= 8 && Unicode_CanLoad( pIn + nIn, bNullTerm, nInChars - nIn, 8, 8 * sizeof( SrcType ) ) )
+	{
+		unsigned nInvalid;
+		const __m128i v = Unicode_LoadBMP( pIn + nIn, nInvalid );
+		const unsigned nValid = Unicode_ValidBMPLanes( v, bNullTerm ) & ~nInvalid;
+		const int nLanes = Unicode_LanePrefix( nValid & _mm_movemask_epi8( Unicode_CmpLtU16( v, 0x80 ) ) );
+		if ( pOut )
+			_mm_storel_epi64( (__m128i *)( pOut + nOut ), _mm_packus_epi16( v, v ) );
+		nIn += nLanes;
+		nOut += nLanes;
+		if ( nLanes < 8 )
+			break;
+	}
+	return nIn;
+}
+
+template < typename SrcType >
+UNICODE_TARGET_AVX2 static int Unicode_EncodeUTF8Run_AVX2( const SrcType *pIn, int nInChars, char *pOut, int nOutRoom, int &nOut )
+{
+	const bool bNullTerm = nInChars < 0;
+	int nIn = 0;
+	nOut = 0;
+	for ( ;; )
+	{
+		if ( nOutRoom - nOut >= 16 && Unicode_CanLoad( pIn + nIn, bNullTerm, nInChars - nIn, 16, 16 * sizeof( SrcType ) ) )
+		{
+			unsigned nInvalidLo, nInvalidHi;
+			const __m128i lo = Unicode_LoadBMP( pIn + nIn, nInvalidLo );
+			const __m128i hi = Unicode_LoadBMP( pIn + nIn + 8, nInvalidHi );
+			const __m128i ascii = _mm_and_si128( Unicode_CmpLtU16( lo, 0x80 ), Unicode_CmpLtU16( hi, 0x80 ) );
+			__m128i nonzero = _mm_set1_epi16( -1 );
+			if ( bNullTerm )
+				nonzero = _mm_cmpeq_epi16( _mm_or_si128( _mm_cmpeq_epi16( lo, _mm_setzero_si128() ), _mm_cmpeq_epi16( hi, _mm_setzero_si128() ) ), _mm_setzero_si128() );
+			if ( ( nInvalidLo | nInvalidHi ) == 0 && _mm_movemask_epi8( _mm_and_si128( ascii, nonzero ) ) == 0xFFFF )
+			{
+				if ( pOut )
+					_mm_storeu_si128( (__m128i *)( pOut + nOut ), _mm_packus_epi16( lo, hi ) );
+				nIn += 16;
+				nOut += 16;
+				continue;
+			}
+		}
+
+		if ( nOutRoom - nOut < 24 || !Unicode_CanLoad( pIn + nIn, bNullTerm, nInChars - nIn, 8, 8 * sizeof( SrcType ) ) )
+			break;
+
+		unsigned nInvalid;
+		const __m128i v = Unicode_LoadBMP( pIn + nIn, nInvalid );
+		const unsigned nValid = Unicode_ValidBMPLanes( v, bNullTerm ) & ~nInvalid;
+		const unsigned nShort = _mm_movemask_epi8( Unicode_CmpLtU16( v, 0x800 ) );
+
+		// as many lanes as there are of the same UTF-8 length class as the first
+		int nLanes, nBytes;
+		if ( nShort & 1 )
+		{
+			nLanes = Unicode_LanePrefix( nValid & nShort );
+			nBytes = Unicode_EncodeUTF8Short( v, nLanes, pOut ? pOut + nOut : NULL );
+		}
+		else
+		{
+			nLanes = Unicode_LanePrefix( nValid & ~nShort );
+			nBytes = nLanes * 3;
+			if ( pOut )
+				Unicode_EncodeUTF8Long( v, pOut + nOut );
+		}
+		if ( nLanes == 0 )
+			break;
+		nIn += nLanes;
+		nOut += nBytes;
+	}
+	return nIn;
+}
+
+// UTF-16 and UTF-32, both ways
+template < typename SrcType, typename DstType >
+static int Unicode_WideRun( const SrcType *pIn, int nInChars, DstType *pOut, int nOutRoom, int &nOut )
+{
+	const bool bNullTerm = nInChars < 0;
+	int nIn = 0;
+	nOut = 0;
+	while ( nOutRoom - nOut >= 8 && Unicode_CanLoad( pIn + nIn, bNullTerm, nInChars - nIn, 8, 8 * sizeof( SrcType ) ) )
+	{
+		unsigned nInvalid;
+		const __m128i v = Unicode_LoadBMP( pIn + nIn, nInvalid );
+		const int nLanes = Unicode_LanePrefix( Unicode_ValidBMPLanes( v, bNullTerm ) & ~nInvalid );
+		if ( pOut )
+			Unicode_StoreLanes( pOut + nOut, v );
+		nIn += nLanes;
+		nOut += nLanes;
+		if ( nLanes < 8 )
+			break;
+	}
+	return nIn;
+}
+
+// Starts at stubs which pick the implementations, so they work during static init too
+static int Unicode_UTF8ToUTF16Run_Select( const uint8 *pIn, int nInChars, uchar16 *pOut, int nOutRoom, int &nOut );
+static int Unicode_UTF8ToUTF32Run_Select( const uint8 *pIn, int nInChars, uchar32 *pOut, int nOutRoom, int &nOut );
+static int Unicode_UTF16ToUTF8Run_Select( const uchar16 *pIn, int nInChars, char *pOut, int nOutRoom, int &nOut );
+static int Unicode_UTF32ToUTF8Run_Select( const uchar32 *pIn, int nInChars, char *pOut, int nOutRoom, int &nOut );
+
+static int ( *s_pfnUTF8ToUTF16Run )( const uint8 *, int, uchar16 *, int, int & ) = Unicode_UTF8ToUTF16Run_Select;
+static int ( *s_pfnUTF8ToUTF32Run )( const uint8 *, int, uchar32 *, int, int & ) = Unicode_UTF8ToUTF32Run_Select;
+static int ( *s_pfnUTF16ToUTF8Run )( const uchar16 *, int, char *, int, int & ) = Unicode_UTF16ToUTF8Run_Select;
+static int ( *s_pfnUTF32ToUTF8Run )( const uchar32 *, int, char *, int, int & ) = Unicode_UTF32ToUTF8Run_Select;
+
+static void Unicode_SelectImplementations()
+{
+	const bool bAVX2 = CheckAVX2Technology();
+	s_pfnUTF8ToUTF16Run = bAVX2 ? Unicode_UTF8Run_AVX2<uchar16> : Unicode_UTF8Run_SSE2<uchar16>;
+	s_pfnUTF8ToUTF32Run = bAVX2 ? Unicode_UTF8Run_AVX2<uchar32> : Unicode_UTF8Run_SSE2<uchar32>;
+	s_pfnUTF16ToUTF8Run = bAVX2 ? Unicode_EncodeUTF8Run_AVX2<uchar16> : Unicode_EncodeUTF8Run_SSE2<uchar16>;
+	s_pfnUTF32ToUTF8Run = bAVX2 ? Unicode_EncodeUTF8Run_AVX2<uchar32> : Unicode_EncodeUTF8Run_SSE2<uchar32>;
+}
+
+static int Unicode_UTF8ToUTF16Run_Select( const uint8 *pIn, int nInChars, uchar16 *pOut, int nOutRoom, int &nOut )
+{
+	Unicode_SelectImplementations();
+	return s_pfnUTF8ToUTF16Run( pIn, nInChars, pOut, nOutRoom, nOut );
+}
+
+static int Unicode_UTF8ToUTF32Run_Select( const uint8 *pIn, int nInChars, uchar32 *pOut, int nOutRoom, int &nOut )
+{
+	Unicode_SelectImplementations();
+	return s_pfnUTF8ToUTF32Run( pIn, nInChars, pOut, nOutRoom, nOut );
+}
+
+static int Unicode_UTF16ToUTF8Run_Select( const uchar16 *pIn, int nInChars, char *pOut, int nOutRoom, int &nOut )
+{
+	Unicode_SelectImplementations();
+	return s_pfnUTF16ToUTF8Run( pIn, nInChars, pOut, nOutRoom, nOut );
+}
+
+static int Unicode_UTF32ToUTF8Run_Select( const uchar32 *pIn, int nInChars, char *pOut, int nOutRoom, int &nOut )
+{
+	Unicode_SelectImplementations();
+	return s_pfnUTF32ToUTF8Run( pIn, nInChars, pOut, nOutRoom, nOut );
+}
+
 namespace // internal use only
 {
 	// Identity transformations and validity tests for use with Q_UnicodeConvertT
@@ -228,6 +685,67 @@ namespace // internal use only
 		return 1;
 	}
 
+	// Bulk conversion of the characters at the start of the input, see the SIMD runs above.
+	// nInChars is negative for null terminated input; returns the input elements used, nOut the output ones
+	template < typename SrcType, typename DstType >
+	int Q_UnicodeRun( const SrcType *pIn, int nInChars, DstType *pOut, int nOutRoom, int &nOut )
+	{
+		nOut = 0;
+		return 0;
+	}
+
+	int Q_UnicodeRun( const char *pIn, int nInChars, uchar16 *pOut, int nOutRoom, int &nOut )
+	{
+		return s_pfnUTF8ToUTF16Run( (const uint8 *)pIn, nInChars, pOut, nOutRoom, nOut );
+	}
+
+	int Q_UnicodeRun( const char *pIn, int nInChars, uchar32 *pOut, int nOutRoom, int &nOut )
+	{
+		return s_pfnUTF8ToUTF32Run( (const uint8 *)pIn, nInChars, pOut, nOutRoom, nOut );
+	}
+
+	int Q_UnicodeRun( const uchar16 *pIn, int nInChars, char *pOut, int nOutRoom, int &nOut )
+	{
+		return s_pfnUTF16ToUTF8Run( pIn, nInChars, pOut, nOutRoom, nOut );
+	}
+
+	int Q_UnicodeRun( const uchar32 *pIn, int nInChars, char *pOut, int nOutRoom, int &nOut )
+	{
+		return s_pfnUTF32ToUTF8Run( pIn, nInChars, pOut, nOutRoom, nOut );
+	}
+
+	int Q_UnicodeRun( const uchar16 *pIn, int nInChars, uchar32 *pOut, int nOutRoom, int &nOut )
+	{
+		return Unicode_WideRun( pIn, nInChars, pOut, nOutRoom, nOut );
+	}
+
+	int Q_UnicodeRun( const uchar32 *pIn, int nInChars, uchar16 *pOut, int nOutRoom, int &nOut )
+	{
+		return Unicode_WideRun( pIn, nInChars, pOut, nOutRoom, nOut );
+	}
+
+	// Runs which found nothing aren't tried again for a few characters, text which doesn't suit them would only pay for the attempts
+	template < typename SrcType, typename DstType >
+	int Q_UnicodeRunBackoff( const SrcType *pIn, int nInChars, DstType *pOut, int nOutRoom, int &nOut, int &nSkip )
+	{
+		if ( nSkip > 0 )
+		{
+			nSkip--;
+			nOut = 0;
+			return 0;
+		}
+		const int nIn = Q_UnicodeRun( pIn, nInChars, pOut, nOutRoom, nOut );
+		nSkip = nIn ? 0 : 8;
+		return nIn;
+	}
+
+	// Runs come in BMP characters only: a UTF-8 source has one per output element, the others one per input element
+	template < typename SrcType >
+	int Q_UnicodeRunChars( int nIn, int nOut )
+	{
+		return sizeof( SrcType ) == 1 ? nOut : nIn;
+	}
+
 	// A generic Unicode processing loop: decode one character from input to uchar32, handle errors, encode uchar32 to output
 	template < typename SrcType, typename DstType, bool bStopAtNull, int (&DecodeSrc)( const SrcType*, uchar32&, bool& ), int (&EncodeDstLen)( uchar32 ), int (&EncodeDst)( uchar32, DstType* ) >
 	int Q_UnicodeConvertT( const SrcType *pIn, int nInChars, DstType *pOut, int nOutBytes, EStringConvertErrorPolicy ePolicy )
@@ -242,10 +760,21 @@ namespace // internal use only
 
 		int nOut = 0;
 
+		int nSkipRuns = 0;
 		if ( !pOut )
 		{
-			while ( bStopAtNull ? ( *pIn ) : ( nInChars-- > 0 ) )
+			for ( ;; )
 			{
+				int nRunOut;
+				const int nRunIn = Q_UnicodeRunBackoff( pIn, bStopAtNull ? -1 : nInChars, (DstType *)NULL, INT_MAX, nRunOut, nSkipRuns );
+				pIn += nRunIn;
+				nOut += nRunOut;
+				if ( !bStopAtNull )
+					nInChars -= Q_UnicodeRunChars<SrcType>( nRunIn, nRunOut );
+
+				if ( !( bStopAtNull ? ( *pIn ) : ( nInChars-- > 0 ) ) )
+					break;
+
 				uchar32 uVal;
 				// Initialize in order to avoid /analyze warnings.
 				bool bErr = false;
@@ -262,7 +791,6 @@ namespace // internal use only
 					}
 					else if ( ePolicy & _STRINGCONVERTFLAG_FAIL )
 					{
-						pOut[0] = 0;
 						return 0;
 					}
 				}
@@ -275,8 +803,18 @@ namespace // internal use only
 				return 0;
 
 			int nMaxOut = nOutElems - 1;
-			while ( bStopAtNull ? ( *pIn ) : ( nInChars-- > 0 ) )
+			for ( ;; )
 			{
+				int nRunOut;
+				const int nRunIn = Q_UnicodeRunBackoff( pIn, bStopAtNull ? -1 : nInChars, pOut + nOut, nMaxOut - nOut, nRunOut, nSkipRuns );
+				pIn += nRunIn;
+				nOut += nRunOut;
+				if ( !bStopAtNull )
+					nInChars -= Q_UnicodeRunChars<SrcType>( nRunIn, nRunOut );
+
+				if ( !( bStopAtNull ? ( *pIn ) : ( nInChars-- > 0 ) ) )
+					break;
+
 				uchar32 uVal;
 				// Initialize in order to avoid /analyze warnings.
 				bool bErr = false;
@@ -313,8 +851,15 @@ namespace // internal use only
 bool Q_UnicodeValidate( const char *pUTF8 )
 {
 	bool bError = false;
-	while ( *pUTF8 )
+	int nSkipRuns = 0;
+	for ( ;; )
 	{
+		// runs only take valid characters
+		int nRunChars;
+		pUTF8 += Q_UnicodeRunBackoff( pUTF8, -1, (uchar32 *)NULL, INT_MAX, nRunChars, nSkipRuns );
+		if ( !*pUTF8 )
+			break;
+
 		uchar32 uVal;
 		// Our UTF-8 decoder silently fixes up 6-byte CESU-8 (improperly re-encoded UTF-16) sequences.
 		// However, these are technically not valid UTF-8. So if we eat 6 bytes at once, it's an error.
@@ -332,8 +877,14 @@ bool Q_UnicodeValidate( const char *pUTF8 )
 bool Q_UnicodeValidate( const uchar16 *pUTF16 )
 {
 	bool bError = false;
-	while ( *pUTF16 )
+	int nSkipRuns = 0;
+	for ( ;; )
 	{
+		int nRunChars;
+		pUTF16 += Q_UnicodeRunBackoff( pUTF16, -1, (uchar32 *)NULL, INT_MAX, nRunChars, nSkipRuns );
+		if ( !*pUTF16 )
+			break;
+
 		uchar32 uVal;
 		pUTF16 += Q_UTF16ToUChar32( pUTF16, uVal, bError );
 		if ( bError )
@@ -351,7 +902,6 @@ bool Q_UnicodeValidate( const uchar32 *pUTF32 )
 	{
 		if ( !Q_IsValidUChar32( *pUTF32++ ) )
 			return false;
-		++pUTF32;
 	}
 	return true;
 }
@@ -362,8 +912,15 @@ bool Q_UnicodeValidate( const uchar32 *pUTF32 )
 int Q_UnicodeLength( const char *pUTF8 )
 {
 	int nChars = 0;
-	while ( *pUTF8 )
+	int nSkipRuns = 0;
+	for ( ;; )
 	{
+		int nRunChars;
+		pUTF8 += Q_UnicodeRunBackoff( pUTF8, -1, (uchar32 *)NULL, INT_MAX, nRunChars, nSkipRuns );
+		nChars += nRunChars;
+		if ( !*pUTF8 )
+			break;
+
 		bool bError;
 		uchar32 uVal;
 		pUTF8 += Q_UTF8ToUChar32( pUTF8, uVal, bError );
@@ -378,8 +935,15 @@ int Q_UnicodeLength( const char *pUTF8 )
 int Q_UnicodeLength( const uchar16 *pUTF16 )
 {
 	int nChars = 0;
-	while ( *pUTF16 )
+	int nSkipRuns = 0;
+	for ( ;; )
 	{
+		int nRunChars;
+		pUTF16 += Q_UnicodeRunBackoff( pUTF16, -1, (uchar32 *)NULL, INT_MAX, nRunChars, nSkipRuns );
+		nChars += nRunChars;
+		if ( !*pUTF16 )
+			break;
+
 		bool bError;
 		uchar32 uVal;
 		pUTF16 += Q_UTF16ToUChar32( pUTF16, uVal, bError );
@@ -14,6 +14,7 @@ set( TIER1_SOURCE_FILES
 	"${TIER1_DIR}/convar.cpp"
 	"${TIER1_DIR}/datamanager.cpp"
 	"${TIER1_DIR}/diff.cpp"
+	"${TIER1_DIR}/functorarena.cpp"
 	"${TIER1_DIR}/generichash.cpp"
 	"${TIER1_DIR}/ilocalize.cpp"
 	"${TIER1_DIR}/interface.cpp"
@@ -33,6 +34,7 @@ set( TIER1_SOURCE_FILES
 
 	"${TIER1_DIR}/rangecheckedvar.cpp"
 	"${TIER1_DIR}/reliabletimer.cpp"
+	"${TIER1_DIR}/scratcharena.cpp"
 	"${TIER1_DIR}/stringpool.cpp"
 	"${TIER1_DIR}/strtools.cpp"
 	"${TIER1_DIR}/strtools_unicode.cpp"
@@ -41,6 +43,7 @@ set( TIER1_SOURCE_FILES
 	"${TIER1_DIR}/sparsematrix.cpp"
 	"${TIER1_DIR}/utlbuffer.cpp"
 	"${TIER1_DIR}/utlbufferutil.cpp"
+	"${TIER1_DIR}/utlsegmentedbuffer.cpp"
 	"${TIER1_DIR}/utlstring.cpp"
 	"${TIER1_DIR}/utlsymbol.cpp"
 	"${TIER1_DIR}/utlbinaryblock.cpp"
@@ -60,6 +63,7 @@ set( TIER1_SOURCE_FILES
 	# Header Files
 
 	# Internal Header Files
+	"${TIER1_DIR}/checksum_multibuffer.h"
 	"${TIER1_DIR}/snappy-internal.h"
 	"${TIER1_DIR}/snappy-stubs-internal.h"
 
@@ -78,6 +82,7 @@ set( TIER1_SOURCE_FILES
 	"${SRCDIR}/public/tier1/delegates.h"
 	"${SRCDIR}/public/tier1/diff.h"
 	"${SRCDIR}/public/tier1/fmtstr.h"
+	"${SRCDIR}/public/tier1/functorarena.h"
 	"${SRCDIR}/public/tier1/functors.h"
 	"${SRCDIR}/public/tier1/generichash.h"
 	"${SRCDIR}/public/tier1/iconvar.h"
@@ -85,6 +90,7 @@ set( TIER1_SOURCE_FILES
 	"${SRCDIR}/public/tier1/interface.h"
 	"${SRCDIR}/public/tier1/KeyValues.h"
 	"${SRCDIR}/public/tier1/kvpacker.h"
+	"${SRCDIR}/public/tier1/lockfreequeue.h"
 	"${SRCDIR}/public/tier1/lzmaDecoder.h"
 	"${SRCDIR}/public/tier1/lzss.h"
 	"${SRCDIR}/public/tier1/mempool.h"
@@ -93,6 +99,7 @@ set( TIER1_SOURCE_FILES
 	"${SRCDIR}/public/tier1/processor_detect.h"
 	"${SRCDIR}/public/tier1/rangecheckedvar.h"
 	"${SRCDIR}/public/tier1/refcount.h"
+	"${SRCDIR}/public/tier1/scratcharena.h"
 	"${SRCDIR}/public/tier1/smartptr.h"
 	"${SRCDIR}/public/tier1/snappy.h"
 	"${SRCDIR}/public/tier1/snappy-sinksource.h"
@@ -108,6 +115,7 @@ set( TIER1_SOURCE_FILES
 	"${SRCDIR}/public/tier1/utldict.h"
 	"${SRCDIR}/public/tier1/utlenvelope.h"
 	"${SRCDIR}/public/tier1/utlfixedmemory.h"
+	"${SRCDIR}/public/tier1/utlflathashmap.h"
 	"${SRCDIR}/public/tier1/utlhandletable.h"
 	"${SRCDIR}/public/tier1/utlhash.h"
 	"${SRCDIR}/public/tier1/utlhashtable.h"
@@ -118,6 +126,7 @@ set( TIER1_SOURCE_FILES
 	"${SRCDIR}/public/tier1/utlpriorityqueue.h"
 	"${SRCDIR}/public/tier1/utlqueue.h"
 	"${SRCDIR}/public/tier1/utlrbtree.h"
+	"${SRCDIR}/public/tier1/utlsegmentedbuffer.h"
 	"${SRCDIR}/public/tier1/UtlSortVector.h"
 	"${SRCDIR}/public/tier1/utlstack.h"
 	"${SRCDIR}/public/tier1/utlstring.h"
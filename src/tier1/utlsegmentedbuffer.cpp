@@ -0,0 +1,297 @@
+//
+// Created by ENDERZOMBI102 on 18/10/2026.
+//
+#include "tier1/utlsegmentedbuffer.h"
+#include "filesystem.h"
+
+
+CUtlSegmentedBuffer::CUtlSegmentedBuffer( int nSegmentSize ) : m_nSegmentSize( nSegmentSize ) {
+	Assert( nSegmentSize > 0 );
+}
+
+CUtlSegmentedBuffer::~CUtlSegmentedBuffer() {
+	Purge();
+}
+
+void CUtlSegmentedBuffer::Swap( CUtlSegmentedBuffer& other ) {
+	m_Segments.Swap( other.m_Segments );
+	m_SpareSegments.Swap( other.m_SpareSegments );
+	V_swap( m_nSegmentSize, other.m_nSegmentSize );
+	V_swap( m_nPut, other.m_nPut );
+	V_swap( m_nGet, other.m_nGet );
+	V_swap( m_nGetSegment, other.m_nGetSegment );
+	V_swap( m_nGetOffset, other.m_nGetOffset );
+	V_swap( m_bGetOverflow, other.m_bGetOverflow );
+	V_swap( m_Byteswap, other.m_Byteswap );
+}
+
+void CUtlSegmentedBuffer::Clear() {
+	for ( auto& segment : m_Segments ) {
+		ReleaseSegment( segment, true );
+	}
+	m_Segments.RemoveAll();
+	m_nPut = 0;
+	m_nGet = 0;
+	m_nGetSegment = 0;
+	m_nGetOffset = 0;
+	m_bGetOverflow = false;
+}
+
+void CUtlSegmentedBuffer::Purge() {
+	Clear();
+	for ( auto pSpare : m_SpareSegments ) {
+		delete[] pSpare;
+	}
+	m_SpareSegments.Purge();
+	m_Segments.Purge();
+}
+
+void CUtlSegmentedBuffer::Get( void* pMem, int nSize ) {
+	if ( nSize <= 0 ) {
+		return;
+	}
+	if ( not IsValid() or nSize > GetBytesRemaining() ) {
+		memset( pMem, 0, nSize );
+		m_bGetOverflow = true;
+		return;
+	}
+
+	auto pDest{ static_cast<byte*>( pMem ) };
+	while ( nSize > 0 ) {
+		SkipExhaustedSegments();
+		const auto& segment{ m_Segments[ m_nGetSegment ] };
+		const auto nCopy{ MIN( segment.m_nSize - m_nGetOffset, nSize ) };
+		memcpy( pDest, segment.m_pData + m_nGetOffset, nCopy );
+		m_nGetOffset += nCopy;
+		m_nGet += nCopy;
+		pDest += nCopy;
+		nSize -= nCopy;
+	}
+}
+
+int CUtlSegmentedBuffer::GetUpTo( void* pMem, int nSize ) {
+	const auto nRead{ MIN( nSize, GetBytesRemaining() ) };
+	Get( pMem, nRead );
+	return nRead;
+}
+
+void CUtlSegmentedBuffer::GetStringInternal( char* pString, size_t maxLenInChars ) {
+	if (! IsValid() ) {
+		*pString = 0;
+		return;
+	}
+	if ( maxLenInChars == 0 ) {
+		return;
+	}
+
+	// find the terminator, it may be a few segments away
+	auto nLen{ -1 };
+	auto nScanned{ 0 };
+	for ( auto i{ m_nGetSegment }; i < m_Segments.Count() and nLen == -1; i += 1 ) {
+		const auto& segment{ m_Segments[ i ] };
+		const auto nOffset{ i == m_nGetSegment ? m_nGetOffset : 0 };
+		const auto pNull{ static_cast<const byte*>( memchr( segment.m_pData + nOffset, 0, segment.m_nSize - nOffset ) ) };
+		if ( pNull ) {
+			nLen = nScanned + static_cast<int>( pNull - ( segment.m_pData + nOffset ) ) + 1;
+		}
+		nScanned += segment.m_nSize - nOffset;
+	}
+	if ( nLen == -1 ) {
+		*pString = 0;
+		m_bGetOverflow = true;
+		return;
+	}
+
+	const auto nCharsToRead{ static_cast<int>( MIN( static_cast<size_t>( nLen ), maxLenInChars ) - 1 ) };
+	Get( pString, nCharsToRead );
+	pString[ nCharsToRead ] = 0;
+	// skip what didn't fit, and the terminator
+	SeekGet( SEEK_CURRENT, nLen - nCharsToRead );
+}
+
+void CUtlSegmentedBuffer::PutString( const char* pString ) {
+	if ( pString ) {
+		Put( pString, V_strlen( pString ) + 1 );
+	} else {
+		PutChar( 0 );
+	}
+}
+
+void CUtlSegmentedBuffer::PutSlow( const void* pMem, int nSize ) {
+	auto pSrc{ static_cast<const byte*>( pMem ) };
+	while ( nSize > 0 ) {
+		if ( m_Segments.Count() == 0 or m_Segments.Tail().m_nSize == m_Segments.Tail().m_nCapacity ) {
+			AllocSegment();
+		}
+
+		auto& tail{ m_Segments.Tail() };
+		const auto nCopy{ MIN( tail.m_nCapacity - tail.m_nSize, nSize ) };
+		memcpy( tail.m_pData + tail.m_nSize, pSrc, nCopy );
+		tail.m_nSize += nCopy;
+		m_nPut += nCopy;
+		pSrc += nCopy;
+		nSize -= nCopy;
+	}
+}
+
+void CUtlSegmentedBuffer::PutExternal( const void* pMemory, int nSize, FreeFunc_t pfnFree, void* pContext ) {
+	if ( nSize <= 0 ) {
+		if ( pfnFree ) {
+			pfnFree( const_cast<void*>( pMemory ), pContext );
+		}
+		return;
+	}
+
+	auto& segment{ m_Segments[ m_Segments.AddToTail() ] };
+	segment.m_pData = static_cast<byte*>( const_cast<void*>( pMemory ) );
+	segment.m_nStart = m_nPut;
+	segment.m_nSize = nSize;
+	segment.m_nCapacity = nSize;
+	segment.m_pfnFree = pfnFree;
+	segment.m_pFreeContext = pContext;
+	segment.m_bExternal = true;
+	m_nPut += nSize;
+}
+
+void CUtlSegmentedBuffer::PutSegments( CUtlSegmentedBuffer& other ) {
+	Assert( &other != this );
+	for ( auto& segment : other.m_Segments ) {
+		segment.m_nStart += m_nPut;
+		m_Segments.AddToTail( segment );
+	}
+	m_nPut += other.m_nPut;
+
+	// the segments are ours now, don't let it free them
+	other.m_Segments.RemoveAll();
+	other.Clear();
+}
+
+void CUtlSegmentedBuffer::SeekGet( SeekType_t type, int offset ) {
+	auto nPos{ offset };
+	if ( type == SEEK_CURRENT ) {
+		nPos += m_nGet;
+	} else if ( type == SEEK_TAIL ) {
+		nPos += m_nPut;
+	}
+	if ( nPos < 0 or nPos > m_nPut ) {
+		m_bGetOverflow = true;
+		nPos = clamp( nPos, 0, m_nPut );
+	}
+
+	// last segment starting at or before the position
+	auto nLow{ 0 };
+	auto nHigh{ m_Segments.Count() - 1 };
+	while ( nLow < nHigh ) {
+		const auto nMid{ ( nLow + nHigh + 1 ) / 2 };
+		if ( m_Segments[ nMid ].m_nStart <= nPos ) {
+			nLow = nMid;
+		} else {
+			nHigh = nMid - 1;
+		}
+	}
+
+	m_nGet = nPos;
+	m_nGetSegment = nLow;
+	m_nGetOffset = m_Segments.Count() ? nPos - m_Segments[ nLow ].m_nStart : 0;
+}
+
+int CUtlSegmentedBuffer::GetIOVecs( CUtlVector<IOVec_t>& vecs ) const {
+	const auto nFirst{ vecs.Count() };
+	for ( auto i{ m_nGetSegment }; i < m_Segments.Count(); i += 1 ) {
+		const auto& segment{ m_Segments[ i ] };
+		const auto nOffset{ i == m_nGetSegment ? m_nGetOffset : 0 };
+		if ( segment.m_nSize > nOffset ) {
+			vecs.AddToTail( { segment.m_pData + nOffset, segment.m_nSize - nOffset } );
+		}
+	}
+	return vecs.Count() - nFirst;
+}
+
+bool CUtlSegmentedBuffer::WriteToFile( IBaseFileSystem* pFileSystem, FileHandle_t hFile ) const {
+	// there's no vectored write in the filesystem interface, but writes of whole segments are big enough
+	for ( auto i{ m_nGetSegment }; i < m_Segments.Count(); i += 1 ) {
+		const auto& segment{ m_Segments[ i ] };
+		const auto nOffset{ i == m_nGetSegment ? m_nGetOffset : 0 };
+		const auto nLength{ segment.m_nSize - nOffset };
+		if ( nLength > 0 and pFileSystem->Write( segment.m_pData + nOffset, nLength, hFile ) != nLength ) {
+			return false;
+		}
+	}
+	return true;
+}
+
+int CUtlSegmentedBuffer::ReadFromFile( IBaseFileSystem* pFileSystem, FileHandle_t hFile, int nSize ) {
+	auto nTotal{ 0 };
+	while ( nSize > 0 ) {
+		if ( m_Segments.Count() == 0 or m_Segments.Tail().m_nSize == m_Segments.Tail().m_nCapacity ) {
+			AllocSegment();
+		}
+
+		auto& tail{ m_Segments.Tail() };
+		const auto nWanted{ MIN( tail.m_nCapacity - tail.m_nSize, nSize ) };
+		const auto nRead{ pFileSystem->Read( tail.m_pData + tail.m_nSize, nWanted, hFile ) };
+		if ( nRead <= 0 ) {
+			break;
+		}
+		tail.m_nSize += nRead;
+		m_nPut += nRead;
+		nTotal += nRead;
+		nSize -= nRead;
+		if ( nRead < nWanted ) {
+			break;
+		}
+	}
+
+	// don't leave an empty segment around, if the read failed right away
+	if ( m_Segments.Count() and m_Segments.Tail().m_nSize == 0 ) {
+		ReleaseSegment( m_Segments.Tail(), true );
+		m_Segments.RemoveMultipleFromTail( 1 );
+	}
+	return nTotal;
+}
+
+void CUtlSegmentedBuffer::CopyTo( CUtlBuffer& buf ) const {
+	buf.EnsureCapacity( buf.TellPut() + GetBytesRemaining() );
+
+	CUtlVector<IOVec_t> vecs{};
+	GetIOVecs( vecs );
+	for ( const auto& vec : vecs ) {
+		buf.Put( vec.m_pBase, vec.m_nLength );
+	}
+}
+
+void CUtlSegmentedBuffer::AllocSegment() {
+	auto& segment{ m_Segments[ m_Segments.AddToTail() ] };
+	if ( m_SpareSegments.Count() ) {
+		segment.m_pData = m_SpareSegments.Tail();
+		m_SpareSegments.RemoveMultipleFromTail( 1 );
+	} else {
+		segment.m_pData = new byte[ m_nSegmentSize ];
+	}
+	segment.m_nStart = m_nPut;
+	segment.m_nSize = 0;
+	segment.m_nCapacity = m_nSegmentSize;
+	segment.m_pfnFree = nullptr;
+	segment.m_pFreeContext = nullptr;
+	segment.m_bExternal = false;
+}
+
+void CUtlSegmentedBuffer::ReleaseSegment( Segment_t& segment, bool bKeepSpare ) {
+	if ( segment.m_bExternal ) {
+		if ( segment.m_pfnFree ) {
+			segment.m_pfnFree( segment.m_pData, segment.m_pFreeContext );
+		}
+	} else if ( bKeepSpare and segment.m_nCapacity == m_nSegmentSize ) {
+		m_SpareSegments.AddToTail( segment.m_pData );
+	} else {
+		delete[] segment.m_pData;
+	}
+	segment.m_pData = nullptr;
+}
+
+void CUtlSegmentedBuffer::SkipExhaustedSegments() {
+	while ( m_nGetSegment + 1 < m_Segments.Count() and m_nGetOffset == m_Segments[ m_nGetSegment ].m_nSize ) {
+		m_nGetSegment += 1;
+		m_nGetOffset = 0;
+	}
+}
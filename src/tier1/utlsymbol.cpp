@@ -11,6 +11,7 @@
 #include "stringpool.h"
 #include "tier0/memdbgon.h"
 #include "tier0/threadtools.h"
+#include "generichash.h"
 #include "utlhashtable.h"
 #include "utlstring.h"
 // memdbgon must be the last include file in a .cpp file!!!
@@ -268,6 +269,242 @@ void CUtlSymbolTable::RemoveAll() {
 }
 
 
+//-----------------------------------------------------------------------------
+// Hashed symbol table
+//-----------------------------------------------------------------------------
+
+static uint32 HighestBit( uint32 n ) {
+	#if defined( COMPILER_MSVC )
+		unsigned long index;
+		_BitScanReverse( &index, n );
+		return index;
+	#else
+		return 31 - __builtin_clz( n );
+	#endif
+}
+
+
+CUtlSymbolTableHashed::CUtlSymbolTableHashed( bool caseInsensitive ) : m_bInsensitive( caseInsensitive ) {
+	m_pTable.store( AllocTable( 1024 ), std::memory_order_relaxed );
+}
+
+CUtlSymbolTableHashed::~CUtlSymbolTableHashed() {
+	RemoveAll();
+
+	const auto table{ m_pTable.load( std::memory_order_relaxed ) };
+	delete[] table->m_pSlots;
+	delete table;
+}
+
+
+CUtlSymbolTableHashed::Table_t* CUtlSymbolTableHashed::AllocTable( uint32 nCapacity ) {
+	const auto table{ new Table_t };
+	table->m_nMask = nCapacity - 1;
+	table->m_pSlots = new Slot_t[nCapacity];
+	for ( uint32 i{0}; i < nCapacity; i += 1 ) {
+		table->m_pSlots[i].m_nHash.store( 0, std::memory_order_relaxed );
+		table->m_pSlots[i].m_nId.store( 0, std::memory_order_relaxed );
+	}
+	return table;
+}
+
+
+uint32 CUtlSymbolTableHashed::HashOf( const char* pString, uint32 nLength ) const {
+	return m_bInsensitive ? MurmurHash2LowerCase( pString, 0x5bd1e995 ) : MurmurHash2( pString, nLength, 0x5bd1e995 );
+}
+
+
+const CUtlSymbolTableHashed::Entry_t& CUtlSymbolTableHashed::EntryOf( UtlSymId32_t id ) const {
+	// segment `n` starts at id `2^(n + FIRST_SEGMENT_BITS) - 2^FIRST_SEGMENT_BITS`
+	const auto biased{ id + ( 1u << FIRST_SEGMENT_BITS ) };
+	const auto highBit{ HighestBit( biased ) };
+	const auto segment{ highBit - FIRST_SEGMENT_BITS };
+	return m_pSegments[segment][biased - ( 1u << highBit )];
+}
+
+
+UtlSymId32_t CUtlSymbolTableHashed::Lookup( const Table_t* pTable, const char* pString, uint32 nLength, uint32 nHash ) const {
+	for ( auto slot{ nHash & pTable->m_nMask };; slot = ( slot + 1 ) & pTable->m_nMask ) {
+		const auto id{ pTable->m_pSlots[slot].m_nId.load( std::memory_order_acquire ) };
+		if ( id == 0 ) {
+			return UTL_INVAL_SYMBOL32;
+		}
+		// a reserved slot is a different string being added, the same one would have waited on our stripe
+		if ( id == RESERVED_SLOT or pTable->m_pSlots[slot].m_nHash.load( std::memory_order_relaxed ) != nHash ) {
+			continue;
+		}
+
+		const auto& entry{ EntryOf( id - 1 ) };
+		if ( entry.m_nLength != nLength ) {
+			continue;
+		}
+		if ( m_bInsensitive ? V_strnicmp( entry.m_pString, pString, nLength ) == 0 : memcmp( entry.m_pString, pString, nLength ) == 0 ) {
+			return id - 1;
+		}
+	}
+}
+
+
+UtlSymId32_t CUtlSymbolTableHashed::Find( const char* pString ) const {
+	if (! pString ) {
+		return UTL_INVAL_SYMBOL32;
+	}
+
+	const auto length{ static_cast<uint32>( V_strlen( pString ) ) };
+	return Lookup( m_pTable.load( std::memory_order_acquire ), pString, length, HashOf( pString, length ) );
+}
+
+
+UtlSymId32_t CUtlSymbolTableHashed::AllocEntry( const char* pString, uint32 nLength, uint32 nHash ) {
+	AUTO_LOCK( m_PoolMutex );
+
+	// long strings get a page of their own
+	const int size = nLength + 1;
+	char* pCopy;
+	if ( size > STRING_PAGE_SIZE / 4 ) {
+		pCopy = static_cast<char*>( malloc( size ) );
+		m_StringPages.AddToHead( pCopy );
+	} else {
+		if ( m_nPageUsed + size > STRING_PAGE_SIZE ) {
+			m_StringPages.AddToTail( static_cast<char*>( malloc( STRING_PAGE_SIZE ) ) );
+			m_nPageUsed = 0;
+		}
+		pCopy = m_StringPages.Tail() + m_nPageUsed;
+		m_nPageUsed += size;
+	}
+	memcpy( pCopy, pString, size );
+
+	const auto id{ m_nCount.load( std::memory_order_relaxed ) };
+	AssertMsg( id < UTL_INVAL_SYMBOL32 - ( 1u << FIRST_SEGMENT_BITS ), "Symbol table is full" );
+	const auto biased{ id + ( 1u << FIRST_SEGMENT_BITS ) };
+	if ( ( biased & ( biased - 1 ) ) == 0 ) {
+		// first id of a segment
+		const auto segment{ HighestBit( biased ) - FIRST_SEGMENT_BITS };
+		m_pSegments[segment] = new Entry_t[biased];
+	}
+
+	auto& entry{ const_cast<Entry_t&>( EntryOf( id ) ) };
+	entry.m_pString = pCopy;
+	entry.m_nHash = nHash;
+	entry.m_nLength = nLength;
+
+	m_nCount.store( id + 1, std::memory_order_release );
+	return id;
+}
+
+
+void CUtlSymbolTableHashed::Insert( Table_t* pTable, uint32 nHash, UtlSymId32_t id ) {
+	for ( auto slot{ nHash & pTable->m_nMask };; slot = ( slot + 1 ) & pTable->m_nMask ) {
+		auto& target{ pTable->m_pSlots[slot] };
+		uint32 expected{ 0 };
+		// other stripes may be adding to the same run of slots
+		if ( target.m_nId.compare_exchange_strong( expected, RESERVED_SLOT, std::memory_order_relaxed ) ) {
+			target.m_nHash.store( nHash, std::memory_order_relaxed );
+			target.m_nId.store( id + 1, std::memory_order_release );
+			return;
+		}
+	}
+}
+
+
+UtlSymId32_t CUtlSymbolTableHashed::AddString( const char* pString ) {
+	if (! pString ) {
+		return UTL_INVAL_SYMBOL32;
+	}
+
+	const auto length{ static_cast<uint32>( V_strlen( pString ) ) };
+	const auto hash{ HashOf( pString, length ) };
+	if ( const auto id{ Lookup( m_pTable.load( std::memory_order_acquire ), pString, length, hash ) }; id != UTL_INVAL_SYMBOL32 ) {
+		return id;
+	}
+
+	UtlSymId32_t id;
+	bool grow;
+	{
+		m_IndexLock.LockForRead();
+		auto& stripe{ m_Stripes[ hash % STRIPE_COUNT ] };
+		stripe.Lock();
+
+		// someone with the same string might have been first
+		const auto table{ m_pTable.load( std::memory_order_acquire ) };
+		id = Lookup( table, pString, length, hash );
+		if ( id == UTL_INVAL_SYMBOL32 ) {
+			id = AllocEntry( pString, length, hash );
+			Insert( table, hash, id );
+		}
+		// keep it at most half full
+		grow = m_nCount.load( std::memory_order_relaxed ) > ( table->m_nMask + 1 ) / 2;
+
+		stripe.Unlock();
+		m_IndexLock.UnlockRead();
+	}
+
+	if ( grow ) {
+		Grow();
+	}
+	return id;
+}
+
+
+void CUtlSymbolTableHashed::Grow() {
+	m_IndexLock.LockForWrite();
+
+	const auto table{ m_pTable.load( std::memory_order_relaxed ) };
+	const auto count{ m_nCount.load( std::memory_order_relaxed ) };
+	if ( count > ( table->m_nMask + 1 ) / 2 ) {
+		const auto grown{ AllocTable( ( table->m_nMask + 1 ) * 2 ) };
+		for ( uint32 id{0}; id < count; id += 1 ) {
+			Insert( grown, EntryOf( id ).m_nHash, id );
+		}
+		m_pTable.store( grown, std::memory_order_release );
+		m_RetiredTables.AddToTail( table );
+	}
+
+	m_IndexLock.UnlockWrite();
+}
+
+
+const char* CUtlSymbolTableHashed::String( UtlSymId32_t id ) const {
+	if ( id == UTL_INVAL_SYMBOL32 ) {
+		return "";
+	}
+
+	Assert( id < m_nCount.load( std::memory_order_acquire ) );
+	return EntryOf( id ).m_pString;
+}
+
+
+uint32 CUtlSymbolTableHashed::Hash( UtlSymId32_t id ) const {
+	Assert( id != UTL_INVAL_SYMBOL32 and id < m_nCount.load( std::memory_order_acquire ) );
+	return EntryOf( id ).m_nHash;
+}
+
+
+void CUtlSymbolTableHashed::RemoveAll() {
+	for ( const auto table : m_RetiredTables ) {
+		delete[] table->m_pSlots;
+		delete table;
+	}
+	m_RetiredTables.RemoveAll();
+
+	const auto table{ m_pTable.load( std::memory_order_relaxed ) };
+	for ( uint32 i{0}; i <= table->m_nMask; i += 1 ) {
+		table->m_pSlots[i].m_nId.store( 0, std::memory_order_relaxed );
+	}
+
+	for ( auto& segment : m_pSegments ) {
+		delete[] segment;
+		segment = nullptr;
+	}
+	for ( const auto page : m_StringPages ) {
+		free( page );
+	}
+	m_StringPages.RemoveAll();
+	m_nPageUsed = STRING_PAGE_SIZE;
+	m_nCount.store( 0, std::memory_order_release );
+}
+
+
 class CUtlFilenameSymbolTable::HashTable : public CUtlStableHashtable<CUtlConstString> { };
 
 CUtlFilenameSymbolTable::CUtlFilenameSymbolTable() {
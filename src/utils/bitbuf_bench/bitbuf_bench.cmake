@@ -0,0 +1,24 @@
+# bitbuf_bench.cmake
+
+set( BITBUF_BENCH_DIR ${CMAKE_CURRENT_LIST_DIR} )
+set( BITBUF_BENCH_SOURCE_FILES
+	"${BITBUF_BENCH_DIR}/bitbuf_bench.cpp"
+
+	# Header Files
+	"${SRCDIR}/public/tier0/platform.h"
+	"${SRCDIR}/public/tier1/bitbuf.h"
+)
+add_executable( bitbuf_bench ${BITBUF_BENCH_SOURCE_FILES} )
+
+set_target_properties( bitbuf_bench
+	PROPERTIES
+		RUNTIME_OUTPUT_DIRECTORY "${GAMEDIR}/bin"
+)
+
+target_link_libraries( bitbuf_bench
+	PRIVATE
+		mathlib
+		tier0
+		tier1
+		vstdlib
+)
@@ -0,0 +1,214 @@
+//
+// Created by ENDERZOMBI102 on 18/10/2026.
+//
+// Purpose: Times the bulk reads and writes of bf_read / bf_write against doing the same one
+//          field at a time, and checks that both produce the same bits and values.
+//
+#include "tier0/platform.h"
+#include "tier1/bitbuf.h"
+#include "tier1/utlvector.h"
+#include "vstdlib/random.h"
+#include <cstdio>
+#include <cstring>
+
+
+namespace {
+	constexpr int NUM_FIELDS{ 8192 };
+	constexpr int BUFFER_BYTES{ NUM_FIELDS * 16 };  // fits 8192 vectors at their worst
+
+	uint32 s_nSeed{ 0x2545F491 };
+	uint32 RandomBits() {
+		s_nSeed ^= s_nSeed << 13;
+		s_nSeed ^= s_nSeed >> 17;
+		s_nSeed ^= s_nSeed << 5;
+		return s_nSeed;
+	}
+
+	// Runs `func`, which moves `nBytes` each time, until a good chunk of time went by, returns MiB/s
+	template<typename FUNC>
+	double Measure( int nBytes, FUNC&& func ) {
+		auto nRounds{ 0 };
+		const auto start{ Plat_FloatTime() };
+		double elapsed;
+		do {
+			func();
+			nRounds += 1;
+			elapsed = Plat_FloatTime() - start;
+		} while ( elapsed < 0.25 );
+		return static_cast<double>( nBytes ) * nRounds / elapsed / ( 1024.0 * 1024.0 );
+	}
+
+	void Report( const char* pTest, double perField, double bulk ) {
+		printf( "%-28s %10.1f %10.1f %7.2fx\n", pTest, perField, bulk, bulk / perField );
+	}
+
+	int s_nFailures{ 0 };
+	void Check( bool bOk, const char* pTest, const char* pWhat ) {
+		if (! bOk ) {
+			printf( "FAILED: %s: %s differ\n", pTest, pWhat );
+			s_nFailures += 1;
+		}
+	}
+
+	// the buffers, as dwords so they're aligned the way bf_write likes them
+	CUtlVector<uint32> s_PerField;
+	CUtlVector<uint32> s_Bulk;
+
+	void BenchFields( int numbits ) {
+		char name[64];
+		V_snprintf( name, sizeof( name ), "%d bit fields", numbits );
+
+		CUtlVector<uint32> values;
+		values.SetCount( NUM_FIELDS );
+		const auto nMask{ numbits == 32 ? 0xFFFFFFFFu : ( 1u << numbits ) - 1 };
+		for ( auto& value : values ) {
+			value = RandomBits() & nMask;
+		}
+
+		// writes
+		auto nBytes{ 0 };
+		const auto write{ Measure( ( NUM_FIELDS * numbits + 7 ) / 8, [&] {
+			bf_write buf{ s_PerField.Base(), BUFFER_BYTES };
+			for ( const auto value : values ) {
+				buf.WriteUBitLong( value, numbits );
+			}
+			nBytes = buf.GetNumBytesWritten();
+		} ) };
+		const auto writeBulk{ Measure( ( NUM_FIELDS * numbits + 7 ) / 8, [&] {
+			bf_write buf{ s_Bulk.Base(), BUFFER_BYTES };
+			buf.WriteBitsArray( values.Base(), NUM_FIELDS, numbits );
+		} ) };
+		Check( V_memcmp( s_PerField.Base(), s_Bulk.Base(), nBytes ) == 0, name, "written bits" );
+		V_strncat( name, " write", sizeof( name ) );
+		Report( name, write, writeBulk );
+
+		// reads
+		CUtlVector<uint32> perField, bulk;
+		perField.SetCount( NUM_FIELDS );
+		bulk.SetCount( NUM_FIELDS );
+		const auto read{ Measure( nBytes, [&] {
+			bf_read buf{ s_PerField.Base(), nBytes };
+			for ( auto& value : perField ) {
+				value = buf.ReadUBitLong( numbits );
+			}
+		} ) };
+		const auto readBulk{ Measure( nBytes, [&] {
+			bf_read buf{ s_PerField.Base(), nBytes };
+			buf.ReadBitsArray( bulk.Base(), NUM_FIELDS, numbits );
+		} ) };
+		V_snprintf( name, sizeof( name ), "%d bit fields", numbits );
+		Check( V_memcmp( perField.Base(), bulk.Base(), NUM_FIELDS * sizeof( uint32 ) ) == 0, name, "read values" );
+		Check( V_memcmp( values.Base(), bulk.Base(), NUM_FIELDS * sizeof( uint32 ) ) == 0, name, "round tripped values" );
+		V_strncat( name, " read", sizeof( name ) );
+		Report( name, read, readBulk );
+	}
+
+	template<typename WRITE_ONE, typename WRITE_ALL, typename READ_ONE, typename READ_ALL>
+	void BenchVectors( const char* pName, const CUtlVector<Vector>& vectors, WRITE_ONE&& writeOne, WRITE_ALL&& writeAll, READ_ONE&& readOne, READ_ALL&& readAll ) {
+		char name[64];
+
+		auto nBytes{ 0 };
+		const auto write{ Measure( NUM_FIELDS * sizeof( Vector ), [&] {
+			bf_write buf{ s_PerField.Base(), BUFFER_BYTES };
+			for ( const auto& vec : vectors ) {
+				writeOne( buf, vec );
+			}
+			nBytes = buf.GetNumBytesWritten();
+		} ) };
+		const auto writeBulk{ Measure( NUM_FIELDS * sizeof( Vector ), [&] {
+			bf_write buf{ s_Bulk.Base(), BUFFER_BYTES };
+			writeAll( buf, vectors.Base(), NUM_FIELDS );
+		} ) };
+		Check( V_memcmp( s_PerField.Base(), s_Bulk.Base(), nBytes ) == 0, pName, "written bits" );
+		V_snprintf( name, sizeof( name ), "%s write", pName );
+		Report( name, write, writeBulk );
+
+		CUtlVector<Vector> perField, bulk;
+		perField.SetCount( NUM_FIELDS );
+		bulk.SetCount( NUM_FIELDS );
+		const auto read{ Measure( NUM_FIELDS * sizeof( Vector ), [&] {
+			bf_read buf{ s_PerField.Base(), nBytes };
+			for ( auto& vec : perField ) {
+				readOne( buf, vec );
+			}
+		} ) };
+		const auto readBulk{ Measure( NUM_FIELDS * sizeof( Vector ), [&] {
+			bf_read buf{ s_PerField.Base(), nBytes };
+			readAll( buf, bulk.Base(), NUM_FIELDS );
+		} ) };
+		Check( V_memcmp( perField.Base(), bulk.Base(), NUM_FIELDS * sizeof( Vector ) ) == 0, pName, "read vectors" );
+		V_snprintf( name, sizeof( name ), "%s read", pName );
+		Report( name, read, readBulk );
+	}
+
+	// `ReadBits` has no per-field twin, so it's compared to reading a byte at a time
+	void BenchReadBits( int iStartBit ) {
+		char name[64];
+		V_snprintf( name, sizeof( name ), "ReadBits from bit %d", iStartBit );
+
+		for ( auto& dword : s_PerField ) {
+			dword = RandomBits();
+		}
+		const auto nBytes{ BUFFER_BYTES - 4 };
+
+		CUtlVector<byte> perByte, bulk;
+		perByte.SetCount( nBytes );
+		bulk.SetCount( nBytes );
+		const auto read{ Measure( nBytes, [&] {
+			bf_read buf{ s_PerField.Base(), BUFFER_BYTES };
+			buf.Seek( iStartBit );
+			for ( auto& value : perByte ) {
+				value = static_cast<byte>( buf.ReadUBitLong( 8 ) );
+			}
+		} ) };
+		const auto readBulk{ Measure( nBytes, [&] {
+			bf_read buf{ s_PerField.Base(), BUFFER_BYTES };
+			buf.Seek( iStartBit );
+			buf.ReadBits( bulk.Base(), nBytes * 8 );
+		} ) };
+		Check( V_memcmp( perByte.Base(), bulk.Base(), nBytes ) == 0, name, "read bytes" );
+		Report( name, read, readBulk );
+	}
+}
+
+int main( int argc, char** argv ) {
+	RandomSeed( 0x2545F491 );
+	s_PerField.SetCount( BUFFER_BYTES / 4 );
+	s_Bulk.SetCount( BUFFER_BYTES / 4 );
+
+	printf( "bitbuf_bench: MiB/s of the unpacked data\n" );
+	printf( "%-28s %10s %10s %8s\n", "test", "per field", "bulk", "speedup" );
+
+	for ( const auto numbits : { 1, 5, 13, 17, 32 } ) {
+		BenchFields( numbits );
+	}
+
+	CUtlVector<Vector> coords, normals;
+	coords.SetCount( NUM_FIELDS );
+	normals.SetCount( NUM_FIELDS );
+	for ( auto i{ 0 }; i < NUM_FIELDS; i += 1 ) {
+		// some components zero and some integral, like real entity data
+		coords[i].Init( RandomFloat( -4096.0f, 4096.0f ), ( i & 3 ) ? RandomFloat( -4096.0f, 4096.0f ) : 0.0f, static_cast<float>( static_cast<int>( RandomFloat( -512.0f, 512.0f ) ) ) );
+		normals[i].Init( RandomFloat( -1.0f, 1.0f ), RandomFloat( -1.0f, 1.0f ), RandomFloat( -1.0f, 1.0f ) );
+		VectorNormalize( normals[i] );
+	}
+	BenchVectors( "Vec3Coord", coords,
+		[]( bf_write& buf, const Vector& vec ) { buf.WriteBitVec3Coord( vec ); },
+		[]( bf_write& buf, const Vector* pVecs, int nCount ) { buf.WriteBitVec3CoordArray( pVecs, nCount ); },
+		[]( bf_read& buf, Vector& vec ) { buf.ReadBitVec3Coord( vec ); },
+		[]( bf_read& buf, Vector* pVecs, int nCount ) { buf.ReadBitVec3CoordArray( pVecs, nCount ); } );
+	BenchVectors( "Vec3Normal", normals,
+		[]( bf_write& buf, const Vector& vec ) { buf.WriteBitVec3Normal( vec ); },
+		[]( bf_write& buf, const Vector* pVecs, int nCount ) { buf.WriteBitVec3NormalArray( pVecs, nCount ); },
+		[]( bf_read& buf, Vector& vec ) { buf.ReadBitVec3Normal( vec ); },
+		[]( bf_read& buf, Vector* pVecs, int nCount ) { buf.ReadBitVec3NormalArray( pVecs, nCount ); } );
+
+	BenchReadBits( 0 );
+	BenchReadBits( 3 );
+
+	if ( s_nFailures ) {
+		printf( "FAILED: %d checks\n", s_nFailures );
+		return 1;
+	}
+	return 0;
+}
@@ -12,7 +12,7 @@ extern "C" {
 }
 
 #define LZMA_ID ( ( 'A' << 24 ) | ( 'M' << 16 ) | ( 'Z' << 8 ) | ( 'L' ) )
-#define LZMA_ORIGINAL_HEADER_SIZE 13
+#define LZMA_BLOCKS_ID ( ( 'B' << 24 ) | ( 'M' << 16 ) | ( 'Z' << 8 ) | ( 'L' ) )
 
 #pragma pack( 1 )
 struct LzmaHeader {
@@ -21,6 +21,14 @@ struct LzmaHeader {
 	unsigned int lzmaSize;  // always little endian
 	unsigned char properties[ 5 ];
 };
+
+// see lzmaDecoder.h
+struct LzmaBlocksHeader {
+	unsigned int id;
+	unsigned int actualSize;
+	unsigned int blockSize;
+	unsigned int blockCount;
+};
 #pragma pack()
 
 // TODO: Verify this all works! It wasn't tested nor logic-verified!
@@ -49,16 +57,17 @@ extern "C" unsigned char* LZMA_Compress( unsigned char* pInput, unsigned int inp
 		.Free = [](void*, void* ptr) { free(ptr); }
 	};
 
-	// compress, skipping past our header
+	// compress, skipping past our header; LzmaEncode writes the properties separately
+	auto* pHeader = reinterpret_cast<LzmaHeader*>( pOutputBuffer );
 	size_t propsSize = LZMA_PROPS_SIZE;
 	CLzmaEncProps props;
 	LzmaEncProps_Init( &props );
 	props.numThreads = 4;
 	auto outBufferSize = static_cast<size_t>( outSize - sizeof( LzmaHeader ) );
 	int result = LzmaEncode(
-		pOutputBuffer + sizeof( LzmaHeader ) + LZMA_PROPS_SIZE, &outBufferSize,
+		pOutputBuffer + sizeof( LzmaHeader ), &outBufferSize,
 		pInput, inputSize,
-		&props, pOutputBuffer + sizeof( LzmaHeader ), &propsSize, (int) props.writeEndMark,
+		&props, pHeader->properties, &propsSize, (int) props.writeEndMark,
 		nullptr, &allocator, &allocator
 	);
 	if ( result != SZ_OK ) {
@@ -66,25 +75,78 @@ extern "C" unsigned char* LZMA_Compress( unsigned char* pInput, unsigned int inp
 		return nullptr;
 	}
 
-	if ( outBufferSize - LZMA_ORIGINAL_HEADER_SIZE + sizeof( LzmaHeader ) >= inputSize ) {
+	if ( outBufferSize + sizeof( LzmaHeader ) >= inputSize ) {
 		// compression got worse or stayed the same
 		free( pOutputBuffer );
 		return nullptr;
 	}
 
-	// construct our header, strip theirs
-	auto* pHeader = reinterpret_cast<LzmaHeader*>( pOutputBuffer );
+	// construct our header
 	pHeader->id = LZMA_ID;
 	pHeader->actualSize = inputSize;
-	pHeader->lzmaSize = outBufferSize - LZMA_ORIGINAL_HEADER_SIZE;
-	memcpy( pHeader->properties, pOutputBuffer + sizeof( LzmaHeader ), 5 );
-
-	// shift the compressed data into place
-	memcpy( pOutputBuffer + sizeof( LzmaHeader ), pOutputBuffer + sizeof( LzmaHeader ) + LZMA_ORIGINAL_HEADER_SIZE, outBufferSize - LZMA_ORIGINAL_HEADER_SIZE );
+	pHeader->lzmaSize = outBufferSize;
 
 	// final output size is our header plus compressed bits
-	*pOutputSize = sizeof( LzmaHeader ) + outBufferSize - LZMA_ORIGINAL_HEADER_SIZE;
+	*pOutputSize = sizeof( LzmaHeader ) + outBufferSize;
+
+	return pOutputBuffer;
+}
+
+//-----------------------------------------------------------------------------
+// Encodes the input as a container of independently compressed blocks, which
+// the engine can decode in parallel. Returns non-null Compressed buffer if successful.
+// Caller must free.
+//-----------------------------------------------------------------------------
+extern "C" unsigned char* LZMA_CompressBlocks( unsigned char* pInput, unsigned int inputSize, unsigned int blockSize, unsigned int* pOutputSize ) {
+	*pOutputSize = 0;
+
+	if ( inputSize == 0 || blockSize == 0 ) {
+		return nullptr;
+	}
+
+	const unsigned blockCount = ( inputSize + blockSize - 1 ) / blockSize;
+	const unsigned dataStart = sizeof( LzmaBlocksHeader ) + ( blockCount + 1 ) * sizeof( unsigned int );
+
+	// blocks which don't compress are stored, so they never take more than the input
+	auto* pOutputBuffer = reinterpret_cast<unsigned char*>( malloc( dataStart + inputSize ) );
+	if ( !pOutputBuffer ) {
+		return nullptr;
+	}
+
+	auto* pHeader = reinterpret_cast<LzmaBlocksHeader*>( pOutputBuffer );
+	pHeader->id = LZMA_BLOCKS_ID;
+	pHeader->actualSize = inputSize;
+	pHeader->blockSize = blockSize;
+	pHeader->blockCount = blockCount;
+	auto* pOffsets = reinterpret_cast<unsigned int*>( pHeader + 1 );
+
+	unsigned outPos = dataStart;
+	for ( unsigned i = 0; i < blockCount; i++ ) {
+		const unsigned blockStart = i * blockSize;
+		const unsigned blockLength = inputSize - blockStart < blockSize ? inputSize - blockStart : blockSize;
+		pOffsets[ i ] = outPos;
+
+		unsigned compressedSize;
+		auto* pCompressed = LZMA_Compress( pInput + blockStart, blockLength, &compressedSize );
+		if ( pCompressed ) {
+			// always smaller than the block, so it can't be confused with a stored one
+			memcpy( pOutputBuffer + outPos, pCompressed, compressedSize );
+			outPos += compressedSize;
+			free( pCompressed );
+		} else {
+			memcpy( pOutputBuffer + outPos, pInput + blockStart, blockLength );
+			outPos += blockLength;
+		}
+	}
+	pOffsets[ blockCount ] = outPos;
+
+	if ( outPos >= inputSize ) {
+		// compression got worse or stayed the same
+		free( pOutputBuffer );
+		return nullptr;
+	}
 
+	*pOutputSize = outPos;
 	return pOutputBuffer;
 }
 
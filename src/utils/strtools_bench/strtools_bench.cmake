@@ -0,0 +1,24 @@
+# strtools_bench.cmake
+
+set( STRTOOLS_BENCH_DIR ${CMAKE_CURRENT_LIST_DIR} )
+set( STRTOOLS_BENCH_SOURCE_FILES
+	"${STRTOOLS_BENCH_DIR}/strtools_bench.cpp"
+
+	# Header Files
+	"${SRCDIR}/public/tier0/platform.h"
+	"${SRCDIR}/public/tier1/processor_detect.h"
+	"${SRCDIR}/public/tier1/strtools.h"
+)
+add_executable( strtools_bench ${STRTOOLS_BENCH_SOURCE_FILES} )
+
+set_target_properties( strtools_bench
+	PROPERTIES
+		RUNTIME_OUTPUT_DIRECTORY "${GAMEDIR}/bin"
+)
+
+target_link_libraries( strtools_bench
+	PRIVATE
+		tier0
+		tier1
+		vstdlib
+)
@@ -0,0 +1,230 @@
+//
+// Created by ENDERZOMBI102 on 18/10/2026.
+//
+// Purpose: Times the SIMD string primitives of tier1 against the scalar loops they replaced,
+//          on file paths and on KeyValues-style keys, and checks that both agree.
+//
+#include "tier0/platform.h"
+#include "tier1/processor_detect.h"
+#include "tier1/strtools.h"
+#include "tier1/utlstring.h"
+#include "tier1/utlvector.h"
+#include <cstdio>
+
+
+namespace {
+	// The scalar versions, as they were before the SIMD paths
+	int Scalar_stricmp( const char* str1, const char* str2 ) {
+		if ( str1 == str2 ) {
+			return 0;
+		}
+		const auto* s1 = reinterpret_cast<const unsigned char*>( str1 );
+		const auto* s2 = reinterpret_cast<const unsigned char*>( str2 );
+		for ( ; *s1; ++s1, ++s2 ) {
+			if ( *s1 != *s2 ) {
+				unsigned char c1 = *s1 | 0x20;
+				unsigned char c2 = *s2 | 0x20;
+				if ( c1 != c2 || static_cast<unsigned char>( c1 - 'a' ) > ( 'z' - 'a' ) ) {
+					if ( ( c1 | c2 ) >= 0x80 )
+						return stricmp( reinterpret_cast<const char*>( s1 ), reinterpret_cast<const char*>( s2 ) );
+					if ( static_cast<unsigned char>( c1 - 'a' ) > ( 'z' - 'a' ) )
+						c1 = *s1;
+					if ( static_cast<unsigned char>( c2 - 'a' ) > ( 'z' - 'a' ) )
+						c2 = *s2;
+					return c1 > c2 ? 1 : -1;
+				}
+			}
+		}
+		return *s2 ? -1 : 0;
+	}
+	int Scalar_strnicmp( const char* str1, const char* str2, int n ) {
+		const auto* s1 = reinterpret_cast<const unsigned char*>( str1 );
+		const auto* s2 = reinterpret_cast<const unsigned char*>( str2 );
+		for ( ; n > 0 && *s1; --n, ++s1, ++s2 ) {
+			if ( *s1 != *s2 ) {
+				unsigned char c1 = *s1 | 0x20;
+				unsigned char c2 = *s2 | 0x20;
+				if ( c1 != c2 || static_cast<unsigned char>( c1 - 'a' ) > ( 'z' - 'a' ) ) {
+					if ( ( c1 | c2 ) >= 0x80 )
+						return strnicmp( reinterpret_cast<const char*>( s1 ), reinterpret_cast<const char*>( s2 ), n );
+					if ( static_cast<unsigned char>( c1 - 'a' ) > ( 'z' - 'a' ) )
+						c1 = *s1;
+					if ( static_cast<unsigned char>( c2 - 'a' ) > ( 'z' - 'a' ) )
+						c2 = *s2;
+					return c1 > c2 ? 1 : -1;
+				}
+			}
+		}
+		return ( n > 0 && *s2 ) ? -1 : 0;
+	}
+	char* Scalar_strlower( char* start ) {
+		auto* str = reinterpret_cast<unsigned char*>( start );
+		while ( *str ) {
+			if ( static_cast<unsigned char>( *str - 'A' ) <= ( 'Z' - 'A' ) )
+				*str += 'a' - 'A';
+			else if ( static_cast<unsigned char>( *str ) >= 0x80 )
+				*str = tolower( *str );
+			str++;
+		}
+		return start;
+	}
+	void Scalar_FixSlashes( char* pname, char separator ) {
+		while ( *pname ) {
+			if ( *pname == '/' || *pname == '\\' ) {
+				*pname = separator;
+			}
+			pname++;
+		}
+	}
+
+	uint32 s_nSeed{ 0x9E3779B9 };
+	uint32 Random() {
+		s_nSeed ^= s_nSeed << 13;
+		s_nSeed ^= s_nSeed >> 17;
+		s_nSeed ^= s_nSeed << 5;
+		return s_nSeed;
+	}
+
+	// Each string, a copy with its case flipped and one which differs in its last char
+	struct Corpus_t {
+		explicit Corpus_t( const char* pName ) : m_pName( pName ) { }
+
+		const char* m_pName;
+		CUtlVector<CUtlString> m_Strings;
+		CUtlVector<CUtlString> m_Flipped;
+		CUtlVector<CUtlString> m_Different;
+		int m_nBytes{ 0 };
+
+		void Add( const char* pString ) {
+			m_Strings.AddToTail( pString );
+
+			CUtlString flipped{ pString };
+			for ( auto i{ 0 }; i < flipped.Length(); i += 1 ) {
+				const auto c{ flipped.Get()[i] };
+				if ( ( c | 0x20 ) >= 'a' and ( c | 0x20 ) <= 'z' ) {
+					flipped.GetForModify()[i] = c ^ 0x20;
+				}
+			}
+			m_Flipped.AddToTail( flipped );
+
+			CUtlString different{ pString };
+			different.GetForModify()[ different.Length() - 1 ] ^= 0x01;
+			m_Different.AddToTail( different );
+
+			m_nBytes += V_strlen( pString ) + 1;
+		}
+	};
+
+	void BuildPaths( Corpus_t& corpus, int nCount ) {
+		static const char* const s_Dirs[]{ "materials", "models", "Props_Junk", "sound", "Weapons", "scripts", "maps", "effects", "Portal", "decals", "Overlays", "BTS" };
+		static const char* const s_Names[]{ "Wood_Crate001a", "metalwall048b", "Glass_Window_Broken", "vgui_logo", "LightBridge_Emitter", "door01", "Concrete_Floor_Dirty02" };
+		static const char* const s_Exts[]{ ".vmt", ".vtf", ".mdl", ".wav", ".txt", ".bsp" };
+
+		char path[MAX_PATH];
+		for ( auto i{ 0 }; i < nCount; i += 1 ) {
+			path[0] = '\0';
+			const auto nDepth{ 1 + Random() % 5 };
+			for ( auto d{ 0u }; d < nDepth; d += 1 ) {
+				V_strncat( path, s_Dirs[ Random() % std::size( s_Dirs ) ], sizeof( path ) );
+				V_strncat( path, ( Random() & 1 ) ? "/" : "\\", sizeof( path ) );
+			}
+			V_strncat( path, s_Names[ Random() % std::size( s_Names ) ], sizeof( path ) );
+			V_strncat( path, s_Exts[ Random() % std::size( s_Exts ) ], sizeof( path ) );
+			corpus.Add( path );
+		}
+	}
+
+	void BuildKeys( Corpus_t& corpus, int nCount ) {
+		static const char* const s_Keys[]{ "$basetexture", "$BumpMap", "$surfaceprop", "classname", "targetname", "origin", "angles", "$envmapmask", "Proxies", "model", "rendercolor", "spawnflags", "$translucent", "OnTrigger" };
+		for ( auto i{ 0 }; i < nCount; i += 1 ) {
+			corpus.Add( s_Keys[ Random() % std::size( s_Keys ) ] );
+		}
+	}
+
+	// Runs `func` over the corpus until a good chunk of time went by, returns the throughput in MiB/s
+	template<typename FUNC>
+	double Measure( const Corpus_t& corpus, FUNC&& func ) {
+		auto nRounds{ 0 };
+		const auto start{ Plat_FloatTime() };
+		double elapsed;
+		do {
+			for ( auto i{ 0 }; i < corpus.m_Strings.Count(); i += 1 ) {
+				func( i );
+			}
+			nRounds += 1;
+			elapsed = Plat_FloatTime() - start;
+		} while ( elapsed < 0.25 );
+		return static_cast<double>( corpus.m_nBytes ) * nRounds / elapsed / ( 1024.0 * 1024.0 );
+	}
+
+	void Report( const char* pCorpus, const char* pTest, double scalar, double simd ) {
+		printf( "%-6s %-22s %10.1f %10.1f %7.2fx\n", pCorpus, pTest, scalar, simd, simd / scalar );
+	}
+
+	int Sign( int value ) {
+		return value < 0 ? -1 : value > 0 ? 1 : 0;
+	}
+
+	// Returns how many results differed between the two paths
+	int RunCorpus( Corpus_t& corpus ) {
+		auto nMismatches{ 0 };
+		auto sink{ 0 };  // printed, so the calls can't be optimized out
+
+		for ( auto i{ 0 }; i < corpus.m_Strings.Count(); i += 1 ) {
+			const auto pStr{ corpus.m_Strings[i].Get() };
+			const auto pFlipped{ corpus.m_Flipped[i].Get() };
+			const auto pDifferent{ corpus.m_Different[i].Get() };
+			const auto nHalf{ corpus.m_Strings[i].Length() / 2 };
+			nMismatches += Sign( V_stricmp( pStr, pFlipped ) ) != Sign( Scalar_stricmp( pStr, pFlipped ) );
+			nMismatches += Sign( V_stricmp( pStr, pDifferent ) ) != Sign( Scalar_stricmp( pStr, pDifferent ) );
+			nMismatches += Sign( V_strnicmp( pStr, pDifferent, nHalf ) ) != Sign( Scalar_strnicmp( pStr, pDifferent, nHalf ) );
+
+			char simd[MAX_PATH], scalar[MAX_PATH];
+			V_strncpy( simd, pFlipped, sizeof( simd ) );
+			V_strncpy( scalar, pFlipped, sizeof( scalar ) );
+			nMismatches += V_strcmp( V_strlower( simd ), Scalar_strlower( scalar ) ) != 0;
+			V_FixSlashes( simd, '/' );
+			Scalar_FixSlashes( scalar, '/' );
+			nMismatches += V_strcmp( simd, scalar ) != 0;
+		}
+
+		Report( corpus.m_pName, "stricmp (equal)",
+			Measure( corpus, [&]( int i ) { sink += Scalar_stricmp( corpus.m_Strings[i].Get(), corpus.m_Flipped[i].Get() ); } ),
+			Measure( corpus, [&]( int i ) { sink += V_stricmp( corpus.m_Strings[i].Get(), corpus.m_Flipped[i].Get() ); } ) );
+		Report( corpus.m_pName, "stricmp (last differs)",
+			Measure( corpus, [&]( int i ) { sink += Scalar_stricmp( corpus.m_Strings[i].Get(), corpus.m_Different[i].Get() ); } ),
+			Measure( corpus, [&]( int i ) { sink += V_stricmp( corpus.m_Strings[i].Get(), corpus.m_Different[i].Get() ); } ) );
+		Report( corpus.m_pName, "strnicmp (equal)",
+			Measure( corpus, [&]( int i ) { sink += Scalar_strnicmp( corpus.m_Strings[i].Get(), corpus.m_Flipped[i].Get(), MAX_PATH ); } ),
+			Measure( corpus, [&]( int i ) { sink += V_strnicmp( corpus.m_Strings[i].Get(), corpus.m_Flipped[i].Get(), MAX_PATH ); } ) );
+
+		// these write, so they work on a scratch copy which is re-dirtied by the other one
+		char buffer[MAX_PATH];
+		Report( corpus.m_pName, "strlower",
+			Measure( corpus, [&]( int i ) { V_strncpy( buffer, corpus.m_Flipped[i].Get(), sizeof( buffer ) ); sink += Scalar_strlower( buffer )[0]; } ),
+			Measure( corpus, [&]( int i ) { V_strncpy( buffer, corpus.m_Flipped[i].Get(), sizeof( buffer ) ); sink += V_strlower( buffer )[0]; } ) );
+		Report( corpus.m_pName, "FixSlashes",
+			Measure( corpus, [&]( int i ) { V_strncpy( buffer, corpus.m_Strings[i].Get(), sizeof( buffer ) ); Scalar_FixSlashes( buffer, '/' ); sink += buffer[0]; } ),
+			Measure( corpus, [&]( int i ) { V_strncpy( buffer, corpus.m_Strings[i].Get(), sizeof( buffer ) ); V_FixSlashes( buffer, '/' ); sink += buffer[0]; } ) );
+
+		printf( "%-6s (checksum %d)\n", corpus.m_pName, sink );
+		return nMismatches;
+	}
+}
+
+int main( int argc, char** argv ) {
+	printf( "strtools_bench: SIMD path is %s, MiB/s\n", CheckAVX2Technology() ? "AVX2" : "SSE2" );
+	printf( "%-6s %-22s %10s %10s %8s\n", "corpus", "test", "scalar", "simd", "speedup" );
+
+	Corpus_t paths{ "paths" };
+	BuildPaths( paths, 4096 );
+	Corpus_t keys{ "keys" };
+	BuildKeys( keys, 4096 );
+
+	const auto nMismatches{ RunCorpus( paths ) + RunCorpus( keys ) };
+	if ( nMismatches ) {
+		printf( "FAILED: %d results differ between the scalar and SIMD paths\n", nMismatches );
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,25 @@
+# unicode_conformance.cmake
+
+set( UNICODE_CONFORMANCE_DIR ${CMAKE_CURRENT_LIST_DIR} )
+set( UNICODE_CONFORMANCE_SOURCE_FILES
+	"${UNICODE_CONFORMANCE_DIR}/unicode_conformance.cpp"
+
+	# Header Files
+	"${SRCDIR}/public/tier0/platform.h"
+	"${SRCDIR}/public/tier1/processor_detect.h"
+	"${SRCDIR}/public/tier1/strtools.h"
+	"${SRCDIR}/public/tier1/utlvector.h"
+)
+add_executable( unicode_conformance ${UNICODE_CONFORMANCE_SOURCE_FILES} )
+
+set_target_properties( unicode_conformance
+	PROPERTIES
+		RUNTIME_OUTPUT_DIRECTORY "${GAMEDIR}/bin"
+)
+
+target_link_libraries( unicode_conformance
+	PRIVATE
+		tier0
+		tier1
+		vstdlib
+)
@@ -0,0 +1,474 @@
+//
+// Created by ENDERZOMBI102 on 18/10/2026.
+//
+// Purpose: Fuzzes the Unicode conversions, validation and length of tier1 against the plain
+//          one-character-at-a-time loops they had before their SIMD runs, and checks that both
+//          agree on every result and output byte. Inputs are null terminated and counted, the
+//          output buffers are often too short, and both end right before a guard page.
+//          Runs the SIMD tier of this CPU, `-sse2` forces the SSE2 one.
+//
+#include "tier0/platform.h"
+#include "tier1/processor_detect.h"
+#include "tier1/strtools.h"
+#include "tier1/utlvector.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#if defined( PLATFORM_WINDOWS )
+	#define WIN32_LEAN_AND_MEAN
+	#include <windows.h>
+#else
+	#include <sys/mman.h>
+	#include <unistd.h>
+#endif
+
+
+namespace {
+	// The scalar versions, as they were before the SIMD runs
+	int Ref_UTF32ToUChar32( const uchar32* pUTF32, uchar32& uVal, bool& bErr ) {
+		bErr = !Q_IsValidUChar32( *pUTF32 );
+		uVal = bErr ? '?' : *pUTF32;
+		return 1;
+	}
+	int Ref_UChar32ToUTF32Len( uchar32 ) {
+		return 1;
+	}
+	int Ref_UChar32ToUTF32( uchar32 uVal, uchar32* pUTF32 ) {
+		*pUTF32 = uVal;
+		return 1;
+	}
+
+	template<typename SrcType, typename DstType, int (&DecodeSrc)( const SrcType*, uchar32&, bool& ), int (&EncodeDstLen)( uchar32 ), int (&EncodeDst)( uchar32, DstType* )>
+	int Ref_Convert( const SrcType* pIn, bool bStopAtNull, int nInChars, DstType* pOut, int nOutBytes, EStringConvertErrorPolicy ePolicy ) {
+		auto nOut{ 0 };
+		if (! pOut ) {
+			while ( bStopAtNull ? ( *pIn ) : ( nInChars-- > 0 ) ) {
+				uchar32 uVal;
+				auto bErr{ false };
+				pIn += DecodeSrc( pIn, uVal, bErr );
+				nOut += EncodeDstLen( uVal );
+				if ( bErr ) {
+					if ( ePolicy & _STRINGCONVERTFLAG_SKIP ) {
+						nOut -= EncodeDstLen( uVal );
+					} else if ( ePolicy & _STRINGCONVERTFLAG_FAIL ) {
+						return 0;
+					}
+				}
+			}
+			return ( nOut + 1 ) * sizeof( DstType );
+		}
+
+		const int nOutElems = nOutBytes / sizeof( DstType );
+		if ( nOutElems <= 0 ) {
+			return 0;
+		}
+		const auto nMaxOut{ nOutElems - 1 };
+		while ( bStopAtNull ? ( *pIn ) : ( nInChars-- > 0 ) ) {
+			uchar32 uVal;
+			auto bErr{ false };
+			pIn += DecodeSrc( pIn, uVal, bErr );
+			if ( nOut + EncodeDstLen( uVal ) > nMaxOut ) {
+				break;
+			}
+			nOut += EncodeDst( uVal, pOut + nOut );
+			if ( bErr ) {
+				if ( ePolicy & _STRINGCONVERTFLAG_SKIP ) {
+					nOut -= EncodeDstLen( uVal );
+				} else if ( ePolicy & _STRINGCONVERTFLAG_FAIL ) {
+					pOut[0] = 0;
+					return 0;
+				}
+			}
+		}
+		pOut[nOut] = 0;
+		return ( nOut + 1 ) * sizeof( DstType );
+	}
+
+	// Picks the reference loop of a source and destination pair
+	template<typename SrcType, typename DstType> struct Ref_t;
+	template<> struct Ref_t<char, uchar16> {
+		static constexpr auto* Convert{ &Ref_Convert<char, uchar16, Q_UTF8ToUChar32, Q_UChar32ToUTF16Len, Q_UChar32ToUTF16> };
+	};
+	template<> struct Ref_t<char, uchar32> {
+		static constexpr auto* Convert{ &Ref_Convert<char, uchar32, Q_UTF8ToUChar32, Ref_UChar32ToUTF32Len, Ref_UChar32ToUTF32> };
+	};
+	template<> struct Ref_t<uchar16, char> {
+		static constexpr auto* Convert{ &Ref_Convert<uchar16, char, Q_UTF16ToUChar32, Q_UChar32ToUTF8Len, Q_UChar32ToUTF8> };
+	};
+	template<> struct Ref_t<uchar16, uchar32> {
+		static constexpr auto* Convert{ &Ref_Convert<uchar16, uchar32, Q_UTF16ToUChar32, Ref_UChar32ToUTF32Len, Ref_UChar32ToUTF32> };
+	};
+	template<> struct Ref_t<uchar32, char> {
+		static constexpr auto* Convert{ &Ref_Convert<uchar32, char, Ref_UTF32ToUChar32, Q_UChar32ToUTF8Len, Q_UChar32ToUTF8> };
+	};
+	template<> struct Ref_t<uchar32, uchar16> {
+		static constexpr auto* Convert{ &Ref_Convert<uchar32, uchar16, Ref_UTF32ToUChar32, Q_UChar32ToUTF16Len, Q_UChar32ToUTF16> };
+	};
+
+	bool Ref_Validate( const char* pUTF8 ) {
+		while ( *pUTF8 ) {
+			uchar32 uVal;
+			bool bError;
+			const auto nCharSize{ Q_UTF8ToUChar32( pUTF8, uVal, bError ) };
+			if ( bError or nCharSize == 6 ) {
+				return false;
+			}
+			pUTF8 += nCharSize;
+		}
+		return true;
+	}
+	bool Ref_Validate( const uchar16* pUTF16 ) {
+		while ( *pUTF16 ) {
+			uchar32 uVal;
+			bool bError;
+			pUTF16 += Q_UTF16ToUChar32( pUTF16, uVal, bError );
+			if ( bError ) {
+				return false;
+			}
+		}
+		return true;
+	}
+	bool Ref_Validate( const uchar32* pUTF32 ) {
+		for ( ; *pUTF32; pUTF32 += 1 ) {
+			if (! Q_IsValidUChar32( *pUTF32 ) ) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	int Ref_Length( const char* pUTF8 ) {
+		auto nChars{ 0 };
+		for ( ; *pUTF8; nChars += 1 ) {
+			uchar32 uVal;
+			bool bError;
+			pUTF8 += Q_UTF8ToUChar32( pUTF8, uVal, bError );
+		}
+		return nChars;
+	}
+	int Ref_Length( const uchar16* pUTF16 ) {
+		auto nChars{ 0 };
+		for ( ; *pUTF16; nChars += 1 ) {
+			uchar32 uVal;
+			bool bError;
+			pUTF16 += Q_UTF16ToUChar32( pUTF16, uVal, bError );
+		}
+		return nChars;
+	}
+	int Ref_Length( const uchar32* pUTF32 ) {
+		auto nChars{ 0 };
+		while ( *pUTF32++ ) {
+			nChars += 1;
+		}
+		return nChars;
+	}
+
+	uint32 s_nSeed{ 0x6C078965 };
+	uint32 Random( uint32 nRange ) {
+		s_nSeed ^= s_nSeed << 13;
+		s_nSeed ^= s_nSeed >> 17;
+		s_nSeed ^= s_nSeed << 5;
+		return s_nSeed % nRange;
+	}
+
+	// Memory followed by a page which faults on any access, so reading or writing past the end crashes
+	class CGuardedBuffer {
+	public:
+		explicit CGuardedBuffer( int nBytes ) {
+			#if defined( PLATFORM_WINDOWS )
+				SYSTEM_INFO info;
+				GetSystemInfo( &info );
+				const int nPageSize = info.dwPageSize;
+			#else
+				const int nPageSize = sysconf( _SC_PAGESIZE );
+			#endif
+			m_nBytes = ( nBytes + nPageSize - 1 ) / nPageSize * nPageSize;
+			#if defined( PLATFORM_WINDOWS )
+				m_pBase = static_cast<byte*>( VirtualAlloc( nullptr, m_nBytes + nPageSize, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE ) );
+				DWORD oldProtect;
+				VirtualProtect( m_pBase + m_nBytes, nPageSize, PAGE_NOACCESS, &oldProtect );
+			#else
+				m_pBase = static_cast<byte*>( mmap( nullptr, m_nBytes + nPageSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 ) );
+				mprotect( m_pBase + m_nBytes, nPageSize, PROT_NONE );
+			#endif
+			m_nPageSize = nPageSize;
+		}
+		~CGuardedBuffer() {
+			#if defined( PLATFORM_WINDOWS )
+				VirtualFree( m_pBase, 0, MEM_RELEASE );
+			#else
+				munmap( m_pBase, m_nBytes + m_nPageSize );
+			#endif
+		}
+		CGuardedBuffer( const CGuardedBuffer& ) = delete;
+		CGuardedBuffer& operator=( const CGuardedBuffer& ) = delete;
+
+		// Room for `nCount` elements and `nSlackBytes` more, ending at the guard page
+		template<typename T>
+		T* End( int nCount, int nSlackBytes = 0 ) {
+			return reinterpret_cast<T*>( m_pBase + m_nBytes - nSlackBytes - nCount * sizeof( T ) );
+		}
+	private:
+		byte* m_pBase;
+		int m_nBytes;
+		int m_nPageSize;
+	};
+
+	constexpr int MAX_ELEMENTS{ 512 };
+	constexpr int COUNTED_SLACK{ 8 };  // the one-character decoders may look this far past the counted end
+	CGuardedBuffer* s_pInput;
+	CGuardedBuffer* s_pOutput;
+
+	// Mostly text the runs like, with everything they leave to the decoders mixed in
+	void GenerateUTF8( CUtlVector<char>& str, int nCount, bool bNulls ) {
+		const auto Push{ [&]( uint32 c ) { str.AddToTail( static_cast<char>( c ) ); } };
+		while ( str.Count() < nCount ) {
+			const auto nKind{ Random( 20 ) };
+			if ( nKind < 6 ) {
+				for ( auto i{ Random( 80 ) }; i > 0; i -= 1 ) {
+					Push( 0x20 + Random( 0x5F ) );
+				}
+			} else if ( nKind < 9 ) {
+				const auto c{ 0x80 + Random( 0x780 ) };
+				Push( 0xC0 | c >> 6 ); Push( 0x80 | ( c & 0x3F ) );
+			} else if ( nKind < 12 ) {
+				// sometimes a noncharacter or a surrogate
+				auto c{ 0x800 + Random( 0xF800 ) };
+				if ( Random( 4 ) == 0 ) {
+					c = 0xFDC0 + Random( 0x40 );
+				}
+				Push( 0xE0 | c >> 12 ); Push( 0x80 | ( ( c >> 6 ) & 0x3F ) ); Push( 0x80 | ( c & 0x3F ) );
+			} else if ( nKind < 13 ) {
+				// sometimes past U+10FFFF
+				auto c{ 0x10000 + Random( 0x100000 ) };
+				if ( Random( 4 ) == 0 ) {
+					c = 0x110000 + Random( 100 );
+				}
+				Push( 0xF0 | c >> 18 ); Push( 0x80 | ( ( c >> 12 ) & 0x3F ) ); Push( 0x80 | ( ( c >> 6 ) & 0x3F ) ); Push( 0x80 | ( c & 0x3F ) );
+			} else if ( nKind < 14 ) {
+				Push( Random( 256 ) );
+			} else if ( nKind < 15 ) {
+				// stray continuation byte
+				Push( 0x80 + Random( 0x40 ) );
+			} else if ( nKind < 16 ) {
+				// overlong 2 byte
+				Push( 0xC0 + Random( 2 ) ); Push( 0x80 + Random( 0x40 ) );
+			} else if ( nKind < 17 ) {
+				// overlong 3 byte
+				Push( 0xE0 ); Push( 0x80 + Random( 0x40 ) ); Push( 0x80 + Random( 0x40 ) );
+			} else if ( nKind < 18 ) {
+				// CESU-8 surrogate pair
+				for ( const auto c : { 0xD800 + Random( 0x400 ), 0xDC00 + Random( 0x400 ) } ) {
+					Push( 0xE0 | c >> 12 ); Push( 0x80 | ( ( c >> 6 ) & 0x3F ) ); Push( 0x80 | ( c & 0x3F ) );
+				}
+			} else if ( nKind < 19 ) {
+				// truncated 3 byte
+				const auto c{ 0x800 + Random( 0xF800 ) };
+				Push( 0xE0 | c >> 12 ); Push( 0x80 | ( ( c >> 6 ) & 0x3F ) );
+			} else if ( bNulls ) {
+				Push( 0 );
+			}
+		}
+		str.SetCountNonDestructively( nCount );
+	}
+
+	template<typename T>
+	void GenerateWide( CUtlVector<T>& str, int nCount, bool bNulls ) {
+		constexpr auto bUTF32{ sizeof( T ) == 4 };
+		while ( str.Count() < nCount ) {
+			const auto nKind{ Random( 16 ) };
+			if ( nKind < 5 ) {
+				for ( auto i{ Random( 60 ) }; i > 0; i -= 1 ) {
+					str.AddToTail( 0x20 + Random( 0x5F ) );
+				}
+			} else if ( nKind < 7 ) {
+				for ( auto i{ Random( 30 ) }; i > 0; i -= 1 ) {
+					str.AddToTail( 0x80 + Random( 0x780 ) );
+				}
+			} else if ( nKind < 9 ) {
+				for ( auto i{ Random( 30 ) }; i > 0; i -= 1 ) {
+					str.AddToTail( 0x800 + Random( 0xF800 ) );
+				}
+			} else if ( nKind < 10 ) {
+				// lone surrogate
+				str.AddToTail( 0xD800 + Random( 0x800 ) );
+			} else if ( nKind < 11 ) {
+				str.AddToTail( 0xD800 + Random( 0x400 ) );
+				str.AddToTail( 0xDC00 + Random( 0x400 ) );
+			} else if ( nKind < 12 ) {
+				// noncharacter
+				str.AddToTail( Random( 2 ) ? 0xFFFE + Random( 2 ) : 0xFDD0 + Random( 0x20 ) );
+			} else if ( nKind < 13 and bUTF32 ) {
+				str.AddToTail( static_cast<T>( 0x10000 + Random( 0x110000 ) ) );
+			} else if ( nKind < 14 and bUTF32 ) {
+				str.AddToTail( static_cast<T>( Random( 2 ) ? 0x80000000u + Random( 5 ) : 0xFFFF0000u + Random( 0x10000 ) ) );
+			} else if ( nKind < 15 ) {
+				str.AddToTail( static_cast<T>( Random( 0x10000 ) ) );
+			} else if ( bNulls ) {
+				str.AddToTail( 0 );
+			}
+		}
+		str.SetCountNonDestructively( nCount );
+	}
+
+	// How many characters start inside of `str`, the most a counted conversion of it may be asked for
+	template<typename T>
+	int CountChars( const CUtlVector<T>& str ) {
+		if constexpr ( sizeof( T ) == 4 ) {
+			return str.Count();
+		} else {
+			CUtlVector<T> padded;
+		padded.CopyArray( str.Base(), str.Count() );
+			for ( auto i{ 0 }; i < COUNTED_SLACK; i += 1 ) {
+				padded.AddToTail( 1 );
+			}
+			auto nChars{ 0 };
+			for ( auto i{ 0 }; i < str.Count(); nChars += 1 ) {
+				uchar32 uVal;
+				bool bError;
+				if constexpr ( sizeof( T ) == 1 ) {
+					i += Q_UTF8ToUChar32( padded.Base() + i, uVal, bError );
+				} else {
+					i += Q_UTF16ToUChar32( padded.Base() + i, uVal, bError );
+				}
+			}
+			return nChars;
+		}
+	}
+
+	int s_nIteration{ 0 };
+	int s_nFailures{ 0 };
+	void Check( bool bOk, const char* pTest, const char* pWhat ) {
+		if (! bOk ) {
+			if ( s_nFailures < 20 ) {
+				printf( "FAILED: iteration %d: %s: %s differ\n", s_nIteration, pTest, pWhat );
+			}
+			s_nFailures += 1;
+		}
+	}
+
+	// Converts with both the tier1 function and the reference, into guarded and plain buffers, and compares
+	template<typename SrcType, typename DstType, typename CONVERT>
+	void CompareConversion( const char* pTest, const SrcType* pIn, bool bStopAtNull, int nInChars, int nOutBytes, EStringConvertErrorPolicy ePolicy, CONVERT&& convert ) {
+		auto pOut{ s_pOutput->End<DstType>( nOutBytes / sizeof( DstType ) ) };
+		CUtlVector<DstType> ref;
+		ref.SetCount( nOutBytes / sizeof( DstType ) + 1 );
+		V_memset( pOut, 0xCC, nOutBytes );
+		V_memset( ref.Base(), 0xCC, ref.Count() * sizeof( DstType ) );
+
+		const auto nResult{ convert( pIn, nInChars, pOut, nOutBytes, ePolicy ) };
+		const auto nRefResult{ Ref_t<SrcType, DstType>::Convert( pIn, bStopAtNull, nInChars, ref.Base(), nOutBytes, ePolicy ) };
+		Check( nResult == nRefResult, pTest, "results" );
+		if ( nResult == nRefResult and nOutBytes >= static_cast<int>( sizeof( DstType ) ) ) {
+			// a failed conversion still terminates the output
+			const int nCompare = nResult ? nResult : sizeof( DstType );
+			Check( V_memcmp( pOut, ref.Base(), nCompare ) == 0, pTest, "outputs" );
+		}
+
+		// only measuring
+		Check( convert( pIn, nInChars, nullptr, 0, ePolicy ) == Ref_t<SrcType, DstType>::Convert( pIn, bStopAtNull, nInChars, nullptr, 0, ePolicy ), pTest, "required sizes" );
+	}
+
+	template<typename SrcType, typename DstType>
+	void TestConversion( const char* pName, const CUtlVector<SrcType>& src, int (*pfnConvert)( const SrcType*, DstType*, int, EStringConvertErrorPolicy ), int (*pfnConvertChars)( const SrcType*, int, DstType*, int, EStringConvertErrorPolicy ) ) {
+		static const EStringConvertErrorPolicy s_Policies[]{ STRINGCONVERT_REPLACE, STRINGCONVERT_SKIP, STRINGCONVERT_FAIL };
+		const auto ePolicy{ s_Policies[ Random( 3 ) ] };
+		// usually room for everything, else anything from no room at all to a bit short
+		auto nOutBytes{ Random( 3 ) ? static_cast<int>( ( src.Count() * 4 + 8 ) * sizeof( DstType ) ) : static_cast<int>( Random( src.Count() * 3 * sizeof( DstType ) + 8 ) ) };
+		nOutBytes &= ~static_cast<int>( sizeof( DstType ) - 1 );
+
+		char test[64];
+
+		// null terminated, the terminator right before the guard page
+		auto nLength{ 0 };
+		while ( nLength < src.Count() and src[ nLength ] ) {
+			nLength += 1;
+		}
+		auto pIn{ s_pInput->End<SrcType>( nLength + 1 ) };
+		V_memcpy( pIn, src.Base(), nLength * sizeof( SrcType ) );
+		pIn[ nLength ] = 0;
+		V_snprintf( test, sizeof( test ), "%s (null terminated)", pName );
+		CompareConversion<SrcType, DstType>( test, pIn, true, 0, nOutBytes, ePolicy, [&]( const SrcType* pSrc, int, DstType* pDst, int nBytes, EStringConvertErrorPolicy policy ) {
+			return pfnConvert( pSrc, pDst, nBytes, policy );
+		} );
+
+		// counted, with non-null garbage after it
+		pIn = s_pInput->End<SrcType>( src.Count(), COUNTED_SLACK );
+		V_memcpy( pIn, src.Base(), src.Count() * sizeof( SrcType ) );
+		for ( auto i{ 0 }; i < COUNTED_SLACK; i += 1 ) {
+			reinterpret_cast<byte*>( pIn + src.Count() )[ i ] = Random( 256 ) | 1;
+		}
+		V_snprintf( test, sizeof( test ), "%s (counted)", pName );
+		CompareConversion<SrcType, DstType>( test, pIn, false, Random( CountChars( src ) + 1 ), nOutBytes, ePolicy, pfnConvertChars );
+	}
+
+	template<typename T>
+	void TestValidateAndLength( const char* pName, const CUtlVector<T>& src ) {
+		auto nLength{ 0 };
+		while ( nLength < src.Count() and src[ nLength ] ) {
+			nLength += 1;
+		}
+		auto pIn{ s_pInput->End<T>( nLength + 1 ) };
+		V_memcpy( pIn, src.Base(), nLength * sizeof( T ) );
+		pIn[ nLength ] = 0;
+
+		char test[64];
+		V_snprintf( test, sizeof( test ), "%s Q_UnicodeValidate", pName );
+		Check( Q_UnicodeValidate( pIn ) == Ref_Validate( pIn ), test, "results" );
+		V_snprintf( test, sizeof( test ), "%s Q_UnicodeLength", pName );
+		Check( Q_UnicodeLength( pIn ) == Ref_Length( pIn ), test, "results" );
+	}
+}
+
+int main( int argc, char** argv ) {
+	auto nIterations{ 20000 };
+	for ( auto i{ 1 }; i < argc; i += 1 ) {
+		if ( V_stricmp( argv[i], "-sse2" ) == 0 ) {
+			DisableAVX2Technology();
+		} else if ( V_stricmp( argv[i], "-iterations" ) == 0 and i + 1 < argc ) {
+			nIterations = V_atoi( argv[ ++i ] );
+		} else if ( V_stricmp( argv[i], "-seed" ) == 0 and i + 1 < argc ) {
+			s_nSeed = V_atoi( argv[ ++i ] ) | 1;
+		} else {
+			printf( "usage: unicode_conformance [-sse2] [-iterations <count>] [-seed <number>]\n" );
+			return 1;
+		}
+	}
+	printf( "unicode_conformance: %d iterations against the %s runs\n", nIterations, CheckAVX2Technology() ? "AVX2" : "SSE2" );
+
+	// the biggest output is four times the input, in UTF-32, plus the terminator
+	CGuardedBuffer input{ ( MAX_ELEMENTS + COUNTED_SLACK ) * 4 };
+	CGuardedBuffer output{ ( MAX_ELEMENTS * 4 + 8 ) * 4 };
+	s_pInput = &input;
+	s_pOutput = &output;
+
+	for ( s_nIteration = 0; s_nIteration < nIterations; s_nIteration += 1 ) {
+		// a quarter shorter than a SIMD block, to hit the tails
+		const int nCount = Random( 4 ) == 0 ? Random( 16 ) : Random( MAX_ELEMENTS );
+
+		CUtlVector<char> utf8;
+		GenerateUTF8( utf8, nCount, Random( 2 ) );
+		TestConversion<char, uchar16>( "UTF8ToUTF16", utf8, Q_UTF8ToUTF16, Q_UTF8CharsToUTF16 );
+		TestConversion<char, uchar32>( "UTF8ToUTF32", utf8, Q_UTF8ToUTF32, Q_UTF8CharsToUTF32 );
+		TestValidateAndLength( "UTF8", utf8 );
+
+		CUtlVector<uchar16> utf16;
+		GenerateWide( utf16, nCount, Random( 2 ) );
+		TestConversion<uchar16, char>( "UTF16ToUTF8", utf16, Q_UTF16ToUTF8, Q_UTF16CharsToUTF8 );
+		TestConversion<uchar16, uchar32>( "UTF16ToUTF32", utf16, Q_UTF16ToUTF32, Q_UTF16CharsToUTF32 );
+		TestValidateAndLength( "UTF16", utf16 );
+
+		CUtlVector<uchar32> utf32;
+		GenerateWide( utf32, nCount, Random( 2 ) );
+		TestConversion<uchar32, char>( "UTF32ToUTF8", utf32, Q_UTF32ToUTF8, Q_UTF32CharsToUTF8 );
+		TestConversion<uchar32, uchar16>( "UTF32ToUTF16", utf32, Q_UTF32ToUTF16, Q_UTF32CharsToUTF16 );
+		TestValidateAndLength( "UTF32", utf32 );
+	}
+
+	if ( s_nFailures ) {
+		printf( "FAILED: %d checks\n", s_nFailures );
+		return 1;
+	}
+	printf( "all checks passed\n" );
+	return 0;
+}
@@ -9,107 +9,66 @@
 #include "vrad.h"
 #include "lightmap.h"
 
-#define SAMPLEHASH_NUM_BUCKETS			65536
-#define SAMPLEHASH_GROW_SIZE			0
-#define SAMPLEHASH_INIT_SIZE			0
+// enough for a mid-sized map, the tables grow past it as needed
+#define SAMPLEHASH_INIT_SIZE			16384
 
 int samplesAdded = 0;
 int patchSamplesAdded = 0;
 static unsigned short g_PatchIterationKey = 0;
 
-//-----------------------------------------------------------------------------
-//-----------------------------------------------------------------------------
-bool SampleData_CompareFunc( SampleData_t const &src1, SampleData_t const &src2 )
-{
-	return ( ( src1.x == src2.x ) &&
-		     ( src1.y == src2.y ) &&
-			 ( src1.z == src2.z ) );
-}
+SampleHashTable_t g_SampleHashTable( SAMPLEHASH_INIT_SIZE );
 
 
 //-----------------------------------------------------------------------------
 //-----------------------------------------------------------------------------
-unsigned int SampleData_KeyFunc( SampleData_t const &src )
+static SampleVoxel_t SampleData_GetVoxel( sample_t *pSample )
 {
-	return ( src.x + src.y + src.z );
+	SampleVoxel_t voxel;
+	voxel.x = ( int )( pSample->pos.x / SAMPLEHASH_VOXEL_SIZE ) * 100;
+	voxel.y = ( int )( pSample->pos.y / SAMPLEHASH_VOXEL_SIZE ) * 10;
+	voxel.z = ( int )( pSample->pos.z / SAMPLEHASH_VOXEL_SIZE );
+	return voxel;
 }
 
 
-CUtlHash<SampleData_t> g_SampleHashTable( SAMPLEHASH_NUM_BUCKETS, 
-										  SAMPLEHASH_GROW_SIZE, 
-										  SAMPLEHASH_INIT_SIZE, 
-										  SampleData_CompareFunc, SampleData_KeyFunc );
-
-
-
 //-----------------------------------------------------------------------------
+// Adds the sample to the data of its voxel, which is created if needed
 //-----------------------------------------------------------------------------
-UtlHashHandle_t SampleData_Find( sample_t *pSample )
+int SampleData_AddSample( sample_t *pSample, SampleHandle_t sampleHandle )
 {
-	SampleData_t sampleData;	
-	sampleData.x = ( int )( pSample->pos.x / SAMPLEHASH_VOXEL_SIZE ) * 100;
-	sampleData.y = ( int )( pSample->pos.y / SAMPLEHASH_VOXEL_SIZE ) * 10;
-	sampleData.z = ( int )( pSample->pos.z / SAMPLEHASH_VOXEL_SIZE );
-
-	return g_SampleHashTable.Find( sampleData );
-}
-
-
-//-----------------------------------------------------------------------------
-//-----------------------------------------------------------------------------
-UtlHashHandle_t SampleData_InsertIntoHashTable( sample_t *pSample, SampleHandle_t sampleHandle )
-{
-	SampleData_t sampleData;
-	sampleData.x = ( int )( pSample->pos.x / SAMPLEHASH_VOXEL_SIZE ) * 100;
-	sampleData.y = ( int )( pSample->pos.y / SAMPLEHASH_VOXEL_SIZE ) * 10;
-	sampleData.z = ( int )( pSample->pos.z / SAMPLEHASH_VOXEL_SIZE );
-
-	UtlHashHandle_t handle = g_SampleHashTable.AllocEntryFromKey( sampleData );
-
-	SampleData_t *pSampleData = &g_SampleHashTable.Element( handle );
-	pSampleData->x = sampleData.x;
-	pSampleData->y = sampleData.y;
-	pSampleData->z = sampleData.z;
-	pSampleData->m_Samples.AddToTail( sampleHandle );
+	int index = g_SampleHashTable.Insert( SampleData_GetVoxel( pSample ) );
+	g_SampleHashTable[index].m_Samples.AddToTail( sampleHandle );
 
 	samplesAdded++;
 
-	return handle;
+	return index;
 }
 
 
 //-----------------------------------------------------------------------------
 //-----------------------------------------------------------------------------
-UtlHashHandle_t SampleData_AddSample( sample_t *pSample, SampleHandle_t sampleHandle )
+static void SampleData_LogTable( FILE *fp, const char *pName, const UtlFlatHashMapStats_t &stats )
 {
-
-	// find the key -- if it doesn't exist add new sample data to the
-	// hash table
-	UtlHashHandle_t handle = SampleData_Find( pSample );
-	if( handle == g_SampleHashTable.InvalidHandle() )
-	{
-		handle = SampleData_InsertIntoHashTable( pSample, sampleHandle );
-	}
-	else
-	{
-		SampleData_t *pSampleData = &g_SampleHashTable.Element( handle );
-		pSampleData->m_Samples.AddToTail( sampleHandle );
-
-		samplesAdded++;
-	}
-
-	return handle;
+	fprintf( fp, "%s: %d voxels in %d slots, %d removed\n", pName, stats.m_nCount, stats.m_nSlots, stats.m_nDeleted );
+	fprintf( fp, "\tprobe groups: %.2f average, %d max\n", stats.m_flAvgProbeGroups, stats.m_nMaxProbeGroups );
 }
 
-
-//-----------------------------------------------------------------------------
-//-----------------------------------------------------------------------------
 void SampleData_Log()
 {
-	if( g_bLogHashData )
-	{
-		g_SampleHashTable.Log( "samplehash.txt" );
-	}
+	if( !g_bLogHashData )
+		return;
+
+	FILE *fp = fopen( "samplehash.txt", "w" );
+	if( !fp )
+		return;
+
+	UtlFlatHashMapStats_t stats;
+	g_SampleHashTable.GetStats( stats );
+	SampleData_LogTable( fp, "samples", stats );
+	g_PatchSampleHashTable.GetStats( stats );
+	SampleData_LogTable( fp, "patch samples", stats );
+
+	fclose( fp );
 }
 
 
@@ -121,28 +80,7 @@ void SampleData_Log()
 //=============================================================================
 //=============================================================================
 
-//-----------------------------------------------------------------------------
-//-----------------------------------------------------------------------------
-bool PatchSampleData_CompareFunc( PatchSampleData_t const &src1, PatchSampleData_t const &src2 )
-{
-	return ( ( src1.x == src2.x ) &&
-		     ( src1.y == src2.y ) &&
-			 ( src1.z == src2.z ) );
-}
-
-
-//-----------------------------------------------------------------------------
-//-----------------------------------------------------------------------------
-unsigned int PatchSampleData_KeyFunc( PatchSampleData_t const &src )
-{
-	return ( src.x + src.y + src.z );
-}
-
-
-CUtlHash<PatchSampleData_t>	g_PatchSampleHashTable( SAMPLEHASH_NUM_BUCKETS,
-												    SAMPLEHASH_GROW_SIZE,
-													SAMPLEHASH_INIT_SIZE,
-													PatchSampleData_CompareFunc, PatchSampleData_KeyFunc );
+PatchSampleHashTable_t g_PatchSampleHashTable( SAMPLEHASH_INIT_SIZE );
 
 void GetPatchSampleHashXYZ( const Vector &vOrigin, int &x, int &y, int &z )
 {
@@ -198,31 +136,15 @@ void PatchSampleData_AddSample( CPatch *pPatch, int ndxPatch )
 			{
 				// find the key -- if it doesn't exist add new sample data to the
 				// hash table
-				PatchSampleData_t iteratePatch;
-				iteratePatch.x = iterateCoords[0] * 100;
-				iteratePatch.y = iterateCoords[1] * 10;
-				iteratePatch.z = iterateCoords[2];
-
-				UtlHashHandle_t handle = g_PatchSampleHashTable.Find( iteratePatch );
-				if( handle == g_PatchSampleHashTable.InvalidHandle() )
-				{
-					UtlHashHandle_t handle = g_PatchSampleHashTable.AllocEntryFromKey( iteratePatch );
-
-					PatchSampleData_t *pPatchData = &g_PatchSampleHashTable.Element( handle );
-					pPatchData->x = iteratePatch.x;
-					pPatchData->y = iteratePatch.y;
-					pPatchData->z = iteratePatch.z;
-					pPatchData->m_ndxPatches.AddToTail( ndxPatch );
-
-					patchSamplesAdded++;
-				}
-				else
-				{
-					PatchSampleData_t *pPatchData = &g_PatchSampleHashTable.Element( handle );
-					pPatchData->m_ndxPatches.AddToTail( ndxPatch );
-
-					patchSamplesAdded++;
-				}
+				SampleVoxel_t voxel;
+				voxel.x = iterateCoords[0] * 100;
+				voxel.y = iterateCoords[1] * 10;
+				voxel.z = iterateCoords[2];
+
+				int index = g_PatchSampleHashTable.Insert( voxel );
+				g_PatchSampleHashTable[index].m_ndxPatches.AddToTail( ndxPatch );
+
+				patchSamplesAdded++;
 			}
 		}
 	}
@@ -22,7 +22,8 @@
 #include "polylib.h"
 #include "raytrace.h"
 #include "threads.h"
-#include "utlhash.h"
+#include "tier1/generichash.h"
+#include "tier1/utlflathashmap.h"
 #include "utlmemory.h"
 #include "utlvector.h"
 #include "vrad_dispcoll.h"
@@ -522,23 +523,34 @@ inline bool ValidDispFace( dface_t* pFace ) {
 typedef unsigned int SampleHandle_t;// the upper 16 bits = facelight index (works because max face are 65536)
 									// the lower 16 bits = sample index inside of facelight
 struct sample_t;
-struct SampleData_t {
+
+// Key of the sample hash tables, hashed as raw bytes so it must stay free of padding
+struct SampleVoxel_t {
 	unsigned short x, y, z;
+
+	bool operator==( const SampleVoxel_t& other ) const {
+		return x == other.x && y == other.y && z == other.z;
+	}
+};
+
+struct SampleData_t {
 	CUtlVector<SampleHandle_t> m_Samples;
 };
 
 struct PatchSampleData_t {
-	unsigned short x, y, z;
 	CUtlVector<int> m_ndxPatches;
 };
 
-UtlHashHandle_t SampleData_AddSample( sample_t* pSample, SampleHandle_t sampleHandle );
+typedef CUtlFlatHashMap<SampleVoxel_t, SampleData_t, XXHash3HashFunctor<SampleVoxel_t>> SampleHashTable_t;
+typedef CUtlFlatHashMap<SampleVoxel_t, PatchSampleData_t, XXHash3HashFunctor<SampleVoxel_t>> PatchSampleHashTable_t;
+
+int SampleData_AddSample( sample_t* pSample, SampleHandle_t sampleHandle );
 void PatchSampleData_AddSample( CPatch* pPatch, int ndxPatch );
 unsigned short IncrementPatchIterationKey();
 void SampleData_Log();
 
-extern CUtlHash<SampleData_t> g_SampleHashTable;
-extern CUtlHash<PatchSampleData_t> g_PatchSampleHashTable;
+extern SampleHashTable_t g_SampleHashTable;
+extern PatchSampleHashTable_t g_PatchSampleHashTable;
 
 extern int samplesAdded;
 extern int patchSamplesAdded;
@@ -140,7 +140,7 @@ set(VRAD_DLL_SOURCE_FILES
 	"${SRCDIR}/public/trace.h"
 	"${SRCDIR}/public/tier1/utlbuffer.h"
 	"${SRCDIR}/public/tier1/utldict.h"
-	"${SRCDIR}/public/tier1/utlhash.h"
+	"${SRCDIR}/public/tier1/utlflathashmap.h"
 	"${SRCDIR}/public/tier1/utllinkedlist.h"
 	"${SRCDIR}/public/tier1/utlmemory.h"
 	"${SRCDIR}/public/tier1/utlrbtree.h"
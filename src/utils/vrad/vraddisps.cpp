@@ -942,21 +942,21 @@ void CVRadDispMgr::RadialLuxelAddSamples( int ndxFace, Vector const &luxelPt, Ve
 		voxelMax[axis] = ( int )( ( luxelPt[axis] + radius ) * ooVoxelSize ) + 1;
 	}
 
-	SampleData_t sampleData;	
+	SampleVoxel_t voxel;
 	for( int ndxZ = voxelMin[2]; ndxZ < voxelMax[2] + 1; ndxZ++ )
 	{
 		for( int ndxY = voxelMin[1]; ndxY < voxelMax[1] + 1; ndxY++ )
 		{
 			for( int ndxX = voxelMin[0]; ndxX < voxelMax[0] + 1; ndxX++ )
 			{
-				sampleData.x = ndxX * 100;
-				sampleData.y = ndxY * 10;
-				sampleData.z = ndxZ;
+				voxel.x = ndxX * 100;
+				voxel.y = ndxY * 10;
+				voxel.z = ndxZ;
 				
-				UtlHashHandle_t handle = g_SampleHashTable.Find( sampleData );
-				if( handle != g_SampleHashTable.InvalidHandle() )
+				int index = g_SampleHashTable.Find( voxel );
+				if( index != g_SampleHashTable.InvalidIndex() )
 				{
-					SampleData_t *pSampleData = &g_SampleHashTable.Element( handle );
+					SampleData_t *pSampleData = &g_SampleHashTable.Element( index );
 					int count = pSampleData->m_Samples.Count();
 					for( int ndx = 0; ndx < count; ndx++ )
 					{
@@ -1205,21 +1205,21 @@ void CVRadDispMgr::RadialLuxelAddPatch( int ndxFace, Vector const &luxelPt,
 	}
 
 	unsigned short curIterationKey = IncrementPatchIterationKey();
-	PatchSampleData_t patchData;	
+	SampleVoxel_t voxel;
 	for ( int ndxZ = voxelMin[2]; ndxZ < voxelMax[2] + 1; ndxZ++ )
 	{
 		for ( int ndxY = voxelMin[1]; ndxY < voxelMax[1] + 1; ndxY++ )
 		{
 			for ( int ndxX = voxelMin[0]; ndxX < voxelMax[0] + 1; ndxX++ )
 			{
-				patchData.x = ndxX * 100;
-				patchData.y = ndxY * 10;
-				patchData.z = ndxZ;
+				voxel.x = ndxX * 100;
+				voxel.y = ndxY * 10;
+				voxel.z = ndxZ;
 				
-				UtlHashHandle_t handle = g_PatchSampleHashTable.Find( patchData );
-				if ( handle != g_PatchSampleHashTable.InvalidHandle() )
+				int index = g_PatchSampleHashTable.Find( voxel );
+				if ( index != g_PatchSampleHashTable.InvalidIndex() )
 				{
-					PatchSampleData_t *pPatchData = &g_PatchSampleHashTable.Element( handle );
+					PatchSampleData_t *pPatchData = &g_PatchSampleHashTable.Element( index );
 					int count = pPatchData->m_ndxPatches.Count();
 					for ( int ndx = 0; ndx < count; ndx++ )
 					{
@@ -1318,15 +1318,15 @@ void CVRadDispMgr::GetInterestingPatchesForLuxels(
 				if ( !val )
 					continue;
 				
-				PatchSampleData_t patchData;	
-				patchData.x = (x + allVoxelMin[0]) * 100;
-				patchData.y = (y + allVoxelMin[1]) * 10;
-				patchData.z = (z + allVoxelMin[2]);
+				SampleVoxel_t voxel;
+				voxel.x = (x + allVoxelMin[0]) * 100;
+				voxel.y = (y + allVoxelMin[1]) * 10;
+				voxel.z = (z + allVoxelMin[2]);
 				
-				UtlHashHandle_t handle = g_PatchSampleHashTable.Find( patchData );
-				if ( handle != g_PatchSampleHashTable.InvalidHandle() )
+				int index = g_PatchSampleHashTable.Find( voxel );
+				if ( index != g_PatchSampleHashTable.InvalidIndex() )
 				{
-					PatchSampleData_t *pPatchData = &g_PatchSampleHashTable.Element( handle );
+					PatchSampleData_t *pPatchData = &g_PatchSampleHashTable.Element( index );
 					
 					// For all patches that touch this hash table element..
 					for ( int ndx = 0; ndx < pPatchData->m_ndxPatches.Count(); ndx++ )
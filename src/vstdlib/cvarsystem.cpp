@@ -1,3 +1,554 @@
 //
 // Created by ENDERZOMBI102 on 09/02/2024.
 //
+#include "cvarsystem.hpp"
+#include "Color.h"
+#include "tier0/icommandline.h"
+#include "tier1/convar.h"
+#include "tier1/generichash.h"
+#include "tier1/interface.h"
+#include "tier1/strtools.h"
+#include <algorithm>
+
+
+namespace {
+	constexpr int INITIAL_TABLE_CAPACITY{ 1024 };
+	constexpr int CONSOLE_BUFFER_SIZE{ 4096 };
+
+	// Used when the engine didn't install its own, every convar pair is linkable
+	class CDefaultCvarQuery : public CBaseAppSystem<ICvarQuery> {
+	public:
+		void* QueryInterface( const char* pInterfaceName ) override {
+			return V_strcmp( pInterfaceName, CVAR_QUERY_INTERFACE_VERSION ) == 0 ? static_cast<ICvarQuery*>( this ) : nullptr;
+		}
+		bool AreConVarsLinkable( const ConVar* child, const ConVar* parent ) override { return true; }
+	};
+	CDefaultCvarQuery s_DefaultCvarQuery{};
+}
+
+ConCommandBase* const CCVarSystem::TOMBSTONE{ reinterpret_cast<ConCommandBase*>( 1 ) };
+
+CCVarSystem::CCVarSystem() {
+	m_pCVarQuery = &s_DefaultCvarQuery;
+	IndexRebuild( INITIAL_TABLE_CAPACITY );
+}
+
+CCVarSystem::~CCVarSystem() {
+	const auto table{ m_pTable.load() };
+	delete[] table->m_pSlots;
+	delete table;
+	for ( const auto retired : m_RetiredTables ) {
+		delete[] retired->m_pSlots;
+		delete retired;
+	}
+}
+
+CVarDLLIdentifier_t CCVarSystem::AllocateDLLIdentifier() {
+	return m_IdCounter++;
+}
+
+void CCVarSystem::RegisterConCommand( ConCommandBase* pCommandBase ) {
+	AUTO_LOCK( m_Mutex );
+	// Already registered
+	if ( pCommandBase->IsRegistered() ) {
+		return;
+	}
+	pCommandBase->m_bRegistered = true;
+
+	const auto name{ pCommandBase->GetName() };
+	if ( name == nullptr or name[0] == '\0' ) {
+		pCommandBase->m_pNext = nullptr;
+		return;
+	}
+
+	// If the variable is already defined, then setup the new variable as a proxy to it.
+	if ( const auto other{ Lookup( name ) } ) {
+		if ( pCommandBase->IsCommand() or other->IsCommand() ) {
+			Warning( "WARNING: unable to link %s and %s because one or more is a ConCommand.\n", name, other->GetName() );
+		} else {
+			LinkConVars( static_cast<ConVar*>( pCommandBase ), static_cast<ConVar*>( other ) );
+		}
+		pCommandBase->m_pNext = nullptr;
+		return;
+	}
+
+	pCommandBase->m_pNext = m_pConCommandList;
+	m_pConCommandList = pCommandBase;
+	IndexInsert( pCommandBase );
+}
+
+void CCVarSystem::UnregisterConCommand( ConCommandBase* pCommandBase ) {
+	AUTO_LOCK( m_Mutex );
+	if (! pCommandBase->IsRegistered() ) {
+		return;
+	}
+	pCommandBase->m_bRegistered = false;
+
+	// linked convars and nameless commands never made it to the list
+	ConCommandBase* prev{ nullptr };
+	for ( auto command{ m_pConCommandList }; command != nullptr; prev = command, command = command->m_pNext ) {
+		if ( command != pCommandBase ) {
+			continue;
+		}
+
+		if ( prev ) {
+			prev->m_pNext = command->m_pNext;
+		} else {
+			m_pConCommandList = command->m_pNext;
+		}
+		IndexRemove( command );
+		break;
+	}
+	pCommandBase->m_pNext = nullptr;
+}
+
+void CCVarSystem::UnregisterConCommands( CVarDLLIdentifier_t id ) {
+	AUTO_LOCK( m_Mutex );
+
+	// a single pass, rebuilding the list without the DLL's commands
+	ConCommandBase* newList{ nullptr };
+	ConCommandBase* tail{ nullptr };
+	for ( auto command{ m_pConCommandList }; command != nullptr; ) {
+		const auto next{ command->m_pNext };
+		if ( command->GetDLLIdentifier() == id ) {
+			command->m_bRegistered = false;
+			command->m_pNext = nullptr;
+			IndexRemove( command );
+		} else {
+			command->m_pNext = nullptr;
+			if ( tail ) {
+				tail->m_pNext = command;
+			} else {
+				newList = command;
+			}
+			tail = command;
+		}
+		command = next;
+	}
+	m_pConCommandList = newList;
+}
+
+const char* CCVarSystem::GetCommandLineValue( const char* pVariableName ) {
+	char search[256];
+	V_snprintf( search, sizeof( search ), "+%s", pVariableName );
+	return CommandLine()->ParmValue( search );
+}
+
+ConCommandBase* CCVarSystem::FindCommandBase( const char* name ) {
+	return Lookup( name );
+}
+const ConCommandBase* CCVarSystem::FindCommandBase( const char* name ) const {
+	return Lookup( name );
+}
+ConVar* CCVarSystem::FindVar( const char* var_name ) {
+	const auto command{ Lookup( var_name ) };
+	return command and not command->IsCommand() ? static_cast<ConVar*>( command ) : nullptr;
+}
+const ConVar* CCVarSystem::FindVar( const char* var_name ) const {
+	const auto command{ Lookup( var_name ) };
+	return command and not command->IsCommand() ? static_cast<ConVar*>( command ) : nullptr;
+}
+ConCommand* CCVarSystem::FindCommand( const char* name ) {
+	const auto command{ Lookup( name ) };
+	return command and command->IsCommand() ? static_cast<ConCommand*>( command ) : nullptr;
+}
+const ConCommand* CCVarSystem::FindCommand( const char* name ) const {
+	const auto command{ Lookup( name ) };
+	return command and command->IsCommand() ? static_cast<ConCommand*>( command ) : nullptr;
+}
+
+ConCommandBase* CCVarSystem::GetCommands() {
+	return m_pConCommandList;
+}
+const ConCommandBase* CCVarSystem::GetCommands() const {
+	return m_pConCommandList;
+}
+
+void CCVarSystem::InstallGlobalChangeCallback( FnChangeCallback_t callback ) {
+	Assert( callback and m_GlobalChangeCallbacks.Find( callback ) == m_GlobalChangeCallbacks.InvalidIndex() );
+	m_GlobalChangeCallbacks.AddToTail( callback );
+}
+void CCVarSystem::RemoveGlobalChangeCallback( FnChangeCallback_t callback ) {
+	Assert( callback );
+	m_GlobalChangeCallbacks.FindAndRemove( callback );
+}
+void CCVarSystem::CallGlobalChangeCallbacks( ConVar* var, const char* pOldString, float flOldValue ) {
+	if ( m_GlobalChangeCallbacks.Count() == 0 ) {
+		return;
+	}
+	if ( m_nChangeBatchDepth == 0 ) {
+		DispatchChange( var, pOldString, flOldValue );
+		return;
+	}
+
+	// only the value from before the batch matters
+	if ( m_QueuedChangeIndices.Find( var ) != m_QueuedChangeIndices.InvalidIndex() ) {
+		return;
+	}
+	const auto index{ m_QueuedChanges.AddToTail() };
+	m_QueuedChanges[index].m_pConVar = var;
+	m_QueuedChanges[index].m_OldString = pOldString;
+	m_QueuedChanges[index].m_flOldValue = flOldValue;
+	m_QueuedChangeIndices.Insert( var, index );
+}
+
+void CCVarSystem::BeginChangeBatch() {
+	m_nChangeBatchDepth += 1;
+}
+void CCVarSystem::EndChangeBatch() {
+	AssertMsg( m_nChangeBatchDepth > 0, "Unbalanced CCVarSystem::EndChangeBatch()" );
+	if ( --m_nChangeBatchDepth != 0 ) {
+		return;
+	}
+
+	// callbacks may change convars themselves, those go through right away
+	CUtlVector<QueuedChange_t> changes{};
+	changes.Swap( m_QueuedChanges );
+	m_QueuedChangeIndices.RemoveAll();
+
+	for ( const auto& change : changes ) {
+		// changed back to what it was, nothing happened as far as anyone can tell
+		if ( V_strcmp( change.m_pConVar->GetString(), change.m_OldString.Get() ) == 0 ) {
+			continue;
+		}
+		DispatchChange( change.m_pConVar, change.m_OldString.Get(), change.m_flOldValue );
+	}
+}
+
+void CCVarSystem::InstallConsoleDisplayFunc( IConsoleDisplayFunc* pDisplayFunc ) {
+	Assert( m_DisplayFuncs.Find( pDisplayFunc ) == m_DisplayFuncs.InvalidIndex() );
+	m_DisplayFuncs.AddToTail( pDisplayFunc );
+}
+void CCVarSystem::RemoveConsoleDisplayFunc( IConsoleDisplayFunc* pDisplayFunc ) {
+	m_DisplayFuncs.FindAndRemove( pDisplayFunc );
+}
+void CCVarSystem::ConsoleColorPrintf( const Color& clr, const char* pFormat, ... ) const {
+	char buffer[CONSOLE_BUFFER_SIZE];
+	va_list args;
+	va_start( args, pFormat );
+	V_vsnprintf( buffer, sizeof( buffer ), pFormat, args );
+	va_end( args );
+
+	for ( const auto func : m_DisplayFuncs ) {
+		func->ColorPrint( clr, buffer );
+	}
+}
+void CCVarSystem::ConsolePrintf( const char* pFormat, ... ) const {
+	char buffer[CONSOLE_BUFFER_SIZE];
+	va_list args;
+	va_start( args, pFormat );
+	V_vsnprintf( buffer, sizeof( buffer ), pFormat, args );
+	va_end( args );
+
+	for ( const auto func : m_DisplayFuncs ) {
+		func->Print( buffer );
+	}
+}
+void CCVarSystem::ConsoleDPrintf( const char* pFormat, ... ) const {
+	char buffer[CONSOLE_BUFFER_SIZE];
+	va_list args;
+	va_start( args, pFormat );
+	V_vsnprintf( buffer, sizeof( buffer ), pFormat, args );
+	va_end( args );
+
+	for ( const auto func : m_DisplayFuncs ) {
+		func->DPrint( buffer );
+	}
+}
+
+void CCVarSystem::RevertFlaggedConVars( int nFlag ) {
+	if ( nFlag == 0 ) {
+		return;
+	}
+
+	CUtlVector<ConCommandBase*> commands{};
+	GetAllCommands( commands, nFlag );
+
+	BeginChangeBatch();
+	for ( const auto command : commands ) {
+		if ( command->IsCommand() ) {
+			continue;
+		}
+
+		const auto var{ static_cast<ConVar*>( command ) };
+		// It's == to the default value, don't count
+		if ( V_stricmp( var->GetDefault(), var->GetString() ) == 0 ) {
+			continue;
+		}
+		var->Revert();
+	}
+	EndChangeBatch();
+}
+
+void CCVarSystem::InstallCVarQuery( ICvarQuery* pQuery ) {
+	Assert( m_pCVarQuery == &s_DefaultCvarQuery );
+	m_pCVarQuery = pQuery ? pQuery : &s_DefaultCvarQuery;
+}
+
+bool CCVarSystem::IsMaterialThreadSetAllowed() const {
+	Assert( ThreadInMainThread() );
+	return m_bMaterialSystemThreadSetAllowed;
+}
+void CCVarSystem::QueueMaterialThreadSetValue( ConVar* pConVar, const char* pValue ) {
+	AUTO_LOCK( m_Mutex );
+	const auto index{ m_QueuedConVarSets.AddToTail() };
+	m_QueuedConVarSets[index].m_pConVar = pConVar;
+	m_QueuedConVarSets[index].m_Type = QueuedConVarSet_t::STRING;
+	m_QueuedConVarSets[index].m_String = pValue;
+}
+void CCVarSystem::QueueMaterialThreadSetValue( ConVar* pConVar, int nValue ) {
+	AUTO_LOCK( m_Mutex );
+	const auto index{ m_QueuedConVarSets.AddToTail() };
+	m_QueuedConVarSets[index].m_pConVar = pConVar;
+	m_QueuedConVarSets[index].m_Type = QueuedConVarSet_t::INT;
+	m_QueuedConVarSets[index].m_nValue = nValue;
+}
+void CCVarSystem::QueueMaterialThreadSetValue( ConVar* pConVar, float flValue ) {
+	AUTO_LOCK( m_Mutex );
+	const auto index{ m_QueuedConVarSets.AddToTail() };
+	m_QueuedConVarSets[index].m_pConVar = pConVar;
+	m_QueuedConVarSets[index].m_Type = QueuedConVarSet_t::FLOAT;
+	m_QueuedConVarSets[index].m_flValue = flValue;
+}
+bool CCVarSystem::HasQueuedMaterialThreadConVarSets() const {
+	return m_QueuedConVarSets.Count() != 0;
+}
+int CCVarSystem::ProcessQueuedMaterialThreadConVarSets() {
+	CUtlVector<QueuedConVarSet_t> sets{};
+	m_Mutex.Lock();
+		sets.Swap( m_QueuedConVarSets );
+	m_Mutex.Unlock();
+
+	m_bMaterialSystemThreadSetAllowed = true;
+	BeginChangeBatch();
+
+	auto updateFlags{ 0 };
+	for ( const auto& set : sets ) {
+		switch ( set.m_Type ) {
+			case QueuedConVarSet_t::STRING:
+				set.m_pConVar->SetValue( set.m_String.Get() );
+				break;
+			case QueuedConVarSet_t::INT:
+				set.m_pConVar->SetValue( set.m_nValue );
+				break;
+			case QueuedConVarSet_t::FLOAT:
+				set.m_pConVar->SetValue( set.m_flValue );
+				break;
+		}
+		updateFlags |= set.m_pConVar->GetFlags() & FCVAR_MATERIAL_THREAD_MASK;
+	}
+
+	EndChangeBatch();
+	m_bMaterialSystemThreadSetAllowed = false;
+	return updateFlags;
+}
+
+void CCVarSystem::GetAllCommands( CUtlVector<ConCommandBase*>& commands, int nFlags, bool bSorted ) const {
+	const auto table{ m_pTable.load( std::memory_order_acquire ) };
+	commands.EnsureCapacity( commands.Count() + table->m_nLive );
+
+	for ( auto i{0}; i < table->m_nCapacity; i += 1 ) {
+		const auto command{ table->m_pSlots[i].m_pCommand.load( std::memory_order_acquire ) };
+		if ( command == nullptr or command == TOMBSTONE ) {
+			continue;
+		}
+		if ( nFlags == 0 or command->IsFlagSet( nFlags ) ) {
+			commands.AddToTail( command );
+		}
+	}
+
+	if ( bSorted ) {
+		std::sort( commands.begin(), commands.end(), []( const ConCommandBase* a, const ConCommandBase* b ) {
+			return V_stricmp( a->GetName(), b->GetName() ) < 0;
+		} );
+	}
+}
+
+ConCommandBase* CCVarSystem::Lookup( const char* name ) const {
+	if ( name == nullptr or name[0] == '\0' ) {
+		return nullptr;
+	}
+
+	const auto hash{ HashStringCaseless( name ) };
+	const auto table{ m_pTable.load( std::memory_order_acquire ) };
+	const auto mask{ table->m_nCapacity - 1 };
+
+	// there's always an empty slot, so this ends
+	for ( auto i{ static_cast<int>( hash & mask ) }; ; i = ( i + 1 ) & mask ) {
+		const auto& slot{ table->m_pSlots[i] };
+		const auto command{ slot.m_pCommand.load( std::memory_order_acquire ) };
+		if ( command == nullptr ) {
+			return nullptr;
+		}
+		if ( command != TOMBSTONE and slot.m_nHash.load( std::memory_order_relaxed ) == hash and V_stricmp( command->GetName(), name ) == 0 ) {
+			return command;
+		}
+	}
+}
+
+void CCVarSystem::IndexInsert( ConCommandBase* pCommand ) {
+	auto table{ m_pTable.load( std::memory_order_relaxed ) };
+	// keep it at most 3/4 full, tombstones included
+	if ( ( table->m_nUsed + 1 ) * 4 > table->m_nCapacity * 3 ) {
+		// mostly tombstones? then the same size will do
+		IndexRebuild( ( table->m_nLive + 1 ) * 2 > table->m_nCapacity ? table->m_nCapacity * 2 : table->m_nCapacity );
+		table = m_pTable.load( std::memory_order_relaxed );
+	}
+
+	const auto hash{ HashStringCaseless( pCommand->GetName() ) };
+	const auto mask{ table->m_nCapacity - 1 };
+	for ( auto i{ static_cast<int>( hash & mask ) }; ; i = ( i + 1 ) & mask ) {
+		auto& slot{ table->m_pSlots[i] };
+		const auto current{ slot.m_pCommand.load( std::memory_order_relaxed ) };
+		if ( current == nullptr or current == TOMBSTONE ) {
+			// readers skip tombstones without looking at the hash, and see the hash once the command is published
+			slot.m_nHash.store( hash, std::memory_order_relaxed );
+			slot.m_pCommand.store( pCommand, std::memory_order_release );
+			if ( current == nullptr ) {
+				table->m_nUsed += 1;
+			}
+			table->m_nLive += 1;
+			return;
+		}
+	}
+}
+
+void CCVarSystem::IndexRemove( ConCommandBase* pCommand ) {
+	const auto table{ m_pTable.load( std::memory_order_relaxed ) };
+	const auto hash{ HashStringCaseless( pCommand->GetName() ) };
+	const auto mask{ table->m_nCapacity - 1 };
+
+	for ( auto i{ static_cast<int>( hash & mask ) }; ; i = ( i + 1 ) & mask ) {
+		auto& slot{ table->m_pSlots[i] };
+		const auto current{ slot.m_pCommand.load( std::memory_order_relaxed ) };
+		if ( current == nullptr ) {
+			return;
+		}
+		if ( current == pCommand ) {
+			slot.m_pCommand.store( TOMBSTONE, std::memory_order_release );
+			table->m_nLive -= 1;
+			return;
+		}
+	}
+}
+
+void CCVarSystem::IndexRebuild( int nCapacity ) {
+	const auto table{ new CommandTable_t{ nCapacity, 0, 0, new CommandSlot_t[nCapacity]{} } };
+
+	const auto old{ m_pTable.load( std::memory_order_relaxed ) };
+	if ( old ) {
+		const auto mask{ nCapacity - 1 };
+		for ( auto j{0}; j < old->m_nCapacity; j += 1 ) {
+			const auto command{ old->m_pSlots[j].m_pCommand.load( std::memory_order_relaxed ) };
+			if ( command == nullptr or command == TOMBSTONE ) {
+				continue;
+			}
+
+			const auto hash{ old->m_pSlots[j].m_nHash.load( std::memory_order_relaxed ) };
+			auto i{ static_cast<int>( hash & mask ) };
+			while ( table->m_pSlots[i].m_pCommand.load( std::memory_order_relaxed ) != nullptr ) {
+				i = ( i + 1 ) & mask;
+			}
+			table->m_pSlots[i].m_nHash.store( hash, std::memory_order_relaxed );
+			table->m_pSlots[i].m_pCommand.store( command, std::memory_order_relaxed );
+			table->m_nUsed += 1;
+			table->m_nLive += 1;
+		}
+		// readers may still be probing it
+		m_RetiredTables.AddToTail( old );
+	}
+
+	m_pTable.store( table, std::memory_order_release );
+}
+
+void CCVarSystem::LinkConVars( ConVar* pChild, ConVar* pParent ) {
+	// See if it's a valid linkage
+	if (! m_pCVarQuery->AreConVarsLinkable( pChild, pParent ) ) {
+		return;
+	}
+
+	// Make sure the default values are the same (but only spew about this for FCVAR_REPLICATED)
+	if ( pChild->m_pszDefaultValue and pParent->m_pszDefaultValue and pChild->IsFlagSet( FCVAR_REPLICATED ) and pParent->IsFlagSet( FCVAR_REPLICATED ) ) {
+		if ( V_stricmp( pChild->m_pszDefaultValue, pParent->m_pszDefaultValue ) != 0 ) {
+			Warning( "Parent and child ConVars with different default values! %s child: %s parent: %s (parent wins)\n", pChild->GetName(), pChild->m_pszDefaultValue, pParent->m_pszDefaultValue );
+		}
+	}
+
+	pChild->m_pParent = pParent->m_pParent;
+
+	// Absorb material thread related convar flags
+	pParent->m_nFlags |= pChild->m_nFlags & ( FCVAR_MATERIAL_THREAD_MASK | FCVAR_ACCESSIBLE_FROM_THREADS );
+
+	// check the parent's callbacks and slam if doesn't have, warn if both have callbacks
+	if ( pChild->m_fnChangeCallback ) {
+		if (! pParent->m_fnChangeCallback ) {
+			pParent->m_fnChangeCallback = pChild->m_fnChangeCallback;
+		} else {
+			Warning( "Convar %s has multiple different change callbacks\n", pChild->GetName() );
+		}
+	}
+
+	// make sure we don't have conflicting help strings.
+	if ( pChild->m_pszHelpString and pChild->m_pszHelpString[0] ) {
+		if ( pParent->m_pszHelpString and pParent->m_pszHelpString[0] ) {
+			if ( V_stricmp( pParent->m_pszHelpString, pChild->m_pszHelpString ) != 0 ) {
+				Warning( "Convar %s has multiple help strings:\n\tparent (wins): \"%s\"\n\tchild: \"%s\"\n", pChild->GetName(), pParent->m_pszHelpString, pChild->m_pszHelpString );
+			}
+		} else {
+			pParent->m_pszHelpString = pChild->m_pszHelpString;
+		}
+	}
+
+	// make sure we don't have conflicting FCVAR_CHEAT and FCVAR_REPLICATED flags.
+	if ( ( pChild->m_nFlags & FCVAR_CHEAT ) != ( pParent->m_nFlags & FCVAR_CHEAT ) ) {
+		Warning( "Convar %s has conflicting FCVAR_CHEAT flags (child: %s, parent: %s, parent wins)\n", pChild->GetName(), pChild->m_nFlags & FCVAR_CHEAT ? "FCVAR_CHEAT" : "no FCVAR_CHEAT", pParent->m_nFlags & FCVAR_CHEAT ? "FCVAR_CHEAT" : "no FCVAR_CHEAT" );
+	}
+	if ( ( pChild->m_nFlags & FCVAR_REPLICATED ) != ( pParent->m_nFlags & FCVAR_REPLICATED ) ) {
+		Warning( "Convar %s has conflicting FCVAR_REPLICATED flags (child: %s, parent: %s, parent wins)\n", pChild->GetName(), pChild->m_nFlags & FCVAR_REPLICATED ? "FCVAR_REPLICATED" : "no FCVAR_REPLICATED", pParent->m_nFlags & FCVAR_REPLICATED ? "FCVAR_REPLICATED" : "no FCVAR_REPLICATED" );
+	}
+}
+
+void CCVarSystem::DispatchChange( ConVar* var, const char* pOldString, float flOldValue ) {
+	for ( const auto callback : m_GlobalChangeCallbacks ) {
+		callback( var, pOldString, flOldValue );
+	}
+}
+
+
+ICvar::ICVarIteratorInternal* CCVarSystem::FactoryInternalIterator() {
+	return new CCVarSystemIterator( this );
+}
+
+void CCVarSystem::CCVarSystemIterator::SetFirst() {
+	// keep walking the table we started with, even if it gets replaced
+	m_pTable = m_pSystem->m_pTable.load( std::memory_order_acquire );
+	m_nSlot = -1;
+	Next();
+}
+void CCVarSystem::CCVarSystemIterator::Next() {
+	while ( ++m_nSlot < m_pTable->m_nCapacity ) {
+		const auto command{ m_pTable->m_pSlots[m_nSlot].m_pCommand.load( std::memory_order_acquire ) };
+		if ( command != nullptr and command != TOMBSTONE ) {
+			return;
+		}
+	}
+}
+bool CCVarSystem::CCVarSystemIterator::IsValid() {
+	return m_pTable and m_nSlot < m_pTable->m_nCapacity;
+}
+ConCommandBase* CCVarSystem::CCVarSystemIterator::Get() {
+	if (! IsValid() ) {
+		return nullptr;
+	}
+	// may have been unregistered since `Next()`
+	const auto command{ m_pTable->m_pSlots[m_nSlot].m_pCommand.load( std::memory_order_acquire ) };
+	return command == TOMBSTONE ? nullptr : command;
+}
+
+
+static CCVarSystem s_CVarSystem{};
+EXPOSE_SINGLE_INTERFACE_GLOBALVAR( CCVarSystem, ICvar, CVAR_INTERFACE_VERSION, s_CVarSystem );
+
+CreateInterfaceFn VStdLib_GetICVarFactory() {
+	return Sys_GetFactoryThis();
+}
@@ -3,9 +3,18 @@
 //
 #pragma once
 
+#include "tier0/threadtools.h"
+#include "tier1/utlmap.h"
+#include "tier1/utlstring.h"
+#include "tier1/utlvector.h"
 #include "vstdlib/cvar.h"
+#include <atomic>
+
+class CCVarSystem : public CBaseAppSystem<ICvar> {
+public:
+	CCVarSystem();
+	~CCVarSystem();
 
-class CCVarSystem : public ICvar {
 	// Allocate a unique DLL identifier
 	CVarDLLIdentifier_t AllocateDLLIdentifier() override;
 
@@ -56,20 +65,94 @@ class CCVarSystem : public ICvar {
 	void QueueMaterialThreadSetValue( ConVar * pConVar, float flValue ) override;
 	bool HasQueuedMaterialThreadConVarSets() const override;
 	int ProcessQueuedMaterialThreadConVarSets() override;
+public:
+	/**
+	 * While a batch is open, global change callbacks are queued instead of called;
+	 * they're called once per changed convar, with its value from before the batch, when the outermost batch ends.
+	 */
+	void BeginChangeBatch();
+	void EndChangeBatch();
+
+	/**
+	 * Collects every registered command, without walking the linked list.
+	 * @param nFlags If not 0, only commands with any of these flags are collected.
+	 * @param bSorted Whether to sort them by name.
+	 */
+	void GetAllCommands( CUtlVector<ConCommandBase*>& commands, int nFlags = 0, bool bSorted = false ) const;
+private:
+	/**
+	 * Open addressing (linear probing) index of the registered commands, by case-insensitive name.
+	 * Readers don't lock: slots are published with release stores, removed commands leave a tombstone,
+	 * and when the table grows the old one is kept alive until shutdown, as a reader may still be probing it.
+	 */
+	struct CommandSlot_t {
+		std::atomic<uint32> m_nHash;
+		std::atomic<ConCommandBase*> m_pCommand;
+	};
+	struct CommandTable_t {
+		int m_nCapacity;  // power of two
+		int m_nUsed{ 0 };  // commands and tombstones
+		int m_nLive{ 0 };
+		CommandSlot_t* m_pSlots;
+	};
+	static ConCommandBase* const TOMBSTONE;
 protected:
 	// internals for  ICVarIterator
 	class CCVarSystemIterator : public ICVarIteratorInternal {
 	public:
+		explicit CCVarSystemIterator( const CCVarSystem* pSystem ) : m_pSystem( pSystem ) { }
 		// warning: delete called on 'ICvar::ICVarIteratorInternal' that is abstract but has non-virtual destructor [-Wdelete-non-virtual-dtor]
 		~CCVarSystemIterator() override = default;
 		void SetFirst() override;
 		void Next() override;
 		bool IsValid() override;
 		ConCommandBase* Get() override;
+	private:
+		const CCVarSystem* m_pSystem;
+		const CommandTable_t* m_pTable{ nullptr };
+		int m_nSlot{ 0 };
 	};
 
-	virtual ICVarIteratorInternal* FactoryInternalIterator() = 0;
-	friend class Iterator;
+	ICVarIteratorInternal* FactoryInternalIterator() override;
+private:
+	[[nodiscard]]
+	ConCommandBase* Lookup( const char* name ) const;
+	// Must hold `m_Mutex`
+	void IndexInsert( ConCommandBase* pCommand );
+	void IndexRemove( ConCommandBase* pCommand );
+	void IndexRebuild( int nCapacity );
+
+	void LinkConVars( ConVar* pChild, ConVar* pParent );
+	void DispatchChange( ConVar* var, const char* pOldString, float flOldValue );
+
+	struct QueuedChange_t {
+		ConVar* m_pConVar;
+		CUtlString m_OldString;
+		float m_flOldValue;
+	};
+	struct QueuedConVarSet_t {
+		ConVar* m_pConVar;
+		enum { STRING, INT, FLOAT } m_Type;
+		CUtlString m_String;
+		int m_nValue;
+		float m_flValue;
+	};
 private:
 	int m_IdCounter{ 0 };
+
+	mutable CThreadFastMutex m_Mutex{};
+	std::atomic<CommandTable_t*> m_pTable{ nullptr };
+	CUtlVector<CommandTable_t*> m_RetiredTables{};
+	ConCommandBase* m_pConCommandList{ nullptr };
+
+	CUtlVector<FnChangeCallback_t> m_GlobalChangeCallbacks{};
+	int m_nChangeBatchDepth{ 0 };
+	CUtlVector<QueuedChange_t> m_QueuedChanges{};
+	CUtlMap<ConVar*, int> m_QueuedChangeIndices{ DefLessFunc( ConVar* ) };
+
+	CUtlVector<IConsoleDisplayFunc*> m_DisplayFuncs{};
+	ICvarQuery* m_pCVarQuery{ nullptr };
+
+	CUtlVector<QueuedConVarSet_t> m_QueuedConVarSets{};
+	bool m_bMaterialSystemThreadSetAllowed{ false };
 };
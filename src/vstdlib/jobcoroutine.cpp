@@ -0,0 +1,49 @@
+//
+// Created by ENDERZOMBI102 on 18/10/2026.
+//
+#include "vstdlib/jobcoroutine.h"
+#include "tier0/tslist.h"
+
+
+namespace {
+	// frames are bucketed in power-of-two classes from 64 bytes to 8KiB, bigger ones aren't worth keeping around
+	constexpr size_t MIN_FRAME_CLASS_SHIFT{ 6 };
+	constexpr size_t MAX_FRAME_CLASS_SHIFT{ 13 };
+	constexpr int FRAME_CLASS_COUNT{ MAX_FRAME_CLASS_SHIFT - MIN_FRAME_CLASS_SHIFT + 1 };
+	// how many free frames a class may hold on to
+	constexpr int MAX_CACHED_FRAMES{ 256 };
+	// the compiler lays frames out for `operator new`'s alignment, which is more than a list node's on 32-bit
+	constexpr size_t FRAME_ALIGNMENT{ MAX( __STDCPP_DEFAULT_NEW_ALIGNMENT__, TSLIST_NODE_ALIGNMENT ) };
+
+	CTSListBase s_FreeFrames[FRAME_CLASS_COUNT];
+
+	int FrameClassFor( size_t size ) {
+		auto shift{ MIN_FRAME_CLASS_SHIFT };
+		while ( ( size_t{ 1 } << shift ) < size ) {
+			shift += 1;
+		}
+		return shift > MAX_FRAME_CLASS_SHIFT ? -1 : static_cast<int>( shift - MIN_FRAME_CLASS_SHIFT );
+	}
+}
+
+void* JobCoroutine_AllocFrame( size_t size ) {
+	const auto frameClass{ FrameClassFor( size ) };
+	if ( frameClass == -1 ) {
+		return MemAlloc_AllocAligned( size, FRAME_ALIGNMENT );
+	}
+
+	if ( const auto frame{ s_FreeFrames[frameClass].Pop() } ) {
+		return frame;
+	}
+	return MemAlloc_AllocAligned( size_t{ 1 } << ( frameClass + MIN_FRAME_CLASS_SHIFT ), FRAME_ALIGNMENT );
+}
+
+void JobCoroutine_FreeFrame( void* pFrame, size_t size ) {
+	const auto frameClass{ FrameClassFor( size ) };
+	if ( frameClass == -1 or s_FreeFrames[frameClass].Count() >= MAX_CACHED_FRAMES ) {
+		MemAlloc_FreeAligned( pFrame );
+		return;
+	}
+
+	s_FreeFrames[frameClass].Push( static_cast<TSLNodeBase_t*>( pFrame ) );
+}
@@ -0,0 +1,241 @@
+//
+// Created by ENDERZOMBI102 on 18/10/2026.
+//
+#include "vstdlib/jobgraph.h"
+#include "tier0/dbg.h"
+
+
+// Job which runs a single task (and whatever it makes ready) of a graph
+class CJobGraphTaskJob : public CJob {
+public:
+	CJobGraphTaskJob( CJobGraph* pGraph, JobGraphTask_t task )
+		: CJob( pGraph->m_Tasks[task]->m_Priority ), m_pGraph( pGraph ), m_Task( task ) {
+		SetDescription( pGraph->m_Tasks[task]->m_pszName );
+	}
+private:
+	JobStatus_t DoExecute() override {
+		m_pGraph->Execute( m_Task );
+		return JOB_OK;
+	}
+	JobStatus_t DoAbort( bool bDiscard ) override {
+		// the graph must still get to the end, so skip this task and everything after it
+		m_pGraph->Cancel();
+		m_pGraph->Execute( m_Task );
+		return JOB_STATUS_ABORTED;
+	}
+private:
+	CJobGraph* m_pGraph;
+	JobGraphTask_t m_Task;
+};
+
+
+CJobGraph::CJobGraph( const char* pszName, IThreadPool* pPool )
+	: m_szName( pszName ), m_pPool( pPool ) { }
+
+CJobGraph::~CJobGraph() {
+	AssertMsg( not IsRunning(), "Destroying job graph `%s` while it's running", m_szName );
+	RemoveAll();
+}
+
+JobGraphTask_t CJobGraph::AddTask( const char* pszName, CFunctor* pFunctor, std::initializer_list<JobGraphTask_t> predecessors, JobPriority_t priority ) {
+	AssertMsg( not IsRunning(), "Tried to modify job graph `%s` while it's running", m_szName );
+
+	const auto task{ new Task_t{} };
+	task->m_pszName = pszName;
+	task->m_pFunctor = pFunctor;
+	task->m_Priority = priority;
+	const JobGraphTask_t handle{ m_Tasks.AddToTail( task ) };
+
+	for ( const auto predecessor : predecessors ) {
+		AddDependency( handle, predecessor );
+	}
+	m_bValidated = false;
+
+	return handle;
+}
+
+void CJobGraph::AddDependency( JobGraphTask_t task, JobGraphTask_t predecessor ) {
+	AssertMsg( not IsRunning(), "Tried to modify job graph `%s` while it's running", m_szName );
+	if (! m_Tasks.IsValidIndex( task ) or not m_Tasks.IsValidIndex( predecessor ) or task == predecessor ) {
+		AssertMsg( false, "Invalid dependency %d -> %d in job graph `%s`", predecessor, task, m_szName );
+		return;
+	}
+
+	// duplicate edges would make the task wait forever
+	auto& successors{ m_Tasks[predecessor]->m_Successors };
+	if ( successors.Find( task ) != successors.InvalidIndex() ) {
+		return;
+	}
+
+	successors.AddToTail( task );
+	m_Tasks[task]->m_nPredecessors += 1;
+	m_bValidated = false;
+}
+
+void CJobGraph::RemoveAll() {
+	AssertMsg( not IsRunning(), "Tried to modify job graph `%s` while it's running", m_szName );
+
+	for ( const auto task : m_Tasks ) {
+		task->m_pFunctor->Release();
+		delete task;
+	}
+	m_Tasks.RemoveAll();
+	m_Roots.RemoveAll();
+	m_bValidated = false;
+}
+
+void CJobGraph::Start() {
+	AssertMsg( not IsRunning(), "Tried to start job graph `%s` while it's already running", m_szName );
+
+	if ( not m_bValidated ) {
+		if (! IsAcyclic() ) {
+			AssertMsg( false, "Job graph `%s` has a dependency cycle", m_szName );
+			m_bCancelled = true;
+			return;
+		}
+
+		m_Roots.RemoveAll();
+		for ( auto i{0}; i < m_Tasks.Count(); i += 1 ) {
+			if ( m_Tasks[i]->m_nPredecessors == 0 ) {
+				m_Roots.AddToTail( i );
+			}
+		}
+		m_bValidated = true;
+	}
+
+	if ( m_pPool == nullptr ) {
+		m_pPool = g_pThreadPool;
+	}
+
+	// reset the per-run state
+	m_bCancelled = false;
+	m_Finished.Reset();
+	for ( const auto task : m_Tasks ) {
+		task->m_nPending = task->m_nPredecessors;
+		task->m_flStart = task->m_flEnd = 0;
+		task->m_bSkipped = false;
+	}
+	m_flStart = Plat_FloatTime();
+	m_flEnd = m_flStart;
+
+	if ( m_Tasks.Count() == 0 ) {
+		m_Finished.Set();
+		return;
+	}
+	m_nRemaining = m_Tasks.Count();
+
+	for ( const auto root : m_Roots ) {
+		Submit( root );
+	}
+}
+
+bool CJobGraph::WaitForFinish( unsigned timeout ) {
+	if ( IsRunning() and not m_pPool->YieldWait( m_Finished, timeout ) ) {
+		return false;
+	}
+	return not m_bCancelled;
+}
+
+void CJobGraph::Cancel() {
+	m_bCancelled = true;
+}
+
+void CJobGraph::DumpTimings() const {
+	Msg( "Job graph `%s`: %d tasks, %.3fms%s\n", m_szName, m_Tasks.Count(), ( m_flEnd - m_flStart ) * 1000.0, m_bCancelled ? " (cancelled)" : "" );
+
+	for ( auto i{0}; i < m_Tasks.Count(); i += 1 ) {
+		const auto task{ m_Tasks[i] };
+		if ( task->m_bSkipped ) {
+			Msg( "  [%3d] %-32s skipped\n", i, task->m_pszName );
+			continue;
+		}
+		Msg(
+			"  [%3d] %-32s thread %-8u start %8.3fms  duration %8.3fms\n",
+			i, task->m_pszName, static_cast<uint>( task->m_Thread ),
+			( task->m_flStart - m_flStart ) * 1000.0,
+			( task->m_flEnd - task->m_flStart ) * 1000.0
+		);
+	}
+}
+
+double CJobGraph::GetTaskDuration( JobGraphTask_t task ) const {
+	if (! m_Tasks.IsValidIndex( task ) ) {
+		return 0;
+	}
+	return m_Tasks[task]->m_flEnd - m_Tasks[task]->m_flStart;
+}
+
+void CJobGraph::Submit( JobGraphTask_t task ) {
+	const auto job{ new CJobGraphTaskJob( this, task ) };
+	m_pPool->AddJob( job );
+	job->Release();
+}
+
+void CJobGraph::Execute( JobGraphTask_t task ) {
+	CUtlVectorFixedGrowable<JobGraphTask_t, 8> inlined{};
+	inlined.AddToTail( task );
+
+	while ( inlined.Count() ) {
+		task = inlined.Tail();
+		inlined.RemoveMultipleFromTail( 1 );
+		const auto pTask{ m_Tasks[task] };
+
+		if ( m_bCancelled ) {
+			pTask->m_bSkipped = true;
+		} else {
+			tmZone( TELEMETRY_LEVEL1, TMZF_NONE, "%s: %s", m_szName, pTask->m_pszName );
+			pTask->m_Thread = ThreadGetCurrentId();
+			pTask->m_flStart = Plat_FloatTime();
+			( *pTask->m_pFunctor )();
+			pTask->m_flEnd = Plat_FloatTime();
+		}
+
+		// keep the first successor we made ready for ourselves, its inputs are still in our cache.
+		// once cancelled, skipping is cheap enough to do all of them here
+		auto kept{ false };
+		for ( const auto successor : pTask->m_Successors ) {
+			if ( --m_Tasks[successor]->m_nPending == 0 ) {
+				if ( not kept or m_bCancelled ) {
+					inlined.AddToTail( successor );
+					kept = true;
+				} else {
+					Submit( successor );
+				}
+			}
+		}
+
+		if ( --m_nRemaining == 0 ) {
+			m_flEnd = Plat_FloatTime();
+			m_Finished.Set();
+		}
+	}
+}
+
+bool CJobGraph::IsAcyclic() const {
+	// Kahn's algorithm: if we can't visit every task, something is waiting on itself
+	CUtlVector<int> pending{};
+	CUtlVector<JobGraphTask_t> ready{};
+	pending.SetCount( m_Tasks.Count() );
+
+	for ( auto i{0}; i < m_Tasks.Count(); i += 1 ) {
+		pending[i] = m_Tasks[i]->m_nPredecessors;
+		if ( pending[i] == 0 ) {
+			ready.AddToTail( i );
+		}
+	}
+
+	auto visited{ 0 };
+	while ( ready.Count() ) {
+		const auto task{ ready.Tail() };
+		ready.RemoveMultipleFromTail( 1 );
+		visited += 1;
+
+		for ( const auto successor : m_Tasks[task]->m_Successors ) {
+			if ( --pending[successor] == 0 ) {
+				ready.AddToTail( successor );
+			}
+		}
+	}
+
+	return visited == m_Tasks.Count();
+}
@@ -8,9 +8,21 @@
 #endif
 #include "jobthread.hpp"
 
+namespace {
+	// Stand-in for work which was executed inline
+	class CDummyJob : public CJob {
+		JobStatus_t DoExecute() override { return JOB_OK; }
+	};
+}
+
 // FIXME: This file might not be completely thread-safe, do a check
 CThreadPool::CThreadPool() = default;
-CThreadPool::~CThreadPool() = default;
+CThreadPool::~CThreadPool() {
+	// broadcasts which didn't get to every worker
+	for ( const auto& entry : m_HighPriorityFunctors ) {
+		entry.m_pFunctor->Release();
+	}
+}
 
 bool CThreadPool::Start( const ThreadPoolStartParams_t& startParams ) {
 	m_Threads.EnsureCapacity( startParams.nThreads );
@@ -90,14 +102,107 @@ int CThreadPool::ResumeExecution() {
 	return 0;
 }
 
-int CThreadPool::YieldWait( CThreadEvent * *pEvents, int nEvents, bool bWaitAll, unsigned timeout ) {
-	AssertUnreachable(); return {};
+int CThreadPool::YieldWait( CThreadEvent** pEvents, int nEvents, bool bWaitAll, unsigned timeout ) {
+	// instead of sleeping, run queued jobs on this thread until the events we want get signaled
+	constexpr uint32 WAIT_SLICE_MS{ 1 };
+	const uint32 start{ Plat_MSTime() };
+
+	// checking an auto-reset event consumes its signal, so every signal we see has to be remembered
+	CUtlVectorFixedGrowable<bool, 16> signaled{};
+	signaled.SetCount( nEvents );
+	for ( auto i{0}; i < nEvents; i += 1 ) {
+		signaled[i] = false;
+	}
+
+	while ( true ) {
+		int firstUnsignaled{ -1 };
+		for ( auto i{0}; i < nEvents; i += 1 ) {
+			if ( signaled[i] ) {
+				continue;
+			}
+			if ( pEvents[i]->Check() ) {
+				if ( not bWaitAll ) {
+					return WAIT_OBJECT_0 + i;
+				}
+				signaled[i] = true;
+			} else if ( firstUnsignaled == -1 ) {
+				firstUnsignaled = i;
+			}
+		}
+		if ( firstUnsignaled == -1 ) {
+			return WAIT_OBJECT_0;
+		}
+
+		const uint32 elapsed{ Plat_MSTime() - start };
+		if ( timeout != TT_INFINITE and elapsed >= timeout ) {
+			return TW_TIMEOUT;
+		}
+
+		if ( const auto job{ GetJob() } ) {
+			job->TryExecute();
+			job->Release();
+			continue;
+		}
+
+		// nothing to help with, wait for a bit and check again
+		const uint32 slice{ timeout == TT_INFINITE ? WAIT_SLICE_MS : std::min( WAIT_SLICE_MS, timeout - elapsed ) };
+		if ( pEvents[ firstUnsignaled ]->Wait( slice ) ) {
+			if ( not bWaitAll ) {
+				return WAIT_OBJECT_0 + firstUnsignaled;
+			}
+			signaled[ firstUnsignaled ] = true;
+		}
+	}
 }
-int CThreadPool::YieldWait( CJob**, int nJobs, bool bWaitAll, unsigned timeout ) {
-	AssertUnreachable(); return {};
+int CThreadPool::YieldWait( CJob** ppJobs, int nJobs, bool bWaitAll, unsigned timeout ) {
+	CUtlVectorFixedGrowable<CThreadEvent*, 16> events{};
+	events.EnsureCapacity( nJobs );
+
+	for ( auto i{0}; i < nJobs; i += 1 ) {
+		if ( not bWaitAll and ppJobs[i]->IsFinished() ) {
+			return WAIT_OBJECT_0 + i;
+		}
+	}
+
+	for ( auto i{0}; i < nJobs; i += 1 ) {
+		const auto job{ ppJobs[i] };
+
+		// jobs nobody picked up yet are faster to run here than to wait for
+		bool queued;
+		m_Mutex.Lock();
+			queued = job->m_pThreadPool == this and UnqueueJobLocked( job );
+		m_Mutex.Unlock();
+
+		if ( queued ) {
+			job->TryExecute();
+			job->Release();
+
+			if ( not bWaitAll and job->IsFinished() ) {
+				return WAIT_OBJECT_0 + i;
+			}
+		}
+
+		events.AddToTail( job->AccessEvent() );
+	}
+
+	// the rest is in the hands of other threads
+	return YieldWait( events.Base(), events.Count(), bWaitAll, timeout );
 }
 void CThreadPool::Yield( unsigned timeout ) {
-	AssertUnreachable();
+	// do useful work for up to `timeout`ms, then get out of the way
+	const uint32 start{ Plat_MSTime() };
+
+	do {
+		const auto job{ GetJob() };
+		if ( job == nullptr ) {
+			const uint32 elapsed{ Plat_MSTime() - start };
+			ThreadSleep( elapsed < timeout ? timeout - elapsed : 0 );
+			return;
+		}
+
+		job->TryExecute();
+		job->Release();
+	} while ( Plat_MSTime() - start < timeout );
 }
 
 void CThreadPool::AddJob( CJob* pJob ) {
@@ -111,42 +216,66 @@ void CThreadPool::AddJob( CJob* pJob ) {
 	// add the job to the queue and update its status
 	m_Mutex.Lock();
 		pJob->AddRef();
-		m_Queue.AddToTail( pJob );
-
-		uint32 idx{ m_Queue.Tail() };
-		const int32 priority{ pJob->GetPriority() };
-
-		while ( idx != CUtlLinkedList<CJob*>::InvalidIndex() && priority > m_Queue[idx]->GetPriority() ) {
-			idx = m_Queue.Previous( idx );
-		}
-
-		if ( idx != CUtlLinkedList<CJob*>::InvalidIndex() ) {
-			m_Queue.InsertAfter( idx, pJob );
-		} else {
-			m_Queue.AddToHead( pJob );
-		}
-
 		pJob->m_pThreadPool = this;
 		pJob->m_status = JOB_STATUS_PENDING;
+		pJob->m_CompleteEvent.Reset();
+		m_JobAccepted.Reset();
+		QueueJobLocked( pJob );
 	m_Mutex.Unlock();
 
 	// tell our workers that we have a job
-	m_JobAccepted.Reset();
 	m_JobAvailable.Set();
-	m_JobAccepted.Wait();
+	// with no workers, it's up to `YieldWait`/`ExecuteToPriority` to get it done
+	if ( m_Threads.Count() ) {
+		m_JobAccepted.Wait();
+	}
 }
 
 void CThreadPool::ExecuteHighPriorityFunctor( CFunctor* pFunctor ) {
-	AssertUnreachable();
+	if ( m_Threads.Count() == 0 ) {
+		// nobody to broadcast to, make sure it still happens
+		( *pFunctor )();
+		return;
+	}
+
+	// every worker gets its own reference, the last one to run it releases the entry
+	m_Mutex.Lock();
+		pFunctor->AddRef();
+		m_HighPriorityFunctors.AddToTail( { pFunctor, m_HighPrioritySerial + 1, m_Threads.Count() } );
+		++m_HighPrioritySerial;
+	m_Mutex.Unlock();
+
+	// wake up idle workers
+	m_JobAvailable.Set();
 }
 
 void CThreadPool::ChangePriority( CJob* pJob, JobPriority_t priority ) {
-	AssertUnreachable();
+	AUTO_LOCK( m_Mutex );
+
+	if ( pJob->GetPriority() == priority ) {
+		return;
+	}
+
+	pJob->SetPriority( priority );
+
+	// a queued job has to be moved to keep the queue sorted, it never leaves it so the events stay as they are
+	if ( pJob->m_pThreadPool == this and pJob->m_ThreadPoolData != JOB_NO_DATA ) {
+		const auto idx{ static_cast<decltype( m_Queue )::IndexType_t>( reinterpret_cast<intp>( pJob->m_ThreadPoolData ) ) };
+		Assert( m_Queue.IsValidIndex( idx ) and m_Queue[idx] == pJob );
+		m_Queue.Remove( idx );
+		QueueJobLocked( pJob );
+	}
 }
 
 int CThreadPool::ExecuteToPriority( JobPriority_t toPriority, JobFilter_t pfnFilter ) {
-	AssertUnreachable();
-	return {};
+	// workers keep on pulling from the queue too, so this drains it in parallel
+	int nExecuted{ 0 };
+	while ( const auto job{ GetJob( toPriority, pfnFilter ) } ) {
+		job->TryExecute();
+		job->Release();
+		nExecuted += 1;
+	}
+	return nExecuted;
 }
 int CThreadPool::AbortAll() {
 	if ( CThread::GetCurrentCThread() != m_CoordinatorThread ) {
@@ -157,10 +286,12 @@ int CThreadPool::AbortAll() {
 	// abort them all
 	m_Mutex.Lock();
 		for ( const auto job : m_Queue ) {
+			job->m_ThreadPoolData = JOB_NO_DATA;
 			job->Abort();
 			job->Release();
 		}
 		m_Queue.RemoveAll();
+		m_JobAvailable.Reset();
 	m_Mutex.Unlock();
 
 	if ( CThread::GetCurrentCThread() != m_CoordinatorThread ) {
@@ -171,12 +302,23 @@ int CThreadPool::AbortAll() {
 }
 
 void CThreadPool::AddFunctorInternal( CFunctor* pFunctor, CJob** ppJob, const char* pszDescription, unsigned flags ) {
-	AssertUnreachable();
+	// the job takes over the functor's reference
+	const auto job{ new CFunctorJob( pFunctor, pszDescription ) };
+	job->SetFlags( flags );
+	AddJob( job );
+
+	if ( ppJob ) {
+		*ppJob = job;
+	} else {
+		job->Release();
+	}
 }
 
 CJob* CThreadPool::GetDummyJob() {
-	AssertUnreachable();
-	return {};
+	// used when the work was done inline, so the caller still has a (finished) job to wait on
+	const auto job{ new CDummyJob() };
+	job->Execute();
+	return job;
 }
 
 void CThreadPool::Distribute( bool bDistribute, int* pAffinityTable ) {
@@ -190,23 +332,25 @@ bool CThreadPool::Start( const ThreadPoolStartParams_t& startParams, const char*
 
 unsigned CThreadPool::PoolThreadFunc( void* pParam ) {
 	const auto pOwner = static_cast<CThreadPool*>( pParam );
+	uint32 lastSerial{ pOwner->m_HighPrioritySerial };
 	pOwner->m_IdleCount += 1;
 
 	while ( true ) {
+		// broadcasted functors come before any other job
+		if ( pOwner->m_HighPrioritySerial != lastSerial ) {
+			pOwner->RunHighPriorityFunctors( lastSerial );
+		}
 		// handle incoming jobs
 		if ( pOwner->m_JobAvailable.Check() ) {
 			pOwner->m_IdleCount -= 1;
 
 			// accept the job
-			const auto head{ pOwner->m_Queue.Head() };
-			CJob* job = pOwner->m_Queue.Element( head );
+			CJob* job{ pOwner->GetJob() };
 			if ( job == nullptr ) {
 				// job got sniped from our hands, go back idling
 				pOwner->m_IdleCount += 1;
 				continue;
 			}
-			pOwner->m_Queue.Remove( head );
-			pOwner->m_JobAccepted.Set();
 
 			// run the job
 			job->TryExecute();
@@ -221,6 +365,90 @@ unsigned CThreadPool::PoolThreadFunc( void* pParam ) {
 	}
 }
 
+void CThreadPool::QueueJobLocked( CJob* pJob ) {
+	// the queue is sorted by priority, find the last job with an equal or higher one
+	const int32 priority{ pJob->GetPriority() };
+	auto idx{ m_Queue.Tail() };
+	while ( m_Queue.IsValidIndex( idx ) and priority > m_Queue[idx]->GetPriority() ) {
+		idx = m_Queue.Previous( idx );
+	}
+
+	if ( m_Queue.IsValidIndex( idx ) ) {
+		idx = m_Queue.InsertAfter( idx, pJob );
+	} else {
+		idx = m_Queue.AddToHead( pJob );
+	}
+	pJob->m_ThreadPoolData = reinterpret_cast<ThreadPoolData_t>( static_cast<intp>( idx ) );
+}
+
+bool CThreadPool::UnqueueJobLocked( CJob* pJob ) {
+	if ( pJob->m_ThreadPoolData == JOB_NO_DATA ) {
+		return false;
+	}
+
+	const auto idx{ static_cast<decltype( m_Queue )::IndexType_t>( reinterpret_cast<intp>( pJob->m_ThreadPoolData ) ) };
+	Assert( m_Queue.IsValidIndex( idx ) and m_Queue[idx] == pJob );
+	m_Queue.Remove( idx );
+	pJob->m_ThreadPoolData = JOB_NO_DATA;
+	// whoever took it, the job has been accepted
+	m_JobAccepted.Set();
+
+	// don't let the workers spin on an empty queue
+	if ( m_Queue.Count() == 0 ) {
+		m_JobAvailable.Reset();
+	}
+	return true;
+}
+
+CJob* CThreadPool::GetJob( JobPriority_t minPriority, JobFilter_t pfnFilter ) {
+	AUTO_LOCK( m_Mutex );
+
+	for ( auto idx{ m_Queue.Head() }; m_Queue.IsValidIndex( idx ); idx = m_Queue.Next( idx ) ) {
+		const auto job{ m_Queue[idx] };
+		// sorted queue, nothing after this one will qualify
+		if ( job->GetPriority() < minPriority ) {
+			break;
+		}
+
+		if ( pfnFilter == nullptr or pfnFilter( job ) ) {
+			UnqueueJobLocked( job );
+			return job;
+		}
+	}
+	return nullptr;
+}
+
+void CThreadPool::RunHighPriorityFunctors( uint32& lastSerial ) {
+	CUtlVectorFixedGrowable<CFunctor*, 4> functors{};
+
+	m_Mutex.Lock();
+		for ( auto i{ m_HighPriorityFunctors.Count() - 1 }; i >= 0; i -= 1 ) {
+			auto& entry{ m_HighPriorityFunctors[i] };
+			if ( entry.m_Serial <= lastSerial ) {
+				continue;
+			}
+
+			// we own the entry's reference if we're the last one to get to it
+			entry.m_nRemaining -= 1;
+			if ( entry.m_nRemaining != 0 ) {
+				entry.m_pFunctor->AddRef();
+			}
+			functors.AddToHead( entry.m_pFunctor );
+
+			if ( entry.m_nRemaining == 0 ) {
+				m_HighPriorityFunctors.Remove( i );
+			}
+		}
+		lastSerial = m_HighPrioritySerial;
+	m_Mutex.Unlock();
+
+	// run them in the order they were posted
+	for ( const auto functor : functors ) {
+		( *functor )();
+		functor->Release();
+	}
+}
+
 
 /*
 bool CThreadPool::RemoveJob( CJob* pJob ) {
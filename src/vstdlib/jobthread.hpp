@@ -66,7 +66,24 @@ public:
 	bool Start( const ThreadPoolStartParams_t& startParams, const char* pszNameOverride ) override;
 private:
 	static uint32 PoolThreadFunc( void* pParam );
+
+	// Inserts/removes a job in priority order, the queue's reference is left untouched. Must hold `m_Mutex`.
+	void QueueJobLocked( CJob* pJob );
+	bool UnqueueJobLocked( CJob* pJob );
+	/**
+	 * Takes the highest priority job matching the arguments out of the queue.
+	 * @return The job, the caller inherits the queue's reference; or nullptr if none matched.
+	 */
+	CJob* GetJob( JobPriority_t minPriority = JP_LOW, JobFilter_t pfnFilter = nullptr );
+	// Runs the broadcast functors posted after `lastSerial`, updating it
+	void RunHighPriorityFunctors( uint32& lastSerial );
 private:
+	struct HighPriorityFunctor_t {
+		CFunctor* m_pFunctor;
+		uint32 m_Serial;
+		int m_nRemaining;  // workers which still have to run it
+	};
+
 	enum State : int32 {
 		EXECUTING,
 		SUSPENDED
@@ -83,6 +100,10 @@ private:
 	// mutex for adding/removing items to/from the queue
 	CThreadFastMutex m_Mutex{};
 	CUtlVector<ThreadHandle_t> m_Threads{};
+
+	// functors broadcasted by `ExecuteHighPriorityFunctor`, guarded by `m_Mutex`
+	CUtlVector<HighPriorityFunctor_t> m_HighPriorityFunctors{};
+	CInterlockedUInt m_HighPrioritySerial;
 };
 
 // JOB_INTERFACE IThreadPool* CreateThreadPool();
@@ -2,60 +2,449 @@
 // Created by ENDERZOMBI102 on 12/02/2024.
 //
 #include "keyvaluessystem.hpp"
+#include "filesystem.h"
 #include "tier0/dbg.h"
+#include "tier1/KeyValues.h"
+#include "tier1/strtools.h"
+#include <algorithm>
 
 
+namespace {
+	constexpr uint16 BLOCK_MAGIC{ 0x4B56 };  // "KV"
+}
+
 void CKeyValuesSystem::RegisterSizeofKeyValues( int size ) {
-	AssertUnreachable();
+	AUTO_LOCK( m_SlabMutex );
+	AssertMsg( m_nBlockSize.load( std::memory_order_relaxed ) == 0 or size <= m_nBlockSize.load( std::memory_order_relaxed ) - HEADER_SIZE, "KeyValues size registered after the pool was sized, bigger ones will come from the heap" );
+	m_nRegisteredSize = std::max( m_nRegisteredSize, size );
 }
 
 void* CKeyValuesSystem::AllocKeyValuesMemory( int size ) {
-	// FIXME: This should either use a custom allocator,
-	//        or to the very least track the allocation sizes (atomically)
-	return malloc( size );
+	auto nBlockSize{ m_nBlockSize.load( std::memory_order_acquire ) };
+	if ( nBlockSize == 0 ) {
+		AUTO_LOCK( m_SlabMutex );
+		nBlockSize = m_nBlockSize.load( std::memory_order_relaxed );
+		if ( nBlockSize == 0 ) {
+			// nobody told us how big a KeyValues is, go with the first one we see
+			const int payload{ std::max( { m_nRegisteredSize, size, static_cast<int>( sizeof( TSLNodeBase_t ) ) } ) };
+			nBlockSize = HEADER_SIZE + ALIGN_VALUE( payload, TSLIST_NODE_ALIGNMENT );
+			m_nBlockSize.store( nBlockSize, std::memory_order_release );
+		}
+	}
+
+	BlockHeader_t* header;
+	if ( size <= nBlockSize - HEADER_SIZE ) {
+		header = HeaderOf( AllocSlabBlock( GetThreadCache() ) );
+		header->m_bFromHeap = false;
+	} else {
+		header = static_cast<BlockHeader_t*>( MemAlloc_AllocAligned( HEADER_SIZE + size, TSLIST_NODE_ALIGNMENT ) );
+		header->m_bFromHeap = true;
+	}
+	header->m_Magic = BLOCK_MAGIC;
+	header->m_bLive = true;
+	header->m_Name = INVALID_KEY_SYMBOL;
+	CountAllocation();
+
+	return reinterpret_cast<byte*>( header ) + HEADER_SIZE;
 }
 void CKeyValuesSystem::FreeKeyValuesMemory( void* pMem ) {
-	free( pMem );
-}
+	if ( pMem == nullptr ) {
+		return;
+	}
 
-HKeySymbol CKeyValuesSystem::GetSymbolForString( const char* name, bool bCreate ) {
-	auto idx{ m_SymbolTable.Find( name ) };
+	const auto header{ HeaderOf( pMem ) };
+	AssertMsg( header->m_Magic == BLOCK_MAGIC and header->m_bLive, "Freeing KeyValues memory which isn't ours (or is already free)" );
+	if ( header->m_Name != INVALID_KEY_SYMBOL ) {
+		--m_nTracked;
+	}
+	header->m_bLive = false;
+	--m_nLive;
 
-	if ( bCreate and !idx.IsValid() ) {
-		idx = m_SymbolTable.AddString( name );
+	if ( header->m_bFromHeap ) {
+		MemAlloc_FreeAligned( header );
+		return;
 	}
 
-	return idx;
+	// the payload becomes the free list link
+	auto& cache{ GetThreadCache() };
+	const auto node{ static_cast<TSLNodeBase_t*>( pMem ) };
+	node->Next = cache.m_pHead;
+	cache.m_pHead = node;
+	cache.m_nCount += 1;
+
+	// give a batch back to the other threads
+	if ( cache.m_nCount >= THREAD_CACHE_BATCH * 2 ) {
+		for ( auto i{0}; i < THREAD_CACHE_BATCH; i += 1 ) {
+			const auto next{ cache.m_pHead->Next };
+			m_FreeBlocks.Push( cache.m_pHead );
+			cache.m_pHead = next;
+		}
+		cache.m_nCount -= THREAD_CACHE_BATCH;
+	}
+}
+
+HKeySymbol CKeyValuesSystem::GetSymbolForString( const char* name, bool bCreate ) {
+	// `UTL_INVAL_SYMBOL32` becomes `INVALID_KEY_SYMBOL`
+	return static_cast<HKeySymbol>( bCreate ? m_SymbolTable.AddString( name ) : m_SymbolTable.Find( name ) );
 }
 const char* CKeyValuesSystem::GetStringForSymbol( HKeySymbol symbol ) {
-	return m_SymbolTable.String( symbol );
+	return m_SymbolTable.String( static_cast<UtlSymId32_t>( symbol ) );
 }
 
 void CKeyValuesSystem::AddKeyValuesToMemoryLeakList( void* pMem, HKeySymbol pName ) {
-	m_LeakList.insert({ pMem, pName });
+	// tracking is a flag on the block itself, leaks are found by walking the slabs
+	const auto header{ HeaderOf( pMem ) };
+	if ( header->m_Name == INVALID_KEY_SYMBOL ) {
+		++m_nTracked;
+	}
+	header->m_Name = pName;
 }
 void CKeyValuesSystem::RemoveKeyValuesFromMemoryLeakList( void* pMem ) {
-	m_LeakList.erase( pMem );
+	const auto header{ HeaderOf( pMem ) };
+	if ( header->m_Name != INVALID_KEY_SYMBOL ) {
+		--m_nTracked;
+	}
+	header->m_Name = INVALID_KEY_SYMBOL;
 }
 
 void CKeyValuesSystem::AddFileKeyValuesToCache( const KeyValues* _kv, const char* resourceName, const char* pathID ) {
-	AssertUnreachable();
+	if ( _kv == nullptr or resourceName == nullptr ) {
+		return;
+	}
+
+	char key[MAX_PATH * 2];
+	MakeCacheKey( key, sizeof( key ), resourceName, pathID );
+
+	AUTO_LOCK( m_CacheMutex );
+	const auto index{ TouchCacheEntry( key ) };
+	const auto entry{ m_Cache[index] };
+
+	// the KeyValues getters aren't const, but nothing gets modified
+	entry->m_Nodes.RemoveAll();
+	entry->m_Strings.RemoveAll();
+	entry->m_nRoots = 0;
+	for ( auto kv{ const_cast<KeyValues*>( _kv ) }; kv != nullptr; kv = kv->GetNextKey() ) {
+		FlattenKeyValues( entry, kv );
+		entry->m_nRoots += 1;
+	}
+	UpdateCacheEntrySize( entry );
+	EvictCacheEntries( index );
 }
 bool CKeyValuesSystem::LoadFileKeyValuesFromCache( KeyValues* _outKv, const char* resourceName, const char* pathID, IBaseFileSystem* filesystem ) const {
-	AssertUnreachable();
-	return false;
+	if ( _outKv == nullptr or resourceName == nullptr or filesystem == nullptr ) {
+		return false;
+	}
+
+	char key[MAX_PATH * 2];
+	MakeCacheKey( key, sizeof( key ), resourceName, pathID );
+
+	// stat outside the lock, it may have to hit the disk
+	const auto fileTime{ filesystem->GetFileTime( resourceName, pathID ) };
+	const auto fileSize{ filesystem->Size( resourceName, pathID ) };
+
+	AUTO_LOCK( m_CacheMutex );
+	const auto index{ TouchCacheEntry( key ) };
+	const auto entry{ m_Cache[index] };
+
+	const auto changed{ entry->m_bStamped and ( entry->m_nFileTime != fileTime or entry->m_nFileSize != fileSize ) };
+	const auto hit{ entry->m_nRoots != 0 and not changed };
+	if (! hit ) {
+		// the caller is going to read the file now, the tree it adds will match this stamp
+		entry->m_Nodes.Purge();
+		entry->m_Strings.Purge();
+		entry->m_nRoots = 0;
+		UpdateCacheEntrySize( entry );
+	}
+	// trees added without a read (e.g. when saving) get stamped on their first lookup
+	entry->m_nFileTime = fileTime;
+	entry->m_nFileSize = fileSize;
+	entry->m_bStamped = true;
+
+	if (! hit ) {
+		EvictCacheEntries( index );
+		return false;
+	}
+
+	_outKv->Clear();
+	_outKv->SetName( &entry->m_Strings[entry->m_Nodes[0].m_nName] );
+	auto node{ BuildKeyValues( entry, 0, _outKv ) };
+	auto last{ _outKv };
+	for ( auto root{1}; root < entry->m_nRoots; root += 1 ) {
+		const auto peer{ new KeyValues( &entry->m_Strings[entry->m_Nodes[node].m_nName] ) };
+		last->SetNextKey( peer );
+		last = peer;
+		node = BuildKeyValues( entry, node, peer );
+	}
+	return true;
 }
 void CKeyValuesSystem::InvalidateCache() {
-	AssertUnreachable();
+	AUTO_LOCK( m_CacheMutex );
+	m_Cache.PurgeAndDeleteElements();
+	m_CacheLru.Purge();
+	m_nCacheBytes = 0;
 }
 void CKeyValuesSystem::InvalidateCacheForFile( const char* resourceName, const char* pathID ) {
-	AssertUnreachable();
+	if ( resourceName == nullptr ) {
+		return;
+	}
+
+	char key[MAX_PATH * 2];
+	MakeCacheKey( key, sizeof( key ), resourceName, pathID );
+
+	AUTO_LOCK( m_CacheMutex );
+	const auto index{ m_Cache.Find( key ) };
+	if ( index != m_Cache.InvalidIndex() ) {
+		RemoveCacheEntry( index );
+	}
+}
+
+void CKeyValuesSystem::SetCacheBudget( int nBytes ) {
+	AUTO_LOCK( m_CacheMutex );
+	m_nCacheBudget = nBytes;
+	EvictCacheEntries( m_Cache.InvalidIndex() );
 }
 
 CKeyValuesSystem::~CKeyValuesSystem() {
-	if ( not m_LeakList.empty() ) {
-		Warning( "[AuroraSource|CKeyValuesSystem] Memory leak detected." );
+	if ( m_nTracked != 0 ) {
+		Warning( "[AuroraSource|CKeyValuesSystem] Memory leak detected: %d KeyValues were never freed.\n", static_cast<int>( m_nTracked ) );
+
+		// name a few of them (heap allocated ones can't be found)
+		auto reported{ 0 };
+		const auto nBlockSize{ m_nBlockSize.load( std::memory_order_acquire ) };
+		for ( const auto slab : m_Slabs ) {
+			for ( auto offset{0}; offset + nBlockSize <= SLAB_SIZE and reported < 16; offset += nBlockSize ) {
+				const auto header{ reinterpret_cast<BlockHeader_t*>( slab + offset ) };
+				if ( header->m_bLive and header->m_Name != INVALID_KEY_SYMBOL ) {
+					Warning( "  - %s\n", GetStringForSymbol( header->m_Name ) );
+					reported += 1;
+				}
+			}
+		}
 	}
+
+	InvalidateCache();
+	for ( const auto slab : m_Slabs ) {
+		MemAlloc_FreeAligned( slab );
+	}
+}
+
+CKeyValuesSystem::ThreadCache_t& CKeyValuesSystem::GetThreadCache() {
+	static thread_local ThreadCache_t s_Cache{};
+	return s_Cache;
+}
+CKeyValuesSystem::ThreadCache_t::~ThreadCache_t() {
+	// don't strand our blocks when the thread exits
+	const auto system{ static_cast<CKeyValuesSystem*>( KeyValuesSystem() ) };
+	while ( m_pHead ) {
+		const auto next{ m_pHead->Next };
+		system->m_FreeBlocks.Push( m_pHead );
+		m_pHead = next;
+	}
+	m_nCount = 0;
+}
+
+void* CKeyValuesSystem::AllocSlabBlock( ThreadCache_t& cache ) {
+	if ( cache.m_pHead == nullptr ) {
+		// take a batch from the other threads' leftovers
+		for ( auto i{0}; i < THREAD_CACHE_BATCH; i += 1 ) {
+			const auto node{ m_FreeBlocks.Pop() };
+			if ( node == nullptr ) {
+				break;
+			}
+			node->Next = cache.m_pHead;
+			cache.m_pHead = node;
+			cache.m_nCount += 1;
+		}
+
+		if ( cache.m_pHead == nullptr ) {
+			AllocSlab( cache );
+		}
+	}
+
+	const auto node{ cache.m_pHead };
+	cache.m_pHead = node->Next;
+	cache.m_nCount -= 1;
+	return node;
+}
+
+void CKeyValuesSystem::AllocSlab( ThreadCache_t& cache ) {
+	const auto slab{ static_cast<byte*>( MemAlloc_AllocAligned( SLAB_SIZE, TSLIST_NODE_ALIGNMENT ) ) };
+	m_SlabMutex.Lock();
+		m_Slabs.AddToTail( slab );
+	m_SlabMutex.Unlock();
+
+	// push in reverse, so they get handed out in address order
+	const auto nBlockSize{ m_nBlockSize.load( std::memory_order_acquire ) };
+	for ( auto offset{ ( SLAB_SIZE / nBlockSize - 1 ) * nBlockSize }; offset >= 0; offset -= nBlockSize ) {
+		const auto header{ reinterpret_cast<BlockHeader_t*>( slab + offset ) };
+		header->m_Magic = BLOCK_MAGIC;
+		header->m_bLive = false;
+		header->m_bFromHeap = false;
+		header->m_Name = INVALID_KEY_SYMBOL;
+
+		const auto node{ reinterpret_cast<TSLNodeBase_t*>( slab + offset + HEADER_SIZE ) };
+		node->Next = cache.m_pHead;
+		cache.m_pHead = node;
+		cache.m_nCount += 1;
+	}
+}
+
+void CKeyValuesSystem::MakeCacheKey( char* pszKey, int nKeySize, const char* resourceName, const char* pathID ) {
+	// the dictionary compares file names ignoring case and slash direction
+	V_snprintf( pszKey, nKeySize, "%s:%s", pathID ? pathID : "", resourceName );
+}
+
+int CKeyValuesSystem::TouchCacheEntry( const char* pszKey ) const {
+	auto index{ m_Cache.Find( pszKey ) };
+	if ( index == m_Cache.InvalidIndex() ) {
+		const auto entry{ new CacheEntry_t{} };
+		index = m_Cache.Insert( pszKey, entry );
+		entry->m_LruIndex = m_CacheLru.AddToTail( index );
+		UpdateCacheEntrySize( entry );
+		return index;
+	}
+
+	const auto entry{ m_Cache[index] };
+	m_CacheLru.Unlink( entry->m_LruIndex );
+	m_CacheLru.LinkToTail( entry->m_LruIndex );
+	return index;
+}
+
+void CKeyValuesSystem::RemoveCacheEntry( int index ) const {
+	const auto entry{ m_Cache[index] };
+	m_nCacheBytes -= entry->m_nBytes;
+	m_CacheLru.Remove( entry->m_LruIndex );
+	m_Cache.RemoveAt( index );
+	delete entry;
+}
+
+void CKeyValuesSystem::EvictCacheEntries( int keep ) const {
+	while ( m_nCacheBytes > m_nCacheBudget and m_CacheLru.Count() != 0 ) {
+		const auto oldest{ m_CacheLru[m_CacheLru.Head()] };
+		if ( oldest == keep ) {
+			// the one just used is all that's left
+			break;
+		}
+		RemoveCacheEntry( oldest );
+	}
+}
+
+void CKeyValuesSystem::UpdateCacheEntrySize( CacheEntry_t* entry ) const {
+	m_nCacheBytes -= entry->m_nBytes;
+	entry->m_nBytes = sizeof( CacheEntry_t ) + entry->m_Nodes.Count() * sizeof( CacheNode_t ) + entry->m_Strings.Count();
+	m_nCacheBytes += entry->m_nBytes;
+}
+
+void CKeyValuesSystem::FlattenKeyValues( CacheEntry_t* entry, KeyValues* kv ) {
+	const auto AddString = [entry]( const void* pData, int nBytes, int alignment ) {
+		while ( entry->m_Strings.Count() % alignment ) {
+			entry->m_Strings.AddToTail( '\0' );
+		}
+		return entry->m_Strings.AddMultipleToTail( nBytes, static_cast<const char*>( pData ) );
+	};
+
+	const auto nodeIndex{ entry->m_Nodes.AddToTail() };
+	{
+		// `entry->m_Nodes` may grow while recursing, so don't keep references around
+		auto& node{ entry->m_Nodes[nodeIndex] };
+		node.m_nChildren = 0;
+		node.m_Uint64 = 0;
+		node.m_Type = kv->GetDataType();
+	}
+	const auto name{ kv->GetName() };
+	entry->m_Nodes[nodeIndex].m_nName = AddString( name, V_strlen( name ) + 1, 1 );
+
+	switch ( entry->m_Nodes[nodeIndex].m_Type ) {
+		case KeyValues::TYPE_STRING: {
+			const auto value{ kv->GetString() };
+			entry->m_Nodes[nodeIndex].m_nString = AddString( value, V_strlen( value ) + 1, 1 );
+			break;
+		}
+		case KeyValues::TYPE_WSTRING: {
+			const auto value{ kv->GetWString() };
+			entry->m_Nodes[nodeIndex].m_nString = AddString( value, ( V_wcslen( value ) + 1 ) * sizeof( wchar_t ), alignof( wchar_t ) );
+			break;
+		}
+		case KeyValues::TYPE_INT:
+			entry->m_Nodes[nodeIndex].m_Int = kv->GetInt();
+			break;
+		case KeyValues::TYPE_UINT64:
+			entry->m_Nodes[nodeIndex].m_Uint64 = kv->GetUint64();
+			break;
+		case KeyValues::TYPE_FLOAT:
+			entry->m_Nodes[nodeIndex].m_Float = kv->GetFloat();
+			break;
+		case KeyValues::TYPE_PTR:
+			entry->m_Nodes[nodeIndex].m_Ptr = kv->GetPtr();
+			break;
+		case KeyValues::TYPE_COLOR: {
+			const auto color{ kv->GetColor() };
+			entry->m_Nodes[nodeIndex].m_Color[0] = color.r();
+			entry->m_Nodes[nodeIndex].m_Color[1] = color.g();
+			entry->m_Nodes[nodeIndex].m_Color[2] = color.b();
+			entry->m_Nodes[nodeIndex].m_Color[3] = color.a();
+			break;
+		}
+		default:
+			break;
+	}
+
+	auto children{ 0 };
+	for ( auto sub{ kv->GetFirstSubKey() }; sub != nullptr; sub = sub->GetNextKey() ) {
+		FlattenKeyValues( entry, sub );
+		children += 1;
+	}
+	entry->m_Nodes[nodeIndex].m_nChildren = children;
+}
+
+int CKeyValuesSystem::BuildKeyValues( const CacheEntry_t* entry, int index, KeyValues* kv ) {
+	const auto& node{ entry->m_Nodes[index] };
+	switch ( node.m_Type ) {
+		case KeyValues::TYPE_STRING:
+			kv->SetStringValue( &entry->m_Strings[node.m_nString] );
+			break;
+		case KeyValues::TYPE_WSTRING:
+			kv->SetWString( nullptr, reinterpret_cast<const wchar_t*>( &entry->m_Strings[node.m_nString] ) );
+			break;
+		case KeyValues::TYPE_INT:
+			kv->SetInt( nullptr, node.m_Int );
+			break;
+		case KeyValues::TYPE_UINT64:
+			kv->SetUint64( nullptr, node.m_Uint64 );
+			break;
+		case KeyValues::TYPE_FLOAT:
+			kv->SetFloat( nullptr, node.m_Float );
+			break;
+		case KeyValues::TYPE_PTR:
+			kv->SetPtr( nullptr, node.m_Ptr );
+			break;
+		case KeyValues::TYPE_COLOR:
+			kv->SetColor( nullptr, Color{ node.m_Color[0], node.m_Color[1], node.m_Color[2], node.m_Color[3] } );
+			break;
+		default:
+			break;
+	}
+
+	// link the children directly, AddSubKey would walk the list every time
+	index += 1;
+	KeyValues* last{ nullptr };
+	for ( auto i{0}; i < node.m_nChildren; i += 1 ) {
+		const auto child{ new KeyValues( &entry->m_Strings[entry->m_Nodes[index].m_nName] ) };
+		if ( last ) {
+			last->SetNextKey( child );
+		} else {
+			kv->AddSubKey( child );
+		}
+		last = child;
+		index = BuildKeyValues( entry, index, child );
+	}
+	return index;
+}
+
+void CKeyValuesSystem::CountAllocation() {
+	const int live{ ++m_nLive };
+	int peak;
+	while ( live > ( peak = m_nPeak ) and not m_nPeak.AssignIf( peak, live ) ) { }
 }
 
 static CKeyValuesSystem g_KeyValueSystem{};
@@ -2,9 +2,13 @@
 // Created by ENDERZOMBI102 on 12/02/2024.
 //
 #pragma once
+#include "tier0/tslist.h"
+#include "tier1/utldict.h"
+#include "tier1/utllinkedlist.h"
 #include "tier1/utlsymbol.h"
+#include "tier1/utlvector.h"
 #include "vstdlib/IKeyValuesSystem.h"
-#include <unordered_map>
+#include <atomic>
 
 
 class CKeyValuesSystem : public IKeyValuesSystem {
@@ -27,7 +31,105 @@ public:
 	void InvalidateCacheForFile( const char* resourceName, const char* pathID ) override;
 public:
 	~CKeyValuesSystem();
+
+	// Allocation statistics, in number of KeyValues
+	[[nodiscard]]
+	int GetLiveAllocationCount() const { return m_nLive; }
+	[[nodiscard]]
+	int GetPeakAllocationCount() const { return m_nPeak; }
+
+	// File cache memory, in bytes; least recently used files are dropped when over budget
+	void SetCacheBudget( int nBytes );
+	[[nodiscard]]
+	int GetCacheMemoryUsage() const { return m_nCacheBytes; }
+private:
+	/**
+	 * Prefix of every allocation, a freed block's payload holds the free list link.
+	 * Having it lets a free find its way back without lookups, and lets the leak tracker flag blocks in place.
+	 */
+	struct BlockHeader_t {
+		uint16 m_Magic;
+		uint8 m_bLive;
+		uint8 m_bFromHeap;  // bigger than a slab block, comes straight from the heap
+		HKeySymbol m_Name;  // set while tracked by the leak list
+	};
+	static constexpr int HEADER_SIZE{ ALIGN_VALUE( sizeof( BlockHeader_t ), TSLIST_NODE_ALIGNMENT ) };
+	static constexpr int SLAB_SIZE{ 64 * 1024 };
+
+	// Blocks freed by a thread are kept by it, and exchanged in batches with the shared list
+	struct ThreadCache_t {
+		~ThreadCache_t();
+		TSLNodeBase_t* m_pHead{ nullptr };
+		int m_nCount{ 0 };
+	};
+	static constexpr int THREAD_CACHE_BATCH{ 64 };
+	static ThreadCache_t& GetThreadCache();
+
+	void* AllocSlabBlock( ThreadCache_t& cache );
+	// Carves a new slab, its blocks go in the cache
+	void AllocSlab( ThreadCache_t& cache );
+	void CountAllocation();
+	[[nodiscard]]
+	BlockHeader_t* HeaderOf( void* pMem ) const { return reinterpret_cast<BlockHeader_t*>( static_cast<byte*>( pMem ) - HEADER_SIZE ); }
+
+	// A key of the cached tree, in pre-order; strings live in the entry's blob
+	struct CacheNode_t {
+		int m_nName;
+		int m_nChildren;
+		uint8 m_Type;
+		union {
+			int m_Int;
+			float m_Float;
+			uint64 m_Uint64;
+			uint8 m_Color[4];
+			void* m_Ptr;
+			int m_nString;
+		};
+	};
+	/**
+	 * A cached file: an immutable, flattened copy of its tree, and what the file looked like on disk when it was read.
+	 * Entries may exist without a tree, to remember the stamp taken on a miss until the tree gets added.
+	 */
+	struct CacheEntry_t {
+		CUtlVector<CacheNode_t> m_Nodes;
+		CUtlVector<char> m_Strings;
+		int m_nRoots{ 0 };  // top level keys, a file may have more than one
+		long m_nFileTime{ 0 };
+		unsigned m_nFileSize{ 0 };
+		bool m_bStamped{ false };
+		int m_nBytes{ 0 };
+		int m_LruIndex{ 0 };
+	};
+
+	static void MakeCacheKey( char* pszKey, int nKeySize, const char* resourceName, const char* pathID );
+	// Finds or creates the entry, and marks it as the most recently used
+	int TouchCacheEntry( const char* pszKey ) const;
+	void RemoveCacheEntry( int index ) const;
+	// Drops the least recently used entries until we're under budget, `keep` excluded
+	void EvictCacheEntries( int keep ) const;
+	void UpdateCacheEntrySize( CacheEntry_t* entry ) const;
+
+	static void FlattenKeyValues( CacheEntry_t* entry, KeyValues* kv );
+	static int BuildKeyValues( const CacheEntry_t* entry, int index, KeyValues* kv );
 private:
-	std::unordered_map<void*, HKeySymbol> m_LeakList{};
-	CUtlSymbolTableMT m_SymbolTable{};
+	// sizes of a slab block, fixed once the first slab is carved
+	int m_nRegisteredSize{ 0 };
+	std::atomic<int> m_nBlockSize{ 0 };  // read without the lock once set
+
+	CTSListBase m_FreeBlocks{};
+	CThreadFastMutex m_SlabMutex{};
+	CUtlVector<byte*> m_Slabs{};
+
+	CInterlockedInt m_nLive{};
+	CInterlockedInt m_nPeak{};
+	CInterlockedInt m_nTracked{};
+
+	CUtlSymbolTableHashed m_SymbolTable{};
+
+	// lookups reorder the LRU and record stamps, so the cache is mutable from the const load
+	mutable CThreadFastMutex m_CacheMutex{};
+	mutable CUtlDict<CacheEntry_t*, int> m_Cache{ k_eDictCompareTypeFilenames };
+	mutable CUtlLinkedList<int, int> m_CacheLru{};  // dict indices, oldest first
+	mutable int m_nCacheBytes{ 0 };
+	int m_nCacheBudget{ 16 * 1024 * 1024 };
 };
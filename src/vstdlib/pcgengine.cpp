@@ -3,7 +3,132 @@
 //
 #include "vstdlib/pcgengine.hpp"
 
+#include <cstring>
+#include <emmintrin.h>
+#include <immintrin.h>
 #include <iostream>
+#if defined( COMPILER_MSVC )
+	#include <intrin.h>
+#endif
+
+#if defined( COMPILER_MSVC )
+	#define PCG_TARGET_AVX2
+#else
+	#define PCG_TARGET_AVX2 __attribute__(( target( "avx2" ) ))
+#endif
+
+
+namespace {
+	// below this, setting up the lanes costs more than it saves
+	constexpr size_t MIN_SIMD_COUNT{ 32 };
+
+	bool CpuHasAVX2() {
+		#if defined( COMPILER_MSVC )
+			int info[4];
+			__cpuid( info, 0 );
+			if ( info[0] < 7 ) {
+				return false;
+			}
+			// the OS has to save the ymm registers too
+			__cpuid( info, 1 );
+			if (! ( info[2] & ( 1 << 27 ) ) or ( _xgetbv( 0 ) & 6 ) != 6 ) {
+				return false;
+			}
+			__cpuidex( info, 7, 0 );
+			return info[1] & ( 1 << 5 );
+		#else
+			return __builtin_cpu_supports( "avx2" );
+		#endif
+	}
+	const bool s_bHasAVX2{ CpuHasAVX2() };
+
+	// 64-bit lane multiply, SSE2 only has 32x32->64: lo*lo + ( ( lo*hi + hi*lo ) << 32 )
+	inline __m128i MulLo64( __m128i a, __m128i bLo, __m128i bHi ) {
+		const auto lolo{ _mm_mul_epu32( a, bLo ) };
+		const auto cross{ _mm_add_epi64( _mm_mul_epu32( a, bHi ), _mm_mul_epu32( _mm_srli_epi64( a, 32 ), bLo ) ) };
+		return _mm_add_epi64( lolo, _mm_slli_epi64( cross, 32 ) );
+	}
+
+	// PCG's output permutation on two 64-bit lanes, the results are in the low half of each
+	inline __m128i Output2( __m128i state ) {
+		const auto rot{ _mm_srli_epi64( state, 59 ) };
+		const auto x{ _mm_xor_si128( state, _mm_srli_epi64( state, 18 ) ) };
+		const auto value{ _mm_srli_epi64( x, 27 ) };
+
+		// no variable shifts: rotr( v, r ) == rotl( v, ( 32 - r ) & 31 ), and the rotl is the two halves of v * 2^shift.
+		// 2^shift is made by building the float and converting it; 2^31 converts to 0x80000000, which is just right
+		const auto shift{ _mm_and_si128( _mm_sub_epi32( _mm_set1_epi32( 32 ), rot ), _mm_set1_epi32( 31 ) ) };
+		const auto pow2{ _mm_cvttps_epi32( _mm_castsi128_ps( _mm_slli_epi32( _mm_add_epi32( shift, _mm_set1_epi32( 127 ) ), 23 ) ) ) };
+		const auto product{ _mm_mul_epu32( value, pow2 ) };
+		return _mm_or_si128( product, _mm_srli_epi64( product, 32 ) );
+	}
+
+	// 4 interleaved lanes, lane `i` starts `i` steps ahead and all move 4 steps at a time
+	void GenerateSSE2( uint64_t& state, uint32_t* pOut, size_t blocks, const uint64_t lanes[4], uint64_t mult, uint64_t plus ) {
+		auto s01{ _mm_set_epi32( static_cast<int>( lanes[1] >> 32 ), static_cast<int>( lanes[1] ), static_cast<int>( lanes[0] >> 32 ), static_cast<int>( lanes[0] ) ) };
+		auto s23{ _mm_set_epi32( static_cast<int>( lanes[3] >> 32 ), static_cast<int>( lanes[3] ), static_cast<int>( lanes[2] >> 32 ), static_cast<int>( lanes[2] ) ) };
+		const auto multLo{ _mm_set_epi32( 0, static_cast<int>( mult ), 0, static_cast<int>( mult ) ) };
+		const auto multHi{ _mm_set_epi32( 0, static_cast<int>( mult >> 32 ), 0, static_cast<int>( mult >> 32 ) ) };
+		const auto vPlus{ _mm_set_epi32( static_cast<int>( plus >> 32 ), static_cast<int>( plus ), static_cast<int>( plus >> 32 ), static_cast<int>( plus ) ) };
+
+		for ( size_t i{0}; i < blocks; i += 1 ) {
+			const auto r01{ _mm_shuffle_epi32( Output2( s01 ), _MM_SHUFFLE( 2, 2, 2, 0 ) ) };
+			const auto r23{ _mm_shuffle_epi32( Output2( s23 ), _MM_SHUFFLE( 2, 2, 2, 0 ) ) };
+			_mm_storeu_si128( reinterpret_cast<__m128i*>( pOut + i * 4 ), _mm_unpacklo_epi64( r01, r23 ) );
+
+			s01 = _mm_add_epi64( MulLo64( s01, multLo, multHi ), vPlus );
+			s23 = _mm_add_epi64( MulLo64( s23, multLo, multHi ), vPlus );
+		}
+
+		// lane 0 is where the scalar generator would be now
+		alignas( 16 ) uint64_t result[2];
+		_mm_store_si128( reinterpret_cast<__m128i*>( result ), s01 );
+		state = result[0];
+	}
+
+	PCG_TARGET_AVX2
+	inline __m256i MulLo64( __m256i a, __m256i bLo, __m256i bHi ) {
+		const auto lolo{ _mm256_mul_epu32( a, bLo ) };
+		const auto cross{ _mm256_add_epi64( _mm256_mul_epu32( a, bHi ), _mm256_mul_epu32( _mm256_srli_epi64( a, 32 ), bLo ) ) };
+		return _mm256_add_epi64( lolo, _mm256_slli_epi64( cross, 32 ) );
+	}
+
+	PCG_TARGET_AVX2
+	inline __m256i Output4( __m256i state ) {
+		const auto rot{ _mm256_srli_epi64( state, 59 ) };
+		const auto x{ _mm256_xor_si256( state, _mm256_srli_epi64( state, 18 ) ) };
+		const auto value{ _mm256_and_si256( _mm256_srli_epi64( x, 27 ), _mm256_set1_epi64x( 0xFFFFFFFF ) ) };
+		// rotating the low half of 64-bit lanes, so a shift of 32 is fine
+		const auto rotated{ _mm256_or_si256( _mm256_srlv_epi64( value, rot ), _mm256_sllv_epi64( value, _mm256_sub_epi64( _mm256_set1_epi64x( 32 ), rot ) ) ) };
+		// gather the low halves in the low 128 bits
+		return _mm256_permutevar8x32_epi32( rotated, _mm256_setr_epi32( 0, 2, 4, 6, 1, 3, 5, 7 ) );
+	}
+
+	// 8 interleaved lanes, as above
+	PCG_TARGET_AVX2
+	void GenerateAVX2( uint64_t& state, uint32_t* pOut, size_t blocks, const uint64_t lanes[8], uint64_t mult, uint64_t plus ) {
+		auto s0{ _mm256_loadu_si256( reinterpret_cast<const __m256i*>( lanes ) ) };
+		auto s1{ _mm256_loadu_si256( reinterpret_cast<const __m256i*>( lanes + 4 ) ) };
+		const auto multLo{ _mm256_set1_epi64x( static_cast<int64_t>( mult & 0xFFFFFFFF ) ) };
+		const auto multHi{ _mm256_set1_epi64x( static_cast<int64_t>( mult >> 32 ) ) };
+		const auto vPlus{ _mm256_set1_epi64x( static_cast<int64_t>( plus ) ) };
+
+		for ( size_t i{0}; i < blocks; i += 1 ) {
+			const auto r0{ _mm256_castsi256_si128( Output4( s0 ) ) };
+			const auto r1{ _mm256_castsi256_si128( Output4( s1 ) ) };
+			_mm256_storeu_si256( reinterpret_cast<__m256i*>( pOut + i * 8 ), _mm256_inserti128_si256( _mm256_castsi128_si256( r0 ), r1, 1 ) );
+
+			s0 = _mm256_add_epi64( MulLo64( s0, multLo, multHi ), vPlus );
+			s1 = _mm256_add_epi64( MulLo64( s1, multLo, multHi ), vPlus );
+		}
+
+		alignas( 32 ) uint64_t result[4];
+		_mm256_store_si256( reinterpret_cast<__m256i*>( result ), s0 );
+		state = result[0];
+		_mm256_zeroupper();
+	}
+}
+
 
 void PcgEngine::seed() {
 	this->m_luState = 0xEBABEFF0C0f33173;
@@ -21,8 +146,80 @@ void PcgEngine::seed( std::random_device& pOther ) {
 
 // e.discard(z)
 void PcgEngine::discard( unsigned long long n ) {
-	for ( auto i{ 0 }; i < n; i++ )
-		this->operator()();
+	uint64_t mult, plus;
+	JumpCoefficients( n, mult, plus );
+	this->m_luState = this->m_luState * mult + plus;
+}
+
+void PcgEngine::Generate( uint32_t* pOut, size_t count ) {
+	if ( count < MIN_SIMD_COUNT ) {
+		for ( size_t i{0}; i < count; i += 1 ) {
+			pOut[i] = this->operator()();
+		}
+		return;
+	}
+
+	const size_t width{ s_bHasAVX2 ? 8u : 4u };
+	const auto blocks{ count / width };
+
+	// lane `i` starts `i` steps ahead, every lane then moves `width` steps at a time
+	uint64_t lanes[8];
+	lanes[0] = this->m_luState;
+	for ( size_t i{1}; i < width; i += 1 ) {
+		lanes[i] = lanes[i - 1] * multiplier + increment;
+	}
+	uint64_t mult, plus;
+	JumpCoefficients( width, mult, plus );
+
+	if ( width == 8 ) {
+		GenerateAVX2( this->m_luState, pOut, blocks, lanes, mult, plus );
+	} else {
+		GenerateSSE2( this->m_luState, pOut, blocks, lanes, mult, plus );
+	}
+
+	for ( auto i{ blocks * width }; i < count; i += 1 ) {
+		pOut[i] = this->operator()();
+	}
+}
+
+void PcgEngine::GenerateFloats( float* pOut, size_t count, float flMin, float flMax ) {
+	// generate in place, then convert: the top 24 bits make an exact float in [0, 1)
+	const auto pBits{ reinterpret_cast<uint32_t*>( pOut ) };
+	this->Generate( pBits, count );
+
+	const auto scale{ ( flMax - flMin ) * ( 1.0f / 16777216.0f ) };
+	const auto vScale{ _mm_set1_ps( scale ) };
+	const auto vMin{ _mm_set1_ps( flMin ) };
+
+	size_t i{0};
+	for ( ; i + 4 <= count; i += 4 ) {
+		const auto bits{ _mm_srli_epi32( _mm_loadu_si128( reinterpret_cast<const __m128i*>( pBits + i ) ), 8 ) };
+		_mm_storeu_ps( pOut + i, _mm_add_ps( _mm_mul_ps( _mm_cvtepi32_ps( bits ), vScale ), vMin ) );
+	}
+	for ( ; i < count; i += 1 ) {
+		uint32_t bits;
+		std::memcpy( &bits, pOut + i, sizeof( bits ) );
+		pOut[i] = static_cast<float>( bits >> 8 ) * scale + flMin;
+	}
+}
+
+void PcgEngine::JumpCoefficients( unsigned long long delta, uint64_t& mult, uint64_t& plus ) {
+	// Brown, "Random Number Generation with Arbitrary Strides": square the step until delta runs out
+	uint64_t accMult{ 1 };
+	uint64_t accPlus{ 0 };
+	uint64_t curMult{ multiplier };
+	uint64_t curPlus{ increment };
+	while ( delta > 0 ) {
+		if ( delta & 1 ) {
+			accMult *= curMult;
+			accPlus = accPlus * curMult + curPlus;
+		}
+		curPlus = ( curMult + 1 ) * curPlus;
+		curMult *= curMult;
+		delta >>= 1;
+	}
+	mult = accMult;
+	plus = accPlus;
 }
 
 // x == y
@@ -41,4 +238,4 @@ std::ostream& operator<<( std::ostream& os, const PcgEngine& pcgEngine ) {
 // is >> x
 std::istream& operator>>( std::istream& is, PcgEngine& pEngine ) {
 	return is >> pEngine.m_luState;
-}
\ No newline at end of file
+}
@@ -34,6 +34,30 @@ float CUniformRandomStream::RandomFloatExp( const float flMinVal, const float fl
 	return std::pow( res, flExponent );
 }
 
+void CUniformRandomStream::RandomFloats( float* pOut, const int nCount, const float flMinVal, const float flMaxVal ) {
+	if ( nCount <= 0 ) {
+		return;
+	}
+	this->m_Mutex.Lock();
+	this->m_Engine.GenerateFloats( pOut, nCount, flMinVal, flMaxVal );
+	this->m_Mutex.Unlock();
+}
+void CUniformRandomStream::RandomInts( int* pOut, const int nCount, const int iMinVal, const int iMaxVal ) {
+	if ( nCount <= 0 ) {
+		return;
+	}
+	this->m_Mutex.Lock();
+	this->m_Engine.Generate( reinterpret_cast<uint32_t*>( pOut ), nCount );
+	this->m_Mutex.Unlock();
+
+	// multiply-shift into the range, it's inclusive so the whole int range is 2^32 values
+	const auto range{ static_cast<uint64_t>( static_cast<int64_t>( iMaxVal ) - iMinVal ) + 1 };
+	for ( auto i{0}; i < nCount; i += 1 ) {
+		const auto bits{ static_cast<uint64_t>( static_cast<uint32_t>( pOut[i] ) ) };
+		pOut[i] = static_cast<int>( iMinVal + static_cast<int64_t>( ( bits * range ) >> 32 ) );
+	}
+}
+
 // --- CGaussianRandomStream ---
 CGaussianRandomStream::CGaussianRandomStream( IUniformRandomStream* pUniformStream ) {
 	this->m_pUniformStream = pUniformStream ? pUniformStream : g_pUniformRandomStream;
@@ -62,6 +86,26 @@ float RandomGaussianFloat( const float flMean, const float flStdDev ) {
 	return g_GaussianRandomStream.RandomFloat( flMean, flStdDev );
 }
 
+void RandomFloats( float* pOut, const int nCount, const float flMinVal, const float flMaxVal ) {
+	if ( const auto stream{ dynamic_cast<CUniformRandomStream*>( g_pUniformRandomStream ) } ) {
+		stream->RandomFloats( pOut, nCount, flMinVal, flMaxVal );
+		return;
+	}
+	// someone installed their own stream
+	for ( auto i{0}; i < nCount; i += 1 ) {
+		pOut[i] = g_pUniformRandomStream->RandomFloat( flMinVal, flMaxVal );
+	}
+}
+void RandomInts( int* pOut, const int nCount, const int iMinVal, const int iMaxVal ) {
+	if ( const auto stream{ dynamic_cast<CUniformRandomStream*>( g_pUniformRandomStream ) } ) {
+		stream->RandomInts( pOut, nCount, iMinVal, iMaxVal );
+		return;
+	}
+	for ( auto i{0}; i < nCount; i += 1 ) {
+		pOut[i] = g_pUniformRandomStream->RandomInt( iMinVal, iMaxVal );
+	}
+}
+
 void InstallUniformRandomStream( IUniformRandomStream* pStream ) {
 	if ( not pStream ) {
 		pStream = &g_UniformRandomStream;
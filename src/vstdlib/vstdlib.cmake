@@ -7,6 +7,8 @@ set( VSTDLIB_SOURCE_FILES
 	"${VSTDLIB_DIR}/keyvaluessystem.cpp"
 	"${VSTDLIB_DIR}/pcgengine.cpp"
 	"${VSTDLIB_DIR}/jobthread.cpp"
+	"${VSTDLIB_DIR}/jobgraph.cpp"
+	"${VSTDLIB_DIR}/jobcoroutine.cpp"
 	"${VSTDLIB_DIR}/osversion.cpp"
 
 	# Header files
@@ -20,6 +22,8 @@ set( VSTDLIB_SOURCE_FILES
 	"${SRCDIR}/public/vstdlib/random.h"
 	"${SRCDIR}/public/vstdlib/osversion.h"
 	"${SRCDIR}/public/vstdlib/jobthread.h"
+	"${SRCDIR}/public/vstdlib/jobgraph.h"
+	"${SRCDIR}/public/vstdlib/jobcoroutine.h"
 	"${SRCDIR}/public/vstdlib/iprocessutils.h"
 	"${SRCDIR}/public/vstdlib/IKeyValuesSystem.h"
 	"${SRCDIR}/public/vstdlib/cvar.h"